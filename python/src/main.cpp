@@ -73,6 +73,103 @@ std::vector<LayerFactory> g_layer_factroys = {
 };
 int g_layer_factroy_index = 0;
 
+// hand the extracted Mat to python without another copy
+// the refcounted data stays valid as long as the returned object,
+// which also keeps the extractor alive for a user blob allocator
+// the mats from the default local pool allocator are already cloned by extract
+static py::object extracted_mat_to_object(Mat& feat, py::handle ex)
+{
+    py::object obj = py::cast(std::move(feat));
+
+    // drop the extractor reference once the returned object is collected
+    ex.inc_ref();
+    py::cpp_function release_ex([ex](py::handle wr) {
+        ex.dec_ref();
+        wr.dec_ref();
+    });
+    py::weakref wr(obj, release_ex);
+    wr.release();
+
+    return obj;
+}
+
+#if NCNN_STRING
+static int extractor_extract(Extractor& ex, const std::string& blob_name, Mat& feat, int type)
+{
+    return ex.extract(blob_name.c_str(), feat, type);
+}
+#endif // NCNN_STRING
+
+static int extractor_extract(Extractor& ex, int blob_index, Mat& feat, int type)
+{
+    return ex.extract(blob_index, feat, type);
+}
+
+#if NCNN_STRING
+// one-shot inference on a private extractor, safe to call from several python threads
+static py::tuple net_run(py::object self, const std::map<std::string, Mat>& inputs, const std::vector<std::string>& outputs)
+{
+    const Net& net = self.cast<const Net&>();
+
+    std::vector<Mat> feats(outputs.size());
+    int ret = 0;
+    {
+        py::gil_scoped_release release;
+
+        Extractor ex = net.create_extractor();
+
+        for (std::map<std::string, Mat>::const_iterator it = inputs.begin(); it != inputs.end(); ++it)
+        {
+            ret = ex.input(it->first.c_str(), it->second);
+            if (ret != 0)
+                break;
+        }
+
+        for (size_t i = 0; i < outputs.size() && ret == 0; i++)
+        {
+            ret = ex.extract(outputs[i].c_str(), feats[i]);
+        }
+    }
+
+    py::dict outs;
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        // the net owns the blob allocator of the outputs
+        outs[py::str(outputs[i])] = extracted_mat_to_object(feats[i], self);
+    }
+
+    return py::make_tuple(ret, outs);
+}
+#endif // NCNN_STRING
+
+// extract several blobs with the GIL released during inference
+template<typename T>
+static py::tuple extract_many(py::object self, const std::vector<T>& blobs, int type)
+{
+    Extractor& ex = self.cast<Extractor&>();
+
+    std::vector<Mat> feats(blobs.size());
+    int ret = 0;
+    {
+        py::gil_scoped_release release;
+
+        for (size_t i = 0; i < blobs.size(); i++)
+        {
+            ret = extractor_extract(ex, blobs[i], feats[i], type);
+            if (ret != 0)
+                break;
+        }
+    }
+
+    py::list outs;
+    for (size_t i = 0; i < feats.size(); i++)
+    {
+        outs.append(extracted_mat_to_object(feats[i], self));
+    }
+
+    return py::make_tuple(ret, outs);
+}
+
 #define LayerFactoryDefine(n)                                  \
     static ncnn::Layer* LayerCreator##n(void* p)               \
     {                                                          \
@@ -116,15 +213,15 @@ PYBIND11_MODULE(ncnn, m)
     py::class_<PoolAllocator, Allocator, PyAllocatorOther<PoolAllocator> >(m, "PoolAllocator")
     .def(py::init<>())
     .def("set_size_compare_ratio", &PoolAllocator::set_size_compare_ratio, py::arg("src"))
-    .def("clear", &PoolAllocator::clear)
-    .def("fastMalloc", &PoolAllocator::fastMalloc, py::arg("size"))
-    .def("fastFree", &PoolAllocator::fastFree, py::arg("ptr"));
+    .def("clear", &PoolAllocator::clear, py::call_guard<py::gil_scoped_release>())
+    .def("fastMalloc", &PoolAllocator::fastMalloc, py::arg("size"), py::call_guard<py::gil_scoped_release>())
+    .def("fastFree", &PoolAllocator::fastFree, py::arg("ptr"), py::call_guard<py::gil_scoped_release>());
     py::class_<UnlockedPoolAllocator, Allocator, PyAllocatorOther<UnlockedPoolAllocator> >(m, "UnlockedPoolAllocator")
     .def(py::init<>())
     .def("set_size_compare_ratio", &UnlockedPoolAllocator::set_size_compare_ratio, py::arg("src"))
-    .def("clear", &UnlockedPoolAllocator::clear)
-    .def("fastMalloc", &UnlockedPoolAllocator::fastMalloc, py::arg("size"))
-    .def("fastFree", &UnlockedPoolAllocator::fastFree, py::arg("ptr"));
+    .def("clear", &UnlockedPoolAllocator::clear, py::call_guard<py::gil_scoped_release>())
+    .def("fastMalloc", &UnlockedPoolAllocator::fastMalloc, py::arg("size"), py::call_guard<py::gil_scoped_release>())
+    .def("fastFree", &UnlockedPoolAllocator::fastFree, py::arg("ptr"), py::call_guard<py::gil_scoped_release>());
 
     py::class_<DataReader, PyDataReader<> >(m, "DataReader")
     .def(py::init<>())
@@ -287,7 +384,7 @@ PYBIND11_MODULE(ncnn, m)
         }
         return std::unique_ptr<Mat>(v);
     }),
-    py::arg("array"))
+    py::arg("array"), py::keep_alive<1, 2>()) // the Mat references the array data
     .def_buffer([](Mat& m) -> py::buffer_info {
         return to_buffer_info(m);
     })
@@ -843,25 +940,37 @@ PYBIND11_MODULE(ncnn, m)
     .def("set_blob_allocator", &Extractor::set_blob_allocator, py::arg("allocator"))
     .def("set_workspace_allocator", &Extractor::set_workspace_allocator, py::arg("allocator"))
 #if NCNN_STRING
-    .def("input", (int (Extractor::*)(const char*, const Mat&)) & Extractor::input, py::arg("blob_name"), py::arg("in"))
-    .def("extract", (int (Extractor::*)(const char*, Mat&, int)) & Extractor::extract, py::arg("blob_name"), py::arg("feat"), py::arg("type") = 0)
+    .def("input", (int (Extractor::*)(const char*, const Mat&)) & Extractor::input, py::arg("blob_name"), py::arg("in"), py::call_guard<py::gil_scoped_release>())
+    .def("extract", (int (Extractor::*)(const char*, Mat&, int)) & Extractor::extract, py::arg("blob_name"), py::arg("feat"), py::arg("type") = 0, py::call_guard<py::gil_scoped_release>())
     .def(
-    "extract", [](Extractor& ex, const char* blob_name, int type) {
+    "extract", [](py::object self, const char* blob_name, int type) {
+        Extractor& ex = self.cast<Extractor&>();
         ncnn::Mat feat;
-        int ret = ex.extract(blob_name, feat, type);
-        return py::make_tuple(ret, feat.clone());
+        int ret = 0;
+        {
+            py::gil_scoped_release release;
+            ret = ex.extract(blob_name, feat, type);
+        }
+        return py::make_tuple(ret, extracted_mat_to_object(feat, self));
     },
     py::arg("blob_name"), py::arg("type") = 0)
+    .def("extract_many", &extract_many<std::string>, py::arg("blob_names"), py::arg("type") = 0)
 #endif
-    .def("input", (int (Extractor::*)(int, const Mat&)) & Extractor::input)
-    .def("extract", (int (Extractor::*)(int, Mat&, int)) & Extractor::extract, py::arg("blob_index"), py::arg("feat"), py::arg("type") = 0)
+    .def("input", (int (Extractor::*)(int, const Mat&)) & Extractor::input, py::call_guard<py::gil_scoped_release>())
+    .def("extract", (int (Extractor::*)(int, Mat&, int)) & Extractor::extract, py::arg("blob_index"), py::arg("feat"), py::arg("type") = 0, py::call_guard<py::gil_scoped_release>())
     .def(
-    "extract", [](Extractor& ex, int blob_index, int type) {
+    "extract", [](py::object self, int blob_index, int type) {
+        Extractor& ex = self.cast<Extractor&>();
         ncnn::Mat feat;
-        int ret = ex.extract(blob_index, feat, type);
-        return py::make_tuple(ret, feat.clone());
+        int ret = 0;
+        {
+            py::gil_scoped_release release;
+            ret = ex.extract(blob_index, feat, type);
+        }
+        return py::make_tuple(ret, extracted_mat_to_object(feat, self));
     },
-    py::arg("blob_index"), py::arg("type") = 0);
+    py::arg("blob_index"), py::arg("type") = 0)
+    .def("extract_many", &extract_many<int>, py::arg("blob_indexes"), py::arg("type") = 0);
 
     py::class_<Layer, PyLayer>(m, "Layer")
     .def(py::init<>())
@@ -941,20 +1050,23 @@ PYBIND11_MODULE(ncnn, m)
     },
     py::arg("index"), py::arg("creator"), py::arg("destroyer"))
 #if NCNN_STRING
-    .def("load_param", (int (Net::*)(const DataReader&)) & Net::load_param, py::arg("dr"))
+    .def("load_param", (int (Net::*)(const DataReader&)) & Net::load_param, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STRING
-    .def("load_param_bin", (int (Net::*)(const DataReader&)) & Net::load_param_bin, py::arg("dr"))
-    .def("load_model", (int (Net::*)(const DataReader&)) & Net::load_model, py::arg("dr"))
+    .def("load_param_bin", (int (Net::*)(const DataReader&)) & Net::load_param_bin, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
+    .def("load_model", (int (Net::*)(const DataReader&)) & Net::load_model, py::arg("dr"), py::call_guard<py::gil_scoped_release>())
 
 #if NCNN_STDIO
 #if NCNN_STRING
-    .def("load_param", (int (Net::*)(const char*)) & Net::load_param, py::arg("protopath"))
+    .def("load_param", (int (Net::*)(const char*)) & Net::load_param, py::arg("protopath"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STRING
-    .def("load_param_bin", (int (Net::*)(const char*)) & Net::load_param_bin, py::arg("protopath"))
-    .def("load_model", (int (Net::*)(const char*)) & Net::load_model, py::arg("modelpath"))
+    .def("load_param_bin", (int (Net::*)(const char*)) & Net::load_param_bin, py::arg("protopath"), py::call_guard<py::gil_scoped_release>())
+    .def("load_model", (int (Net::*)(const char*)) & Net::load_model, py::arg("modelpath"), py::call_guard<py::gil_scoped_release>())
 #endif // NCNN_STDIO
 
     .def("clear", &Net::clear)
+#if NCNN_STRING
+    .def("run", &net_run, py::arg("inputs"), py::arg("outputs"))
+#endif // NCNN_STRING
     .def("create_extractor", &Net::create_extractor, py::keep_alive<0, 1>()) //net should be kept alive until retuned ex is freed by gc
 
     .def("input_indexes", &Net::input_indexes, py::return_value_policy::reference)
@@ -84,3 +84,54 @@ def test_extractor_index():
 
     # not use with sentence, call clear manually to ensure ex destruct before net
     ex.clear()
+
+
+def test_extractor_many():
+    dr = ncnn.DataReaderFromEmpty()
+
+    net = ncnn.Net()
+    net.load_param("tests/test.param")
+    net.load_model(dr)
+
+    in_mat = ncnn.Mat((227, 227, 3))
+    with net.create_extractor() as ex:
+        ex.input("data", in_mat)
+        ret, out_mats = ex.extract_many(["conv0_fwd", "output"])
+        assert ret == 0 and len(out_mats) == 2
+        assert (
+            out_mats[0].dims == 3
+            and out_mats[0].w == 225
+            and out_mats[0].h == 225
+            and out_mats[0].c == 3
+        )
+        assert out_mats[1].dims == 1 and out_mats[1].w == 1
+
+    ex = net.create_extractor()
+    ex.input(0, in_mat)
+    ret, out_mats = ex.extract_many([1, 2])
+    assert ret == 0 and len(out_mats) == 2
+    assert out_mats[0].dims == 3 and out_mats[1].dims == 1
+
+    ex.clear()
+
+
+def test_extractor_zero_copy():
+    import numpy as np
+
+    dr = ncnn.DataReaderFromEmpty()
+
+    net = ncnn.Net()
+    net.load_param("tests/test.param")
+    net.load_model(dr)
+
+    in_mat = ncnn.Mat((227, 227, 3))
+    ex = net.create_extractor()
+    ex.input("data", in_mat)
+    ret, out_mat = ex.extract("conv0_fwd")
+    assert ret == 0
+
+    # the array views the extracted data, which outlives the extractor
+    out = np.array(out_mat, copy=False)
+    out.fill(1)
+    del ex
+    assert np.all(np.array(out_mat) == 1)
@@ -42,6 +42,30 @@ def test_net():
         assert len(net.blobs()) == 0 and len(net.layers()) == 0
 
 
+def test_net_run_threads():
+    from concurrent.futures import ThreadPoolExecutor
+
+    dr = ncnn.DataReaderFromEmpty()
+
+    net = ncnn.Net()
+    net.load_param("tests/test.param")
+    net.load_model(dr)
+
+    def run(i):
+        in_mat = ncnn.Mat(np.full((3, 227, 227), i, dtype=np.float32))
+        return net.run({"data": in_mat}, ["conv0_fwd", "output"])
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+        results = list(pool.map(run, range(8)))
+
+    for ret, outs in results:
+        assert ret == 0
+        assert outs["conv0_fwd"].dims == 3 and outs["conv0_fwd"].c == 3
+        assert outs["output"].dims == 1 and outs["output"].w == 1
+
+    net.clear()
+
+
 def test_net_vulkan():
     if not hasattr(ncnn, "get_gpu_count"):
         return
@@ -21,6 +21,16 @@
 #include <android/hardware_buffer.h>
 #endif // __ANDROID_API__ >= 26
 
+#if defined __ANDROID__ || defined __linux__
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#endif // defined __ANDROID__ || defined __linux__
+
+#if !NCNN_SIMPLESTL
+#include <algorithm>
+#endif // !NCNN_SIMPLESTL
+
 namespace ncnn {
 
 Allocator::~Allocator()
@@ -36,6 +46,8 @@ public:
     size_t size_drop_threshold;
     std::list<std::pair<size_t, void*> > budgets;
     std::list<std::pair<size_t, void*> > payouts;
+    size_t payout_bytes;
+    size_t peak_payout_bytes;
 };
 
 PoolAllocator::PoolAllocator()
@@ -43,6 +55,8 @@ PoolAllocator::PoolAllocator()
 {
     d->size_compare_ratio = 0;
     d->size_drop_threshold = 10;
+    d->payout_bytes = 0;
+    d->peak_payout_bytes = 0;
 }
 
 PoolAllocator::~PoolAllocator()
@@ -106,6 +120,53 @@ void PoolAllocator::set_size_drop_threshold(size_t threshold)
     d->size_drop_threshold = threshold;
 }
 
+size_t PoolAllocator::get_budget_bytes() const
+{
+    d->budgets_lock.lock();
+
+    size_t bytes = 0;
+    std::list<std::pair<size_t, void*> >::const_iterator it = d->budgets.begin();
+    for (; it != d->budgets.end(); ++it)
+    {
+        bytes += it->first;
+    }
+
+    d->budgets_lock.unlock();
+
+    return bytes;
+}
+
+size_t PoolAllocator::get_payout_bytes() const
+{
+    d->payouts_lock.lock();
+
+    size_t bytes = d->payout_bytes;
+
+    d->payouts_lock.unlock();
+
+    return bytes;
+}
+
+size_t PoolAllocator::get_peak_payout_bytes() const
+{
+    d->payouts_lock.lock();
+
+    size_t bytes = d->peak_payout_bytes;
+
+    d->payouts_lock.unlock();
+
+    return bytes;
+}
+
+void PoolAllocator::reset_peak_payout_bytes()
+{
+    d->payouts_lock.lock();
+
+    d->peak_payout_bytes = d->payout_bytes;
+
+    d->payouts_lock.unlock();
+}
+
 void* PoolAllocator::fastMalloc(size_t size)
 {
     d->budgets_lock.lock();
@@ -128,6 +189,9 @@ void* PoolAllocator::fastMalloc(size_t size)
             d->payouts_lock.lock();
 
             d->payouts.push_back(std::make_pair(bs, ptr));
+            d->payout_bytes += bs;
+            if (d->payout_bytes > d->peak_payout_bytes)
+                d->peak_payout_bytes = d->payout_bytes;
 
             d->payouts_lock.unlock();
 
@@ -172,6 +236,9 @@ void* PoolAllocator::fastMalloc(size_t size)
     d->payouts_lock.lock();
 
     d->payouts.push_back(std::make_pair(size, ptr));
+    d->payout_bytes += size;
+    if (d->payout_bytes > d->peak_payout_bytes)
+        d->peak_payout_bytes = d->payout_bytes;
 
     d->payouts_lock.unlock();
 
@@ -191,6 +258,7 @@ void PoolAllocator::fastFree(void* ptr)
             size_t size = it->first;
 
             d->payouts.erase(it);
+            d->payout_bytes -= size;
 
             d->payouts_lock.unlock();
 
@@ -217,6 +285,8 @@ public:
     size_t size_drop_threshold;
     std::list<std::pair<size_t, void*> > budgets;
     std::list<std::pair<size_t, void*> > payouts;
+    size_t payout_bytes;
+    size_t peak_payout_bytes;
 };
 
 UnlockedPoolAllocator::UnlockedPoolAllocator()
@@ -224,6 +294,8 @@ UnlockedPoolAllocator::UnlockedPoolAllocator()
 {
     d->size_compare_ratio = 0;
     d->size_drop_threshold = 10;
+    d->payout_bytes = 0;
+    d->peak_payout_bytes = 0;
 }
 
 UnlockedPoolAllocator::~UnlockedPoolAllocator()
@@ -283,6 +355,33 @@ void UnlockedPoolAllocator::set_size_drop_threshold(size_t threshold)
     d->size_drop_threshold = threshold;
 }
 
+size_t UnlockedPoolAllocator::get_budget_bytes() const
+{
+    size_t bytes = 0;
+    std::list<std::pair<size_t, void*> >::const_iterator it = d->budgets.begin();
+    for (; it != d->budgets.end(); ++it)
+    {
+        bytes += it->first;
+    }
+
+    return bytes;
+}
+
+size_t UnlockedPoolAllocator::get_payout_bytes() const
+{
+    return d->payout_bytes;
+}
+
+size_t UnlockedPoolAllocator::get_peak_payout_bytes() const
+{
+    return d->peak_payout_bytes;
+}
+
+void UnlockedPoolAllocator::reset_peak_payout_bytes()
+{
+    d->peak_payout_bytes = d->payout_bytes;
+}
+
 void* UnlockedPoolAllocator::fastMalloc(size_t size)
 {
     // find free budget
@@ -299,6 +398,9 @@ void* UnlockedPoolAllocator::fastMalloc(size_t size)
             d->budgets.erase(it);
 
             d->payouts.push_back(std::make_pair(bs, ptr));
+            d->payout_bytes += bs;
+            if (d->payout_bytes > d->peak_payout_bytes)
+                d->peak_payout_bytes = d->payout_bytes;
 
             return ptr;
         }
@@ -331,6 +433,9 @@ void* UnlockedPoolAllocator::fastMalloc(size_t size)
     void* ptr = ncnn::fastMalloc(size);
 
     d->payouts.push_back(std::make_pair(size, ptr));
+    d->payout_bytes += size;
+    if (d->payout_bytes > d->peak_payout_bytes)
+        d->peak_payout_bytes = d->payout_bytes;
 
     return ptr;
 }
@@ -346,6 +451,7 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
             size_t size = it->first;
 
             d->payouts.erase(it);
+            d->payout_bytes -= size;
 
             d->budgets.push_back(std::make_pair(size, ptr));
 
@@ -357,6 +463,355 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     ncnn::fastFree(ptr);
 }
 
+#if defined __ANDROID__ || defined __linux__
+static bool is_transparent_huge_page_enabled()
+{
+    // https://github.com/torvalds/linux/blob/v6.0/Documentation/admin-guide/mm/transhuge.rst
+    FILE* fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "rb");
+    if (!fp)
+        return false;
+
+    char line[256];
+    char* s = fgets(line, sizeof(line), fp);
+    fclose(fp);
+
+    return s && !strstr(s, "[never]");
+}
+
+// anonymous memory aligned to the huge page size and advised to use huge pages
+static void* map_huge_page_aligned(size_t size)
+{
+    void* raw = mmap(0, size + NCNN_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+        return 0;
+
+    unsigned char* ptr = alignPtr((unsigned char*)raw, NCNN_HUGE_PAGE_SIZE);
+
+    // trim the unaligned head and tail
+    const size_t head = ptr - (unsigned char*)raw;
+    if (head > 0)
+        munmap(raw, head);
+    munmap(ptr + size, NCNN_HUGE_PAGE_SIZE - head);
+
+    madvise(ptr, size, MADV_HUGEPAGE);
+
+    return ptr;
+}
+
+// AnonHugePages of the mappings that lie inside the ranges
+static size_t get_anon_huge_page_bytes(std::vector<std::pair<size_t, size_t> > ranges)
+{
+    if (ranges.empty())
+        return 0;
+
+    // adjacent mappings with the same flags are merged by the kernel, merge the ranges too
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        for (size_t j = i; j > 0 && ranges[j].first < ranges[j - 1].first; j--)
+        {
+            std::swap(ranges[j], ranges[j - 1]);
+        }
+    }
+    std::vector<std::pair<size_t, size_t> > merged;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        if (!merged.empty() && merged.back().second == ranges[i].first)
+            merged.back().second = ranges[i].second;
+        else
+            merged.push_back(ranges[i]);
+    }
+
+    FILE* fp = fopen("/proc/self/smaps", "rb");
+    if (!fp)
+        return 0;
+
+    size_t bytes = 0;
+    bool inside = false;
+    size_t vma_size = 0;
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp))
+    {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        char perms[8];
+        if (sscanf(line, "%lx-%lx %7s", &start, &end, perms) == 3)
+        {
+            inside = false;
+            vma_size = end - start;
+            for (size_t i = 0; i < merged.size(); i++)
+            {
+                if (start >= merged[i].first && end <= merged[i].second)
+                {
+                    inside = true;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        size_t kb = 0;
+        if (inside && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+        {
+            bytes += std::min(kb * 1024, vma_size);
+        }
+    }
+
+    fclose(fp);
+
+    return bytes;
+}
+#endif // defined __ANDROID__ || defined __linux__
+
+struct huge_page_mapping
+{
+    void* ptr;
+    size_t size;
+    bool hugetlb;
+};
+
+class HugePageAllocatorPrivate
+{
+public:
+    Mutex budgets_lock;
+    Mutex payouts_lock;
+    size_t size_threshold;
+    bool use_hugetlbfs;
+    bool transparent_huge_page_enabled;
+    std::list<huge_page_mapping> budgets;
+    std::list<huge_page_mapping> payouts;
+};
+
+HugePageAllocator::HugePageAllocator()
+    : Allocator(), d(new HugePageAllocatorPrivate)
+{
+    d->size_threshold = 1024 * 1024;
+    d->use_hugetlbfs = false;
+#if defined __ANDROID__ || defined __linux__
+    d->transparent_huge_page_enabled = is_transparent_huge_page_enabled();
+#else
+    d->transparent_huge_page_enabled = false;
+#endif
+}
+
+HugePageAllocator::~HugePageAllocator()
+{
+    clear();
+
+    if (!d->payouts.empty())
+    {
+        NCNN_LOGE("FATAL ERROR! huge page allocator destroyed too early");
+#if NCNN_STDIO
+        std::list<huge_page_mapping>::iterator it = d->payouts.begin();
+        for (; it != d->payouts.end(); ++it)
+        {
+            NCNN_LOGE("%p still in use", it->ptr);
+        }
+#endif
+    }
+
+    delete d;
+}
+
+HugePageAllocator::HugePageAllocator(const HugePageAllocator&)
+    : d(0)
+{
+}
+
+HugePageAllocator& HugePageAllocator::operator=(const HugePageAllocator&)
+{
+    return *this;
+}
+
+void HugePageAllocator::set_size_threshold(size_t threshold)
+{
+    d->size_threshold = threshold;
+}
+
+void HugePageAllocator::set_use_hugetlbfs(bool enable)
+{
+    d->use_hugetlbfs = enable;
+}
+
+void HugePageAllocator::clear()
+{
+    d->budgets_lock.lock();
+
+#if defined __ANDROID__ || defined __linux__
+    std::list<huge_page_mapping>::iterator it = d->budgets.begin();
+    for (; it != d->budgets.end(); ++it)
+    {
+        munmap(it->ptr, it->size);
+    }
+#endif
+    d->budgets.clear();
+
+    d->budgets_lock.unlock();
+}
+
+size_t HugePageAllocator::get_huge_page_bytes() const
+{
+    size_t bytes = 0;
+
+#if defined __ANDROID__ || defined __linux__
+    std::vector<std::pair<size_t, size_t> > ranges;
+
+    d->payouts_lock.lock();
+
+    std::list<huge_page_mapping>::const_iterator it = d->payouts.begin();
+    for (; it != d->payouts.end(); ++it)
+    {
+        if (it->hugetlb)
+            bytes += it->size;
+        else
+            ranges.push_back(std::make_pair((size_t)it->ptr, (size_t)it->ptr + it->size));
+    }
+
+    d->payouts_lock.unlock();
+
+    bytes += get_anon_huge_page_bytes(ranges);
+#endif
+
+    return bytes;
+}
+
+size_t HugePageAllocator::get_huge_page_bytes(const std::vector<void*>& ptrs) const
+{
+    size_t bytes = 0;
+
+#if defined __ANDROID__ || defined __linux__
+    std::vector<std::pair<size_t, size_t> > ranges;
+
+    d->payouts_lock.lock();
+
+    std::list<huge_page_mapping>::const_iterator it = d->payouts.begin();
+    for (; it != d->payouts.end(); ++it)
+    {
+        bool listed = false;
+        for (size_t i = 0; i < ptrs.size(); i++)
+        {
+            if (ptrs[i] == it->ptr)
+            {
+                listed = true;
+                break;
+            }
+        }
+
+        if (!listed)
+            continue;
+
+        if (it->hugetlb)
+            bytes += it->size;
+        else
+            ranges.push_back(std::make_pair((size_t)it->ptr, (size_t)it->ptr + it->size));
+    }
+
+    d->payouts_lock.unlock();
+
+    bytes += get_anon_huge_page_bytes(ranges);
+#else
+    (void)ptrs;
+#endif
+
+    return bytes;
+}
+
+void* HugePageAllocator::fastMalloc(size_t size)
+{
+#if defined __ANDROID__ || defined __linux__
+    if (size >= d->size_threshold && (d->use_hugetlbfs || d->transparent_huge_page_enabled))
+    {
+        const size_t map_size = alignSize(size + NCNN_MALLOC_OVERREAD, NCNN_HUGE_PAGE_SIZE);
+
+        huge_page_mapping m = {0, 0, false};
+
+        d->budgets_lock.lock();
+
+        // the smallest free mapping that fits
+        std::list<huge_page_mapping>::iterator it = d->budgets.begin(), it_best = d->budgets.end();
+        for (; it != d->budgets.end(); ++it)
+        {
+            if (it->size >= map_size && (it_best == d->budgets.end() || it->size < it_best->size))
+                it_best = it;
+        }
+        if (it_best != d->budgets.end())
+        {
+            m = *it_best;
+            d->budgets.erase(it_best);
+        }
+
+        d->budgets_lock.unlock();
+
+#ifdef MAP_HUGETLB
+        if (!m.ptr && d->use_hugetlbfs)
+        {
+            void* ptr = mmap(0, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED)
+            {
+                m.ptr = ptr;
+                m.size = map_size;
+                m.hugetlb = true;
+            }
+        }
+#endif // MAP_HUGETLB
+
+        if (!m.ptr && d->transparent_huge_page_enabled)
+        {
+            m.ptr = map_huge_page_aligned(map_size);
+            m.size = map_size;
+            m.hugetlb = false;
+        }
+
+        if (m.ptr)
+        {
+            d->payouts_lock.lock();
+
+            d->payouts.push_back(m);
+
+            d->payouts_lock.unlock();
+
+            return m.ptr;
+        }
+
+        // fallback to small pages
+    }
+#endif // defined __ANDROID__ || defined __linux__
+
+    return ncnn::fastMalloc(size);
+}
+
+void HugePageAllocator::fastFree(void* ptr)
+{
+    d->payouts_lock.lock();
+
+    // return to budgets
+    std::list<huge_page_mapping>::iterator it = d->payouts.begin();
+    for (; it != d->payouts.end(); ++it)
+    {
+        if (it->ptr == ptr)
+        {
+            huge_page_mapping m = *it;
+
+            d->payouts.erase(it);
+
+            d->payouts_lock.unlock();
+
+            d->budgets_lock.lock();
+
+            d->budgets.push_back(m);
+
+            d->budgets_lock.unlock();
+
+            return;
+        }
+    }
+
+    d->payouts_lock.unlock();
+
+    // small allocation or fallback
+    ncnn::fastFree(ptr);
+}
+
 #if NCNN_VULKAN
 VkAllocator::VkAllocator(const VulkanDevice* _vkdev)
     : vkdev(_vkdev)
@@ -180,6 +180,16 @@ public:
     // release all budgets immediately
     void clear();
 
+    // bytes cached in budgets for reuse
+    size_t get_budget_bytes() const;
+
+    // bytes handed out and in use
+    size_t get_payout_bytes() const;
+
+    // the high-water mark of payout bytes since creation or the last reset
+    size_t get_peak_payout_bytes() const;
+    void reset_peak_payout_bytes();
+
     virtual void* fastMalloc(size_t size);
     virtual void fastFree(void* ptr);
 
@@ -209,6 +219,16 @@ public:
     // release all budgets immediately
     void clear();
 
+    // bytes cached in budgets for reuse
+    size_t get_budget_bytes() const;
+
+    // bytes handed out and in use
+    size_t get_payout_bytes() const;
+
+    // the high-water mark of payout bytes since creation or the last reset
+    size_t get_peak_payout_bytes() const;
+    void reset_peak_payout_bytes();
+
     virtual void* fastMalloc(size_t size);
     virtual void fastFree(void* ptr);
 
@@ -220,6 +240,47 @@ private:
     UnlockedPoolAllocatorPrivate* const d;
 };
 
+// 2M transparent huge pages on linux
+// large weights and feature maps touch fewer dTLB entries when backed by them
+#define NCNN_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+class HugePageAllocatorPrivate;
+class NCNN_EXPORT HugePageAllocator : public Allocator
+{
+public:
+    HugePageAllocator();
+    ~HugePageAllocator();
+
+    // allocations smaller than threshold go to fastMalloc
+    // default threshold = 1M
+    void set_size_threshold(size_t threshold);
+
+    // take pages from the preallocated hugetlbfs pool before transparent huge pages
+    // default off, see /proc/sys/vm/nr_hugepages
+    void set_use_hugetlbfs(bool enable);
+
+    // release all budgets immediately
+    void clear();
+
+    // the bytes handed out that are backed by huge pages right now
+    // transparent huge pages are counted from /proc/self/smaps once they are touched
+    size_t get_huge_page_bytes() const;
+
+    // the same for the allocations at these pointers only
+    // adjacent mappings merged by the kernel are counted only when all of them are listed
+    size_t get_huge_page_bytes(const std::vector<void*>& ptrs) const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    HugePageAllocator(const HugePageAllocator&);
+    HugePageAllocator& operator=(const HugePageAllocator&);
+
+private:
+    HugePageAllocatorPrivate* const d;
+};
+
 #if NCNN_VULKAN
 
 class VulkanDevice;
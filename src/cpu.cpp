@@ -18,6 +18,7 @@
 
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _OPENMP
@@ -120,6 +121,10 @@ static int g_powersave;
 static ncnn::CpuSet g_cpu_affinity_mask_all;
 static ncnn::CpuSet g_cpu_affinity_mask_little;
 static ncnn::CpuSet g_cpu_affinity_mask_big;
+static std::vector<ncnn::CpuSet> g_cpu_numa_node_affinity_masks;
+#if defined __ANDROID__ || defined __linux__
+static std::vector<int> g_cpu_numa_node_ids;
+#endif // defined __ANDROID__ || defined __linux__
 
 // isa info
 #if defined __ANDROID__ || defined __linux__
@@ -1306,6 +1311,7 @@ static int set_sched_affinity(const ncnn::CpuSet& thread_affinity_mask)
 
     return 0;
 }
+
 #endif // defined __ANDROID__ || defined __linux__
 
 #if __APPLE__
@@ -1772,6 +1778,97 @@ static int detect_cpu_is_arm_a53_a55()
 #endif // __aarch64__
 #endif // defined __ANDROID__ || defined __linux__
 
+#if defined __ANDROID__ || defined __linux__
+// parse a sysfs list like 0-3,8-11
+static int read_sysfs_list(const char* path, std::vector<int>& ids)
+{
+    ids.clear();
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+
+    char line[4096];
+    char* s = fgets(line, sizeof(line), fp);
+    fclose(fp);
+
+    if (!s)
+        return -1;
+
+    while (*s)
+    {
+        if (*s < '0' || *s > '9')
+        {
+            s++;
+            continue;
+        }
+
+        char* end = 0;
+        int first = (int)strtol(s, &end, 10);
+        int last = first;
+        if (*end == '-')
+        {
+            s = end + 1;
+            last = (int)strtol(s, &end, 10);
+        }
+
+        for (int i = first; i <= last; i++)
+        {
+            ids.push_back(i);
+        }
+
+        s = end;
+    }
+
+    return 0;
+}
+#endif // defined __ANDROID__ || defined __linux__
+
+static void initialize_cpu_numa_nodes(std::vector<ncnn::CpuSet>& node_masks)
+{
+    node_masks.clear();
+
+#if defined __ANDROID__ || defined __linux__
+    g_cpu_numa_node_ids.clear();
+
+    // https://github.com/torvalds/linux/blob/v6.0/Documentation/ABI/stable/sysfs-devices-node
+    std::vector<int> node_ids;
+    read_sysfs_list("/sys/devices/system/node/online", node_ids);
+
+    for (size_t i = 0; i < node_ids.size(); i++)
+    {
+        char path[256];
+        sprintf(path, "/sys/devices/system/node/node%d/cpulist", node_ids[i]);
+
+        std::vector<int> cpus;
+        read_sysfs_list(path, cpus);
+
+        ncnn::CpuSet node_mask;
+        for (size_t j = 0; j < cpus.size(); j++)
+        {
+            if (cpus[j] < g_cpucount)
+                node_mask.enable(cpus[j]);
+        }
+
+        // memory only nodes have nothing to run on
+        if (node_mask.num_enabled() == 0)
+            continue;
+
+        node_masks.push_back(node_mask);
+        g_cpu_numa_node_ids.push_back(node_ids[i]);
+    }
+#endif // defined __ANDROID__ || defined __linux__
+
+    if (node_masks.empty())
+    {
+        // no numa info, treat all cpus as one node
+        node_masks.push_back(g_cpu_affinity_mask_all);
+#if defined __ANDROID__ || defined __linux__
+        g_cpu_numa_node_ids.push_back(0);
+#endif // defined __ANDROID__ || defined __linux__
+    }
+}
+
 // the initialization
 static void initialize_global_cpu_info()
 {
@@ -1779,6 +1876,7 @@ static void initialize_global_cpu_info()
     g_physical_cpucount = get_physical_cpucount();
     g_powersave = 0;
     initialize_cpu_thread_affinity_mask(g_cpu_affinity_mask_all, g_cpu_affinity_mask_little, g_cpu_affinity_mask_big);
+    initialize_cpu_numa_nodes(g_cpu_numa_node_affinity_masks);
 
 #if defined __ANDROID__ || defined __linux__
     g_hwcaps = get_elf_hwcap(AT_HWCAP);
@@ -2572,6 +2670,64 @@ const CpuSet& get_cpu_thread_affinity_mask(int powersave)
     return g_cpu_affinity_mask_all;
 }
 
+int get_cpu_numa_node_count()
+{
+    try_initialize_global_cpu_info();
+    return (int)g_cpu_numa_node_affinity_masks.size();
+}
+
+const CpuSet& get_cpu_numa_node_affinity_mask(int node)
+{
+    try_initialize_global_cpu_info();
+    if (node >= 0 && node < (int)g_cpu_numa_node_affinity_masks.size())
+        return g_cpu_numa_node_affinity_masks[node];
+
+    NCNN_LOGE("numa node %d not found", node);
+
+    // fallback to all cores anyway
+    return g_cpu_affinity_mask_all;
+}
+
+int set_memory_numa_interleave(const void* ptr, size_t size)
+{
+    try_initialize_global_cpu_info();
+    if (g_cpu_numa_node_affinity_masks.size() <= 1)
+        return 0;
+
+#if (defined __ANDROID__ || defined __linux__) && defined __NR_mbind
+    // only the pages entirely inside the range, the rest may be shared with other allocations
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t begin = ((size_t)ptr + page_size - 1) / page_size * page_size;
+    const size_t end = ((size_t)ptr + size) / page_size * page_size;
+    if (begin >= end)
+        return 0;
+
+    const int nodemask_bits = sizeof(unsigned long) * 8;
+    unsigned long nodemask[1024 / (sizeof(unsigned long) * 8)];
+    memset(nodemask, 0, sizeof(nodemask));
+    for (size_t i = 0; i < g_cpu_numa_node_ids.size(); i++)
+    {
+        const int node_id = g_cpu_numa_node_ids[i];
+        if (node_id < 1024)
+            nodemask[node_id / nodemask_bits] |= 1UL << (node_id % nodemask_bits);
+    }
+
+    // MPOL_INTERLEAVE = 3, MPOL_MF_MOVE = 2
+    int syscallret = syscall(__NR_mbind, (void*)begin, end - begin, 3, nodemask, (unsigned long)1024 + 1, 2);
+    if (syscallret)
+    {
+        NCNN_LOGE("syscall error %d", syscallret);
+        return -1;
+    }
+
+    return 0;
+#else
+    (void)ptr;
+    (void)size;
+    return -1;
+#endif
+}
+
 int set_cpu_thread_affinity(const CpuSet& thread_affinity_mask)
 {
     try_initialize_global_cpu_info();
@@ -2654,6 +2810,44 @@ int set_cpu_thread_affinity(const CpuSet& thread_affinity_mask)
 #endif
 }
 
+int get_cpu_thread_affinity(CpuSet& thread_affinity_mask)
+{
+    try_initialize_global_cpu_info();
+#if defined __ANDROID__ || defined __linux__
+#if defined(__BIONIC__)
+    pid_t pid = gettid();
+#else
+    pid_t pid = syscall(SYS_gettid);
+#endif
+
+    thread_affinity_mask.disable_all();
+
+    // the raw syscall returns the mask size copied on success
+    int syscallret = syscall(__NR_sched_getaffinity, pid, sizeof(cpu_set_t), &thread_affinity_mask.cpu_set);
+    if (syscallret < 0)
+    {
+        NCNN_LOGE("syscall error %d", syscallret);
+        return -1;
+    }
+
+    return 0;
+#elif (defined _WIN32 && !(defined __MINGW32__))
+    // there is no getter, swap in the full mask and put the previous one back
+    DWORD_PTR prev_mask = SetThreadAffinityMask(GetCurrentThread(), g_cpu_affinity_mask_all.mask);
+    if (prev_mask == 0)
+        return -1;
+
+    SetThreadAffinityMask(GetCurrentThread(), prev_mask);
+
+    thread_affinity_mask.mask = prev_mask;
+    return 0;
+#else
+    // TODO
+    (void)thread_affinity_mask;
+    return -1;
+#endif
+}
+
 int is_current_thread_running_on_a53_a55()
 {
     try_initialize_global_cpu_info();
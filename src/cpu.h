@@ -149,6 +149,19 @@ NCNN_EXPORT const CpuSet& get_cpu_thread_affinity_mask(int powersave);
 // set explicit thread affinity
 NCNN_EXPORT int set_cpu_thread_affinity(const CpuSet& thread_affinity_mask);
 
+// get the thread affinity of the calling thread
+// return 0 if success
+NCNN_EXPORT int get_cpu_thread_affinity(CpuSet& thread_affinity_mask);
+
+// numa nodes from /sys/devices/system/node, nodes without cpu are skipped
+// there is only one node covering all cpus on other platforms
+NCNN_EXPORT int get_cpu_numa_node_count();
+NCNN_EXPORT const CpuSet& get_cpu_numa_node_affinity_mask(int node);
+
+// spread the pages inside ptr range over all numa nodes
+// no-op on single node, return 0 if success
+NCNN_EXPORT int set_memory_numa_interleave(const void* ptr, size_t size);
+
 // runtime thread affinity info
 NCNN_EXPORT int is_current_thread_running_on_a53_a55();
 
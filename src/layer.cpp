@@ -85,6 +85,16 @@ int Layer::destroy_pipeline(const Option& /*opt*/)
     return 0;
 }
 
+int Layer::save_weight_cache(std::vector<Mat>& /*mats*/) const
+{
+    return -1;
+}
+
+int Layer::load_weight_cache(const std::vector<Mat>& /*mats*/, const Option& /*opt*/)
+{
+    return -1;
+}
+
 int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     if (!support_inplace)
@@ -56,6 +56,14 @@ public:
     // return 0 if success
     virtual int destroy_pipeline(const Option& opt);
 
+    // export the weights transformed in create_pipeline
+    // return 0 if success, -1 if the pipeline can not be cached
+    virtual int save_weight_cache(std::vector<Mat>& mats) const;
+
+    // restore the transformed weights exported by save_weight_cache in place of create_pipeline
+    // return 0 if success
+    virtual int load_weight_cache(const std::vector<Mat>& mats, const Option& opt);
+
 public:
     // one input and one output blob
     bool one_blob_only;
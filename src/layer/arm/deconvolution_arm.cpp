@@ -25,11 +25,17 @@
 
 #include "cpu.h"
 
+#include <string.h>
+
 namespace ncnn {
 
 #include "deconvolution_3x3.h"
 #include "deconvolution_4x4.h"
 
+#if NCNN_INT8
+#include "deconvolution_int8.h"
+#endif // NCNN_INT8
+
 Deconvolution_arm::Deconvolution_arm()
 {
 #if __ARM_NEON
@@ -49,6 +55,15 @@ Deconvolution_arm::Deconvolution_arm()
 
 int Deconvolution_arm::create_pipeline(const Option& opt)
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
+    {
+        support_fp16_storage = false;
+        support_bf16_storage = false;
+        return create_pipeline_int8_arm(opt);
+    }
+#endif
+
     activation = create_activation_layer(activation_type, activation_params, opt);
 
 #if NCNN_ARM82
@@ -237,6 +252,13 @@ int Deconvolution_arm::destroy_pipeline(const Option& opt)
 
 int Deconvolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && int8_scale_term)
+    {
+        return forward_int8_arm(bottom_blob, top_blob, opt);
+    }
+#endif
+
     int elembits = bottom_blob.elembits();
 
 #if NCNN_ARM82
@@ -1207,4 +1229,125 @@ int Deconvolution_arm::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, cons
 }
 #endif // NCNN_BF16
 
+#if NCNN_INT8
+int Deconvolution_arm::create_pipeline_int8_arm(const Option& opt)
+{
+    const int maxk = kernel_w * kernel_h;
+    const int num_input = weight_data_size / maxk / num_output;
+
+    deconvolution_transform_kernel_int8_neon(weight_data, weight_data_tm, num_input, num_output, maxk, opt);
+    if (weight_data_tm.empty())
+        return -100;
+
+    scale_in_data.create(num_output);
+    if (scale_in_data.empty())
+        return -100;
+
+    for (int p = 0; p < num_output; p++)
+    {
+        // dequantize
+        float scale_in;
+        if (weight_data_int8_scales[p] == 0)
+            scale_in = 0;
+        else
+            scale_in = 1.f / (bottom_blob_int8_scales[0] * weight_data_int8_scales[p]);
+
+        scale_in_data[p] = scale_in;
+    }
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int Deconvolution_arm::forward_int8_arm(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    Option opt_q = opt;
+    opt_q.blob_allocator = opt.workspace_allocator;
+
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_q);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    Mat bottom_blob_int8 = bottom_blob_unpacked;
+    if (bottom_blob_unpacked.elemsize != 1)
+    {
+        quantize_to_int8(bottom_blob_unpacked, bottom_blob_int8, bottom_blob_int8_scales, opt_q);
+        if (bottom_blob_int8.empty())
+            return -100;
+    }
+
+    const int w = bottom_blob_int8.w;
+    const int h = bottom_blob_int8.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    const int outw = (w - 1) * stride_w + kernel_extent_w + output_pad_right;
+    const int outh = (h - 1) * stride_h + kernel_extent_h + output_pad_bottom;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // col = kernel x input
+    Mat col;
+    {
+        Mat panel;
+        deconvolution_pack_input_int8_neon(bottom_blob_int8, panel, opt);
+        if (panel.empty())
+            return -100;
+
+        col.create(panel.h * 8, maxk * num_output, (size_t)4u, opt.workspace_allocator);
+        if (col.empty())
+            return -100;
+
+        deconvolution_gemm_int8_neon(panel, weight_data_tm, col, maxk * num_output, opt);
+    }
+
+    // dequantize to fp32, the padding is cut before requantize
+    bool use_int8_requantize = int8_scale_term > 100;
+
+    Mat top_blob_bordered;
+    if (use_int8_requantize || pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0 || (output_w > 0 && output_h > 0))
+    {
+        top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
+    }
+    else
+    {
+        top_blob_bordered = top_blob;
+        top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
+    }
+    if (top_blob_bordered.empty())
+        return -100;
+
+    int ret = deconvolution_col2im_int8_neon(col, top_blob_bordered, w, h, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, scale_in_data, bias_data, activation_type, activation_params, opt);
+    if (ret != 0)
+        return ret;
+
+    if (use_int8_requantize)
+    {
+        Mat top_blob_fp32;
+        cut_padding(top_blob_bordered, top_blob_fp32, opt_q);
+        if (top_blob_fp32.empty())
+            return -100;
+
+        quantize_to_int8(top_blob_fp32, top_blob, top_blob_int8_scales, opt);
+    }
+    else
+    {
+        cut_padding(top_blob_bordered, top_blob, opt);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 } // namespace ncnn
@@ -0,0 +1,258 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// int8 deconvolution as col = kernel x input followed by col2im
+// the products are widened to int16 and accumulated with vmlal_lane_s16
+//
+// kernel_tm : 4 rows of outch*maxk, inch interleaved
+// panel     : 8 columns of the input, inch interleaved
+// col       : outch*maxk rows of int32, one per input pixel
+
+static void deconvolution_transform_kernel_int8_neon(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int maxk, const Option& opt)
+{
+    // src = kw-kh-inch-outch
+    // dst = 4b-inch-(maxk*outch)/4b
+    const int M = maxk * outch;
+
+    kernel_tm.create(inch * 4, (M + 3) / 4, (size_t)2u);
+    if (kernel_tm.empty())
+        return;
+
+    const signed char* kptr = kernel;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii = 0; ii < (M + 3) / 4; ii++)
+    {
+        short* g00 = kernel_tm.row<short>(ii);
+
+        for (int k = 0; k < inch; k++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                const int m = ii * 4 + r;
+                const int p = m / maxk;
+                const int kk = m % maxk;
+
+                g00[0] = m < M ? kptr[(p * inch + k) * maxk + kk] : 0;
+                g00++;
+            }
+        }
+    }
+}
+
+static void deconvolution_pack_input_int8_neon(const Mat& bottom_blob, Mat& panel, const Option& opt)
+{
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int inch = bottom_blob.c;
+
+    const int nn_size = (size + 7) / 8;
+
+    panel.create(inch * 8, nn_size, (size_t)2u, opt.workspace_allocator);
+    if (panel.empty())
+        return;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jj = 0; jj < nn_size; jj++)
+    {
+        short* pp = panel.row<short>(jj);
+
+        for (int k = 0; k < inch; k++)
+        {
+            const signed char* p0 = (const signed char*)bottom_blob.channel(k) + jj * 8;
+
+            if (jj * 8 + 7 < size)
+            {
+#if __ARM_NEON
+                vst1q_s16(pp, vmovl_s8(vld1_s8(p0)));
+#else
+                for (int j = 0; j < 8; j++)
+                {
+                    pp[j] = p0[j];
+                }
+#endif
+            }
+            else
+            {
+                for (int j = 0; j < 8; j++)
+                {
+                    pp[j] = jj * 8 + j < size ? p0[j] : 0;
+                }
+            }
+
+            pp += 8;
+        }
+    }
+}
+
+static void deconvolution_gemm_int8_neon(const Mat& panel, const Mat& kernel_tm, Mat& col, int M, const Option& opt)
+{
+    const int K = kernel_tm.w / 4;
+    const int nn_size = panel.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii = 0; ii < (M + 3) / 4; ii++)
+    {
+        const int m = ii * 4;
+
+        for (int jj = 0; jj < nn_size; jj++)
+        {
+            const short* pA = kernel_tm.row<const short>(ii);
+            const short* pB = panel.row<const short>(jj);
+
+            int* outptr0 = col.row<int>(m) + jj * 8;
+            int* outptr1 = m + 1 < M ? col.row<int>(m + 1) + jj * 8 : 0;
+            int* outptr2 = m + 2 < M ? col.row<int>(m + 2) + jj * 8 : 0;
+            int* outptr3 = m + 3 < M ? col.row<int>(m + 3) + jj * 8 : 0;
+
+#if __ARM_NEON
+            int32x4_t _sum00 = vdupq_n_s32(0);
+            int32x4_t _sum01 = vdupq_n_s32(0);
+            int32x4_t _sum10 = vdupq_n_s32(0);
+            int32x4_t _sum11 = vdupq_n_s32(0);
+            int32x4_t _sum20 = vdupq_n_s32(0);
+            int32x4_t _sum21 = vdupq_n_s32(0);
+            int32x4_t _sum30 = vdupq_n_s32(0);
+            int32x4_t _sum31 = vdupq_n_s32(0);
+
+            for (int k = 0; k < K; k++)
+            {
+                int16x4_t _pA = vld1_s16(pA);
+                int16x8_t _pB = vld1q_s16(pB);
+
+                _sum00 = vmlal_lane_s16(_sum00, vget_low_s16(_pB), _pA, 0);
+                _sum01 = vmlal_lane_s16(_sum01, vget_high_s16(_pB), _pA, 0);
+                _sum10 = vmlal_lane_s16(_sum10, vget_low_s16(_pB), _pA, 1);
+                _sum11 = vmlal_lane_s16(_sum11, vget_high_s16(_pB), _pA, 1);
+                _sum20 = vmlal_lane_s16(_sum20, vget_low_s16(_pB), _pA, 2);
+                _sum21 = vmlal_lane_s16(_sum21, vget_high_s16(_pB), _pA, 2);
+                _sum30 = vmlal_lane_s16(_sum30, vget_low_s16(_pB), _pA, 3);
+                _sum31 = vmlal_lane_s16(_sum31, vget_high_s16(_pB), _pA, 3);
+
+                pA += 4;
+                pB += 8;
+            }
+
+            vst1q_s32(outptr0, _sum00);
+            vst1q_s32(outptr0 + 4, _sum01);
+            if (outptr1)
+            {
+                vst1q_s32(outptr1, _sum10);
+                vst1q_s32(outptr1 + 4, _sum11);
+            }
+            if (outptr2)
+            {
+                vst1q_s32(outptr2, _sum20);
+                vst1q_s32(outptr2 + 4, _sum21);
+            }
+            if (outptr3)
+            {
+                vst1q_s32(outptr3, _sum30);
+                vst1q_s32(outptr3 + 4, _sum31);
+            }
+#else
+            int sum[4][8] = {{0}};
+
+            for (int k = 0; k < K; k++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    for (int j = 0; j < 8; j++)
+                    {
+                        sum[r][j] += pA[r] * pB[j];
+                    }
+                }
+
+                pA += 4;
+                pB += 8;
+            }
+
+            for (int j = 0; j < 8; j++)
+            {
+                outptr0[j] = sum[0][j];
+                if (outptr1) outptr1[j] = sum[1][j];
+                if (outptr2) outptr2[j] = sum[2][j];
+                if (outptr3) outptr3[j] = sum[3][j];
+            }
+#endif // __ARM_NEON
+        }
+    }
+}
+
+static void deconvolution_dequantize_int8_neon(const int* sumptr, float* outptr, int size, float scale_in, float bias, int activation_type, const Mat& activation_params)
+{
+    int i = 0;
+#if __ARM_NEON
+    float32x4_t _scale_in = vdupq_n_f32(scale_in);
+    float32x4_t _bias = vdupq_n_f32(bias);
+    for (; i + 3 < size; i += 4)
+    {
+        float32x4_t _v = vcvtq_f32_s32(vld1q_s32(sumptr + i));
+        _v = vmlaq_f32(_bias, _v, _scale_in);
+        _v = activation_ps(_v, activation_type, activation_params);
+        vst1q_f32(outptr + i, _v);
+    }
+#endif // __ARM_NEON
+    for (; i < size; i++)
+    {
+        outptr[i] = activation_ss(sumptr[i] * scale_in + bias, activation_type, activation_params);
+    }
+}
+
+static int deconvolution_col2im_int8_neon(const Mat& col, Mat& top_blob, int w, int h, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Mat& scale_in_data, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch = top_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // one int32 accumulator per thread
+    Mat sum_int32(outw * outh, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    if (sum_int32.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < outch; p++)
+    {
+        int* sumptr = sum_int32.row<int>(get_omp_thread_num());
+
+        memset(sumptr, 0, outw * outh * sizeof(int));
+
+        for (int u = 0; u < kernel_h; u++)
+        {
+            for (int v = 0; v < kernel_w; v++)
+            {
+                const int* colptr = col.row<const int>(p * maxk + u * kernel_w + v);
+
+                for (int i = 0; i < h; i++)
+                {
+                    int* outptr = sumptr + (i * stride_h + u * dilation_h) * outw + v * dilation_w;
+
+                    for (int j = 0; j < w; j++)
+                    {
+                        outptr[j * stride_w] += colptr[j];
+                    }
+
+                    colptr += w;
+                }
+            }
+        }
+
+        const float bias = bias_data.empty() ? 0.f : bias_data[p];
+
+        deconvolution_dequantize_int8_neon(sumptr, top_blob.channel(p), outw * outh, scale_in_data[p], bias, activation_type, activation_params);
+    }
+
+    return 0;
+}
@@ -25,6 +25,8 @@
 
 #include "cpu.h"
 
+#include <string.h>
+
 namespace ncnn {
 
 DeconvolutionDepthWise_arm::DeconvolutionDepthWise_arm()
@@ -43,6 +45,15 @@ DeconvolutionDepthWise_arm::DeconvolutionDepthWise_arm()
 
 int DeconvolutionDepthWise_arm::create_pipeline(const Option& opt)
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
+    {
+        support_fp16_storage = false;
+        support_bf16_storage = false;
+        return create_pipeline_int8_arm(opt);
+    }
+#endif
+
 #if NCNN_ARM82
     if (support_fp16_storage && opt.use_fp16_storage)
     {
@@ -128,71 +139,111 @@ int DeconvolutionDepthWise_arm::create_pipeline(const Option& opt)
     else
     {
         // group deconvolution
-        for (int i = 0; i < (int)group_ops.size(); i++)
-            delete group_ops[i];
+        create_group_ops(opt);
+    }
 
-        group_ops.clear();
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
 
-        const int channels_g = channels / group;
-        const int num_output_g = num_output / group;
+    return 0;
+}
 
-        group_ops.resize(group);
+int DeconvolutionDepthWise_arm::create_group_ops(const Option& opt)
+{
+    // create Deconvolution op for each group
+    const int maxk = kernel_w * kernel_h;
+    int channels = (weight_data_size / group) / maxk / (num_output / group) * group;
 
-        for (int g = 0; g < group; g++)
+    for (int i = 0; i < (int)group_ops.size(); i++)
+        delete group_ops[i];
+
+    group_ops.clear();
+
+    const int channels_g = channels / group;
+    const int num_output_g = num_output / group;
+
+    group_ops.resize(group);
+
+    for (int g = 0; g < group; g++)
+    {
+        Mat weight_data_g = weight_data.range(maxk * channels_g * num_output_g * g, maxk * channels_g * num_output_g).clone();
+        Mat bias_data_g;
+        if (bias_term)
+            bias_data_g = bias_data.range(num_output_g * g, num_output_g);
+
+        ncnn::Layer* op = ncnn::create_layer(ncnn::LayerType::Deconvolution);
+
+        // set param
+        ncnn::ParamDict pd;
+        pd.set(0, num_output_g); // num_output
+        pd.set(1, kernel_w);
+        pd.set(11, kernel_h);
+        pd.set(2, dilation_w);
+        pd.set(12, dilation_h);
+        pd.set(3, stride_w);
+        pd.set(13, stride_h);
+        pd.set(4, 0);  // pad_w
+        pd.set(14, 0); // pad_h
+        pd.set(18, output_pad_right);
+        pd.set(19, output_pad_bottom);
+        pd.set(5, bias_term);
+        pd.set(6, maxk * channels_g * num_output_g); // weight_data_size
+        pd.set(8, int8_scale_term);
+        pd.set(9, activation_type);
+        pd.set(10, activation_params);
+
+        op->load_param(pd);
+
+        // set weights
+        if (bias_term)
         {
-            Mat weight_data_g = weight_data.range(maxk * channels_g * num_output_g * g, maxk * channels_g * num_output_g).clone();
-            Mat bias_data_g;
-            if (bias_term)
-                bias_data_g = bias_data.range(num_output_g * g, num_output_g);
-
-            ncnn::Layer* op = ncnn::create_layer(ncnn::LayerType::Deconvolution);
-
-            // set param
-            ncnn::ParamDict pd;
-            pd.set(0, num_output_g); // num_output
-            pd.set(1, kernel_w);
-            pd.set(11, kernel_h);
-            pd.set(2, dilation_w);
-            pd.set(12, dilation_h);
-            pd.set(3, stride_w);
-            pd.set(13, stride_h);
-            pd.set(4, 0);  // pad_w
-            pd.set(14, 0); // pad_h
-            pd.set(18, output_pad_right);
-            pd.set(19, output_pad_bottom);
-            pd.set(5, bias_term);
-            pd.set(6, maxk * channels_g * num_output_g); // weight_data_size
-            pd.set(9, activation_type);
-            pd.set(10, activation_params);
-
-            op->load_param(pd);
-
-            // set weights
-            if (bias_term)
-            {
-                ncnn::Mat weights[2];
-                weights[0] = weight_data_g;
-                weights[1] = bias_data_g;
+            ncnn::Mat weights[5];
+            weights[0] = weight_data_g;
+            weights[1] = bias_data_g;
 
-                op->load_model(ModelBinFromMatArray(weights));
+#if NCNN_INT8
+            if (int8_scale_term)
+            {
+                Mat weight_data_int8_scales_g(num_output_g);
+                weight_data_int8_scales_g.fill(weight_data_int8_scales[g]);
+                weights[2] = weight_data_int8_scales_g;
+                weights[3] = bottom_blob_int8_scales.range(g, 1);
             }
-            else
+            if (int8_scale_term > 100)
             {
-                ncnn::Mat weights[1];
-                weights[0] = weight_data_g;
-
-                op->load_model(ModelBinFromMatArray(weights));
+                weights[4] = top_blob_int8_scales.range(g, 1);
             }
+#endif
 
-            op->create_pipeline(opt);
+            op->load_model(ModelBinFromMatArray(weights));
+        }
+        else
+        {
+            ncnn::Mat weights[4];
+            weights[0] = weight_data_g;
+
+#if NCNN_INT8
+            if (int8_scale_term)
+            {
+                Mat weight_data_int8_scales_g(num_output_g);
+                weight_data_int8_scales_g.fill(weight_data_int8_scales[g]);
+                weights[1] = weight_data_int8_scales_g;
+                weights[2] = bottom_blob_int8_scales.range(g, 1);
+            }
+            if (int8_scale_term > 100)
+            {
+                weights[3] = top_blob_int8_scales.range(g, 1);
+            }
+#endif
 
-            group_ops[g] = op;
+            op->load_model(ModelBinFromMatArray(weights));
         }
-    }
 
-    if (opt.lightmode)
-    {
-        weight_data.release();
+        op->create_pipeline(opt);
+
+        group_ops[g] = op;
     }
 
     return 0;
@@ -212,6 +263,13 @@ int DeconvolutionDepthWise_arm::destroy_pipeline(const Option& opt)
 
 int DeconvolutionDepthWise_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && int8_scale_term)
+    {
+        return forward_int8_arm(bottom_blob, top_blob, opt);
+    }
+#endif
+
     int elembits = bottom_blob.elembits();
 
 #if NCNN_ARM82
@@ -736,4 +794,228 @@ int DeconvolutionDepthWise_arm::forward_bf16s(const Mat& bottom_blob, Mat& top_b
 }
 #endif // NCNN_BF16
 
+#if NCNN_INT8
+int DeconvolutionDepthWise_arm::create_pipeline_int8_arm(const Option& opt)
+{
+    const int maxk = kernel_w * kernel_h;
+    int channels = (weight_data_size / group) / maxk / (num_output / group) * group;
+
+    // depth-wise
+    if (channels == group && group == num_output)
+    {
+        weight_data_tm = weight_data;
+
+        scale_in_data.create(group);
+        if (scale_in_data.empty())
+            return -100;
+
+        for (int g = 0; g < group; g++)
+        {
+            // dequantize
+            float scale_in;
+            if (weight_data_int8_scales[g] == 0)
+                scale_in = 0;
+            else
+                scale_in = 1.f / (bottom_blob_int8_scales[g] * weight_data_int8_scales[g]);
+
+            scale_in_data[g] = scale_in;
+        }
+
+        return 0;
+    }
+
+    // group deconvolution
+    create_group_ops(opt);
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int DeconvolutionDepthWise_arm::forward_int8_arm(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    Option opt_q = opt;
+    opt_q.blob_allocator = opt.workspace_allocator;
+
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_q);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    const int w = bottom_blob_unpacked.w;
+    const int h = bottom_blob_unpacked.h;
+    const int channels = bottom_blob_unpacked.c;
+
+    const int channels_g = channels / group;
+    const int num_output_g = num_output / group;
+
+    Mat bottom_blob_int8 = bottom_blob_unpacked;
+    if (bottom_blob_unpacked.elemsize != 1)
+    {
+        Mat scales(channels);
+        {
+            float* ps = scales;
+            for (int g = 0; g < group; g++)
+            {
+                float scale = bottom_blob_int8_scales[g];
+                for (int q = 0; q < channels_g; q++)
+                {
+                    *ps++ = scale;
+                }
+            }
+        }
+
+        quantize_to_int8(bottom_blob_unpacked, bottom_blob_int8, scales, opt_q);
+        if (bottom_blob_int8.empty())
+            return -100;
+    }
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    const int outw = (w - 1) * stride_w + kernel_extent_w + output_pad_right;
+    const int outh = (h - 1) * stride_h + kernel_extent_h + output_pad_bottom;
+
+    bool use_int8_requantize = int8_scale_term > 100;
+
+    // depth-wise
+    if (channels == group && group == num_output)
+    {
+        // dequantize to fp32, the padding is cut before requantize
+        Mat top_blob_bordered;
+        if (use_int8_requantize || pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0 || (output_w > 0 && output_h > 0))
+        {
+            top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
+        }
+        else
+        {
+            top_blob_bordered = top_blob;
+            top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
+        }
+        if (top_blob_bordered.empty())
+            return -100;
+
+        // one int32 accumulator per thread
+        Mat sum_int32(outw * outh, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+        if (sum_int32.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int g = 0; g < group; g++)
+        {
+            int* sumptr = sum_int32.row<int>(get_omp_thread_num());
+
+            memset(sumptr, 0, outw * outh * sizeof(int));
+
+            const signed char* kptr = (const signed char*)weight_data_tm + kernel_w * kernel_h * g;
+
+            for (int u = 0; u < kernel_h; u++)
+            {
+                for (int v = 0; v < kernel_w; v++)
+                {
+                    const signed char* sptr = bottom_blob_int8.channel(g);
+                    const int wt = kptr[u * kernel_w + v];
+
+                    for (int i = 0; i < h; i++)
+                    {
+                        int* outptr = sumptr + (i * stride_h + u * dilation_h) * outw + v * dilation_w;
+
+                        for (int j = 0; j < w; j++)
+                        {
+                            outptr[j * stride_w] += sptr[j] * wt;
+                        }
+
+                        sptr += w;
+                    }
+                }
+            }
+
+            const float scale_in = scale_in_data[g];
+            const float bias = bias_term ? bias_data[g] : 0.f;
+
+            float* outptr = top_blob_bordered.channel(g);
+
+            int i = 0;
+#if __ARM_NEON
+            float32x4_t _scale_in = vdupq_n_f32(scale_in);
+            float32x4_t _bias = vdupq_n_f32(bias);
+            for (; i + 3 < outw * outh; i += 4)
+            {
+                float32x4_t _v = vcvtq_f32_s32(vld1q_s32(sumptr + i));
+                _v = vmlaq_f32(_bias, _v, _scale_in);
+                _v = activation_ps(_v, activation_type, activation_params);
+                vst1q_f32(outptr + i, _v);
+            }
+#endif // __ARM_NEON
+            for (; i < outw * outh; i++)
+            {
+                outptr[i] = activation_ss(sumptr[i] * scale_in + bias, activation_type, activation_params);
+            }
+        }
+
+        if (use_int8_requantize)
+        {
+            Mat top_blob_fp32;
+            cut_padding(top_blob_bordered, top_blob_fp32, opt_q);
+            if (top_blob_fp32.empty())
+                return -100;
+
+            quantize_to_int8(top_blob_fp32, top_blob, top_blob_int8_scales, opt);
+        }
+        else
+        {
+            cut_padding(top_blob_bordered, top_blob, opt);
+        }
+        if (top_blob.empty())
+            return -100;
+
+        return 0;
+    }
+
+    // group deconvolution
+    size_t out_elemsize = use_int8_requantize ? 1u : 4u;
+
+    Mat top_blob_bordered;
+    if (pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0 || (output_w > 0 && output_h > 0))
+    {
+        top_blob_bordered.create(outw, outh, num_output, out_elemsize, opt.workspace_allocator);
+    }
+    else
+    {
+        top_blob_bordered = top_blob;
+        top_blob_bordered.create(outw, outh, num_output, out_elemsize, opt.blob_allocator);
+    }
+    if (top_blob_bordered.empty())
+        return -100;
+
+    for (int g = 0; g < group; g++)
+    {
+        const Mat bottom_blob_g = bottom_blob_int8.channel_range(channels_g * g, channels_g);
+        Mat top_blob_bordered_g = top_blob_bordered.channel_range(num_output_g * g, num_output_g);
+
+        const ncnn::Layer* op = group_ops[g];
+
+        Option opt_g = opt;
+        opt_g.blob_allocator = top_blob_bordered.allocator;
+
+        // forward
+        int ret = op->forward(bottom_blob_g, top_blob_bordered_g, opt_g);
+        if (ret != 0)
+            return ret;
+    }
+
+    cut_padding(top_blob_bordered, top_blob, opt);
+    if (top_blob.empty())
+        return -100;
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 } // namespace ncnn
@@ -24,6 +24,9 @@ Convolution::Convolution()
 {
     one_blob_only = true;
     support_inplace = false;
+
+    fuse_residual = 0;
+    residual_activation_type = 0;
 }
 
 int Convolution::load_param(const ParamDict& pd)
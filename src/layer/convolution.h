@@ -68,6 +68,12 @@ public:
 
     int dynamic_weight;
 
+    // set by net layer fusion, not a param
+    // top = activation(conv(bottom) + residual) where residual is the second input
+    int fuse_residual;
+    int residual_activation_type;
+    Mat residual_activation_params;
+
     // model
     Mat weight_data;
     Mat bias_data;
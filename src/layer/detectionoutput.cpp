@@ -14,6 +14,7 @@
 
 #include "detectionoutput.h"
 
+#include <algorithm>
 #include <math.h>
 
 namespace ncnn {
@@ -62,46 +63,44 @@ static inline float intersection_area(const BBoxRect& a, const BBoxRect& b)
     return inter_width * inter_height;
 }
 
-template<typename T>
-static void qsort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores, int left, int right)
+// boxes of equal score keep their order so that the result does not depend on the sort
+struct sort_descent_compare
 {
-    int i = left;
-    int j = right;
-    float p = scores[(left + right) / 2];
+    const float* scores;
 
-    while (i <= j)
+    bool operator()(size_t a, size_t b) const
     {
-        while (scores[i] > p)
-            i++;
-
-        while (scores[j] < p)
-            j--;
-
-        if (i <= j)
-        {
-            // swap
-            std::swap(datas[i], datas[j]);
-            std::swap(scores[i], scores[j]);
-
-            i++;
-            j--;
-        }
+        return scores[a] > scores[b];
     }
-
-    if (left < j)
-        qsort_descent_inplace(datas, scores, left, j);
-
-    if (i < right)
-        qsort_descent_inplace(datas, scores, i, right);
-}
+};
 
 template<typename T>
-static void qsort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores)
+static void sort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores)
 {
     if (datas.empty() || scores.empty())
         return;
 
-    qsort_descent_inplace(datas, scores, 0, static_cast<int>(scores.size() - 1));
+    const size_t n = scores.size();
+
+    std::vector<size_t> indices(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        indices[i] = i;
+    }
+
+    sort_descent_compare comp = {&scores[0]};
+    std::stable_sort(indices.begin(), indices.end(), comp);
+
+    std::vector<T> sorted_datas(n);
+    std::vector<float> sorted_scores(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        sorted_datas[i] = datas[indices[i]];
+        sorted_scores[i] = scores[indices[i]];
+    }
+
+    datas.swap(sorted_datas);
+    scores.swap(sorted_scores);
 }
 
 static void nms_sorted_bboxes(const std::vector<BBoxRect>& bboxes, std::vector<size_t>& picked, float nms_threshold)
@@ -229,7 +228,7 @@ int DetectionOutput::forward(const std::vector<Mat>& bottom_blobs, std::vector<M
         }
 
         // sort inplace
-        qsort_descent_inplace(class_bbox_rects, class_bbox_scores);
+        sort_descent_inplace(class_bbox_rects, class_bbox_scores);
 
         // keep nms_top_k
         if (nms_top_k < (int)class_bbox_rects.size())
@@ -265,7 +264,7 @@ int DetectionOutput::forward(const std::vector<Mat>& bottom_blobs, std::vector<M
     }
 
     // global sort inplace
-    qsort_descent_inplace(bbox_rects, bbox_scores);
+    sort_descent_inplace(bbox_rects, bbox_scores);
 
     // keep_top_k
     if (keep_top_k < (int)bbox_rects.size())
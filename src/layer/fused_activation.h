@@ -70,6 +70,20 @@ static NCNN_FORCEINLINE float activation_ss(float v, int activation_type, const
             v = v * (v * alpha + beta);
         break;
     }
+    case 7:
+    {
+        v = v / (1.f + expf(-v));
+        break;
+    }
+    case 8:
+    {
+        float fast_gelu = activation_params[0];
+        if (fast_gelu != 0.f)
+            v = 0.5f * v * (1.0f + tanhf(0.79788452f * (v + 0.044715f * v * v * v)));
+        else
+            v = 0.5f * v * erfcf(-0.70710678f * v);
+        break;
+    }
     }
 
     return v;
@@ -128,6 +142,21 @@ static ncnn::Layer* create_activation_layer(int activation_type, const ncnn::Mat
 
         activation->load_param(pd);
     }
+    else if (activation_type == 7)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::Swish);
+
+        ncnn::ParamDict pd;
+        activation->load_param(pd);
+    }
+    else if (activation_type == 8)
+    {
+        activation = ncnn::create_layer(ncnn::LayerType::GELU);
+
+        ncnn::ParamDict pd;
+        pd.set(0, (int)activation_params[0]); // fast_gelu
+        activation->load_param(pd);
+    }
 
     if (activation)
     {
@@ -14,12 +14,17 @@
 
 #include "gemm.h"
 
+#include "fused_activation.h"
+
 namespace ncnn {
 
 Gemm::Gemm()
 {
     one_blob_only = false;
     support_inplace = false;
+
+    fuse_residual = 0;
+    activation_type = 0;
 }
 
 int Gemm::load_param(const ParamDict& pd)
@@ -308,6 +313,8 @@ int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
 
             sum *= alpha;
 
+            sum = activation_ss(sum, activation_type, activation_params);
+
             if (output_transpose)
             {
                 top_blob[j * out_hstep + i] = sum;
@@ -54,6 +54,15 @@ public:
     int constant_TILE_N;
     int constant_TILE_K;
 
+    // set by net layer fusion, not a param
+    // the trailing input is the residual addend taken as C
+    int fuse_residual;
+
+    // set by net layer fusion, not a param
+    // applied to the output, see fused_activation.h
+    int activation_type;
+    Mat activation_params;
+
     // constant A / B / C
     Mat A_data;
     Mat B_data;
@@ -14,6 +14,7 @@
 
 #include "gru.h"
 
+#include <algorithm>
 #include <math.h>
 
 namespace ncnn {
@@ -29,6 +30,16 @@ int GRU::load_param(const ParamDict& pd)
     num_output = pd.get(0, 0);
     weight_data_size = pd.get(1, 0);
     direction = pd.get(2, 0);
+    int8_scale_term = pd.get(8, 0);
+
+    if (int8_scale_term)
+    {
+#if !NCNN_INT8
+        NCNN_LOGE("please build ncnn with NCNN_INT8 enabled for int8 inference");
+        return -1;
+#endif
+    }
+
     return 0;
 }
 
@@ -51,6 +62,14 @@ int GRU::load_model(const ModelBin& mb)
     if (weight_hc_data.empty())
         return -100;
 
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        weight_xc_data_int8_scales = mb.load(num_output * 3, num_directions, 1);
+        weight_hc_data_int8_scales = mb.load(num_output * 3, num_directions, 1);
+    }
+#endif // NCNN_INT8
+
     return 0;
 }
 
@@ -162,6 +181,182 @@ static int gru(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& we
     return 0;
 }
 
+#if NCNN_INT8
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+static float dynamic_quantize(const float* ptr, signed char* outptr, int size)
+{
+    float absmax = 0.f;
+    for (int i = 0; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(ptr[i]));
+    }
+
+    const float scale = absmax == 0.f ? 1.f : 127.f / absmax;
+
+    for (int i = 0; i < size; i++)
+    {
+        outptr[i] = float2int8(ptr[i] * scale);
+    }
+
+    // descale
+    return 1.f / scale;
+}
+
+static int gru_dynamic_quantize(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc_int8, const float* weight_xc_int8_scales, const Mat& bias_c, const Mat& weight_hc_int8, const float* weight_hc_int8_scales, Mat& hidden_state, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    int num_output = top_blob.w;
+
+    // dynamic quantize bottom_blob, one scale per timestep
+    Mat bottom_blob_int8(size, T, (size_t)1u, opt.workspace_allocator);
+    if (bottom_blob_int8.empty())
+        return -100;
+
+    Mat bottom_blob_int8_descales(T, 4u, opt.workspace_allocator);
+    if (bottom_blob_int8_descales.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < T; t++)
+    {
+        bottom_blob_int8_descales[t] = dynamic_quantize(bottom_blob.row(t), bottom_blob_int8.row<signed char>(t), size);
+    }
+
+    Mat hidden_state_int8(num_output, (size_t)1u, opt.workspace_allocator);
+    if (hidden_state_int8.empty())
+        return -100;
+
+    // 2 x num_output
+    Mat gates(2, num_output, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        const signed char* x = bottom_blob_int8.row<const signed char>(ti);
+        const float descale_x = bottom_blob_int8_descales[ti];
+
+        // dynamic quantize hidden_state
+        const signed char* h = hidden_state_int8;
+        const float descale_h = dynamic_quantize(hidden_state, hidden_state_int8, num_output);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < num_output; q++)
+        {
+            float* gates_data = gates.row(q);
+
+            // gate reset update
+            const float* bias_c_R = bias_c.row(0);
+            const float* bias_c_U = bias_c.row(1);
+
+            const signed char* weight_xc_R = weight_xc_int8.row<const signed char>(num_output * 0 + q);
+            const signed char* weight_xc_U = weight_xc_int8.row<const signed char>(num_output * 1 + q);
+            const signed char* weight_hc_R = weight_hc_int8.row<const signed char>(num_output * 0 + q);
+            const signed char* weight_hc_U = weight_hc_int8.row<const signed char>(num_output * 1 + q);
+
+            int Rx = 0;
+            int Ux = 0;
+            for (int i = 0; i < size; i++)
+            {
+                int xi = x[i];
+
+                Rx += weight_xc_R[i] * xi;
+                Ux += weight_xc_U[i] * xi;
+            }
+
+            int Rh = 0;
+            int Uh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                int h_cont = h[i];
+
+                Rh += weight_hc_R[i] * h_cont;
+                Uh += weight_hc_U[i] * h_cont;
+            }
+
+            const float descale_xc_R = weight_xc_int8_scales[num_output * 0 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[num_output * 0 + q];
+            const float descale_xc_U = weight_xc_int8_scales[num_output * 1 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[num_output * 1 + q];
+            const float descale_hc_R = weight_hc_int8_scales[num_output * 0 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[num_output * 0 + q];
+            const float descale_hc_U = weight_hc_int8_scales[num_output * 1 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[num_output * 1 + q];
+
+            float R = bias_c_R[q] + Rx * descale_xc_R + Rh * descale_hc_R;
+            float U = bias_c_U[q] + Ux * descale_xc_U + Uh * descale_hc_U;
+
+            // sigmoid(R)
+            // sigmoid(U)
+            R = 1.f / (1.f + expf(-R));
+            U = 1.f / (1.f + expf(-U));
+
+            // gate new
+            const float* bias_c_WN = bias_c.row(2);
+            const float* bias_c_BN = bias_c.row(3);
+
+            const signed char* weight_xc_N = weight_xc_int8.row<const signed char>(num_output * 2 + q);
+            const signed char* weight_hc_N = weight_hc_int8.row<const signed char>(num_output * 2 + q);
+
+            int Nh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                int h_cont = h[i];
+
+                Nh += weight_hc_N[i] * h_cont;
+            }
+
+            int Nx = 0;
+            for (int i = 0; i < size; i++)
+            {
+                int xi = x[i];
+
+                Nx += weight_xc_N[i] * xi;
+            }
+
+            const float descale_xc_N = weight_xc_int8_scales[num_output * 2 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[num_output * 2 + q];
+            const float descale_hc_N = weight_hc_int8_scales[num_output * 2 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[num_output * 2 + q];
+
+            float N = bias_c_BN[q] + Nh * descale_hc_N;
+
+            N = bias_c_WN[q] + R * N + Nx * descale_xc_N;
+
+            // tanh(N)
+            N = tanhf(N);
+
+            gates_data[0] = U;
+            gates_data[1] = N;
+        }
+
+        // h_t := (1 - update) .* new + update .* h_{t-1}
+        float* output_data = top_blob.row(ti);
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < num_output; q++)
+        {
+            const float* gates_data = gates.row(q);
+
+            float U = gates_data[0];
+            float N = gates_data[1];
+
+            float H = (1 - U) * N + U * hidden_state[q];
+
+            hidden_state[q] = H;
+            output_data[q] = H;
+        }
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 int GRU::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int T = bottom_blob.h;
@@ -181,9 +376,20 @@ int GRU::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
     // Uni directional
     if (direction == 0 || direction == 1)
     {
-        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
-        if (ret != 0)
-            return ret;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret = gru_dynamic_quantize(bottom_blob, top_blob, direction, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+        else
+#endif
+        {
+            int ret = gru(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
     }
 
     if (direction == 2)
@@ -196,15 +402,37 @@ int GRU::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
         if (top_blob_reverse.empty())
             return -100;
 
-        int ret0 = gru(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
-        if (ret0 != 0)
-            return ret0;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret0 = gru_dynamic_quantize(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), hidden, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
+        else
+#endif
+        {
+            int ret0 = gru(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
 
         hidden.fill(0.0f);
 
-        int ret1 = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), hidden, opt);
-        if (ret1 != 0)
-            return ret1;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret1 = gru_dynamic_quantize(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), weight_xc_data_int8_scales.row(1), bias_c_data.channel(1), weight_hc_data.channel(1), weight_hc_data_int8_scales.row(1), hidden, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
+        else
+#endif
+        {
+            int ret1 = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), hidden, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
 
         // concat w
         for (int i = 0; i < T; i++)
@@ -249,9 +477,20 @@ int GRU::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blo
     // Uni directional
     if (direction == 0 || direction == 1)
     {
-        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
-        if (ret != 0)
-            return ret;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret = gru_dynamic_quantize(bottom_blob, top_blob, direction, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+        else
+#endif
+        {
+            int ret = gru(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
     }
 
     if (direction == 2)
@@ -265,14 +504,36 @@ int GRU::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blo
             return -100;
 
         Mat hidden0 = hidden.row_range(0, 1);
-        int ret0 = gru(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden0, opt);
-        if (ret0 != 0)
-            return ret0;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret0 = gru_dynamic_quantize(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), hidden0, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
+        else
+#endif
+        {
+            int ret0 = gru(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), hidden0, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
 
         Mat hidden1 = hidden.row_range(1, 1);
-        int ret1 = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), hidden1, opt);
-        if (ret1 != 0)
-            return ret1;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret1 = gru_dynamic_quantize(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), weight_xc_data_int8_scales.row(1), bias_c_data.channel(1), weight_hc_data.channel(1), weight_hc_data_int8_scales.row(1), hidden1, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
+        else
+#endif
+        {
+            int ret1 = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), hidden1, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
 
         // concat w
         for (int i = 0; i < T; i++)
@@ -14,6 +14,7 @@
 
 #include "lstm.h"
 
+#include <algorithm>
 #include <math.h>
 
 namespace ncnn {
@@ -30,6 +31,16 @@ int LSTM::load_param(const ParamDict& pd)
     weight_data_size = pd.get(1, 0);
     direction = pd.get(2, 0);
     hidden_size = pd.get(3, num_output);
+    int8_scale_term = pd.get(8, 0);
+
+    if (int8_scale_term)
+    {
+#if !NCNN_INT8
+        NCNN_LOGE("please build ncnn with NCNN_INT8 enabled for int8 inference");
+        return -1;
+#endif
+    }
+
     return 0;
 }
 
@@ -59,6 +70,14 @@ int LSTM::load_model(const ModelBin& mb)
             return -100;
     }
 
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        weight_xc_data_int8_scales = mb.load(hidden_size * 4, num_directions, 1);
+        weight_hc_data_int8_scales = mb.load(hidden_size * 4, num_directions, 1);
+    }
+#endif // NCNN_INT8
+
     return 0;
 }
 
@@ -208,6 +227,205 @@ static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& w
     return 0;
 }
 
+#if NCNN_INT8
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+static float dynamic_quantize(const float* ptr, signed char* outptr, int size)
+{
+    float absmax = 0.f;
+    for (int i = 0; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(ptr[i]));
+    }
+
+    const float scale = absmax == 0.f ? 1.f : 127.f / absmax;
+
+    for (int i = 0; i < size; i++)
+    {
+        outptr[i] = float2int8(ptr[i] * scale);
+    }
+
+    // descale
+    return 1.f / scale;
+}
+
+static int lstm_dynamic_quantize(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc_int8, const float* weight_xc_int8_scales, const Mat& bias_c, const Mat& weight_hc_int8, const float* weight_hc_int8_scales, const Mat& weight_hr, Mat& hidden_state, Mat& cell_state, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    int num_output = top_blob.w;
+    int hidden_size = cell_state.w;
+
+    // dynamic quantize bottom_blob, one scale per timestep
+    Mat bottom_blob_int8(size, T, (size_t)1u, opt.workspace_allocator);
+    if (bottom_blob_int8.empty())
+        return -100;
+
+    Mat bottom_blob_int8_descales(T, 4u, opt.workspace_allocator);
+    if (bottom_blob_int8_descales.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < T; t++)
+    {
+        bottom_blob_int8_descales[t] = dynamic_quantize(bottom_blob.row(t), bottom_blob_int8.row<signed char>(t), size);
+    }
+
+    Mat hidden_state_int8(num_output, (size_t)1u, opt.workspace_allocator);
+    if (hidden_state_int8.empty())
+        return -100;
+
+    // 4 x hidden_size
+    Mat gates(4, hidden_size, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    Mat tmp_hidden_state;
+    if (num_output != hidden_size)
+    {
+        tmp_hidden_state.create(hidden_size, 4u, opt.workspace_allocator);
+        if (tmp_hidden_state.empty())
+            return -100;
+    }
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        const signed char* x = bottom_blob_int8.row<const signed char>(ti);
+        const float descale_x = bottom_blob_int8_descales[ti];
+
+        // dynamic quantize hidden_state
+        const signed char* h = hidden_state_int8;
+        const float descale_h = dynamic_quantize(hidden_state, hidden_state_int8, num_output);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < hidden_size; q++)
+        {
+            const float* bias_c_I = bias_c.row(0);
+            const float* bias_c_F = bias_c.row(1);
+            const float* bias_c_O = bias_c.row(2);
+            const float* bias_c_G = bias_c.row(3);
+
+            float* gates_data = gates.row(q);
+
+            // gate I F O G
+            const signed char* weight_xc_I = weight_xc_int8.row<const signed char>(hidden_size * 0 + q);
+            const signed char* weight_xc_F = weight_xc_int8.row<const signed char>(hidden_size * 1 + q);
+            const signed char* weight_xc_O = weight_xc_int8.row<const signed char>(hidden_size * 2 + q);
+            const signed char* weight_xc_G = weight_xc_int8.row<const signed char>(hidden_size * 3 + q);
+
+            const signed char* weight_hc_I = weight_hc_int8.row<const signed char>(hidden_size * 0 + q);
+            const signed char* weight_hc_F = weight_hc_int8.row<const signed char>(hidden_size * 1 + q);
+            const signed char* weight_hc_O = weight_hc_int8.row<const signed char>(hidden_size * 2 + q);
+            const signed char* weight_hc_G = weight_hc_int8.row<const signed char>(hidden_size * 3 + q);
+
+            int Ix = 0;
+            int Fx = 0;
+            int Ox = 0;
+            int Gx = 0;
+            for (int i = 0; i < size; i++)
+            {
+                int xi = x[i];
+
+                Ix += weight_xc_I[i] * xi;
+                Fx += weight_xc_F[i] * xi;
+                Ox += weight_xc_O[i] * xi;
+                Gx += weight_xc_G[i] * xi;
+            }
+
+            int Ih = 0;
+            int Fh = 0;
+            int Oh = 0;
+            int Gh = 0;
+            for (int i = 0; i < num_output; i++)
+            {
+                int h_cont = h[i];
+
+                Ih += weight_hc_I[i] * h_cont;
+                Fh += weight_hc_F[i] * h_cont;
+                Oh += weight_hc_O[i] * h_cont;
+                Gh += weight_hc_G[i] * h_cont;
+            }
+
+            const float descale_xc_I = weight_xc_int8_scales[hidden_size * 0 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[hidden_size * 0 + q];
+            const float descale_xc_F = weight_xc_int8_scales[hidden_size * 1 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[hidden_size * 1 + q];
+            const float descale_xc_O = weight_xc_int8_scales[hidden_size * 2 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[hidden_size * 2 + q];
+            const float descale_xc_G = weight_xc_int8_scales[hidden_size * 3 + q] == 0.f ? 0.f : descale_x / weight_xc_int8_scales[hidden_size * 3 + q];
+            const float descale_hc_I = weight_hc_int8_scales[hidden_size * 0 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[hidden_size * 0 + q];
+            const float descale_hc_F = weight_hc_int8_scales[hidden_size * 1 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[hidden_size * 1 + q];
+            const float descale_hc_O = weight_hc_int8_scales[hidden_size * 2 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[hidden_size * 2 + q];
+            const float descale_hc_G = weight_hc_int8_scales[hidden_size * 3 + q] == 0.f ? 0.f : descale_h / weight_hc_int8_scales[hidden_size * 3 + q];
+
+            gates_data[0] = bias_c_I[q] + Ix * descale_xc_I + Ih * descale_hc_I;
+            gates_data[1] = bias_c_F[q] + Fx * descale_xc_F + Fh * descale_hc_F;
+            gates_data[2] = bias_c_O[q] + Ox * descale_xc_O + Oh * descale_hc_O;
+            gates_data[3] = bias_c_G[q] + Gx * descale_xc_G + Gh * descale_hc_G;
+        }
+
+        // lstm unit
+        float* output_data = top_blob.row(ti);
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < hidden_size; q++)
+        {
+            const float* gates_data = gates.row(q);
+
+            float I = gates_data[0];
+            float F = gates_data[1];
+            float O = gates_data[2];
+            float G = gates_data[3];
+
+            I = 1.f / (1.f + expf(-I));
+            F = 1.f / (1.f + expf(-F));
+            O = 1.f / (1.f + expf(-O));
+            G = tanhf(G);
+
+            float cell2 = F * cell_state[q] + I * G;
+            float H = O * tanhf(cell2);
+            cell_state[q] = cell2;
+
+            if (num_output == hidden_size)
+            {
+                hidden_state[q] = H;
+                output_data[q] = H;
+            }
+            else
+            {
+                tmp_hidden_state[q] = H;
+            }
+        }
+
+        if (num_output != hidden_size)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < num_output; q++)
+            {
+                const float* hr = weight_hr.row(q);
+
+                float H = 0;
+                for (int i = 0; i < hidden_size; i++)
+                {
+                    H += tmp_hidden_state[i] * hr[i];
+                }
+
+                hidden_state[q] = H;
+                output_data[q] = H;
+            }
+        }
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     int T = bottom_blob.h;
@@ -232,9 +450,20 @@ int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
     // Uni directional
     if (direction == 0 || direction == 1)
     {
-        int ret = lstm(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
-        if (ret != 0)
-            return ret;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret = lstm_dynamic_quantize(bottom_blob, top_blob, direction, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret != 0)
+                return ret;
+        }
+        else
+#endif
+        {
+            int ret = lstm(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret != 0)
+                return ret;
+        }
     }
 
     if (direction == 2)
@@ -247,16 +476,38 @@ int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
         if (top_blob_reverse.empty())
             return -100;
 
-        int ret0 = lstm(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
-        if (ret0 != 0)
-            return ret0;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret0 = lstm_dynamic_quantize(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
+        else
+#endif
+        {
+            int ret0 = lstm(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
 
         hidden.fill(0.0f);
         cell.fill(0.0f);
 
-        int ret1 = lstm(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden, cell, opt);
-        if (ret1 != 0)
-            return ret1;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret1 = lstm_dynamic_quantize(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), weight_xc_data_int8_scales.row(1), bias_c_data.channel(1), weight_hc_data.channel(1), weight_hc_data_int8_scales.row(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden, cell, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
+        else
+#endif
+        {
+            int ret1 = lstm(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden, cell, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
 
         // concat w
         for (int i = 0; i < T; i++)
@@ -308,9 +559,20 @@ int LSTM::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     // Uni directional
     if (direction == 0 || direction == 1)
     {
-        int ret = lstm(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
-        if (ret != 0)
-            return ret;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret = lstm_dynamic_quantize(bottom_blob, top_blob, direction, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret != 0)
+                return ret;
+        }
+        else
+#endif
+        {
+            int ret = lstm(bottom_blob, top_blob, direction, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden, cell, opt);
+            if (ret != 0)
+                return ret;
+        }
     }
 
     if (direction == 2)
@@ -325,15 +587,37 @@ int LSTM::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
 
         Mat hidden0 = hidden.row_range(0, 1);
         Mat cell0 = cell.row_range(0, 1);
-        int ret0 = lstm(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden0, cell0, opt);
-        if (ret0 != 0)
-            return ret0;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret0 = lstm_dynamic_quantize(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), weight_xc_data_int8_scales.row(0), bias_c_data.channel(0), weight_hc_data.channel(0), weight_hc_data_int8_scales.row(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden0, cell0, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
+        else
+#endif
+        {
+            int ret0 = lstm(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), num_output == hidden_size ? Mat() : weight_hr_data.channel(0), hidden0, cell0, opt);
+            if (ret0 != 0)
+                return ret0;
+        }
 
         Mat hidden1 = hidden.row_range(1, 1);
         Mat cell1 = cell.row_range(1, 1);
-        int ret1 = lstm(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden1, cell1, opt);
-        if (ret1 != 0)
-            return ret1;
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            int ret1 = lstm_dynamic_quantize(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), weight_xc_data_int8_scales.row(1), bias_c_data.channel(1), weight_hc_data.channel(1), weight_hc_data_int8_scales.row(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden1, cell1, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
+        else
+#endif
+        {
+            int ret1 = lstm(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), num_output == hidden_size ? Mat() : weight_hr_data.channel(1), hidden1, cell1, opt);
+            if (ret1 != 0)
+                return ret1;
+        }
 
         // concat w
         for (int i = 0; i < T; i++)
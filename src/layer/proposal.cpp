@@ -14,6 +14,7 @@
 
 #include "proposal.h"
 
+#include <algorithm>
 #include <math.h>
 
 namespace ncnn {
@@ -111,46 +112,44 @@ static inline float intersection_area(const Rect& a, const Rect& b)
     return inter_width * inter_height;
 }
 
-template<typename T>
-static void qsort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores, int left, int right)
+// boxes of equal score keep their order so that the result does not depend on the sort
+struct sort_descent_compare
 {
-    int i = left;
-    int j = right;
-    float p = scores[(left + right) / 2];
+    const float* scores;
 
-    while (i <= j)
+    bool operator()(size_t a, size_t b) const
     {
-        while (scores[i] > p)
-            i++;
-
-        while (scores[j] < p)
-            j--;
-
-        if (i <= j)
-        {
-            // swap
-            std::swap(datas[i], datas[j]);
-            std::swap(scores[i], scores[j]);
-
-            i++;
-            j--;
-        }
+        return scores[a] > scores[b];
     }
-
-    if (left < j)
-        qsort_descent_inplace(datas, scores, left, j);
-
-    if (i < right)
-        qsort_descent_inplace(datas, scores, i, right);
-}
+};
 
 template<typename T>
-static void qsort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores)
+static void sort_descent_inplace(std::vector<T>& datas, std::vector<float>& scores)
 {
     if (datas.empty() || scores.empty())
         return;
 
-    qsort_descent_inplace(datas, scores, 0, static_cast<int>(scores.size() - 1));
+    const size_t n = scores.size();
+
+    std::vector<size_t> indices(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        indices[i] = i;
+    }
+
+    sort_descent_compare comp = {&scores[0]};
+    std::stable_sort(indices.begin(), indices.end(), comp);
+
+    std::vector<T> sorted_datas(n);
+    std::vector<float> sorted_scores(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        sorted_datas[i] = datas[indices[i]];
+        sorted_scores[i] = scores[indices[i]];
+    }
+
+    datas.swap(sorted_datas);
+    scores.swap(sorted_scores);
 }
 
 static void nms_sorted_bboxes(const std::vector<Rect>& bboxes, std::vector<size_t>& picked, float nms_threshold)
@@ -315,7 +314,7 @@ int Proposal::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     }
 
     // sort all (proposal, score) pairs by score from highest to lowest
-    qsort_descent_inplace(proposal_boxes, scores);
+    sort_descent_inplace(proposal_boxes, scores);
 
     // take top pre_nms_topN
     if (pre_nms_topN > 0 && pre_nms_topN < (int)proposal_boxes.size())
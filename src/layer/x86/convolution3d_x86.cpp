@@ -0,0 +1,372 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "convolution3d_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "fused_activation.h"
+#include "layer_type.h"
+
+namespace ncnn {
+
+Convolution3D_x86::Convolution3D_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+
+    activation = 0;
+    gemm = 0;
+}
+
+int Convolution3D_x86::create_pipeline(const Option& opt)
+{
+    activation = create_activation_layer(activation_type, activation_params, opt);
+
+    const int maxk = kernel_w * kernel_h * kernel_d;
+    const int num_input = weight_data_size / maxk / num_output;
+
+    int elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        elempack = num_input % 16 == 0 ? 16 : num_input % 8 == 0 ? 8 : num_input % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        elempack = num_input % 8 == 0 ? 8 : num_input % 4 == 0 ? 4 : 1;
+#else
+        elempack = num_input % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+
+    // lower to gemm over the 3d im2col
+    gemm = ncnn::create_layer(ncnn::LayerType::Gemm);
+
+    ncnn::ParamDict pd;
+    pd.set(2, 0);                   // transA
+    pd.set(3, 0);                   // transB
+    pd.set(4, 1);                   // constantA
+    pd.set(5, 0);                   // constantB
+    pd.set(6, 1);                   // constantC
+    pd.set(7, num_output);          // M = outch
+    pd.set(8, 0);                   // N = size
+    pd.set(9, maxk * num_input);    // K = maxk*inch
+    pd.set(10, bias_term ? 1 : -1); // constant_broadcast_type_C = (M)
+    pd.set(11, 1);                  // output_N1M
+
+    gemm->load_param(pd);
+
+    // maxk-inch-outch to pa-maxk-inch/pa-outch
+    Mat tmp;
+    {
+        Mat weight_data_r2 = weight_data.reshape(maxk, num_input, num_output);
+
+        tmp.create(maxk * num_input, num_output);
+
+        for (int q = 0; q < num_output; q += 1)
+        {
+            float* g00 = tmp.row(q);
+
+            for (int p = 0; p + (elempack - 1) < num_input; p += elempack)
+            {
+                for (int k = 0; k < maxk; k++)
+                {
+                    for (int i = 0; i < elempack; i++)
+                    {
+                        const float* k00 = weight_data_r2.channel(q).row(p + i);
+                        g00[0] = k00[k];
+                        g00++;
+                    }
+                }
+            }
+        }
+    }
+
+    if (bias_term)
+    {
+        ncnn::Mat weights[2];
+        weights[0] = tmp;
+        weights[1] = bias_data;
+
+        gemm->load_model(ModelBinFromMatArray(weights));
+    }
+    else
+    {
+        ncnn::Mat weights[1];
+        weights[0] = tmp;
+
+        gemm->load_model(ModelBinFromMatArray(weights));
+    }
+
+    gemm->create_pipeline(opt);
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int Convolution3D_x86::destroy_pipeline(const Option& opt)
+{
+    if (activation)
+    {
+        activation->destroy_pipeline(opt);
+        delete activation;
+        activation = 0;
+    }
+
+    if (gemm)
+    {
+        gemm->destroy_pipeline(opt);
+        delete gemm;
+        gemm = 0;
+    }
+
+    return 0;
+}
+
+static void convolution3d_im2col_sse(const Mat& bottom_blob, Mat& bottom_im2col, int outw, int outh, int outd, int kernel_w, int kernel_h, int kernel_d, int dilation_w, int dilation_h, int dilation_d, int stride_w, int stride_h, int stride_d, const Option& opt)
+{
+    const int channels = bottom_blob.c;
+    const int elempack = bottom_blob.elempack;
+    const int maxk = kernel_w * kernel_h * kernel_d;
+
+    // one row of outw*outh*outd for each kernel tap, inch major
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < channels; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+            float* ptr = bottom_im2col.row(p * maxk);
+
+            for (int z = 0; z < kernel_d; z++)
+            {
+                for (int u = 0; u < kernel_h; u++)
+                {
+                    for (int v = 0; v < kernel_w; v++)
+                    {
+                        for (int k = 0; k < outd; k++)
+                        {
+                            for (int i = 0; i < outh; i++)
+                            {
+                                const float* sptr = img.depth(dilation_d * z + k * stride_d).row(dilation_h * u + i * stride_h) + dilation_w * v * 16;
+
+                                for (int j = 0; j < outw; j++)
+                                {
+                                    __m512 _val = _mm512_load_ps(sptr);
+                                    _mm512_store_ps(ptr, _val);
+
+                                    sptr += stride_w * 16;
+                                    ptr += 16;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+#endif // __AVX512F__
+
+    if (elempack == 8)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < channels; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+            float* ptr = bottom_im2col.row(p * maxk);
+
+            for (int z = 0; z < kernel_d; z++)
+            {
+                for (int u = 0; u < kernel_h; u++)
+                {
+                    for (int v = 0; v < kernel_w; v++)
+                    {
+                        for (int k = 0; k < outd; k++)
+                        {
+                            for (int i = 0; i < outh; i++)
+                            {
+                                const float* sptr = img.depth(dilation_d * z + k * stride_d).row(dilation_h * u + i * stride_h) + dilation_w * v * 8;
+
+                                for (int j = 0; j < outw; j++)
+                                {
+                                    __m256 _val = _mm256_load_ps(sptr);
+                                    _mm256_store_ps(ptr, _val);
+
+                                    sptr += stride_w * 8;
+                                    ptr += 8;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+#endif // __AVX__
+
+    if (elempack == 4)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < channels; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+            float* ptr = bottom_im2col.row(p * maxk);
+
+            for (int z = 0; z < kernel_d; z++)
+            {
+                for (int u = 0; u < kernel_h; u++)
+                {
+                    for (int v = 0; v < kernel_w; v++)
+                    {
+                        for (int k = 0; k < outd; k++)
+                        {
+                            for (int i = 0; i < outh; i++)
+                            {
+                                const float* sptr = img.depth(dilation_d * z + k * stride_d).row(dilation_h * u + i * stride_h) + dilation_w * v * 4;
+
+                                for (int j = 0; j < outw; j++)
+                                {
+                                    __m128 _val = _mm_load_ps(sptr);
+                                    _mm_store_ps(ptr, _val);
+
+                                    sptr += stride_w * 4;
+                                    ptr += 4;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+#endif // __SSE2__
+
+    if (elempack == 1)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < channels; p++)
+        {
+            const Mat img = bottom_blob.channel(p);
+            float* ptr = bottom_im2col.row(p * maxk);
+
+            for (int z = 0; z < kernel_d; z++)
+            {
+                for (int u = 0; u < kernel_h; u++)
+                {
+                    for (int v = 0; v < kernel_w; v++)
+                    {
+                        for (int k = 0; k < outd; k++)
+                        {
+                            for (int i = 0; i < outh; i++)
+                            {
+                                const float* sptr = img.depth(dilation_d * z + k * stride_d).row(dilation_h * u + i * stride_h) + dilation_w * v;
+
+                                for (int j = 0; j < outw; j++)
+                                {
+                                    ptr[0] = sptr[0];
+
+                                    sptr += stride_w;
+                                    ptr += 1;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int Convolution3D_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int d = bottom_blob.d;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+    int elempack = bottom_blob.elempack;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+    const int kernel_extent_d = dilation_d * (kernel_d - 1) + 1;
+
+    Mat bottom_blob_bordered;
+    make_padding(bottom_blob, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+    d = bottom_blob_bordered.d;
+
+    const int outw = (w - kernel_extent_w) / stride_w + 1;
+    const int outh = (h - kernel_extent_h) / stride_h + 1;
+    const int outd = (d - kernel_extent_d) / stride_d + 1;
+
+    // im2col
+    Mat bottom_im2col;
+    if (kernel_w == 1 && kernel_h == 1 && kernel_d == 1 && stride_w == 1 && stride_h == 1 && stride_d == 1)
+    {
+        bottom_im2col = bottom_blob_bordered;
+        bottom_im2col.dims = 3;
+        bottom_im2col.w = w * h * d;
+        bottom_im2col.h = 1;
+        bottom_im2col.d = 1;
+    }
+    else
+    {
+        const int size = outw * outh * outd;
+        const int maxk = kernel_w * kernel_h * kernel_d;
+
+        bottom_im2col.create(size, maxk * channels, elemsize, elempack, opt.workspace_allocator);
+        if (bottom_im2col.empty())
+            return -100;
+
+        convolution3d_im2col_sse(bottom_blob_bordered, bottom_im2col, outw, outh, outd, kernel_w, kernel_h, kernel_d, dilation_w, dilation_h, dilation_d, stride_w, stride_h, stride_d, opt);
+    }
+
+    // sgemm
+    int ret = gemm->forward(bottom_im2col, top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    // outw*outh*outd x outch to 3d
+    top_blob.dims = 4;
+    top_blob.w = outw;
+    top_blob.h = outh;
+    top_blob.d = outd;
+
+    if (activation)
+    {
+        activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -28,6 +28,7 @@
 #endif // __SSE2__
 #include "x86_activation.h"
 #include "x86_usability.h"
+#include "x86_sparse_weight.h"
 
 #include "benchmark.h"
 #include "cpu.h"
@@ -88,9 +89,25 @@ Convolution_x86::Convolution_x86()
     activation = 0;
     nT = 0;
     convolution_dilation1 = 0;
+    residual_binaryop = 0;
+    residual_activation = 0;
     gemm = 0;
 }
 
+static Layer* create_residual_binaryop_layer(const Option& opt)
+{
+    Layer* op = create_layer(LayerType::BinaryOp);
+
+    ParamDict pd;
+    pd.set(0, 0); // add
+
+    op->load_param(pd);
+
+    op->create_pipeline(opt);
+
+    return op;
+}
+
 static void convolution_transform_kernel_packed_sse(const Mat& weight_data, Mat& weight_data_tm, int num_input, int num_output, int kernel_w, int kernel_h, int elempack, int out_elempack)
 {
     const int maxk = kernel_w * kernel_h;
@@ -291,6 +308,27 @@ static bool test_prefer_winograd23(int num_input, int num_output, int w, int h)
     return false;
 }
 
+static Layer* create_gemm_layer(int num_output, int K, int bias_term)
+{
+    Layer* gemm = ncnn::create_layer(ncnn::LayerType::Gemm);
+
+    ncnn::ParamDict pd;
+    pd.set(2, 0);                   // transA
+    pd.set(3, 0);                   // transB
+    pd.set(4, 1);                   // constantA
+    pd.set(5, 0);                   // constantB
+    pd.set(6, 1);                   // constantC
+    pd.set(7, num_output);          // M = outch
+    pd.set(8, 0);                   // N = size
+    pd.set(9, K);                   // K = maxk*inch
+    pd.set(10, bias_term ? 1 : -1); // constant_broadcast_type_C = (M)
+    pd.set(11, 1);                  // output_N1M
+
+    gemm->load_param(pd);
+
+    return gemm;
+}
+
 int Convolution_x86::create_pipeline(const Option& opt)
 {
     if (dynamic_weight)
@@ -299,6 +337,12 @@ int Convolution_x86::create_pipeline(const Option& opt)
     activation = create_activation_layer(activation_type, activation_params, opt);
     nT = opt.num_threads;
 
+    if (fuse_residual)
+    {
+        residual_binaryop = create_residual_binaryop_layer(opt);
+        residual_activation = create_activation_layer(residual_activation_type, residual_activation_params, opt);
+    }
+
 #if NCNN_INT8
     if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
     {
@@ -476,6 +520,23 @@ int Convolution_x86::create_pipeline(const Option& opt)
         return 0;
     }
 
+    if (opt.use_sparse_weight && kernel_w == 1 && kernel_h == 1 && stride_w == 1 && stride_h == 1)
+    {
+        int ret = sparse_weight_transform_kernel(weight_data, weight_sparse_index, weight_sparse_data, num_input, num_output);
+        if (ret != 0)
+            return ret;
+
+        if (!weight_sparse_data.empty())
+        {
+            if (opt.lightmode)
+            {
+                weight_data.release();
+            }
+
+            return 0;
+        }
+    }
+
     int l2_cache_size = get_cpu_level2_cache_size();
     bool prefer_sgemm = num_input * num_output * kernel_w * kernel_h * dilation_w * dilation_h * stride_w * stride_h * (int)sizeof(float) * 2 > l2_cache_size || (num_input > 16 || num_output > 16);
 
@@ -483,21 +544,7 @@ int Convolution_x86::create_pipeline(const Option& opt)
     {
         const int maxk = kernel_w * kernel_h;
 
-        gemm = ncnn::create_layer(ncnn::LayerType::Gemm);
-
-        ncnn::ParamDict pd;
-        pd.set(2, 0);                   // transA
-        pd.set(3, 0);                   // transB
-        pd.set(4, 1);                   // constantA
-        pd.set(5, 0);                   // constantB
-        pd.set(6, 1);                   // constantC
-        pd.set(7, num_output);          // M = outch
-        pd.set(8, 0);                   // N = size
-        pd.set(9, maxk * num_input);    // K = maxk*inch
-        pd.set(10, bias_term ? 1 : -1); // constant_broadcast_type_C = (M)
-        pd.set(11, 1);                  // output_N1M
-
-        gemm->load_param(pd);
+        gemm = create_gemm_layer(num_output, maxk * num_input, bias_term);
 
         // maxk-inch-outch to pa-maxk-inch/pa-outch
         Mat tmp;
@@ -586,6 +633,20 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
         convolution_dilation1 = 0;
     }
 
+    if (residual_binaryop)
+    {
+        residual_binaryop->destroy_pipeline(opt);
+        delete residual_binaryop;
+        residual_binaryop = 0;
+    }
+
+    if (residual_activation)
+    {
+        residual_activation->destroy_pipeline(opt);
+        delete residual_activation;
+        residual_activation = 0;
+    }
+
     if (gemm)
     {
         gemm->destroy_pipeline(opt);
@@ -596,6 +657,85 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution_x86::save_weight_cache(std::vector<Mat>& mats) const
+{
+    if (dynamic_weight || convolution_dilation1)
+        return -1;
+
+    mats.resize(8);
+    mats[0] = weight_data_tm;
+    mats[1] = weight_sgemm_data;
+    mats[2] = weight_winograd23_data;
+    mats[3] = weight_winograd43_data;
+    mats[4] = weight_winograd63_data;
+#if NCNN_INT8
+    mats[5] = scale_in_data;
+#endif
+    mats[6] = weight_sparse_index;
+    mats[7] = weight_sparse_data;
+
+    if (gemm)
+    {
+        std::vector<Mat> gemm_mats;
+        int ret = gemm->save_weight_cache(gemm_mats);
+        if (ret != 0)
+            return ret;
+
+        mats.insert(mats.end(), gemm_mats.begin(), gemm_mats.end());
+    }
+
+    return 0;
+}
+
+int Convolution_x86::load_weight_cache(const std::vector<Mat>& mats, const Option& opt)
+{
+    if (dynamic_weight || mats.size() < 8)
+        return -1;
+
+    if (mats.size() > 8)
+    {
+        const int maxk = kernel_w * kernel_h;
+        const int num_input = weight_data_size / maxk / num_output;
+
+        gemm = create_gemm_layer(num_output, maxk * num_input, bias_term);
+
+        int ret = gemm->load_weight_cache(std::vector<Mat>(mats.begin() + 8, mats.end()), opt);
+        if (ret != 0)
+        {
+            delete gemm;
+            gemm = 0;
+            return ret;
+        }
+    }
+
+    activation = create_activation_layer(activation_type, activation_params, opt);
+    nT = opt.num_threads;
+
+    if (fuse_residual)
+    {
+        residual_binaryop = create_residual_binaryop_layer(opt);
+        residual_activation = create_activation_layer(residual_activation_type, residual_activation_params, opt);
+    }
+
+    weight_data_tm = mats[0];
+    weight_sgemm_data = mats[1];
+    weight_winograd23_data = mats[2];
+    weight_winograd43_data = mats[3];
+    weight_winograd63_data = mats[4];
+#if NCNN_INT8
+    scale_in_data = mats[5];
+#endif
+    weight_sparse_index = mats[6];
+    weight_sparse_data = mats[7];
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
 int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
 #if NCNN_INT8
@@ -693,6 +833,40 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
 
     const int num_input = channels * elempack;
 
+    if (!weight_sparse_data.empty())
+    {
+        // pruned 1x1 stride 1, the sparse kernel walks unpacked channels
+        Option opt_unpack = opt;
+        opt_unpack.blob_allocator = opt.workspace_allocator;
+
+        Mat bottom_blob_unpacked = bottom_blob_bordered;
+        if (elempack != 1)
+        {
+            convert_packing(bottom_blob_bordered, bottom_blob_unpacked, 1, opt_unpack);
+            if (bottom_blob_unpacked.empty())
+                return -100;
+        }
+
+        Mat top_blob_unpacked = top_blob;
+        if (out_elempack != 1)
+        {
+            top_blob_unpacked.create(outw, outh, num_output, elemsize / elempack, 1, opt.workspace_allocator);
+            if (top_blob_unpacked.empty())
+                return -100;
+        }
+
+        sparse_weight_gemm(bottom_blob_unpacked, top_blob_unpacked, weight_sparse_index, weight_sparse_data, bias_data, activation_type, activation_params, opt);
+
+        if (out_elempack != 1)
+        {
+            convert_packing(top_blob_unpacked, top_blob, out_elempack, opt);
+            if (top_blob.empty())
+                return -100;
+        }
+
+        return 0;
+    }
+
     bool prefer_winograd = (opt.use_winograd23_convolution || opt.use_winograd43_convolution || opt.use_winograd63_convolution) && (num_input > 8 || num_output > 8);
 
     if (opt.use_winograd_convolution && prefer_winograd && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
@@ -1162,8 +1336,105 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     return 0;
 }
 
+static void convolution_residual_activation(Mat& top_blob, const Mat& residual_blob, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int channels = top_blob.c;
+    const int size = top_blob.w * top_blob.h * top_blob.d * top_blob.elempack;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        float* ptr = top_blob.channel(q);
+        const float* rptr = residual_blob.channel(q);
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i + 15 < size; i += 16)
+        {
+            __m512 _p = _mm512_add_ps(_mm512_loadu_ps(ptr), _mm512_loadu_ps(rptr));
+            _p = activation_avx512(_p, activation_type, activation_params);
+            _mm512_storeu_ps(ptr, _p);
+            ptr += 16;
+            rptr += 16;
+        }
+#endif // __AVX512F__
+        for (; i + 7 < size; i += 8)
+        {
+            __m256 _p = _mm256_add_ps(_mm256_loadu_ps(ptr), _mm256_loadu_ps(rptr));
+            _p = activation_avx(_p, activation_type, activation_params);
+            _mm256_storeu_ps(ptr, _p);
+            ptr += 8;
+            rptr += 8;
+        }
+#endif // __AVX__
+        for (; i + 3 < size; i += 4)
+        {
+            __m128 _p = _mm_add_ps(_mm_loadu_ps(ptr), _mm_loadu_ps(rptr));
+            _p = activation_sse(_p, activation_type, activation_params);
+            _mm_storeu_ps(ptr, _p);
+            ptr += 4;
+            rptr += 4;
+        }
+#endif // __SSE2__
+        for (; i < size; i++)
+        {
+            *ptr = activation_ss(*ptr + *rptr, activation_type, activation_params);
+            ptr++;
+            rptr++;
+        }
+    }
+}
+
+int Convolution_x86::forward_residual(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& residual_blob = bottom_blobs[1];
+    Mat& top_blob = top_blobs[0];
+
+    // the convolution itself runs without activation
+    int ret = forward(bottom_blob, top_blob, opt);
+    if (ret != 0)
+        return ret;
+
+    if (residual_blob.dims == top_blob.dims && residual_blob.w == top_blob.w && residual_blob.h == top_blob.h && residual_blob.d == top_blob.d && residual_blob.c == top_blob.c && residual_blob.elempack == top_blob.elempack)
+    {
+        // add and activate in one sweep over the output
+        convolution_residual_activation(top_blob, residual_blob, residual_activation_type, residual_activation_params, opt);
+        return 0;
+    }
+
+    // broadcasting residual, fallback to the standalone operators
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    std::vector<Mat> bottom_blobs_unpacked(2);
+    convert_packing(top_blob, bottom_blobs_unpacked[0], 1, opt_unpack);
+    convert_packing(residual_blob, bottom_blobs_unpacked[1], 1, opt_unpack);
+    if (bottom_blobs_unpacked[0].empty() || bottom_blobs_unpacked[1].empty())
+        return -100;
+
+    std::vector<Mat> top_blobs_unpacked(1);
+    ret = residual_binaryop->forward(bottom_blobs_unpacked, top_blobs_unpacked, opt);
+    if (ret != 0)
+        return ret;
+
+    top_blob = top_blobs_unpacked[0];
+
+    if (residual_activation)
+    {
+        residual_activation->forward_inplace(top_blob, opt);
+    }
+
+    return 0;
+}
+
 int Convolution_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
+    if (fuse_residual)
+        return forward_residual(bottom_blobs, top_blobs, opt);
+
     const Mat& bottom_blob = bottom_blobs[0];
     const Mat& _weight_data = bottom_blobs[1];
     Mat& top_blob = top_blobs[0];
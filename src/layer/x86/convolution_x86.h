@@ -27,11 +27,15 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int save_weight_cache(std::vector<Mat>& mats) const;
+    virtual int load_weight_cache(const std::vector<Mat>& mats, const Option& opt);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
 protected:
+    int forward_residual(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 #if NCNN_INT8
     int create_pipeline_int8_x86(const Option& opt);
     int forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
@@ -48,9 +52,17 @@ public:
     Mat weight_winograd43_data;
     Mat weight_winograd63_data;
 
+    // block sparse weight of 1x1 stride 1, see x86_sparse_weight.h
+    Mat weight_sparse_index;
+    Mat weight_sparse_data;
+
     // forwardDilation
     Layer* convolution_dilation1;
 
+    // forward_residual with a broadcasting residual
+    Layer* residual_binaryop;
+    Layer* residual_activation;
+
     Layer* gemm;
 
 #if NCNN_INT8
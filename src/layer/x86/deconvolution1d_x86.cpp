@@ -0,0 +1,371 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "deconvolution1d_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "x86_activation.h"
+
+#include "layer_type.h"
+
+namespace ncnn {
+
+Deconvolution1D_x86::Deconvolution1D_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+
+    gemm = 0;
+}
+
+int Deconvolution1D_x86::create_pipeline(const Option& opt)
+{
+    const int num_input = weight_data_size / kernel_w / num_output;
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+
+    // lower to gemm followed by 1d col2im
+    gemm = ncnn::create_layer(ncnn::LayerType::Gemm);
+
+    ncnn::ParamDict pd;
+    pd.set(2, 1);                     // transA
+    pd.set(3, 0);                     // transB
+    pd.set(4, 1);                     // constantA
+    pd.set(5, 0);                     // constantB
+    pd.set(6, 1);                     // constantC
+    pd.set(7, kernel_w * num_output); // M = kernel_w*num_output
+    pd.set(8, 0);                     // N = w
+    pd.set(9, num_input);             // K = inh
+    pd.set(10, -1);                   // constant_broadcast_type_C = null
+    pd.set(11, 0);                    // output_N1M
+    pd.set(12, out_elempack);
+
+    gemm->load_param(pd);
+
+    // kw-inh-outh to pa-kw-outh/pa-inh
+    Mat tmp;
+    {
+        Mat weight_data_r2 = weight_data.reshape(kernel_w, num_input, num_output);
+
+        tmp.create(kernel_w * num_output, num_input);
+
+        for (int p = 0; p < num_input; p += 1)
+        {
+            float* g00 = tmp.row(p);
+
+            for (int q = 0; q + (out_elempack - 1) < num_output; q += out_elempack)
+            {
+                for (int k = 0; k < kernel_w; k++)
+                {
+                    for (int i = 0; i < out_elempack; i++)
+                    {
+                        const float* k00 = weight_data_r2.channel(q + i).row(p);
+                        g00[0] = k00[k];
+                        g00++;
+                    }
+                }
+            }
+        }
+    }
+
+    ncnn::Mat weights[1];
+    weights[0] = tmp;
+
+    gemm->load_model(ModelBinFromMatArray(weights));
+
+    gemm->create_pipeline(opt);
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int Deconvolution1D_x86::destroy_pipeline(const Option& opt)
+{
+    if (gemm)
+    {
+        gemm->destroy_pipeline(opt);
+        delete gemm;
+        gemm = 0;
+    }
+
+    return 0;
+}
+
+static void deconvolution1d_col2im_sse(const Mat& top_col2im, Mat& top_blob, int w, const Mat& bias_data, int kernel_w, int dilation_w, int stride_w, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int out_elempack = top_blob.elempack;
+
+    // scatter-add one row of w for each kernel tap and apply activation in place
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (out_elempack == 16)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outh; p++)
+        {
+            const float* sptr = top_col2im.row(p * kernel_w);
+            Mat outm = top_blob.row_range(p, 1);
+
+            if (bias_data.empty())
+            {
+                outm.fill(_mm512_setzero_ps());
+            }
+            else
+            {
+                outm.fill(_mm512_loadu_ps((const float*)bias_data + p * 16));
+            }
+
+            for (int k = 0; k < kernel_w; k++)
+            {
+                float* ptr = outm.row(0) + dilation_w * k * 16;
+
+                for (int j = 0; j < w; j++)
+                {
+                    __m512 _val = _mm512_load_ps(ptr);
+                    __m512 _s = _mm512_load_ps(sptr);
+                    _val = _mm512_add_ps(_val, _s);
+                    _mm512_store_ps(ptr, _val);
+
+                    ptr += stride_w * 16;
+                    sptr += 16;
+                }
+            }
+
+            float* ptr = outm;
+
+            for (int j = 0; j < outw; j++)
+            {
+                __m512 _val = _mm512_load_ps(ptr);
+                _val = activation_avx512(_val, activation_type, activation_params);
+                _mm512_store_ps(ptr, _val);
+                ptr += 16;
+            }
+        }
+    }
+#endif // __AVX512F__
+
+    if (out_elempack == 8)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outh; p++)
+        {
+            const float* sptr = top_col2im.row(p * kernel_w);
+            Mat outm = top_blob.row_range(p, 1);
+
+            if (bias_data.empty())
+            {
+                outm.fill(_mm256_setzero_ps());
+            }
+            else
+            {
+                outm.fill(_mm256_loadu_ps((const float*)bias_data + p * 8));
+            }
+
+            for (int k = 0; k < kernel_w; k++)
+            {
+                float* ptr = outm.row(0) + dilation_w * k * 8;
+
+                for (int j = 0; j < w; j++)
+                {
+                    __m256 _val = _mm256_load_ps(ptr);
+                    __m256 _s = _mm256_load_ps(sptr);
+                    _val = _mm256_add_ps(_val, _s);
+                    _mm256_store_ps(ptr, _val);
+
+                    ptr += stride_w * 8;
+                    sptr += 8;
+                }
+            }
+
+            float* ptr = outm;
+
+            for (int j = 0; j < outw; j++)
+            {
+                __m256 _val = _mm256_load_ps(ptr);
+                _val = activation_avx(_val, activation_type, activation_params);
+                _mm256_store_ps(ptr, _val);
+                ptr += 8;
+            }
+        }
+    }
+#endif // __AVX__
+
+    if (out_elempack == 4)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outh; p++)
+        {
+            const float* sptr = top_col2im.row(p * kernel_w);
+            Mat outm = top_blob.row_range(p, 1);
+
+            if (bias_data.empty())
+            {
+                outm.fill(_mm_setzero_ps());
+            }
+            else
+            {
+                outm.fill(_mm_loadu_ps((const float*)bias_data + p * 4));
+            }
+
+            for (int k = 0; k < kernel_w; k++)
+            {
+                float* ptr = outm.row(0) + dilation_w * k * 4;
+
+                for (int j = 0; j < w; j++)
+                {
+                    __m128 _val = _mm_load_ps(ptr);
+                    __m128 _s = _mm_load_ps(sptr);
+                    _val = _mm_add_ps(_val, _s);
+                    _mm_store_ps(ptr, _val);
+
+                    ptr += stride_w * 4;
+                    sptr += 4;
+                }
+            }
+
+            float* ptr = outm;
+
+            for (int j = 0; j < outw; j++)
+            {
+                __m128 _val = _mm_load_ps(ptr);
+                _val = activation_sse(_val, activation_type, activation_params);
+                _mm_store_ps(ptr, _val);
+                ptr += 4;
+            }
+        }
+    }
+#endif // __SSE2__
+
+    if (out_elempack == 1)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outh; p++)
+        {
+            const float* sptr = top_col2im.row(p * kernel_w);
+            Mat outm = top_blob.row_range(p, 1);
+
+            if (bias_data.empty())
+            {
+                outm.fill(0.f);
+            }
+            else
+            {
+                outm.fill(bias_data[p]);
+            }
+
+            for (int k = 0; k < kernel_w; k++)
+            {
+                float* ptr = outm.row(0) + dilation_w * k;
+
+                for (int j = 0; j < w; j++)
+                {
+                    ptr[0] += sptr[0];
+
+                    ptr += stride_w;
+                    sptr += 1;
+                }
+            }
+
+            float* ptr = outm;
+
+            for (int j = 0; j < outw; j++)
+            {
+                ptr[j] = activation_ss(ptr[j], activation_type, activation_params);
+            }
+        }
+    }
+}
+
+int Deconvolution1D_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int w = bottom_blob.w;
+    size_t elemsize = bottom_blob.elemsize;
+    int elempack = bottom_blob.elempack;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+
+    int outw = (w - 1) * stride_w + kernel_extent_w + output_pad_right;
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    size_t out_elemsize = elemsize / elempack * out_elempack;
+
+    Mat top_blob_bordered;
+    if (pad_left > 0 || pad_right > 0 || output_w > 0)
+    {
+        top_blob_bordered.create(outw, num_output / out_elempack, out_elemsize, out_elempack, opt.workspace_allocator);
+    }
+    else
+    {
+        top_blob_bordered = top_blob;
+        top_blob_bordered.create(outw, num_output / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    }
+    if (top_blob_bordered.empty())
+        return -100;
+
+    // sgemm
+    Mat top_col2im;
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+    int ret = gemm->forward(bottom_blob, top_col2im, opt_b);
+    if (ret != 0)
+        return ret;
+
+    // col2im
+    deconvolution1d_col2im_sse(top_col2im, top_blob_bordered, w, bias_data, kernel_w, dilation_w, stride_w, activation_type, activation_params, opt);
+
+    cut_padding(top_blob_bordered, top_blob, opt);
+    if (top_blob.empty())
+        return -100;
+
+    return 0;
+}
+
+} // namespace ncnn
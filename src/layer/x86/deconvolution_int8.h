@@ -0,0 +1,259 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// int8 deconvolution as col = kernel x input followed by col2im
+// the products are accumulated pairwise in int16 with madd
+//
+// kernel_tm : 4 rows of outch*maxk, inch pairs interleaved
+// panel     : nn columns of the input, inch pairs interleaved
+// col       : outch*maxk rows of int32, one per input pixel
+
+static inline int deconvolution_int8_panel_width()
+{
+#if __AVX2__
+    return 8;
+#else
+    return 4;
+#endif
+}
+
+static void deconvolution_transform_kernel_int8_sse(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int maxk, const Option& opt)
+{
+    // src = kw-kh-inch-outch
+    // dst = 2a-4b-inch/2a-(maxk*outch)/4b
+    const int M = maxk * outch;
+    const int K2 = (inch + 1) / 2;
+
+    kernel_tm.create(K2 * 8, (M + 3) / 4, (size_t)2u);
+    if (kernel_tm.empty())
+        return;
+
+    const signed char* kptr = kernel;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii = 0; ii < (M + 3) / 4; ii++)
+    {
+        short* g00 = kernel_tm.row<short>(ii);
+
+        for (int k = 0; k < K2 * 2; k += 2)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                const int m = ii * 4 + r;
+                const int p = m / maxk;
+                const int kk = m % maxk;
+
+                g00[0] = m < M && k < inch ? kptr[(p * inch + k) * maxk + kk] : 0;
+                g00[1] = m < M && k + 1 < inch ? kptr[(p * inch + k + 1) * maxk + kk] : 0;
+                g00 += 2;
+            }
+        }
+    }
+}
+
+static void deconvolution_pack_input_int8_sse(const Mat& bottom_blob, Mat& panel, int nn, const Option& opt)
+{
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int inch = bottom_blob.c;
+    const int K2 = (inch + 1) / 2;
+
+    const int nn_size = (size + nn - 1) / nn;
+
+    panel.create(K2 * 2 * nn, nn_size, (size_t)2u, opt.workspace_allocator);
+    if (panel.empty())
+        return;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int jj = 0; jj < nn_size; jj++)
+    {
+        short* pp = panel.row<short>(jj);
+
+        for (int k = 0; k < K2 * 2; k += 2)
+        {
+            const signed char* p0 = bottom_blob.channel(k);
+            const signed char* p1 = k + 1 < inch ? (const signed char*)bottom_blob.channel(k + 1) : 0;
+
+            for (int j = 0; j < nn; j++)
+            {
+                const int n = jj * nn + j;
+
+                pp[0] = n < size ? p0[n] : 0;
+                pp[1] = n < size && p1 ? p1[n] : 0;
+                pp += 2;
+            }
+        }
+    }
+}
+
+static void deconvolution_gemm_int8_sse(const Mat& panel, const Mat& kernel_tm, Mat& col, int M, int nn, const Option& opt)
+{
+    const int K2 = kernel_tm.w / 8;
+    const int nn_size = panel.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii = 0; ii < (M + 3) / 4; ii++)
+    {
+        const int m = ii * 4;
+
+        for (int jj = 0; jj < nn_size; jj++)
+        {
+            const short* pA = kernel_tm.row<const short>(ii);
+            const short* pB = panel.row<const short>(jj);
+
+            int* outptr0 = col.row<int>(m) + jj * nn;
+            int* outptr1 = m + 1 < M ? col.row<int>(m + 1) + jj * nn : 0;
+            int* outptr2 = m + 2 < M ? col.row<int>(m + 2) + jj * nn : 0;
+            int* outptr3 = m + 3 < M ? col.row<int>(m + 3) + jj * nn : 0;
+
+#if __AVX2__
+            __m256i _sum0 = _mm256_setzero_si256();
+            __m256i _sum1 = _mm256_setzero_si256();
+            __m256i _sum2 = _mm256_setzero_si256();
+            __m256i _sum3 = _mm256_setzero_si256();
+
+            for (int k = 0; k < K2; k++)
+            {
+                __m256i _pB = _mm256_loadu_si256((const __m256i*)pB);
+
+                _sum0 = _mm256_add_epi32(_sum0, _mm256_madd_epi16(_mm256_set1_epi32(((const int*)pA)[0]), _pB));
+                _sum1 = _mm256_add_epi32(_sum1, _mm256_madd_epi16(_mm256_set1_epi32(((const int*)pA)[1]), _pB));
+                _sum2 = _mm256_add_epi32(_sum2, _mm256_madd_epi16(_mm256_set1_epi32(((const int*)pA)[2]), _pB));
+                _sum3 = _mm256_add_epi32(_sum3, _mm256_madd_epi16(_mm256_set1_epi32(((const int*)pA)[3]), _pB));
+
+                pA += 8;
+                pB += 16;
+            }
+
+            _mm256_storeu_si256((__m256i*)outptr0, _sum0);
+            if (outptr1) _mm256_storeu_si256((__m256i*)outptr1, _sum1);
+            if (outptr2) _mm256_storeu_si256((__m256i*)outptr2, _sum2);
+            if (outptr3) _mm256_storeu_si256((__m256i*)outptr3, _sum3);
+#elif __SSE2__
+            __m128i _sum0 = _mm_setzero_si128();
+            __m128i _sum1 = _mm_setzero_si128();
+            __m128i _sum2 = _mm_setzero_si128();
+            __m128i _sum3 = _mm_setzero_si128();
+
+            for (int k = 0; k < K2; k++)
+            {
+                __m128i _pA = _mm_loadu_si128((const __m128i*)pA);
+                __m128i _pB = _mm_loadu_si128((const __m128i*)pB);
+
+                _sum0 = _mm_add_epi32(_sum0, _mm_madd_epi16(_mm_shuffle_epi32(_pA, _MM_SHUFFLE(0, 0, 0, 0)), _pB));
+                _sum1 = _mm_add_epi32(_sum1, _mm_madd_epi16(_mm_shuffle_epi32(_pA, _MM_SHUFFLE(1, 1, 1, 1)), _pB));
+                _sum2 = _mm_add_epi32(_sum2, _mm_madd_epi16(_mm_shuffle_epi32(_pA, _MM_SHUFFLE(2, 2, 2, 2)), _pB));
+                _sum3 = _mm_add_epi32(_sum3, _mm_madd_epi16(_mm_shuffle_epi32(_pA, _MM_SHUFFLE(3, 3, 3, 3)), _pB));
+
+                pA += 8;
+                pB += 8;
+            }
+
+            _mm_storeu_si128((__m128i*)outptr0, _sum0);
+            if (outptr1) _mm_storeu_si128((__m128i*)outptr1, _sum1);
+            if (outptr2) _mm_storeu_si128((__m128i*)outptr2, _sum2);
+            if (outptr3) _mm_storeu_si128((__m128i*)outptr3, _sum3);
+#else
+            int sum[4][4] = {{0}};
+
+            for (int k = 0; k < K2; k++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        sum[r][j] += pA[r * 2] * pB[j * 2] + pA[r * 2 + 1] * pB[j * 2 + 1];
+                    }
+                }
+
+                pA += 8;
+                pB += 8;
+            }
+
+            for (int j = 0; j < 4; j++)
+            {
+                outptr0[j] = sum[0][j];
+                if (outptr1) outptr1[j] = sum[1][j];
+                if (outptr2) outptr2[j] = sum[2][j];
+                if (outptr3) outptr3[j] = sum[3][j];
+            }
+#endif
+        }
+    }
+}
+
+static int deconvolution_col2im_int8_sse(const Mat& col, Mat& top_blob, int w, int h, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Mat& scale_in_data, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch = top_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+
+    // one int32 accumulator per thread
+    Mat sum_int32(outw * outh, opt.num_threads, (size_t)4u, opt.workspace_allocator);
+    if (sum_int32.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < outch; p++)
+    {
+        int* sumptr = sum_int32.row<int>(get_omp_thread_num());
+
+        memset(sumptr, 0, outw * outh * sizeof(int));
+
+        for (int u = 0; u < kernel_h; u++)
+        {
+            for (int v = 0; v < kernel_w; v++)
+            {
+                const int* colptr = col.row<const int>(p * maxk + u * kernel_w + v);
+
+                for (int i = 0; i < h; i++)
+                {
+                    int* outptr = sumptr + (i * stride_h + u * dilation_h) * outw + v * dilation_w;
+
+                    for (int j = 0; j < w; j++)
+                    {
+                        outptr[j * stride_w] += colptr[j];
+                    }
+
+                    colptr += w;
+                }
+            }
+        }
+
+        const float scale_in = scale_in_data[p];
+        const float bias = bias_data.empty() ? 0.f : bias_data[p];
+
+        float* outptr = top_blob.channel(p);
+
+        int i = 0;
+#if __SSE2__
+        __m128 _scale_in = _mm_set1_ps(scale_in);
+        __m128 _bias = _mm_set1_ps(bias);
+        for (; i + 3 < outw * outh; i += 4)
+        {
+            __m128 _v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(sumptr + i)));
+            _v = _mm_add_ps(_mm_mul_ps(_v, _scale_in), _bias);
+            _v = activation_sse(_v, activation_type, activation_params);
+            _mm_storeu_ps(outptr + i, _v);
+        }
+#endif // __SSE2__
+        for (; i < outw * outh; i++)
+        {
+            outptr[i] = activation_ss(sumptr[i] * scale_in + bias, activation_type, activation_params);
+        }
+    }
+
+    return 0;
+}
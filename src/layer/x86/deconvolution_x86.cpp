@@ -26,6 +26,10 @@
 #include "x86_activation.h"
 #include "x86_usability.h"
 
+#include "cpu.h"
+
+#include <string.h>
+
 namespace ncnn {
 
 #if __SSE2__
@@ -52,6 +56,10 @@ namespace ncnn {
 #endif // __AVX__
 #endif // __SSE2__
 
+#if NCNN_INT8
+#include "deconvolution_int8.h"
+#endif // NCNN_INT8
+
 Deconvolution_x86::Deconvolution_x86()
 {
 #if __SSE2__
@@ -64,6 +72,13 @@ Deconvolution_x86::Deconvolution_x86()
 
 int Deconvolution_x86::create_pipeline(const Option& opt)
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
+    {
+        return create_pipeline_int8_x86(opt);
+    }
+#endif
+
     activation = create_activation_layer(activation_type, activation_params, opt);
 
     const int maxk = kernel_w * kernel_h;
@@ -219,6 +234,13 @@ int Deconvolution_x86::destroy_pipeline(const Option& opt)
 
 int Deconvolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+#if NCNN_INT8
+    if (opt.use_int8_inference && int8_scale_term)
+    {
+        return forward_int8_x86(bottom_blob, top_blob, opt);
+    }
+#endif
+
     // deconvolv with NxN kernel
     // value = value + bias
 
@@ -627,4 +649,126 @@ int Deconvolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Opti
     return 0;
 }
 
+#if NCNN_INT8
+int Deconvolution_x86::create_pipeline_int8_x86(const Option& opt)
+{
+    const int maxk = kernel_w * kernel_h;
+    const int num_input = weight_data_size / maxk / num_output;
+
+    deconvolution_transform_kernel_int8_sse(weight_data, weight_data_tm, num_input, num_output, maxk, opt);
+    if (weight_data_tm.empty())
+        return -100;
+
+    scale_in_data.create(num_output);
+    if (scale_in_data.empty())
+        return -100;
+
+    for (int p = 0; p < num_output; p++)
+    {
+        // dequantize
+        float scale_in;
+        if (weight_data_int8_scales[p] == 0)
+            scale_in = 0;
+        else
+            scale_in = 1.f / (bottom_blob_int8_scales[0] * weight_data_int8_scales[p]);
+
+        scale_in_data[p] = scale_in;
+    }
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int Deconvolution_x86::forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    Option opt_q = opt;
+    opt_q.blob_allocator = opt.workspace_allocator;
+
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (bottom_blob.elempack != 1)
+    {
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_q);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    Mat bottom_blob_int8 = bottom_blob_unpacked;
+    if (bottom_blob_unpacked.elemsize != 1)
+    {
+        quantize_to_int8(bottom_blob_unpacked, bottom_blob_int8, bottom_blob_int8_scales, opt_q);
+        if (bottom_blob_int8.empty())
+            return -100;
+    }
+
+    const int w = bottom_blob_int8.w;
+    const int h = bottom_blob_int8.h;
+
+    const int kernel_extent_w = dilation_w * (kernel_w - 1) + 1;
+    const int kernel_extent_h = dilation_h * (kernel_h - 1) + 1;
+
+    const int outw = (w - 1) * stride_w + kernel_extent_w + output_pad_right;
+    const int outh = (h - 1) * stride_h + kernel_extent_h + output_pad_bottom;
+
+    const int maxk = kernel_w * kernel_h;
+    const int nn = deconvolution_int8_panel_width();
+
+    // col = kernel x input
+    Mat col;
+    {
+        Mat panel;
+        deconvolution_pack_input_int8_sse(bottom_blob_int8, panel, nn, opt);
+        if (panel.empty())
+            return -100;
+
+        col.create(panel.h * nn, maxk * num_output, (size_t)4u, opt.workspace_allocator);
+        if (col.empty())
+            return -100;
+
+        deconvolution_gemm_int8_sse(panel, weight_data_tm, col, maxk * num_output, nn, opt);
+    }
+
+    // dequantize to fp32, the padding is cut before requantize
+    bool use_int8_requantize = int8_scale_term > 100;
+
+    Mat top_blob_bordered;
+    if (use_int8_requantize || pad_left > 0 || pad_right > 0 || pad_top > 0 || pad_bottom > 0 || (output_w > 0 && output_h > 0))
+    {
+        top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.workspace_allocator);
+    }
+    else
+    {
+        top_blob_bordered = top_blob;
+        top_blob_bordered.create(outw, outh, num_output, (size_t)4u, opt.blob_allocator);
+    }
+    if (top_blob_bordered.empty())
+        return -100;
+
+    int ret = deconvolution_col2im_int8_sse(col, top_blob_bordered, w, h, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, scale_in_data, bias_data, activation_type, activation_params, opt);
+    if (ret != 0)
+        return ret;
+
+    if (use_int8_requantize)
+    {
+        Mat top_blob_fp32;
+        cut_padding(top_blob_bordered, top_blob_fp32, opt_q);
+        if (top_blob_fp32.empty())
+            return -100;
+
+        quantize_to_int8(top_blob_fp32, top_blob, top_blob_int8_scales, opt);
+    }
+    else
+    {
+        cut_padding(top_blob_bordered, top_blob, opt);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    return 0;
+}
+#endif // NCNN_INT8
+
 } // namespace ncnn
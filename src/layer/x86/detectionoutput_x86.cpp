@@ -0,0 +1,268 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "detectionoutput_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+#include "x86_nms.h"
+
+#include <math.h>
+
+namespace ncnn {
+
+DetectionOutput_x86::DetectionOutput_x86()
+{
+}
+
+struct BBoxRect
+{
+    float xmin;
+    float ymin;
+    float xmax;
+    float ymax;
+    int label;
+};
+
+static void decode_bboxes(const Mat& location, const Mat& priorbox, const float* variances, int num_prior, bool mxnet_ssd_style, Mat& bboxes, const Option& opt)
+{
+    const float* location_ptr = location;
+    const float* priorbox_ptr = priorbox.row(0);
+    const float* variance_ptr = mxnet_ssd_style ? 0 : priorbox.row(1);
+
+    int remain_num_prior_start = 0;
+#if __SSE2__
+    const int nn_num_prior = num_prior / 4;
+    remain_num_prior_start = nn_num_prior * 4;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ii = 0; ii < nn_num_prior; ii++)
+    {
+        const int i = ii * 4;
+
+        const float* loc = location_ptr + i * 4;
+        const float* pb = priorbox_ptr + i * 4;
+
+        float* bbox = bboxes.row(i);
+
+        // four priors at once, transposed to one coordinate per register
+        __m128 _loc0 = _mm_loadu_ps(loc);
+        __m128 _loc1 = _mm_loadu_ps(loc + 4);
+        __m128 _loc2 = _mm_loadu_ps(loc + 8);
+        __m128 _loc3 = _mm_loadu_ps(loc + 12);
+        _MM_TRANSPOSE4_PS(_loc0, _loc1, _loc2, _loc3);
+
+        __m128 _pb0 = _mm_loadu_ps(pb);
+        __m128 _pb1 = _mm_loadu_ps(pb + 4);
+        __m128 _pb2 = _mm_loadu_ps(pb + 8);
+        __m128 _pb3 = _mm_loadu_ps(pb + 12);
+        _MM_TRANSPOSE4_PS(_pb0, _pb1, _pb2, _pb3);
+
+        __m128 _var0;
+        __m128 _var1;
+        __m128 _var2;
+        __m128 _var3;
+        if (variance_ptr)
+        {
+            const float* var = variance_ptr + i * 4;
+            _var0 = _mm_loadu_ps(var);
+            _var1 = _mm_loadu_ps(var + 4);
+            _var2 = _mm_loadu_ps(var + 8);
+            _var3 = _mm_loadu_ps(var + 12);
+            _MM_TRANSPOSE4_PS(_var0, _var1, _var2, _var3);
+        }
+        else
+        {
+            _var0 = _mm_set1_ps(variances[0]);
+            _var1 = _mm_set1_ps(variances[1]);
+            _var2 = _mm_set1_ps(variances[2]);
+            _var3 = _mm_set1_ps(variances[3]);
+        }
+
+        const __m128 _half = _mm_set1_ps(0.5f);
+
+        // CENTER_SIZE
+        __m128 _pb_w = _mm_sub_ps(_pb2, _pb0);
+        __m128 _pb_h = _mm_sub_ps(_pb3, _pb1);
+        __m128 _pb_cx = _mm_mul_ps(_mm_add_ps(_pb0, _pb2), _half);
+        __m128 _pb_cy = _mm_mul_ps(_mm_add_ps(_pb1, _pb3), _half);
+
+        __m128 _bbox_cx = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_var0, _loc0), _pb_w), _pb_cx);
+        __m128 _bbox_cy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_var1, _loc1), _pb_h), _pb_cy);
+        __m128 _bbox_w = _mm_mul_ps(exp_ps(_mm_mul_ps(_var2, _loc2)), _pb_w);
+        __m128 _bbox_h = _mm_mul_ps(exp_ps(_mm_mul_ps(_var3, _loc3)), _pb_h);
+
+        __m128 _bbox0 = _mm_sub_ps(_bbox_cx, _mm_mul_ps(_bbox_w, _half));
+        __m128 _bbox1 = _mm_sub_ps(_bbox_cy, _mm_mul_ps(_bbox_h, _half));
+        __m128 _bbox2 = _mm_add_ps(_bbox_cx, _mm_mul_ps(_bbox_w, _half));
+        __m128 _bbox3 = _mm_add_ps(_bbox_cy, _mm_mul_ps(_bbox_h, _half));
+        _MM_TRANSPOSE4_PS(_bbox0, _bbox1, _bbox2, _bbox3);
+
+        _mm_storeu_ps(bbox, _bbox0);
+        _mm_storeu_ps(bbox + 4, _bbox1);
+        _mm_storeu_ps(bbox + 8, _bbox2);
+        _mm_storeu_ps(bbox + 12, _bbox3);
+    }
+#endif // __SSE2__
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = remain_num_prior_start; i < num_prior; i++)
+    {
+        const float* loc = location_ptr + i * 4;
+        const float* pb = priorbox_ptr + i * 4;
+        const float* var = variance_ptr ? variance_ptr + i * 4 : variances;
+
+        float* bbox = bboxes.row(i);
+
+        // CENTER_SIZE
+        float pb_w = pb[2] - pb[0];
+        float pb_h = pb[3] - pb[1];
+        float pb_cx = (pb[0] + pb[2]) * 0.5f;
+        float pb_cy = (pb[1] + pb[3]) * 0.5f;
+
+        float bbox_cx = var[0] * loc[0] * pb_w + pb_cx;
+        float bbox_cy = var[1] * loc[1] * pb_h + pb_cy;
+        float bbox_w = expf(var[2] * loc[2]) * pb_w;
+        float bbox_h = expf(var[3] * loc[3]) * pb_h;
+
+        bbox[0] = bbox_cx - bbox_w * 0.5f;
+        bbox[1] = bbox_cy - bbox_h * 0.5f;
+        bbox[2] = bbox_cx + bbox_w * 0.5f;
+        bbox[3] = bbox_cy + bbox_h * 0.5f;
+    }
+}
+
+int DetectionOutput_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& location = bottom_blobs[0];
+    const Mat& confidence = bottom_blobs[1];
+    const Mat& priorbox = bottom_blobs[2];
+
+    bool mxnet_ssd_style = num_class == -233;
+
+    // mxnet-ssd _contrib_MultiBoxDetection
+    const int num_prior = mxnet_ssd_style ? priorbox.h : priorbox.w / 4;
+
+    int num_class_copy = mxnet_ssd_style ? confidence.h : num_class;
+
+    // apply location with priorbox
+    // every prior is decoded, which is cheaper than testing the background score of each one
+    Mat bboxes;
+    bboxes.create(4, num_prior, 4u, opt.workspace_allocator);
+    if (bboxes.empty())
+        return -100;
+
+    decode_bboxes(location, priorbox, variances, num_prior, mxnet_ssd_style, bboxes, opt);
+
+    // sort and nms for each class
+    std::vector<std::vector<BBoxRect> > all_class_bbox_rects;
+    std::vector<std::vector<float> > all_class_bbox_scores;
+    all_class_bbox_rects.resize(num_class_copy);
+    all_class_bbox_scores.resize(num_class_copy);
+
+    // start from 1 to ignore background class
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 1; i < num_class_copy; i++)
+    {
+        // filter by confidence_threshold
+        std::vector<int> class_bbox_indices;
+        std::vector<float> class_bbox_scores;
+
+        for (int j = 0; j < num_prior; j++)
+        {
+            // prob data layout
+            // caffe-ssd = num_class x num_prior
+            // mxnet-ssd = num_prior x num_class
+            float score = mxnet_ssd_style ? confidence[i * num_prior + j] : confidence[j * num_class_copy + i];
+
+            if (score > confidence_threshold)
+            {
+                class_bbox_indices.push_back(j);
+                class_bbox_scores.push_back(score);
+            }
+        }
+
+        // keep nms_top_k in descending order
+        std::vector<int> order;
+        topk_descent_indices(class_bbox_scores, nms_top_k, order);
+
+        std::vector<BBoxRect> class_bbox_rects(order.size());
+        for (size_t j = 0; j < order.size(); j++)
+        {
+            const float* bbox = bboxes.row(class_bbox_indices[order[j]]);
+            BBoxRect c = {bbox[0], bbox[1], bbox[2], bbox[3], i};
+            class_bbox_rects[j] = c;
+        }
+
+        // apply nms
+        std::vector<size_t> picked;
+        nms_sorted_bboxes_x86(class_bbox_rects, picked, nms_threshold);
+
+        // select
+        for (size_t j = 0; j < picked.size(); j++)
+        {
+            size_t z = picked[j];
+            all_class_bbox_rects[i].push_back(class_bbox_rects[z]);
+            all_class_bbox_scores[i].push_back(class_bbox_scores[order[z]]);
+        }
+    }
+
+    // gather all class
+    std::vector<BBoxRect> bbox_rects;
+    std::vector<float> bbox_scores;
+
+    for (int i = 1; i < num_class_copy; i++)
+    {
+        const std::vector<BBoxRect>& class_bbox_rects = all_class_bbox_rects[i];
+        const std::vector<float>& class_bbox_scores = all_class_bbox_scores[i];
+
+        bbox_rects.insert(bbox_rects.end(), class_bbox_rects.begin(), class_bbox_rects.end());
+        bbox_scores.insert(bbox_scores.end(), class_bbox_scores.begin(), class_bbox_scores.end());
+    }
+
+    // keep_top_k in descending order
+    std::vector<int> order;
+    topk_descent_indices(bbox_scores, keep_top_k, order);
+
+    // fill result
+    int num_detected = static_cast<int>(order.size());
+    if (num_detected == 0)
+        return 0;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(6, num_detected, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    for (int i = 0; i < num_detected; i++)
+    {
+        const BBoxRect& r = bbox_rects[order[i]];
+        float score = bbox_scores[order[i]];
+        float* outptr = top_blob.row(i);
+
+        outptr[0] = static_cast<float>(r.label);
+        outptr[1] = score;
+        outptr[2] = r.xmin;
+        outptr[3] = r.ymin;
+        outptr[4] = r.xmax;
+        outptr[5] = r.ymax;
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
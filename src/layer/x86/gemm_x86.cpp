@@ -20,9 +20,11 @@
 #include <immintrin.h>
 #endif // __AVX__
 #endif // __SSE2__
+#include "x86_activation.h"
 #include "x86_usability.h"
 
 #include "cpu.h"
+#include "layer_type.h"
 
 namespace ncnn {
 
@@ -33,6 +35,21 @@ Gemm_x86::Gemm_x86()
 #endif // __SSE2__
 
     nT = 0;
+    residual_binaryop = 0;
+}
+
+static Layer* create_residual_binaryop_layer(const Option& opt)
+{
+    Layer* op = create_layer(LayerType::BinaryOp);
+
+    ParamDict pd;
+    pd.set(0, 0); // add
+
+    op->load_param(pd);
+
+    op->create_pipeline(opt);
+
+    return op;
 }
 
 static void pack_A_tile(const Mat& A, Mat& AT, int i, int max_ii, int k, int max_kk)
@@ -6431,6 +6448,30 @@ static void gemm_transB_packed_tile(const Mat& AT_tile, const Mat& BT_tile, cons
 
             const float* pA = pAT;
             int kk = 0;
+#if __AVX__
+            {
+                // a single row is latency bound, keep two chains of sums in flight
+                __m256 _sum01 = _mm256_insertf128_ps(_mm256_castps128_ps256(_sum0), _sum1, 1);
+                __m256 _sum01b = _mm256_setzero_ps();
+                __m128 _sum2b = _mm_setzero_ps();
+                for (; kk + 1 < max_kk; kk += 2)
+                {
+                    __m256 _pA0 = _mm256_set1_ps(pA[0]);
+                    __m256 _pA1 = _mm256_set1_ps(pA[1]);
+                    _sum01 = _mm256_comp_fmadd_ps(_pA0, _mm256_loadu_ps(pB), _sum01);
+                    _sum2 = _mm_comp_fmadd_ps(_mm256_castps256_ps128(_pA0), _mm_load_ps(pB + 8), _sum2);
+                    _sum01b = _mm256_comp_fmadd_ps(_pA1, _mm256_loadu_ps(pB + 12), _sum01b);
+                    _sum2b = _mm_comp_fmadd_ps(_mm256_castps256_ps128(_pA1), _mm_load_ps(pB + 20), _sum2b);
+
+                    pA += 2;
+                    pB += 24;
+                }
+                _sum01 = _mm256_add_ps(_sum01, _sum01b);
+                _sum0 = _mm256_castps256_ps128(_sum01);
+                _sum1 = _mm256_extractf128_ps(_sum01, 1);
+                _sum2 = _mm_add_ps(_sum2, _sum2b);
+            }
+#endif // __AVX__
             for (; kk < max_kk; kk += 1)
             {
                 __m128 _pB0 = _mm_load_ps(pB);
@@ -6498,6 +6539,23 @@ static void gemm_transB_packed_tile(const Mat& AT_tile, const Mat& BT_tile, cons
 
             const float* pA = pAT;
             int kk = 0;
+#if __AVX__
+            {
+                __m256 _sum01 = _mm256_insertf128_ps(_mm256_castps128_ps256(_sum0), _sum1, 1);
+                __m256 _sum01b = _mm256_setzero_ps();
+                for (; kk + 1 < max_kk; kk += 2)
+                {
+                    _sum01 = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA[0]), _mm256_loadu_ps(pB), _sum01);
+                    _sum01b = _mm256_comp_fmadd_ps(_mm256_set1_ps(pA[1]), _mm256_loadu_ps(pB + 8), _sum01b);
+
+                    pA += 2;
+                    pB += 16;
+                }
+                _sum01 = _mm256_add_ps(_sum01, _sum01b);
+                _sum0 = _mm256_castps256_ps128(_sum01);
+                _sum1 = _mm256_extractf128_ps(_sum01, 1);
+            }
+#endif // __AVX__
             for (; kk < max_kk; kk += 1)
             {
                 __m128 _pB0 = _mm_load_ps(pB);
@@ -6841,7 +6899,299 @@ static void get_optimal_tile_mnk(int M, int N, int K, int constant_TILE_M, int c
     }
 }
 
-static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int broadcast_type_C, int transA, int transB, int output_transpose, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
+static void get_skinny_tile_n(int M, int N, int TILE_M, int& TILE_N, int nT)
+{
+    // spread the columns over the threads the M tiles leave idle
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+    const int nn_N = (N + TILE_N - 1) / TILE_N;
+
+    if (nT <= 1 || nn_M >= nT || nn_M * nn_N >= nT)
+        return;
+
+    const int nn_N_wanted = (nT + nn_M - 1) / nn_M;
+#if __SSE2__
+    TILE_N = std::min(TILE_N, std::max(4, ((N + nn_N_wanted - 1) / nn_N_wanted + 3) / 4 * 4));
+#else
+    TILE_N = std::min(TILE_N, std::max(1, (N + nn_N_wanted - 1) / nn_N_wanted));
+#endif
+}
+
+// schedule for fewer M tiles than threads, as in batch-1 projections with tiny M and huge K
+// the (M, N) tiles are spread over the threads, and when there are still too few of them
+// the K tiles are split into ranges whose partial sums are reduced afterwards
+// AT holds all M tiles pre-packed, or is empty when A has to be packed here
+// the fused activation over one output tile while it is still in cache
+// the row tiles are aligned to the output elempack
+static void gemm_activation_tile(Mat& top_blob, int i, int max_ii, int j, int max_jj, int activation_type, const Mat& activation_params)
+{
+    const int out_elempack = top_blob.elempack;
+    const int out_hstep = top_blob.dims == 3 ? (int)top_blob.cstep : top_blob.w;
+
+    const int size = max_jj * out_elempack;
+
+    for (int ii = i / out_elempack; ii < (i + max_ii) / out_elempack; ii++)
+    {
+        float* ptr = (float*)top_blob + (ii * out_hstep + j) * out_elempack;
+
+        int kk = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; kk + 15 < size; kk += 16)
+        {
+            _mm512_storeu_ps(ptr + kk, activation_avx512(_mm512_loadu_ps(ptr + kk), activation_type, activation_params));
+        }
+#endif // __AVX512F__
+        for (; kk + 7 < size; kk += 8)
+        {
+            _mm256_storeu_ps(ptr + kk, activation_avx(_mm256_loadu_ps(ptr + kk), activation_type, activation_params));
+        }
+#endif // __AVX__
+        for (; kk + 3 < size; kk += 4)
+        {
+            _mm_storeu_ps(ptr + kk, activation_sse(_mm_loadu_ps(ptr + kk), activation_type, activation_params));
+        }
+#endif // __SSE2__
+        for (; kk < size; kk++)
+        {
+            ptr[kk] = activation_ss(ptr[kk], activation_type, activation_params);
+        }
+    }
+}
+
+static int gemm_skinny_x86(const Mat& A, const Mat& AT, const Mat& BT, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int N, int K, int transA, int output_transpose, int activation_type, const Mat& activation_params, int TILE_M, int TILE_N, int TILE_K, int nT, const Option& opt)
+{
+    const int nn_M = (M + TILE_M - 1) / TILE_M;
+    const int nn_N = (N + TILE_N - 1) / TILE_N;
+    const int nn_K = (K + TILE_K - 1) / TILE_K;
+
+    Mat ATX = AT;
+    if (ATX.empty())
+    {
+        ATX.create(TILE_K * TILE_M, nn_K, nn_M, 4u, opt.workspace_allocator);
+        if (ATX.empty())
+            return -100;
+
+        const int nn_MK = nn_M * nn_K;
+
+        // pack A
+        #pragma omp parallel for num_threads(nT)
+        for (int ppik = 0; ppik < nn_MK; ppik++)
+        {
+            const int ppi = ppik / nn_K;
+            const int ppk = ppik % nn_K;
+
+            const int i = ppi * TILE_M;
+            const int k = ppk * TILE_K;
+
+            const int max_ii = std::min((M - i), TILE_M);
+            const int max_kk = std::min((K - k), TILE_K);
+
+            Mat AT_tile = ATX.channel(ppi).row_range(ppk, 1);
+
+            if (transA)
+            {
+                transpose_pack_A_tile(A, AT_tile, i, max_ii, k, max_kk);
+            }
+            else
+            {
+                pack_A_tile(A, AT_tile, i, max_ii, k, max_kk);
+            }
+        }
+    }
+
+    const int nn_MN = nn_M * nn_N;
+
+    // split K only as far as the partial sums of all tiles stay in level3 cache
+    int nn_KS = 1;
+    if (nn_MN < nT && nn_K > 1)
+    {
+        nn_KS = std::min(nn_K, (nT + nn_MN - 1) / nn_MN);
+
+        const int l3_cache_size = get_cpu_level3_cache_size();
+        if (l3_cache_size > 0)
+        {
+            const int partial_size = nn_MN * TILE_M * TILE_N * (int)sizeof(float);
+            nn_KS = std::max(1, std::min(nn_KS, l3_cache_size / 2 / partial_size));
+        }
+    }
+
+    const int ks_step = (nn_K + nn_KS - 1) / nn_KS;
+    nn_KS = (nn_K + ks_step - 1) / ks_step;
+
+    if (nn_KS == 1)
+    {
+        Mat topT;
+        if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
+            topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+
+        #pragma omp parallel for num_threads(nT)
+        for (int ppij = 0; ppij < nn_MN; ppij++)
+        {
+            const int ppi = ppij / nn_N;
+            const int ppj = ppij % nn_N;
+
+            const int i = ppi * TILE_M;
+            const int j = ppj * TILE_N;
+
+            const int max_ii = std::min((M - i), TILE_M);
+            const int max_jj = std::min((N - j), TILE_N);
+
+            Mat topT_tile;
+            if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
+                topT_tile = topT.channel(get_omp_thread_num());
+
+            if (broadcast_type_C == 3)
+            {
+                pack_A_tile(C, topT_tile, i, max_ii, j, max_jj);
+            }
+
+            const Mat& CT_tile = broadcast_type_C == 3 ? topT_tile : C;
+
+            for (int k = 0; k < K; k += TILE_K)
+            {
+                const int max_kk = std::min((K - k), TILE_K);
+
+                Mat AT_tile = ATX.channel(ppi).row_range(k / TILE_K, 1);
+
+                Mat BT_tile = BT.channel(ppj).row_range(k / TILE_K, 1);
+
+                bool k_end = !output_transpose && k + TILE_K >= K;
+
+                gemm_transB_packed_tile(AT_tile, BT_tile, CT_tile, topT_tile, top_blob, broadcast_type_C, i, max_ii, j, max_jj, k, max_kk, k_end);
+            }
+
+            if (output_transpose)
+            {
+                transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
+            }
+            else if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
+        }
+
+        return 0;
+    }
+
+    // one partial sum per tile and K range
+    Mat topTS(TILE_N * TILE_M, nn_KS, nn_MN, 4u, opt.workspace_allocator);
+    if (topTS.empty())
+        return -100;
+
+    const int nn_MNKS = nn_MN * nn_KS;
+
+    #pragma omp parallel for num_threads(nT)
+    for (int ppijk = 0; ppijk < nn_MNKS; ppijk++)
+    {
+        const int ppij = ppijk / nn_KS;
+        const int ppks = ppijk % nn_KS;
+
+        const int ppi = ppij / nn_N;
+        const int ppj = ppij % nn_N;
+
+        const int i = ppi * TILE_M;
+        const int j = ppj * TILE_N;
+
+        const int max_ii = std::min((M - i), TILE_M);
+        const int max_jj = std::min((N - j), TILE_N);
+
+        Mat topT_tile = topTS.channel(ppij).row_range(ppks, 1);
+
+        // only the first range starts from C, the others accumulate onto zero
+        if (ppks == 0 && broadcast_type_C == 3)
+        {
+            pack_A_tile(C, topT_tile, i, max_ii, j, max_jj);
+        }
+        if (ppks != 0)
+        {
+            topT_tile.fill(0.f);
+        }
+
+        const Mat& CT_tile = broadcast_type_C == 3 ? topT_tile : C;
+
+        const int k_start = ppks * ks_step * TILE_K;
+        const int k_stop = std::min(K, k_start + ks_step * TILE_K);
+
+        for (int k = k_start; k < k_stop; k += TILE_K)
+        {
+            const int max_kk = std::min((k_stop - k), TILE_K);
+
+            Mat AT_tile = ATX.channel(ppi).row_range(k / TILE_K, 1);
+
+            Mat BT_tile = BT.channel(ppj).row_range(k / TILE_K, 1);
+
+            gemm_transB_packed_tile(AT_tile, BT_tile, CT_tile, topT_tile, top_blob, broadcast_type_C, i, max_ii, j, max_jj, k, max_kk, false);
+        }
+    }
+
+    // reduce the K ranges and write out
+    #pragma omp parallel for num_threads(nT)
+    for (int ppij = 0; ppij < nn_MN; ppij++)
+    {
+        const int ppi = ppij / nn_N;
+        const int ppj = ppij % nn_N;
+
+        const int i = ppi * TILE_M;
+        const int j = ppj * TILE_N;
+
+        const int max_ii = std::min((M - i), TILE_M);
+        const int max_jj = std::min((N - j), TILE_N);
+
+        const int size = max_ii * max_jj;
+
+        Mat topT_tile = topTS.channel(ppij).row_range(0, 1);
+
+        float* outptr = topT_tile;
+        for (int ks = 1; ks < nn_KS; ks++)
+        {
+            const float* ptr = topTS.channel(ppij).row(ks);
+
+            int kk = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            for (; kk + 15 < size; kk += 16)
+            {
+                _mm512_storeu_ps(outptr + kk, _mm512_add_ps(_mm512_loadu_ps(outptr + kk), _mm512_loadu_ps(ptr + kk)));
+            }
+#endif // __AVX512F__
+            for (; kk + 7 < size; kk += 8)
+            {
+                _mm256_storeu_ps(outptr + kk, _mm256_add_ps(_mm256_loadu_ps(outptr + kk), _mm256_loadu_ps(ptr + kk)));
+            }
+#endif // __AVX__
+            for (; kk + 3 < size; kk += 4)
+            {
+                _mm_storeu_ps(outptr + kk, _mm_add_ps(_mm_loadu_ps(outptr + kk), _mm_loadu_ps(ptr + kk)));
+            }
+#endif // __SSE2__
+            for (; kk < size; kk++)
+            {
+                outptr[kk] += ptr[kk];
+            }
+        }
+
+        if (output_transpose)
+        {
+            transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
+        }
+        else
+        {
+            // no more K to accumulate, the tile kernel just unpacks the sums
+            gemm_transB_packed_tile(Mat(), Mat(), C, topT_tile, top_blob, broadcast_type_C, i, max_ii, j, max_jj, K, 0, true);
+
+            if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int broadcast_type_C, int transA, int transB, int output_transpose, int activation_type, const Mat& activation_params, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
 {
     const int M = transA ? A.w : (A.dims == 3 ? A.c : A.h) * A.elempack;
     const int K = transA ? (A.dims == 3 ? A.c : A.h) * A.elempack : A.w;
@@ -6852,13 +7202,15 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
     int TILE_M, TILE_N, TILE_K;
     get_optimal_tile_mnk(M, N, K, constant_TILE_M, constant_TILE_N, constant_TILE_K, TILE_M, TILE_N, TILE_K, nT);
 
+    if (constant_TILE_N <= 0)
+        get_skinny_tile_n(M, N, TILE_M, TILE_N, nT);
+
     // NCNN_LOGE("TILE M/N/K = %d %d %d", TILE_M, TILE_N, TILE_K);
 
     int nn_M = (M + TILE_M - 1) / TILE_M;
     int nn_N = (N + TILE_N - 1) / TILE_N;
     int nn_K = (K + TILE_K - 1) / TILE_K;
 
-    Mat ATX(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 4u, opt.workspace_allocator);
     Mat BT(TILE_K * TILE_N, (K + TILE_K - 1) / TILE_K, (N + TILE_N - 1) / TILE_N, 4u, opt.workspace_allocator);
 
     const int nn_NK = nn_N * nn_K;
@@ -6888,6 +7240,13 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
         }
     }
 
+    if (nT > 1 && nn_M < nT)
+    {
+        return gemm_skinny_x86(A, Mat(), BT, C, top_blob, broadcast_type_C, M, N, K, transA, output_transpose, activation_type, activation_params, TILE_M, TILE_N, TILE_K, nT, opt);
+    }
+
+    Mat ATX(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 4u, opt.workspace_allocator);
+
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
         topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
@@ -6949,13 +7308,17 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
             {
                 transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
             }
+            else if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
         }
     }
 
     return 0;
 }
 
-static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int K, int transB, int output_transpose, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
+static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int K, int transB, int output_transpose, int activation_type, const Mat& activation_params, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
 {
     const int N = transB ? (B.dims == 3 ? B.c : B.h) * B.elempack : B.w;
 
@@ -6964,6 +7327,9 @@ static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob,
     int TILE_M, TILE_N, TILE_K;
     get_optimal_tile_mnk(M, N, K, constant_TILE_M, constant_TILE_N, constant_TILE_K, TILE_M, TILE_N, TILE_K, nT);
 
+    if (constant_TILE_N <= 0)
+        get_skinny_tile_n(M, N, TILE_M, TILE_N, nT);
+
     // NCNN_LOGE("TILE M/N/K = %d %d %d", TILE_M, TILE_N, TILE_K);
 
     int nn_M = (M + TILE_M - 1) / TILE_M;
@@ -6999,6 +7365,11 @@ static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob,
         }
     }
 
+    if (nT > 1 && nn_M < nT)
+    {
+        return gemm_skinny_x86(Mat(), AT, BT, C, top_blob, broadcast_type_C, M, N, K, 0, output_transpose, activation_type, activation_params, TILE_M, TILE_N, TILE_K, nT, opt);
+    }
+
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
         topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
@@ -7044,13 +7415,17 @@ static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob,
             {
                 transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
             }
+            else if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
         }
     }
 
     return 0;
 }
 
-static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob, int broadcast_type_C, int N, int K, int transA, int output_transpose, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
+static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob, int broadcast_type_C, int N, int K, int transA, int output_transpose, int activation_type, const Mat& activation_params, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
 {
     const int M = transA ? A.w : (A.dims == 3 ? A.c : A.h) * A.elempack;
 
@@ -7064,6 +7439,11 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
     int nn_M = (M + TILE_M - 1) / TILE_M;
     // int nn_N = (N + TILE_N - 1) / TILE_N;
 
+    if (nT > 1 && nn_M < nT)
+    {
+        return gemm_skinny_x86(A, Mat(), BT, C, top_blob, broadcast_type_C, M, N, K, transA, output_transpose, activation_type, activation_params, TILE_M, TILE_N, TILE_K, nT, opt);
+    }
+
     Mat ATX(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 4u, opt.workspace_allocator);
 
     Mat topT;
@@ -7127,13 +7507,17 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
             {
                 transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
             }
+            else if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
         }
     }
 
     return 0;
 }
 
-static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int N, int K, int output_transpose, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
+static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_blob, int broadcast_type_C, int M, int N, int K, int output_transpose, int activation_type, const Mat& activation_params, int constant_TILE_M, int constant_TILE_N, int constant_TILE_K, int nT, const Option& opt)
 {
     // NCNN_LOGE("M/N/K = %d %d %d", M, N, K);
 
@@ -7145,6 +7529,11 @@ static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
     int nn_M = (M + TILE_M - 1) / TILE_M;
     // int nn_N = (N + TILE_N - 1) / TILE_N;
 
+    if (nT > 1 && nn_M < nT)
+    {
+        return gemm_skinny_x86(Mat(), AT, BT, C, top_blob, broadcast_type_C, M, N, K, 0, output_transpose, activation_type, activation_params, TILE_M, TILE_N, TILE_K, nT, opt);
+    }
+
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
         topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
@@ -7190,6 +7579,10 @@ static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
             {
                 transpose_unpack_output_tile(topT_tile, top_blob, i, max_ii, j, max_jj);
             }
+            else if (activation_type)
+            {
+                gemm_activation_tile(top_blob, i, max_ii, j, max_jj, activation_type, activation_params);
+            }
         }
     }
 
@@ -7198,6 +7591,11 @@ static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
 
 int Gemm_x86::create_pipeline(const Option& opt)
 {
+    if (fuse_residual)
+    {
+        residual_binaryop = create_residual_binaryop_layer(opt);
+    }
+
     if (constantA)
     {
         const int M = constantM;
@@ -7335,6 +7733,57 @@ int Gemm_x86::create_pipeline(const Option& opt)
     return 0;
 }
 
+int Gemm_x86::destroy_pipeline(const Option& opt)
+{
+    if (residual_binaryop)
+    {
+        residual_binaryop->destroy_pipeline(opt);
+        delete residual_binaryop;
+        residual_binaryop = 0;
+    }
+
+    return 0;
+}
+
+int Gemm_x86::save_weight_cache(std::vector<Mat>& mats) const
+{
+    if (!constantA && !constantB && !constantC)
+        return -1;
+
+    mats.resize(3);
+    mats[0] = AT_data;
+    mats[1] = BT_data;
+    mats[2] = CT_data;
+
+    return 0;
+}
+
+int Gemm_x86::load_weight_cache(const std::vector<Mat>& mats, const Option& opt)
+{
+    if ((!constantA && !constantB && !constantC) || mats.size() != 3)
+        return -1;
+
+    AT_data = mats[0];
+    BT_data = mats[1];
+    CT_data = mats[2];
+
+    nT = opt.num_threads;
+
+    if (fuse_residual)
+    {
+        residual_binaryop = create_residual_binaryop_layer(opt);
+    }
+
+    if (opt.lightmode)
+    {
+        A_data.release();
+        B_data.release();
+        C_data.release();
+    }
+
+    return 0;
+}
+
 int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     int M;
@@ -7441,6 +7890,14 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
         }
     }
 
+    if (fuse_residual && !C.empty())
+    {
+        // the residual is folded into C only where gemm broadcasts it the same way as binaryop
+        const bool broadcast_as_binaryop = (C.dims == 1 && C.w == 1) || (C.dims == 2 && (C.w == N || C.w == 1) && (C.h * C.elempack == M || C.h * C.elempack == 1));
+        if (!broadcast_as_binaryop)
+            return forward_residual_fallback(bottom_blobs, top_blobs, opt);
+    }
+
     int out_elempack = 1;
 #if __SSE2__
     if (opt.use_packing_layout)
@@ -7488,23 +7945,23 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     int ret = 0;
     if (constantA && constantB)
     {
-        ret = gemm_AT_BT_x86(AT_data, BT_data, C, top_blob, broadcast_type_C, constantM, constantN, constantK, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        ret = gemm_AT_BT_x86(AT_data, BT_data, C, top_blob, broadcast_type_C, constantM, constantN, constantK, output_transpose, activation_type, activation_params, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
     }
     else if (constantA)
     {
         const Mat& B = bottom_blobs[0];
-        ret = gemm_AT_x86(AT_data, B, C, top_blob, broadcast_type_C, constantM, constantK, transB, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        ret = gemm_AT_x86(AT_data, B, C, top_blob, broadcast_type_C, constantM, constantK, transB, output_transpose, activation_type, activation_params, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
     }
     else if (constantB)
     {
         const Mat& A = bottom_blobs[0];
-        ret = gemm_BT_x86(A, BT_data, C, top_blob, broadcast_type_C, constantN, constantK, transA, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        ret = gemm_BT_x86(A, BT_data, C, top_blob, broadcast_type_C, constantN, constantK, transA, output_transpose, activation_type, activation_params, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
     }
     else
     {
         const Mat& A = bottom_blobs[0];
         const Mat& B = bottom_blobs[1];
-        ret = gemm_x86(A, B, C, top_blob, broadcast_type_C, transA, transB, output_transpose, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
+        ret = gemm_x86(A, B, C, top_blob, broadcast_type_C, transA, transB, output_transpose, activation_type, activation_params, constant_TILE_M, constant_TILE_N, constant_TILE_K, _nT, opt);
     }
 
     // multiply top_blob with alpha
@@ -7522,4 +7979,25 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     return ret;
 }
 
+int Gemm_x86::forward_residual_fallback(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_b = opt;
+    opt_b.blob_allocator = opt.workspace_allocator;
+
+    // gemm without the trailing residual input
+    std::vector<Mat> bottom_blobs_gemm(bottom_blobs.begin(), bottom_blobs.end() - 1);
+    std::vector<Mat> top_blobs_gemm(1);
+    int ret = forward(bottom_blobs_gemm, top_blobs_gemm, opt_b);
+    if (ret != 0)
+        return ret;
+
+    std::vector<Mat> bottom_blobs_unpacked(2);
+    convert_packing(top_blobs_gemm[0], bottom_blobs_unpacked[0], 1, opt_b);
+    convert_packing(bottom_blobs.back(), bottom_blobs_unpacked[1], 1, opt_b);
+    if (bottom_blobs_unpacked[0].empty() || bottom_blobs_unpacked[1].empty())
+        return -100;
+
+    return residual_binaryop->forward(bottom_blobs_unpacked, top_blobs, opt);
+}
+
 } // namespace ncnn
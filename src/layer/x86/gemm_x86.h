@@ -25,14 +25,24 @@ public:
     Gemm_x86();
 
     virtual int create_pipeline(const Option& opt);
+    virtual int destroy_pipeline(const Option& opt);
+
+    virtual int save_weight_cache(std::vector<Mat>& mats) const;
+    virtual int load_weight_cache(const std::vector<Mat>& mats, const Option& opt);
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+protected:
+    int forward_residual_fallback(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
 public:
     int nT;
     Mat AT_data;
     Mat BT_data;
     Mat CT_data;
+
+    // forward_residual_fallback
+    Layer* residual_binaryop;
 };
 
 } // namespace ncnn
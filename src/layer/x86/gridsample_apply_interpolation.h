@@ -0,0 +1,824 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+void gridsample_nearest_apply_interpolation_p1_avx2(const Mat& src, Mat& dst, const Mat& offset_blob, const Option& opt);
+void gridsample_2d_bilinear_apply_interpolation_p1_avx2(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt);
+void gridsample_2d_bicubic_apply_interpolation_p1_avx2(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt);
+void gridsample_3d_bilinear_apply_interpolation_p1_avx2(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt);
+#endif
+
+static NCNN_FORCEINLINE float gridsample_load(const float* ptr, int offset)
+{
+    return offset >= 0 ? ptr[offset] : 0.f;
+}
+
+#if __SSE2__
+static NCNN_FORCEINLINE __m128 gridsample_load_pack4(const float* ptr, int offset)
+{
+    return offset >= 0 ? _mm_load_ps(ptr + offset) : _mm_setzero_ps();
+}
+
+#if __AVX__
+static NCNN_FORCEINLINE __m256 gridsample_load_pack8(const float* ptr, int offset)
+{
+    return offset >= 0 ? _mm256_load_ps(ptr + offset) : _mm256_setzero_ps();
+}
+
+#if __AVX2__
+// gather 8 output points at once, lanes with negative offset read as zero
+static NCNN_FORCEINLINE __m256 gridsample_gather_p8(const float* ptr, const int* offset_ptr)
+{
+    __m256i _offset = _mm256_loadu_si256((const __m256i*)offset_ptr);
+    __m256 _mask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_offset, _mm256_set1_epi32(-1)));
+    return _mm256_mask_i32gather_ps(_mm256_setzero_ps(), ptr, _offset, _mask, sizeof(float));
+}
+#endif // __AVX2__
+
+#if __AVX512F__
+static NCNN_FORCEINLINE __m512 gridsample_load_pack16(const float* ptr, int offset)
+{
+    return offset >= 0 ? _mm512_load_ps(ptr + offset) : _mm512_setzero_ps();
+}
+
+// gather 16 output points at once, lanes with negative offset read as zero
+static NCNN_FORCEINLINE __m512 gridsample_gather_p16(const float* ptr, const int* offset_ptr)
+{
+    __m512i _offset = _mm512_loadu_si512((const __m512i*)offset_ptr);
+    __mmask16 _mask = _mm512_cmpgt_epi32_mask(_offset, _mm512_set1_epi32(-1));
+    return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), _mask, _offset, ptr, sizeof(float));
+}
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+static void gridsample_nearest_apply_interpolation_p16(const Mat& src, Mat& dst, const Mat& offset_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    const int* offset_ptr = offset_blob.row<const int>(0);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            _mm512_store_ps(outptr, gridsample_load_pack16(srcptr, offset_ptr[i]));
+            outptr += 16;
+        }
+    }
+}
+
+static void gridsample_2d_bilinear_apply_interpolation_p16(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    const int* offset_ptr00 = offset_blob.row<const int>(0);
+    const int* offset_ptr01 = offset_blob.row<const int>(1);
+    const int* offset_ptr10 = offset_blob.row<const int>(2);
+    const int* offset_ptr11 = offset_blob.row<const int>(3);
+    const float* alpha_ptr = value_blob.row(0);
+    const float* beta_ptr = value_blob.row(1);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m512 _v00 = gridsample_load_pack16(srcptr, offset_ptr00[i]);
+            __m512 _v01 = gridsample_load_pack16(srcptr, offset_ptr01[i]);
+            __m512 _v10 = gridsample_load_pack16(srcptr, offset_ptr10[i]);
+            __m512 _v11 = gridsample_load_pack16(srcptr, offset_ptr11[i]);
+
+            __m512 _alpha = _mm512_set1_ps(alpha_ptr[i]);
+            __m512 _beta = _mm512_set1_ps(beta_ptr[i]);
+            __m512 _alpha1 = _mm512_set1_ps(1.f - alpha_ptr[i]);
+            __m512 _beta1 = _mm512_set1_ps(1.f - beta_ptr[i]);
+
+            __m512 _v0 = _mm512_fmadd_ps(_v01, _alpha, _mm512_mul_ps(_v00, _alpha1));
+            __m512 _v1 = _mm512_fmadd_ps(_v11, _alpha, _mm512_mul_ps(_v10, _alpha1));
+            __m512 _v = _mm512_fmadd_ps(_v1, _beta, _mm512_mul_ps(_v0, _beta1));
+
+            _mm512_store_ps(outptr, _v);
+            outptr += 16;
+        }
+    }
+}
+
+static void gridsample_2d_bicubic_apply_interpolation_p16(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m512 _x_coeff0 = _mm512_set1_ps(value_blob.row(0)[i]);
+            __m512 _x_coeff1 = _mm512_set1_ps(value_blob.row(1)[i]);
+            __m512 _x_coeff2 = _mm512_set1_ps(value_blob.row(2)[i]);
+            __m512 _x_coeff3 = _mm512_set1_ps(value_blob.row(3)[i]);
+
+            __m512 _v = _mm512_setzero_ps();
+            for (int ii = 0; ii < 4; ii++)
+            {
+                __m512 _r0 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(ii * 4 + 0)[i]);
+                __m512 _r1 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(ii * 4 + 1)[i]);
+                __m512 _r2 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(ii * 4 + 2)[i]);
+                __m512 _r3 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(ii * 4 + 3)[i]);
+
+                __m512 _r = _mm512_mul_ps(_r0, _x_coeff0);
+                _r = _mm512_fmadd_ps(_r1, _x_coeff1, _r);
+                _r = _mm512_fmadd_ps(_r2, _x_coeff2, _r);
+                _r = _mm512_fmadd_ps(_r3, _x_coeff3, _r);
+
+                _v = _mm512_fmadd_ps(_r, _mm512_set1_ps(value_blob.row(4 + ii)[i]), _v);
+            }
+
+            _mm512_store_ps(outptr, _v);
+            outptr += 16;
+        }
+    }
+}
+
+static void gridsample_3d_bilinear_apply_interpolation_p16(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m512 _v000 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(0)[i]);
+            __m512 _v001 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(1)[i]);
+            __m512 _v010 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(2)[i]);
+            __m512 _v011 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(3)[i]);
+            __m512 _v100 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(4)[i]);
+            __m512 _v101 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(5)[i]);
+            __m512 _v110 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(6)[i]);
+            __m512 _v111 = gridsample_load_pack16(srcptr, offset_blob.row<const int>(7)[i]);
+
+            const float alpha = value_blob.row(0)[i];
+            const float beta = value_blob.row(1)[i];
+            const float gamma = value_blob.row(2)[i];
+
+            __m512 _alpha = _mm512_set1_ps(alpha);
+            __m512 _alpha1 = _mm512_set1_ps(1.f - alpha);
+
+            __m512 _v00 = _mm512_fmadd_ps(_v001, _alpha, _mm512_mul_ps(_v000, _alpha1));
+            __m512 _v01 = _mm512_fmadd_ps(_v011, _alpha, _mm512_mul_ps(_v010, _alpha1));
+            __m512 _v10 = _mm512_fmadd_ps(_v101, _alpha, _mm512_mul_ps(_v100, _alpha1));
+            __m512 _v11 = _mm512_fmadd_ps(_v111, _alpha, _mm512_mul_ps(_v110, _alpha1));
+
+            __m512 _beta = _mm512_set1_ps(beta);
+            __m512 _beta1 = _mm512_set1_ps(1.f - beta);
+
+            __m512 _v0 = _mm512_fmadd_ps(_v01, _beta, _mm512_mul_ps(_v00, _beta1));
+            __m512 _v1 = _mm512_fmadd_ps(_v11, _beta, _mm512_mul_ps(_v10, _beta1));
+
+            __m512 _v = _mm512_fmadd_ps(_v1, _mm512_set1_ps(gamma), _mm512_mul_ps(_v0, _mm512_set1_ps(1.f - gamma)));
+
+            _mm512_store_ps(outptr, _v);
+            outptr += 16;
+        }
+    }
+}
+#endif // __AVX512F__
+
+static void gridsample_nearest_apply_interpolation_p8(const Mat& src, Mat& dst, const Mat& offset_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    const int* offset_ptr = offset_blob.row<const int>(0);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            _mm256_store_ps(outptr, gridsample_load_pack8(srcptr, offset_ptr[i]));
+            outptr += 8;
+        }
+    }
+}
+
+static void gridsample_2d_bilinear_apply_interpolation_p8(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    const int* offset_ptr00 = offset_blob.row<const int>(0);
+    const int* offset_ptr01 = offset_blob.row<const int>(1);
+    const int* offset_ptr10 = offset_blob.row<const int>(2);
+    const int* offset_ptr11 = offset_blob.row<const int>(3);
+    const float* alpha_ptr = value_blob.row(0);
+    const float* beta_ptr = value_blob.row(1);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m256 _v00 = gridsample_load_pack8(srcptr, offset_ptr00[i]);
+            __m256 _v01 = gridsample_load_pack8(srcptr, offset_ptr01[i]);
+            __m256 _v10 = gridsample_load_pack8(srcptr, offset_ptr10[i]);
+            __m256 _v11 = gridsample_load_pack8(srcptr, offset_ptr11[i]);
+
+            __m256 _alpha = _mm256_set1_ps(alpha_ptr[i]);
+            __m256 _beta = _mm256_set1_ps(beta_ptr[i]);
+            __m256 _alpha1 = _mm256_set1_ps(1.f - alpha_ptr[i]);
+            __m256 _beta1 = _mm256_set1_ps(1.f - beta_ptr[i]);
+
+            __m256 _v0 = _mm256_comp_fmadd_ps(_v01, _alpha, _mm256_mul_ps(_v00, _alpha1));
+            __m256 _v1 = _mm256_comp_fmadd_ps(_v11, _alpha, _mm256_mul_ps(_v10, _alpha1));
+            __m256 _v = _mm256_comp_fmadd_ps(_v1, _beta, _mm256_mul_ps(_v0, _beta1));
+
+            _mm256_store_ps(outptr, _v);
+            outptr += 8;
+        }
+    }
+}
+
+static void gridsample_2d_bicubic_apply_interpolation_p8(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m256 _x_coeff0 = _mm256_set1_ps(value_blob.row(0)[i]);
+            __m256 _x_coeff1 = _mm256_set1_ps(value_blob.row(1)[i]);
+            __m256 _x_coeff2 = _mm256_set1_ps(value_blob.row(2)[i]);
+            __m256 _x_coeff3 = _mm256_set1_ps(value_blob.row(3)[i]);
+
+            __m256 _v = _mm256_setzero_ps();
+            for (int ii = 0; ii < 4; ii++)
+            {
+                __m256 _r0 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(ii * 4 + 0)[i]);
+                __m256 _r1 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(ii * 4 + 1)[i]);
+                __m256 _r2 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(ii * 4 + 2)[i]);
+                __m256 _r3 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(ii * 4 + 3)[i]);
+
+                __m256 _r = _mm256_mul_ps(_r0, _x_coeff0);
+                _r = _mm256_comp_fmadd_ps(_r1, _x_coeff1, _r);
+                _r = _mm256_comp_fmadd_ps(_r2, _x_coeff2, _r);
+                _r = _mm256_comp_fmadd_ps(_r3, _x_coeff3, _r);
+
+                _v = _mm256_comp_fmadd_ps(_r, _mm256_set1_ps(value_blob.row(4 + ii)[i]), _v);
+            }
+
+            _mm256_store_ps(outptr, _v);
+            outptr += 8;
+        }
+    }
+}
+
+static void gridsample_3d_bilinear_apply_interpolation_p8(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m256 _v000 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(0)[i]);
+            __m256 _v001 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(1)[i]);
+            __m256 _v010 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(2)[i]);
+            __m256 _v011 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(3)[i]);
+            __m256 _v100 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(4)[i]);
+            __m256 _v101 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(5)[i]);
+            __m256 _v110 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(6)[i]);
+            __m256 _v111 = gridsample_load_pack8(srcptr, offset_blob.row<const int>(7)[i]);
+
+            const float alpha = value_blob.row(0)[i];
+            const float beta = value_blob.row(1)[i];
+            const float gamma = value_blob.row(2)[i];
+
+            __m256 _alpha = _mm256_set1_ps(alpha);
+            __m256 _alpha1 = _mm256_set1_ps(1.f - alpha);
+
+            __m256 _v00 = _mm256_comp_fmadd_ps(_v001, _alpha, _mm256_mul_ps(_v000, _alpha1));
+            __m256 _v01 = _mm256_comp_fmadd_ps(_v011, _alpha, _mm256_mul_ps(_v010, _alpha1));
+            __m256 _v10 = _mm256_comp_fmadd_ps(_v101, _alpha, _mm256_mul_ps(_v100, _alpha1));
+            __m256 _v11 = _mm256_comp_fmadd_ps(_v111, _alpha, _mm256_mul_ps(_v110, _alpha1));
+
+            __m256 _beta = _mm256_set1_ps(beta);
+            __m256 _beta1 = _mm256_set1_ps(1.f - beta);
+
+            __m256 _v0 = _mm256_comp_fmadd_ps(_v01, _beta, _mm256_mul_ps(_v00, _beta1));
+            __m256 _v1 = _mm256_comp_fmadd_ps(_v11, _beta, _mm256_mul_ps(_v10, _beta1));
+
+            __m256 _v = _mm256_comp_fmadd_ps(_v1, _mm256_set1_ps(gamma), _mm256_mul_ps(_v0, _mm256_set1_ps(1.f - gamma)));
+
+            _mm256_store_ps(outptr, _v);
+            outptr += 8;
+        }
+    }
+}
+#endif // __AVX__
+
+static void gridsample_nearest_apply_interpolation_p4(const Mat& src, Mat& dst, const Mat& offset_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    const int* offset_ptr = offset_blob.row<const int>(0);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            _mm_store_ps(outptr, gridsample_load_pack4(srcptr, offset_ptr[i]));
+            outptr += 4;
+        }
+    }
+}
+
+static void gridsample_2d_bilinear_apply_interpolation_p4(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    const int* offset_ptr00 = offset_blob.row<const int>(0);
+    const int* offset_ptr01 = offset_blob.row<const int>(1);
+    const int* offset_ptr10 = offset_blob.row<const int>(2);
+    const int* offset_ptr11 = offset_blob.row<const int>(3);
+    const float* alpha_ptr = value_blob.row(0);
+    const float* beta_ptr = value_blob.row(1);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m128 _v00 = gridsample_load_pack4(srcptr, offset_ptr00[i]);
+            __m128 _v01 = gridsample_load_pack4(srcptr, offset_ptr01[i]);
+            __m128 _v10 = gridsample_load_pack4(srcptr, offset_ptr10[i]);
+            __m128 _v11 = gridsample_load_pack4(srcptr, offset_ptr11[i]);
+
+            __m128 _alpha = _mm_set1_ps(alpha_ptr[i]);
+            __m128 _beta = _mm_set1_ps(beta_ptr[i]);
+            __m128 _alpha1 = _mm_set1_ps(1.f - alpha_ptr[i]);
+            __m128 _beta1 = _mm_set1_ps(1.f - beta_ptr[i]);
+
+            __m128 _v0 = _mm_comp_fmadd_ps(_v01, _alpha, _mm_mul_ps(_v00, _alpha1));
+            __m128 _v1 = _mm_comp_fmadd_ps(_v11, _alpha, _mm_mul_ps(_v10, _alpha1));
+            __m128 _v = _mm_comp_fmadd_ps(_v1, _beta, _mm_mul_ps(_v0, _beta1));
+
+            _mm_store_ps(outptr, _v);
+            outptr += 4;
+        }
+    }
+}
+
+static void gridsample_2d_bicubic_apply_interpolation_p4(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m128 _x_coeff0 = _mm_set1_ps(value_blob.row(0)[i]);
+            __m128 _x_coeff1 = _mm_set1_ps(value_blob.row(1)[i]);
+            __m128 _x_coeff2 = _mm_set1_ps(value_blob.row(2)[i]);
+            __m128 _x_coeff3 = _mm_set1_ps(value_blob.row(3)[i]);
+
+            __m128 _v = _mm_setzero_ps();
+            for (int ii = 0; ii < 4; ii++)
+            {
+                __m128 _r0 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(ii * 4 + 0)[i]);
+                __m128 _r1 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(ii * 4 + 1)[i]);
+                __m128 _r2 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(ii * 4 + 2)[i]);
+                __m128 _r3 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(ii * 4 + 3)[i]);
+
+                __m128 _r = _mm_mul_ps(_r0, _x_coeff0);
+                _r = _mm_comp_fmadd_ps(_r1, _x_coeff1, _r);
+                _r = _mm_comp_fmadd_ps(_r2, _x_coeff2, _r);
+                _r = _mm_comp_fmadd_ps(_r3, _x_coeff3, _r);
+
+                _v = _mm_comp_fmadd_ps(_r, _mm_set1_ps(value_blob.row(4 + ii)[i]), _v);
+            }
+
+            _mm_store_ps(outptr, _v);
+            outptr += 4;
+        }
+    }
+}
+
+static void gridsample_3d_bilinear_apply_interpolation_p4(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i = 0; i < outsize; i++)
+        {
+            __m128 _v000 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(0)[i]);
+            __m128 _v001 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(1)[i]);
+            __m128 _v010 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(2)[i]);
+            __m128 _v011 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(3)[i]);
+            __m128 _v100 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(4)[i]);
+            __m128 _v101 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(5)[i]);
+            __m128 _v110 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(6)[i]);
+            __m128 _v111 = gridsample_load_pack4(srcptr, offset_blob.row<const int>(7)[i]);
+
+            const float alpha = value_blob.row(0)[i];
+            const float beta = value_blob.row(1)[i];
+            const float gamma = value_blob.row(2)[i];
+
+            __m128 _alpha = _mm_set1_ps(alpha);
+            __m128 _alpha1 = _mm_set1_ps(1.f - alpha);
+
+            __m128 _v00 = _mm_comp_fmadd_ps(_v001, _alpha, _mm_mul_ps(_v000, _alpha1));
+            __m128 _v01 = _mm_comp_fmadd_ps(_v011, _alpha, _mm_mul_ps(_v010, _alpha1));
+            __m128 _v10 = _mm_comp_fmadd_ps(_v101, _alpha, _mm_mul_ps(_v100, _alpha1));
+            __m128 _v11 = _mm_comp_fmadd_ps(_v111, _alpha, _mm_mul_ps(_v110, _alpha1));
+
+            __m128 _beta = _mm_set1_ps(beta);
+            __m128 _beta1 = _mm_set1_ps(1.f - beta);
+
+            __m128 _v0 = _mm_comp_fmadd_ps(_v01, _beta, _mm_mul_ps(_v00, _beta1));
+            __m128 _v1 = _mm_comp_fmadd_ps(_v11, _beta, _mm_mul_ps(_v10, _beta1));
+
+            __m128 _v = _mm_comp_fmadd_ps(_v1, _mm_set1_ps(gamma), _mm_mul_ps(_v0, _mm_set1_ps(1.f - gamma)));
+
+            _mm_store_ps(outptr, _v);
+            outptr += 4;
+        }
+    }
+}
+#endif // __SSE2__
+
+static void gridsample_nearest_apply_interpolation_p1(const Mat& src, Mat& dst, const Mat& offset_blob, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gridsample_nearest_apply_interpolation_p1_avx2(src, dst, offset_blob, opt);
+        return;
+    }
+#endif
+
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    const int* offset_ptr = offset_blob.row<const int>(0);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        int i = 0;
+#if __AVX512F__
+        for (; i + 15 < outsize; i += 16)
+        {
+            _mm512_storeu_ps(outptr, gridsample_gather_p16(srcptr, offset_ptr + i));
+            outptr += 16;
+        }
+#endif // __AVX512F__
+#if __AVX2__
+        for (; i + 7 < outsize; i += 8)
+        {
+            _mm256_storeu_ps(outptr, gridsample_gather_p8(srcptr, offset_ptr + i));
+            outptr += 8;
+        }
+#endif // __AVX2__
+        for (; i < outsize; i++)
+        {
+            *outptr++ = gridsample_load(srcptr, offset_ptr[i]);
+        }
+    }
+}
+
+static void gridsample_2d_bilinear_apply_interpolation_p1(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gridsample_2d_bilinear_apply_interpolation_p1_avx2(src, dst, offset_blob, value_blob, opt);
+        return;
+    }
+#endif
+
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    const int* offset_ptr00 = offset_blob.row<const int>(0);
+    const int* offset_ptr01 = offset_blob.row<const int>(1);
+    const int* offset_ptr10 = offset_blob.row<const int>(2);
+    const int* offset_ptr11 = offset_blob.row<const int>(3);
+    const float* alpha_ptr = value_blob.row(0);
+    const float* beta_ptr = value_blob.row(1);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        int i = 0;
+#if __AVX512F__
+        for (; i + 15 < outsize; i += 16)
+        {
+            __m512 _v00 = gridsample_gather_p16(srcptr, offset_ptr00 + i);
+            __m512 _v01 = gridsample_gather_p16(srcptr, offset_ptr01 + i);
+            __m512 _v10 = gridsample_gather_p16(srcptr, offset_ptr10 + i);
+            __m512 _v11 = gridsample_gather_p16(srcptr, offset_ptr11 + i);
+
+            __m512 _alpha = _mm512_loadu_ps(alpha_ptr + i);
+            __m512 _beta = _mm512_loadu_ps(beta_ptr + i);
+            __m512 _alpha1 = _mm512_sub_ps(_mm512_set1_ps(1.f), _alpha);
+            __m512 _beta1 = _mm512_sub_ps(_mm512_set1_ps(1.f), _beta);
+
+            __m512 _v0 = _mm512_fmadd_ps(_v01, _alpha, _mm512_mul_ps(_v00, _alpha1));
+            __m512 _v1 = _mm512_fmadd_ps(_v11, _alpha, _mm512_mul_ps(_v10, _alpha1));
+            __m512 _v = _mm512_fmadd_ps(_v1, _beta, _mm512_mul_ps(_v0, _beta1));
+
+            _mm512_storeu_ps(outptr, _v);
+            outptr += 16;
+        }
+#endif // __AVX512F__
+#if __AVX2__
+        for (; i + 7 < outsize; i += 8)
+        {
+            __m256 _v00 = gridsample_gather_p8(srcptr, offset_ptr00 + i);
+            __m256 _v01 = gridsample_gather_p8(srcptr, offset_ptr01 + i);
+            __m256 _v10 = gridsample_gather_p8(srcptr, offset_ptr10 + i);
+            __m256 _v11 = gridsample_gather_p8(srcptr, offset_ptr11 + i);
+
+            __m256 _alpha = _mm256_loadu_ps(alpha_ptr + i);
+            __m256 _beta = _mm256_loadu_ps(beta_ptr + i);
+            __m256 _alpha1 = _mm256_sub_ps(_mm256_set1_ps(1.f), _alpha);
+            __m256 _beta1 = _mm256_sub_ps(_mm256_set1_ps(1.f), _beta);
+
+            __m256 _v0 = _mm256_comp_fmadd_ps(_v01, _alpha, _mm256_mul_ps(_v00, _alpha1));
+            __m256 _v1 = _mm256_comp_fmadd_ps(_v11, _alpha, _mm256_mul_ps(_v10, _alpha1));
+            __m256 _v = _mm256_comp_fmadd_ps(_v1, _beta, _mm256_mul_ps(_v0, _beta1));
+
+            _mm256_storeu_ps(outptr, _v);
+            outptr += 8;
+        }
+#endif // __AVX2__
+        for (; i < outsize; i++)
+        {
+            float v00 = gridsample_load(srcptr, offset_ptr00[i]);
+            float v01 = gridsample_load(srcptr, offset_ptr01[i]);
+            float v10 = gridsample_load(srcptr, offset_ptr10[i]);
+            float v11 = gridsample_load(srcptr, offset_ptr11[i]);
+
+            float alpha = alpha_ptr[i];
+            float beta = beta_ptr[i];
+
+            float v0 = v00 * (1 - alpha) + v01 * alpha;
+            float v1 = v10 * (1 - alpha) + v11 * alpha;
+
+            *outptr++ = v0 * (1 - beta) + v1 * beta;
+        }
+    }
+}
+
+static void gridsample_2d_bicubic_apply_interpolation_p1(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gridsample_2d_bicubic_apply_interpolation_p1_avx2(src, dst, offset_blob, value_blob, opt);
+        return;
+    }
+#endif
+
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        int i = 0;
+#if __AVX512F__
+        for (; i + 15 < outsize; i += 16)
+        {
+            __m512 _x_coeff0 = _mm512_loadu_ps(value_blob.row(0) + i);
+            __m512 _x_coeff1 = _mm512_loadu_ps(value_blob.row(1) + i);
+            __m512 _x_coeff2 = _mm512_loadu_ps(value_blob.row(2) + i);
+            __m512 _x_coeff3 = _mm512_loadu_ps(value_blob.row(3) + i);
+
+            __m512 _v = _mm512_setzero_ps();
+            for (int ii = 0; ii < 4; ii++)
+            {
+                __m512 _r0 = gridsample_gather_p16(srcptr, offset_blob.row<const int>(ii * 4 + 0) + i);
+                __m512 _r1 = gridsample_gather_p16(srcptr, offset_blob.row<const int>(ii * 4 + 1) + i);
+                __m512 _r2 = gridsample_gather_p16(srcptr, offset_blob.row<const int>(ii * 4 + 2) + i);
+                __m512 _r3 = gridsample_gather_p16(srcptr, offset_blob.row<const int>(ii * 4 + 3) + i);
+
+                __m512 _r = _mm512_mul_ps(_r0, _x_coeff0);
+                _r = _mm512_fmadd_ps(_r1, _x_coeff1, _r);
+                _r = _mm512_fmadd_ps(_r2, _x_coeff2, _r);
+                _r = _mm512_fmadd_ps(_r3, _x_coeff3, _r);
+
+                _v = _mm512_fmadd_ps(_r, _mm512_loadu_ps(value_blob.row(4 + ii) + i), _v);
+            }
+
+            _mm512_storeu_ps(outptr, _v);
+            outptr += 16;
+        }
+#endif // __AVX512F__
+#if __AVX2__
+        for (; i + 7 < outsize; i += 8)
+        {
+            __m256 _x_coeff0 = _mm256_loadu_ps(value_blob.row(0) + i);
+            __m256 _x_coeff1 = _mm256_loadu_ps(value_blob.row(1) + i);
+            __m256 _x_coeff2 = _mm256_loadu_ps(value_blob.row(2) + i);
+            __m256 _x_coeff3 = _mm256_loadu_ps(value_blob.row(3) + i);
+
+            __m256 _v = _mm256_setzero_ps();
+            for (int ii = 0; ii < 4; ii++)
+            {
+                __m256 _r0 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(ii * 4 + 0) + i);
+                __m256 _r1 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(ii * 4 + 1) + i);
+                __m256 _r2 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(ii * 4 + 2) + i);
+                __m256 _r3 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(ii * 4 + 3) + i);
+
+                __m256 _r = _mm256_mul_ps(_r0, _x_coeff0);
+                _r = _mm256_comp_fmadd_ps(_r1, _x_coeff1, _r);
+                _r = _mm256_comp_fmadd_ps(_r2, _x_coeff2, _r);
+                _r = _mm256_comp_fmadd_ps(_r3, _x_coeff3, _r);
+
+                _v = _mm256_comp_fmadd_ps(_r, _mm256_loadu_ps(value_blob.row(4 + ii) + i), _v);
+            }
+
+            _mm256_storeu_ps(outptr, _v);
+            outptr += 8;
+        }
+#endif // __AVX2__
+        for (; i < outsize; i++)
+        {
+            float v = 0.f;
+            for (int ii = 0; ii < 4; ii++)
+            {
+                float r0 = gridsample_load(srcptr, offset_blob.row<const int>(ii * 4 + 0)[i]);
+                float r1 = gridsample_load(srcptr, offset_blob.row<const int>(ii * 4 + 1)[i]);
+                float r2 = gridsample_load(srcptr, offset_blob.row<const int>(ii * 4 + 2)[i]);
+                float r3 = gridsample_load(srcptr, offset_blob.row<const int>(ii * 4 + 3)[i]);
+
+                float r = r0 * value_blob.row(0)[i] + r1 * value_blob.row(1)[i] + r2 * value_blob.row(2)[i] + r3 * value_blob.row(3)[i];
+
+                v += r * value_blob.row(4 + ii)[i];
+            }
+
+            *outptr++ = v;
+        }
+    }
+}
+
+static void gridsample_3d_bilinear_apply_interpolation_p1(const Mat& src, Mat& dst, const Mat& offset_blob, const Mat& value_blob, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gridsample_3d_bilinear_apply_interpolation_p1_avx2(src, dst, offset_blob, value_blob, opt);
+        return;
+    }
+#endif
+
+    const int channels = dst.c;
+    const int outsize = dst.w * dst.h * dst.d;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* srcptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        int i = 0;
+#if __AVX2__
+        for (; i + 7 < outsize; i += 8)
+        {
+            __m256 _v000 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(0) + i);
+            __m256 _v001 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(1) + i);
+            __m256 _v010 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(2) + i);
+            __m256 _v011 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(3) + i);
+            __m256 _v100 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(4) + i);
+            __m256 _v101 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(5) + i);
+            __m256 _v110 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(6) + i);
+            __m256 _v111 = gridsample_gather_p8(srcptr, offset_blob.row<const int>(7) + i);
+
+            __m256 _alpha = _mm256_loadu_ps(value_blob.row(0) + i);
+            __m256 _beta = _mm256_loadu_ps(value_blob.row(1) + i);
+            __m256 _gamma = _mm256_loadu_ps(value_blob.row(2) + i);
+            __m256 _alpha1 = _mm256_sub_ps(_mm256_set1_ps(1.f), _alpha);
+            __m256 _beta1 = _mm256_sub_ps(_mm256_set1_ps(1.f), _beta);
+            __m256 _gamma1 = _mm256_sub_ps(_mm256_set1_ps(1.f), _gamma);
+
+            __m256 _v00 = _mm256_comp_fmadd_ps(_v001, _alpha, _mm256_mul_ps(_v000, _alpha1));
+            __m256 _v01 = _mm256_comp_fmadd_ps(_v011, _alpha, _mm256_mul_ps(_v010, _alpha1));
+            __m256 _v10 = _mm256_comp_fmadd_ps(_v101, _alpha, _mm256_mul_ps(_v100, _alpha1));
+            __m256 _v11 = _mm256_comp_fmadd_ps(_v111, _alpha, _mm256_mul_ps(_v110, _alpha1));
+
+            __m256 _v0 = _mm256_comp_fmadd_ps(_v01, _beta, _mm256_mul_ps(_v00, _beta1));
+            __m256 _v1 = _mm256_comp_fmadd_ps(_v11, _beta, _mm256_mul_ps(_v10, _beta1));
+
+            __m256 _v = _mm256_comp_fmadd_ps(_v1, _gamma, _mm256_mul_ps(_v0, _gamma1));
+
+            _mm256_storeu_ps(outptr, _v);
+            outptr += 8;
+        }
+#endif // __AVX2__
+        for (; i < outsize; i++)
+        {
+            float v000 = gridsample_load(srcptr, offset_blob.row<const int>(0)[i]);
+            float v001 = gridsample_load(srcptr, offset_blob.row<const int>(1)[i]);
+            float v010 = gridsample_load(srcptr, offset_blob.row<const int>(2)[i]);
+            float v011 = gridsample_load(srcptr, offset_blob.row<const int>(3)[i]);
+            float v100 = gridsample_load(srcptr, offset_blob.row<const int>(4)[i]);
+            float v101 = gridsample_load(srcptr, offset_blob.row<const int>(5)[i]);
+            float v110 = gridsample_load(srcptr, offset_blob.row<const int>(6)[i]);
+            float v111 = gridsample_load(srcptr, offset_blob.row<const int>(7)[i]);
+
+            float alpha = value_blob.row(0)[i];
+            float beta = value_blob.row(1)[i];
+            float gamma = value_blob.row(2)[i];
+
+            float v00 = v000 * (1 - alpha) + v001 * alpha;
+            float v01 = v010 * (1 - alpha) + v011 * alpha;
+            float v10 = v100 * (1 - alpha) + v101 * alpha;
+            float v11 = v110 * (1 - alpha) + v111 * alpha;
+
+            float v0 = v00 * (1 - beta) + v01 * beta;
+            float v1 = v10 * (1 - beta) + v11 * beta;
+
+            *outptr++ = v0 * (1 - gamma) + v1 * gamma;
+        }
+    }
+}
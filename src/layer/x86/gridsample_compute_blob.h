@@ -0,0 +1,290 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// the sampling offsets and interpolation weights only depend on the grid,
+// so they are resolved once here and shared by all channels
+//
+// offset_blob row k holds the element offset of corner k for every output point,
+// scaled by elempack, or -1 when the corner falls outside the image and reads as zero
+// value_blob rows hold the interpolation weights
+
+static float gridsample_unormalize(int w, float coordx, int align_corner)
+{
+    return align_corner ? (coordx + 1) / 2.f * (w - 1) : ((coordx + 1) * w - 1) / 2.f;
+}
+
+static float gridsample_border_coord(int x, int border)
+{
+    return std::min(border, std::max(x, 0));
+}
+
+static float gridsample_reflect_coord(float x, int high)
+{
+    x = fabsf(x);
+    x = high - fabsf(x - high);
+    return x;
+}
+
+static int gridsample_compute_coord(int sx, int w, int padding_mode, int align_corner)
+{
+    if (padding_mode == 2) // border
+    {
+        sx = gridsample_border_coord(sx, w - 1);
+    }
+    else if (padding_mode == 3) // reflection
+    {
+        if (align_corner)
+        {
+            sx = gridsample_reflect_coord(sx, w - 1);
+        }
+        else
+        {
+            sx = static_cast<int>(gridsample_reflect_coord(sx + 0.5f, w) - 0.5f);
+            sx = gridsample_border_coord(sx, w - 1);
+        }
+    }
+
+    return sx;
+}
+
+static int gridsample_2d_offset(int x, int y, int w, int h, int elempack, int padding_mode, int align_corner)
+{
+    x = gridsample_compute_coord(x, w, padding_mode, align_corner);
+    y = gridsample_compute_coord(y, h, padding_mode, align_corner);
+
+    if (x < 0 || y < 0 || x >= w || y >= h)
+        return -1;
+
+    return (y * w + x) * elempack;
+}
+
+static int gridsample_3d_offset(int x, int y, int z, int w, int h, int d, int elempack, int padding_mode, int align_corner)
+{
+    x = gridsample_compute_coord(x, w, padding_mode, align_corner);
+    y = gridsample_compute_coord(y, h, padding_mode, align_corner);
+    z = gridsample_compute_coord(z, d, padding_mode, align_corner);
+
+    if (x < 0 || y < 0 || z < 0 || x >= w || y >= h || z >= d)
+        return -1;
+
+    return ((z * h + y) * w + x) * elempack;
+}
+
+static void gridsample_interpolate_cubic(float fx, float* coeffs)
+{
+    const float A = -0.75f;
+
+    float fx0 = fx + 1;
+    float fx1 = fx;
+    float fx2 = 1 - fx;
+    // float fx3 = 2 - fx;
+
+    coeffs[0] = A * fx0 * fx0 * fx0 - 5 * A * fx0 * fx0 + 8 * A * fx0 - 4 * A;
+    coeffs[1] = (A + 2) * fx1 * fx1 * fx1 - (A + 3) * fx1 * fx1 + 1;
+    coeffs[2] = (A + 2) * fx2 * fx2 * fx2 - (A + 3) * fx2 * fx2 + 1;
+    coeffs[3] = 1.f - coeffs[0] - coeffs[1] - coeffs[2];
+}
+
+// offset_blob 4 rows, value_blob 2 rows (alpha beta)
+static void gridsample_2d_bilinear_compute_blob(const Mat& grid, Mat& offset_blob, Mat& value_blob, int w, int h, int elempack, int padding_mode, int align_corner, const Option& opt)
+{
+    const int outw = grid.h;
+    const int outh = grid.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int y = 0; y < outh; y++)
+    {
+        const float* gridptr = grid.channel(y);
+
+        int* offset_ptr00 = offset_blob.row<int>(0) + y * outw;
+        int* offset_ptr01 = offset_blob.row<int>(1) + y * outw;
+        int* offset_ptr10 = offset_blob.row<int>(2) + y * outw;
+        int* offset_ptr11 = offset_blob.row<int>(3) + y * outw;
+        float* alpha_ptr = value_blob.row(0) + y * outw;
+        float* beta_ptr = value_blob.row(1) + y * outw;
+
+        for (int x = 0; x < outw; x++)
+        {
+            float sample_x = gridsample_unormalize(w, gridptr[0], align_corner);
+            float sample_y = gridsample_unormalize(h, gridptr[1], align_corner);
+
+            int x0 = (int)floor(sample_x);
+            int y0 = (int)floor(sample_y);
+            int x1 = x0 + 1;
+            int y1 = y0 + 1;
+
+            offset_ptr00[x] = gridsample_2d_offset(x0, y0, w, h, elempack, padding_mode, align_corner);
+            offset_ptr01[x] = gridsample_2d_offset(x1, y0, w, h, elempack, padding_mode, align_corner);
+            offset_ptr10[x] = gridsample_2d_offset(x0, y1, w, h, elempack, padding_mode, align_corner);
+            offset_ptr11[x] = gridsample_2d_offset(x1, y1, w, h, elempack, padding_mode, align_corner);
+
+            alpha_ptr[x] = sample_x - x0;
+            beta_ptr[x] = sample_y - y0;
+
+            gridptr += 2;
+        }
+    }
+}
+
+// offset_blob 1 row
+static void gridsample_2d_nearest_compute_blob(const Mat& grid, Mat& offset_blob, int w, int h, int elempack, int padding_mode, int align_corner, const Option& opt)
+{
+    const int outw = grid.h;
+    const int outh = grid.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int y = 0; y < outh; y++)
+    {
+        const float* gridptr = grid.channel(y);
+
+        int* offset_ptr = offset_blob.row<int>(0) + y * outw;
+
+        for (int x = 0; x < outw; x++)
+        {
+            float sample_x = gridsample_unormalize(w, gridptr[0], align_corner);
+            float sample_y = gridsample_unormalize(h, gridptr[1], align_corner);
+
+            int x0 = static_cast<int>(round(sample_x));
+            int y0 = static_cast<int>(round(sample_y));
+
+            offset_ptr[x] = gridsample_2d_offset(x0, y0, w, h, elempack, padding_mode, align_corner);
+
+            gridptr += 2;
+        }
+    }
+}
+
+// offset_blob 16 rows (row major 4x4 window), value_blob 8 rows (4 x coeffs, 4 y coeffs)
+static void gridsample_2d_bicubic_compute_blob(const Mat& grid, Mat& offset_blob, Mat& value_blob, int w, int h, int elempack, int padding_mode, int align_corner, const Option& opt)
+{
+    const int outw = grid.h;
+    const int outh = grid.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int y = 0; y < outh; y++)
+    {
+        const float* gridptr = grid.channel(y);
+
+        for (int x = 0; x < outw; x++)
+        {
+            const int i = y * outw + x;
+
+            float sample_x = gridsample_unormalize(w, gridptr[0], align_corner);
+            float sample_y = gridsample_unormalize(h, gridptr[1], align_corner);
+
+            int x1 = (int)floorf(sample_x);
+            int y1 = (int)floorf(sample_y);
+
+            for (int ii = 0; ii < 4; ii++)
+            {
+                for (int jj = 0; jj < 4; jj++)
+                {
+                    offset_blob.row<int>(ii * 4 + jj)[i] = gridsample_2d_offset(x1 - 1 + jj, y1 - 1 + ii, w, h, elempack, padding_mode, align_corner);
+                }
+            }
+
+            float x_coeffs[4];
+            float y_coeffs[4];
+            gridsample_interpolate_cubic(sample_x - x1, x_coeffs);
+            gridsample_interpolate_cubic(sample_y - y1, y_coeffs);
+
+            for (int k = 0; k < 4; k++)
+            {
+                value_blob.row(k)[i] = x_coeffs[k];
+                value_blob.row(4 + k)[i] = y_coeffs[k];
+            }
+
+            gridptr += 2;
+        }
+    }
+}
+
+// offset_blob 8 rows, value_blob 3 rows (alpha beta gamma)
+static void gridsample_3d_bilinear_compute_blob(const Mat& grid, Mat& offset_blob, Mat& value_blob, int w, int h, int d, int elempack, int padding_mode, int align_corner, const Option& opt)
+{
+    const int outw = grid.h;
+    const int outh = grid.d;
+    const int outd = grid.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int z = 0; z < outd; z++)
+    {
+        const float* gridptr = grid.channel(z);
+
+        for (int y = 0; y < outh; y++)
+        {
+            for (int x = 0; x < outw; x++)
+            {
+                const int i = (z * outh + y) * outw + x;
+
+                float sample_x = gridsample_unormalize(w, gridptr[0], align_corner);
+                float sample_y = gridsample_unormalize(h, gridptr[1], align_corner);
+                float sample_z = gridsample_unormalize(d, gridptr[2], align_corner);
+
+                int x0 = (int)floor(sample_x);
+                int y0 = (int)floor(sample_y);
+                int z0 = (int)floor(sample_z);
+                int x1 = x0 + 1;
+                int y1 = y0 + 1;
+                int z1 = z0 + 1;
+
+                offset_blob.row<int>(0)[i] = gridsample_3d_offset(x0, y0, z0, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(1)[i] = gridsample_3d_offset(x1, y0, z0, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(2)[i] = gridsample_3d_offset(x0, y1, z0, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(3)[i] = gridsample_3d_offset(x1, y1, z0, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(4)[i] = gridsample_3d_offset(x0, y0, z1, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(5)[i] = gridsample_3d_offset(x1, y0, z1, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(6)[i] = gridsample_3d_offset(x0, y1, z1, w, h, d, elempack, padding_mode, align_corner);
+                offset_blob.row<int>(7)[i] = gridsample_3d_offset(x1, y1, z1, w, h, d, elempack, padding_mode, align_corner);
+
+                value_blob.row(0)[i] = sample_x - x0;
+                value_blob.row(1)[i] = sample_y - y0;
+                value_blob.row(2)[i] = sample_z - z0;
+
+                gridptr += 3;
+            }
+        }
+    }
+}
+
+// offset_blob 1 row
+static void gridsample_3d_nearest_compute_blob(const Mat& grid, Mat& offset_blob, int w, int h, int d, int elempack, int padding_mode, int align_corner, const Option& opt)
+{
+    const int outw = grid.h;
+    const int outh = grid.d;
+    const int outd = grid.c;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int z = 0; z < outd; z++)
+    {
+        const float* gridptr = grid.channel(z);
+
+        int* offset_ptr = offset_blob.row<int>(0) + z * outh * outw;
+
+        for (int i = 0; i < outh * outw; i++)
+        {
+            float sample_x = gridsample_unormalize(w, gridptr[0], align_corner);
+            float sample_y = gridsample_unormalize(h, gridptr[1], align_corner);
+            float sample_z = gridsample_unormalize(d, gridptr[2], align_corner);
+
+            int x0 = static_cast<int>(round(sample_x));
+            int y0 = static_cast<int>(round(sample_y));
+            int z0 = static_cast<int>(round(sample_z));
+
+            offset_ptr[i] = gridsample_3d_offset(x0, y0, z0, w, h, d, elempack, padding_mode, align_corner);
+
+            gridptr += 3;
+        }
+    }
+}
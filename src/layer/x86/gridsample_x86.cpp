@@ -0,0 +1,218 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "gridsample_x86.h"
+
+#include <math.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "cpu.h"
+#include "x86_usability.h"
+
+namespace ncnn {
+
+#include "gridsample_compute_blob.h"
+#include "gridsample_apply_interpolation.h"
+
+GridSample_x86::GridSample_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int GridSample_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& grid_blob = bottom_blobs[1];
+    Mat& top_blob = top_blobs[0];
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int d = bottom_blob.d;
+    const int channels = bottom_blob.c;
+    const int dims = bottom_blob.dims;
+    const size_t elemsize = bottom_blob.elemsize;
+    const int elempack = bottom_blob.elempack;
+
+    // sampling tables are built from the plain grid layout
+    Mat grid = grid_blob;
+    if (grid_blob.elempack != 1)
+    {
+        Option opt_unpack = opt;
+        opt_unpack.blob_allocator = opt.workspace_allocator;
+        convert_packing(grid_blob, grid, 1, opt_unpack);
+        if (grid.empty())
+            return -100;
+    }
+
+    if (dims == 3)
+    {
+        const int outw = grid.h;
+        const int outh = grid.c;
+        const int outsize = outw * outh;
+
+        top_blob.create(outw, outh, channels, elemsize, elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        if (sample_type == 1) // bilinear
+        {
+            Mat offset_blob(outsize, 4, 4u, opt.workspace_allocator);
+            Mat value_blob(outsize, 2, 4u, opt.workspace_allocator);
+            if (offset_blob.empty() || value_blob.empty())
+                return -100;
+
+            gridsample_2d_bilinear_compute_blob(grid, offset_blob, value_blob, w, h, elempack, padding_mode, align_corner, opt);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            if (elempack == 16)
+                gridsample_2d_bilinear_apply_interpolation_p16(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX512F__
+            if (elempack == 8)
+                gridsample_2d_bilinear_apply_interpolation_p8(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX__
+            if (elempack == 4)
+                gridsample_2d_bilinear_apply_interpolation_p4(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __SSE2__
+            if (elempack == 1)
+                gridsample_2d_bilinear_apply_interpolation_p1(bottom_blob, top_blob, offset_blob, value_blob, opt);
+        }
+        else if (sample_type == 2) // nearest
+        {
+            Mat offset_blob(outsize, 1, 4u, opt.workspace_allocator);
+            if (offset_blob.empty())
+                return -100;
+
+            gridsample_2d_nearest_compute_blob(grid, offset_blob, w, h, elempack, padding_mode, align_corner, opt);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            if (elempack == 16)
+                gridsample_nearest_apply_interpolation_p16(bottom_blob, top_blob, offset_blob, opt);
+#endif // __AVX512F__
+            if (elempack == 8)
+                gridsample_nearest_apply_interpolation_p8(bottom_blob, top_blob, offset_blob, opt);
+#endif // __AVX__
+            if (elempack == 4)
+                gridsample_nearest_apply_interpolation_p4(bottom_blob, top_blob, offset_blob, opt);
+#endif // __SSE2__
+            if (elempack == 1)
+                gridsample_nearest_apply_interpolation_p1(bottom_blob, top_blob, offset_blob, opt);
+        }
+        else if (sample_type == 3) // bicubic
+        {
+            Mat offset_blob(outsize, 16, 4u, opt.workspace_allocator);
+            Mat value_blob(outsize, 8, 4u, opt.workspace_allocator);
+            if (offset_blob.empty() || value_blob.empty())
+                return -100;
+
+            gridsample_2d_bicubic_compute_blob(grid, offset_blob, value_blob, w, h, elempack, padding_mode, align_corner, opt);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            if (elempack == 16)
+                gridsample_2d_bicubic_apply_interpolation_p16(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX512F__
+            if (elempack == 8)
+                gridsample_2d_bicubic_apply_interpolation_p8(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX__
+            if (elempack == 4)
+                gridsample_2d_bicubic_apply_interpolation_p4(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __SSE2__
+            if (elempack == 1)
+                gridsample_2d_bicubic_apply_interpolation_p1(bottom_blob, top_blob, offset_blob, value_blob, opt);
+        }
+    }
+
+    if (dims == 4)
+    {
+        const int outw = grid.h;
+        const int outh = grid.d;
+        const int outd = grid.c;
+        const int outsize = outw * outh * outd;
+
+        if (sample_type == 3)
+        {
+            NCNN_LOGE("unsupported bicubic when dims == 4");
+            return -1;
+        }
+
+        top_blob.create(outw, outh, outd, channels, elemsize, elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        if (sample_type == 1) // bilinear
+        {
+            Mat offset_blob(outsize, 8, 4u, opt.workspace_allocator);
+            Mat value_blob(outsize, 3, 4u, opt.workspace_allocator);
+            if (offset_blob.empty() || value_blob.empty())
+                return -100;
+
+            gridsample_3d_bilinear_compute_blob(grid, offset_blob, value_blob, w, h, d, elempack, padding_mode, align_corner, opt);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            if (elempack == 16)
+                gridsample_3d_bilinear_apply_interpolation_p16(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX512F__
+            if (elempack == 8)
+                gridsample_3d_bilinear_apply_interpolation_p8(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __AVX__
+            if (elempack == 4)
+                gridsample_3d_bilinear_apply_interpolation_p4(bottom_blob, top_blob, offset_blob, value_blob, opt);
+#endif // __SSE2__
+            if (elempack == 1)
+                gridsample_3d_bilinear_apply_interpolation_p1(bottom_blob, top_blob, offset_blob, value_blob, opt);
+        }
+        else if (sample_type == 2) // nearest
+        {
+            Mat offset_blob(outsize, 1, 4u, opt.workspace_allocator);
+            if (offset_blob.empty())
+                return -100;
+
+            gridsample_3d_nearest_compute_blob(grid, offset_blob, w, h, d, elempack, padding_mode, align_corner, opt);
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            if (elempack == 16)
+                gridsample_nearest_apply_interpolation_p16(bottom_blob, top_blob, offset_blob, opt);
+#endif // __AVX512F__
+            if (elempack == 8)
+                gridsample_nearest_apply_interpolation_p8(bottom_blob, top_blob, offset_blob, opt);
+#endif // __AVX__
+            if (elempack == 4)
+                gridsample_nearest_apply_interpolation_p4(bottom_blob, top_blob, offset_blob, opt);
+#endif // __SSE2__
+            if (elempack == 1)
+                gridsample_nearest_apply_interpolation_p1(bottom_blob, top_blob, offset_blob, opt);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,291 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+void innerproduct_bf16s_sse_avx512bf16(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt);
+#endif
+
+static int innerproduct_bf16s_out_elempack(int num_output, const Option& opt)
+{
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = num_output % 16 == 0 ? 16 : num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = num_output % 8 == 0 ? 8 : num_output % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = num_output % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    return out_elempack;
+}
+
+static void innerproduct_transform_kernel_bf16s_sse(const Mat& weight_data, Mat& weight_data_tm, int num_input, int num_output, const Option& opt)
+{
+    const int out_elempack = innerproduct_bf16s_out_elempack(num_output, opt);
+
+    // src = inch-outch
+    // dst = 2-pb-inch/2-outch/pb
+    // pairs of adjacent input channels share one 32bit lane,
+    // the even one in the low half, so that both halves widen to fp32
+    // with a shift or a mask, and vdpbf16ps consumes them directly
+    const int num_input_2 = (num_input + 1) / 2;
+
+    Mat weight_data_r2 = weight_data.reshape(num_input, num_output);
+
+    weight_data_tm.create(num_input_2 * 2 * out_elempack, num_output / out_elempack, (size_t)2u);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < num_output / out_elempack; q++)
+    {
+        unsigned short* g0 = weight_data_tm.row<unsigned short>(q);
+
+        for (int p = 0; p < num_input_2; p++)
+        {
+            for (int j = 0; j < out_elempack; j++)
+            {
+                const float* k0 = weight_data_r2.row(q * out_elempack + j);
+
+                g0[0] = float32_to_bfloat16(k0[p * 2]);
+                g0[1] = p * 2 + 1 < num_input ? float32_to_bfloat16(k0[p * 2 + 1]) : 0;
+                g0 += 2;
+            }
+        }
+    }
+}
+
+static void innerproduct_bf16s_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data_tm, const Mat& bias_data, int activation_type, const Mat& activation_params, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512BF16 && __AVX512F__ && !__AVX512BF16__
+    if (ncnn::cpu_support_x86_avx512_bf16())
+    {
+        innerproduct_bf16s_sse_avx512bf16(bottom_blob, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+        return;
+    }
+#endif
+
+    const int num_input = bottom_blob.w * bottom_blob.elempack;
+    const int outw = top_blob.w;
+    const int out_elempack = top_blob.elempack;
+
+    const float* bias_data_ptr = bias_data;
+
+#if __AVX512BF16__
+    // the input is rounded to bf16 pairs once and broadcast per step
+    const int num_input_2 = (num_input + 1) / 2;
+
+    Mat bottom_blob_bf16(num_input_2, (size_t)4u, opt.workspace_allocator);
+    {
+        const float* sptr = bottom_blob;
+        unsigned int* pptr = bottom_blob_bf16;
+        for (int i = 0; i < num_input_2; i++)
+        {
+            unsigned short v0 = float32_to_bfloat16(sptr[i * 2]);
+            unsigned short v1 = i * 2 + 1 < num_input ? float32_to_bfloat16(sptr[i * 2 + 1]) : 0;
+            pptr[i] = (unsigned int)v0 | ((unsigned int)v1 << 16);
+        }
+    }
+#endif // __AVX512BF16__
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (out_elempack == 16)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outw; p++)
+        {
+            const unsigned short* kptr = weight_data_tm.row<const unsigned short>(p);
+
+            __m512 _sum0 = _mm512_setzero_ps();
+
+            if (bias_data_ptr)
+            {
+                _sum0 = _mm512_loadu_ps(bias_data_ptr + p * 16);
+            }
+
+#if __AVX512BF16__
+            const int* pptr = bottom_blob_bf16;
+            for (int i = 0; i < num_input_2; i++)
+            {
+                __m512i _w = _mm512_loadu_si512((const __m512i*)kptr);
+                _sum0 = _mm512_dpbf16_ps(_sum0, (__m512bh)_w, (__m512bh)_mm512_set1_epi32(pptr[i]));
+                kptr += 32;
+            }
+#else  // __AVX512BF16__
+            __m512 _sum1 = _mm512_setzero_ps();
+            const float* sptr = bottom_blob;
+            const __m512i _mask = _mm512_set1_epi32(0xffff0000);
+            int i = 0;
+            for (; i + 1 < num_input; i += 2)
+            {
+                __m512i _w = _mm512_loadu_si512((const __m512i*)kptr);
+                __m512 _w0 = _mm512_castsi512_ps(_mm512_slli_epi32(_w, 16));
+                __m512 _w1 = _mm512_castsi512_ps(_mm512_and_si512(_w, _mask));
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(sptr[0]), _w0, _sum0);
+                _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(sptr[1]), _w1, _sum1);
+                sptr += 2;
+                kptr += 32;
+            }
+            if (i < num_input)
+            {
+                __m512i _w = _mm512_loadu_si512((const __m512i*)kptr);
+                __m512 _w0 = _mm512_castsi512_ps(_mm512_slli_epi32(_w, 16));
+                _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(sptr[0]), _w0, _sum0);
+            }
+
+            _sum0 = _mm512_add_ps(_sum0, _sum1);
+#endif // __AVX512BF16__
+
+            _sum0 = activation_avx512(_sum0, activation_type, activation_params);
+
+            float* outptr = top_blob;
+            _mm512_storeu_ps(outptr + p * 16, _sum0);
+        }
+    }
+#endif // __AVX512F__
+
+    if (out_elempack == 8)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outw; p++)
+        {
+            const unsigned short* kptr = weight_data_tm.row<const unsigned short>(p);
+
+            __m256 _sum0 = _mm256_setzero_ps();
+
+            if (bias_data_ptr)
+            {
+                _sum0 = _mm256_loadu_ps(bias_data_ptr + p * 8);
+            }
+
+#if __AVX512BF16__
+            const int* pptr = bottom_blob_bf16;
+            for (int i = 0; i < num_input_2; i++)
+            {
+                __m256i _w = _mm256_loadu_si256((const __m256i*)kptr);
+                _sum0 = _mm256_dpbf16_ps(_sum0, (__m256bh)_w, (__m256bh)_mm256_set1_epi32(pptr[i]));
+                kptr += 16;
+            }
+#else  // __AVX512BF16__
+            __m256 _sum1 = _mm256_setzero_ps();
+            const float* sptr = bottom_blob;
+            int i = 0;
+            for (; i + 1 < num_input; i += 2)
+            {
+                __m256i _w = _mm256_loadu_si256((const __m256i*)kptr);
+#if __AVX2__
+                __m256 _w0 = _mm256_castsi256_ps(_mm256_slli_epi32(_w, 16));
+#else
+                __m128i _w0l = _mm_slli_epi32(_mm256_extractf128_si256(_w, 0), 16);
+                __m128i _w0h = _mm_slli_epi32(_mm256_extractf128_si256(_w, 1), 16);
+                __m256 _w0 = _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(_w0l), _w0h, 1));
+#endif
+                __m256 _w1 = _mm256_and_ps(_mm256_castsi256_ps(_w), _mm256_castsi256_ps(_mm256_set1_epi32(0xffff0000)));
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(sptr[0]), _w0, _sum0);
+                _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(sptr[1]), _w1, _sum1);
+                sptr += 2;
+                kptr += 16;
+            }
+            if (i < num_input)
+            {
+                __m256 _w0 = bfloat2float_avx(_mm_set_epi16(kptr[14], kptr[12], kptr[10], kptr[8], kptr[6], kptr[4], kptr[2], kptr[0]));
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(sptr[0]), _w0, _sum0);
+            }
+
+            _sum0 = _mm256_add_ps(_sum0, _sum1);
+#endif // __AVX512BF16__
+
+            _sum0 = activation_avx(_sum0, activation_type, activation_params);
+
+            float* outptr = top_blob;
+            _mm256_storeu_ps(outptr + p * 8, _sum0);
+        }
+    }
+#endif // __AVX__
+
+    if (out_elempack == 4)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outw; p++)
+        {
+            const unsigned short* kptr = weight_data_tm.row<const unsigned short>(p);
+            const float* sptr = bottom_blob;
+
+            __m128 _sum0 = _mm_setzero_ps();
+            __m128 _sum1 = _mm_setzero_ps();
+
+            if (bias_data_ptr)
+            {
+                _sum0 = _mm_loadu_ps(bias_data_ptr + p * 4);
+            }
+
+            const __m128i _mask = _mm_set1_epi32(0xffff0000);
+            int i = 0;
+            for (; i + 1 < num_input; i += 2)
+            {
+                __m128i _w = _mm_loadu_si128((const __m128i*)kptr);
+                __m128 _w0 = _mm_castsi128_ps(_mm_slli_epi32(_w, 16));
+                __m128 _w1 = _mm_castsi128_ps(_mm_and_si128(_w, _mask));
+                _sum0 = _mm_comp_fmadd_ps(_mm_set1_ps(sptr[0]), _w0, _sum0);
+                _sum1 = _mm_comp_fmadd_ps(_mm_set1_ps(sptr[1]), _w1, _sum1);
+                sptr += 2;
+                kptr += 8;
+            }
+            if (i < num_input)
+            {
+                __m128 _w0 = _mm_castsi128_ps(_mm_slli_epi32(_mm_loadu_si128((const __m128i*)kptr), 16));
+                _sum0 = _mm_comp_fmadd_ps(_mm_set1_ps(sptr[0]), _w0, _sum0);
+            }
+
+            _sum0 = _mm_add_ps(_sum0, _sum1);
+
+            _sum0 = activation_sse(_sum0, activation_type, activation_params);
+
+            float* outptr = top_blob;
+            _mm_storeu_ps(outptr + p * 4, _sum0);
+        }
+    }
+#endif // __SSE2__
+
+    if (out_elempack == 1)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < outw; p++)
+        {
+            const unsigned short* kptr = weight_data_tm.row<const unsigned short>(p);
+            const float* sptr = bottom_blob;
+
+            float sum = 0.f;
+
+            if (bias_data_ptr)
+            {
+                sum = bias_data_ptr[p];
+            }
+
+            for (int i = 0; i < num_input; i++)
+            {
+                sum += sptr[i] * bfloat16_to_float32(kptr[i]);
+            }
+
+            sum = activation_ss(sum, activation_type, activation_params);
+
+            float* outptr = top_blob;
+            outptr[p] = sum;
+        }
+    }
+}
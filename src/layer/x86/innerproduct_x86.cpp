@@ -23,6 +23,7 @@
 
 #include "x86_activation.h"
 #include "x86_usability.h"
+#include "x86_sparse_weight.h"
 
 #include "layer_type.h"
 
@@ -40,6 +41,10 @@ namespace ncnn {
 #undef NCNN_IMPL_FP16S
 #endif
 
+#if NCNN_BF16
+#include "innerproduct_bf16s.h"
+#endif
+
 InnerProduct_x86::InnerProduct_x86()
 {
 #if __SSE2__
@@ -69,6 +74,33 @@ int InnerProduct_x86::create_pipeline(const Option& opt)
     }
 #endif
 
+    const int num_input = weight_data_size / num_output;
+
+    // pruned weights take the fp32 sparse path whatever the 16bit storage options
+    if (opt.use_sparse_weight)
+    {
+        int ret = sparse_weight_transform_kernel(weight_data, weight_sparse_index, weight_sparse_data, num_input, num_output);
+        if (ret != 0)
+            return ret;
+
+        if (!weight_sparse_data.empty())
+        {
+            if (opt.lightmode)
+            {
+                weight_data.release();
+            }
+
+            return 0;
+        }
+    }
+
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+    {
+        return create_pipeline_bf16s(opt);
+    }
+#endif
+
 #if NCNN_F16C && __AVX__
     if (cpu_support_x86_f16c() && opt.use_fp16_storage)
     {
@@ -76,8 +108,6 @@ int InnerProduct_x86::create_pipeline(const Option& opt)
     }
 #endif
 
-    const int num_input = weight_data_size / num_output;
-
     innerproduct_transform_kernel_sse(weight_data, weight_data_tm, num_input, num_output, opt);
 
     if (opt.lightmode)
@@ -100,6 +130,47 @@ int InnerProduct_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int InnerProduct_x86::save_weight_cache(std::vector<Mat>& mats) const
+{
+    mats.resize(4);
+    mats[0] = weight_data_tm;
+#if NCNN_INT8
+    mats[1] = scale_in_data;
+#endif
+    mats[2] = weight_sparse_index;
+    mats[3] = weight_sparse_data;
+
+    return 0;
+}
+
+int InnerProduct_x86::load_weight_cache(const std::vector<Mat>& mats, const Option& opt)
+{
+    if (mats.size() != 4)
+        return -1;
+
+    flatten = ncnn::create_layer(ncnn::LayerType::Flatten);
+
+    ncnn::ParamDict pd;
+
+    flatten->load_param(pd);
+
+    flatten->create_pipeline(opt);
+
+    weight_data_tm = mats[0];
+#if NCNN_INT8
+    scale_in_data = mats[1];
+#endif
+    weight_sparse_index = mats[2];
+    weight_sparse_data = mats[3];
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
 int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
 #if NCNN_INT8
@@ -109,8 +180,15 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
     }
 #endif
 
+#if NCNN_BF16
+    if (opt.use_bf16_storage && weight_sparse_data.empty())
+    {
+        return forward_bf16s(bottom_blob, top_blob, opt);
+    }
+#endif
+
 #if NCNN_F16C && __AVX__
-    if (cpu_support_x86_f16c() && opt.use_fp16_storage)
+    if (cpu_support_x86_f16c() && opt.use_fp16_storage && weight_sparse_data.empty())
     {
         return forward_fp16s(bottom_blob, top_blob, opt);
     }
@@ -129,6 +207,27 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
         if (top_blob.empty())
             return -100;
 
+        if (!weight_sparse_data.empty())
+        {
+            const int nb = sparse_weight_block_width();
+            const int ngroup = (num_output + nb - 1) / nb;
+
+            // visit the packed rows lane by lane
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int i = 0; i < h * elempack; i++)
+            {
+                const float* x = (const float*)bottom_blob.row(i / elempack) + i % elempack;
+                float* outptr = (float*)top_blob.row(i / elempack) + i % elempack;
+
+                for (int g = 0; g < ngroup; g++)
+                {
+                    sparse_weight_gemv_group(x, elempack, outptr, elempack, g, weight_sparse_index, weight_sparse_data, bias_data, num_output, activation_type, activation_params);
+                }
+            }
+
+            return 0;
+        }
+
         innerproduct_gemm_sse(bottom_blob, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
 
         return 0;
@@ -166,6 +265,24 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
     if (top_blob.empty())
         return -100;
 
+    if (!weight_sparse_data.empty())
+    {
+        const int nb = sparse_weight_block_width();
+        const int ngroup = (num_output + nb - 1) / nb;
+
+        // 1d blobs are linear whatever the elempack
+        const float* x = bottom_blob_flattened;
+        float* outptr = top_blob;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int g = 0; g < ngroup; g++)
+        {
+            sparse_weight_gemv_group(x, 1, outptr, 1, g, weight_sparse_index, weight_sparse_data, bias_data, num_output, activation_type, activation_params);
+        }
+
+        return 0;
+    }
+
     innerproduct_sse(bottom_blob_flattened, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
 
     return 0;
@@ -240,6 +357,78 @@ int InnerProduct_x86::forward_fp16s(const Mat& bottom_blob, Mat& top_blob, const
 }
 #endif // NCNN_F16C && __AVX__
 
+#if NCNN_BF16
+int InnerProduct_x86::create_pipeline_bf16s(const Option& opt)
+{
+    const int num_input = weight_data_size / num_output;
+
+    innerproduct_transform_kernel_bf16s_sse(weight_data, weight_data_tm, num_input, num_output, opt);
+
+    if (opt.lightmode)
+    {
+        weight_data.release();
+    }
+
+    return 0;
+}
+
+int InnerProduct_x86::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int num_input = weight_data_size / num_output;
+
+    // the blobs stay in fp32, only the weights are kept in bf16
+    Option opt_flatten = opt;
+    opt_flatten.blob_allocator = opt.workspace_allocator;
+
+    const int out_elempack = innerproduct_bf16s_out_elempack(num_output, opt);
+
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input)
+    {
+        // gemm
+        Mat bottom_blob_unpacked = bottom_blob;
+        if (bottom_blob.elempack != 1)
+        {
+            convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_flatten);
+            if (bottom_blob_unpacked.empty())
+                return -100;
+        }
+
+        const int h = bottom_blob_unpacked.h;
+
+        top_blob.create(num_output, h, 4u, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        for (int i = 0; i < h; i++)
+        {
+            const Mat bottom_row(num_input, (void*)bottom_blob_unpacked.row(i), 4u);
+            Mat top_row(num_output / out_elempack, (void*)top_blob.row(i), 4u * out_elempack, out_elempack);
+
+            innerproduct_bf16s_sse(bottom_row, top_row, weight_data_tm, bias_data, activation_type, activation_params, opt);
+        }
+
+        return 0;
+    }
+
+    // flatten
+    Mat bottom_blob_flattened = bottom_blob;
+    if (bottom_blob.dims != 1)
+    {
+        flatten->forward(bottom_blob, bottom_blob_flattened, opt_flatten);
+        if (bottom_blob_flattened.empty())
+            return -100;
+    }
+
+    top_blob.create(num_output / out_elempack, 4u * out_elempack, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    innerproduct_bf16s_sse(bottom_blob_flattened, top_blob, weight_data_tm, bias_data, activation_type, activation_params, opt);
+
+    return 0;
+}
+#endif // NCNN_BF16
+
 #if NCNN_INT8
 int InnerProduct_x86::create_pipeline_int8_x86(const Option& opt)
 {
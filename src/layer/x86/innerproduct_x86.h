@@ -27,6 +27,9 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int save_weight_cache(std::vector<Mat>& mats) const;
+    virtual int load_weight_cache(const std::vector<Mat>& mats, const Option& opt);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 protected:
@@ -34,6 +37,10 @@ protected:
     int create_pipeline_fp16s(const Option& opt);
     int forward_fp16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 #endif
+#if NCNN_BF16
+    int create_pipeline_bf16s(const Option& opt);
+    int forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+#endif
 #if NCNN_INT8
     int create_pipeline_int8_x86(const Option& opt);
     int forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
@@ -44,6 +51,10 @@ public:
 
     Mat weight_data_tm;
 
+    // block sparse weight, see x86_sparse_weight.h
+    Mat weight_sparse_index;
+    Mat weight_sparse_data;
+
 #if NCNN_INT8
     Mat scale_in_data;
 #endif
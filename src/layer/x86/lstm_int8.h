@@ -0,0 +1,417 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// int8 lstm with dynamic quantized input and hidden state
+//
+// weight_data_tm : per hidden unit, 4 inputs x IFOG int8 blocks for xc then hc
+//                  both input lengths are padded to multiple of 8
+// descales       : per hidden unit, 1 / weight scale for IFOG xc then IFOG hc
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX2__ && !__AVXVNNI__
+int lstm_int8_avxvnni(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, const Mat& weight_hr, Mat& hidden_state, Mat& cell_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+int lstm_int8_avx2(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, const Mat& weight_hr, Mat& hidden_state, Mat& cell_state, const Option& opt);
+#endif
+
+static void lstm_transform_weight_int8(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, int hidden_size, const Option& opt)
+{
+    const int size8 = (size + 7) / 8 * 8;
+    const int num_output8 = (num_output + 7) / 8 * 8;
+
+    weight_data_tm.create((size8 + num_output8) * 4, hidden_size, num_directions, (size_t)1u);
+    weight_data_tm_int8_descales.create(8, hidden_size, num_directions);
+    bias_c_tm.create(4, hidden_size, num_directions);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc_dr = weight_xc.channel(dr);
+        const Mat weight_hc_dr = weight_hc.channel(dr);
+        const Mat bias_c_dr = bias_c.channel(dr);
+        const float* weight_xc_int8_scales_ptr = weight_xc_int8_scales.row(dr);
+        const float* weight_hc_int8_scales_ptr = weight_hc_int8_scales.row(dr);
+
+        Mat weight_data_tm_dr = weight_data_tm.channel(dr);
+        Mat weight_data_tm_int8_descales_dr = weight_data_tm_int8_descales.channel(dr);
+        Mat bias_c_tm_dr = bias_c_tm.channel(dr);
+
+        for (int q = 0; q < hidden_size; q++)
+        {
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q);
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q);
+            float* bias_c_IFOG = bias_c_tm_dr.row(q);
+
+            for (int i = 0; i < size8; i += 4)
+            {
+                for (int g = 0; g < 4; g++)
+                {
+                    const signed char* weight_xc_ptr = weight_xc_dr.row<const signed char>(hidden_size * g + q);
+
+                    for (int k = 0; k < 4; k++)
+                    {
+                        kptr[0] = i + k < size ? weight_xc_ptr[i + k] : 0;
+                        kptr++;
+                    }
+                }
+            }
+
+            for (int i = 0; i < num_output8; i += 4)
+            {
+                for (int g = 0; g < 4; g++)
+                {
+                    const signed char* weight_hc_ptr = weight_hc_dr.row<const signed char>(hidden_size * g + q);
+
+                    for (int k = 0; k < 4; k++)
+                    {
+                        kptr[0] = i + k < num_output ? weight_hc_ptr[i + k] : 0;
+                        kptr++;
+                    }
+                }
+            }
+
+            for (int g = 0; g < 4; g++)
+            {
+                const float xc_scale = weight_xc_int8_scales_ptr[hidden_size * g + q];
+                const float hc_scale = weight_hc_int8_scales_ptr[hidden_size * g + q];
+
+                descales_ptr[g] = xc_scale == 0.f ? 0.f : 1.f / xc_scale;
+                descales_ptr[4 + g] = hc_scale == 0.f ? 0.f : 1.f / hc_scale;
+
+                bias_c_IFOG[g] = bias_c_dr.row(g)[q];
+            }
+        }
+    }
+}
+
+static inline signed char lstm_float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
+}
+
+static float lstm_dynamic_quantize(const float* ptr, signed char* outptr, int size, int size8)
+{
+    float absmax = 0.f;
+    for (int i = 0; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(ptr[i]));
+    }
+
+    const float scale = absmax == 0.f ? 1.f : 127.f / absmax;
+
+    int i = 0;
+    for (; i < size; i++)
+    {
+        outptr[i] = lstm_float2int8(ptr[i] * scale);
+    }
+    for (; i < size8; i++)
+    {
+        outptr[i] = 0;
+    }
+
+    // descale
+    return 1.f / scale;
+}
+
+#if __SSE2__
+// dot product of int8 vector against 4 interleaved int8 rows, returns IFOG int32
+static inline __m128i lstm_int8_dot_IFOG(const signed char* x, const signed char* kptr, int size8)
+{
+#if __AVX2__
+    __m256i _sum = _mm256_setzero_si256();
+#if !(__AVXVNNI__ || __AVX512VNNI__)
+    const __m256i _one = _mm256_set1_epi16(1);
+#endif
+    for (int i = 0; i < size8; i += 8)
+    {
+        __m256i _w = _mm256_loadu_si256((const __m256i*)kptr);
+        __m256i _x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi32(((const int*)x)[0])), _mm_set1_epi32(((const int*)x)[1]), 1);
+
+        // |x| as unsigned and the sign of x moved onto w
+        // so that the pairwise int16 sum never saturates
+        __m256i _xabs = _mm256_abs_epi8(_x);
+        __m256i _wsign = _mm256_sign_epi8(_w, _x);
+
+#if __AVXVNNI__ || __AVX512VNNI__
+        _sum = _mm256_dpbusd_epi32(_sum, _xabs, _wsign);
+#else
+        _sum = _mm256_add_epi32(_sum, _mm256_madd_epi16(_mm256_maddubs_epi16(_xabs, _wsign), _one));
+#endif
+
+        x += 8;
+        kptr += 32;
+    }
+
+    return _mm_add_epi32(_mm256_castsi256_si128(_sum), _mm256_extracti128_si256(_sum, 1));
+#else  // __AVX2__
+    // I01 I23 F01 F23
+    // O01 O23 G01 G23
+    __m128i _sum0 = _mm_setzero_si128();
+    __m128i _sum1 = _mm_setzero_si128();
+    for (int i = 0; i < size8; i += 4)
+    {
+        __m128i _w = _mm_loadu_si128((const __m128i*)kptr);
+        __m128i _extw = _mm_cmpgt_epi8(_mm_setzero_si128(), _w);
+        __m128i _w0 = _mm_unpacklo_epi8(_w, _extw);
+        __m128i _w1 = _mm_unpackhi_epi8(_w, _extw);
+
+        __m128i _x = _mm_cvtsi32_si128(((const int*)x)[0]);
+        _x = _mm_unpacklo_epi8(_x, _mm_cmpgt_epi8(_mm_setzero_si128(), _x));
+        _x = _mm_unpacklo_epi64(_x, _x);
+
+        _sum0 = _mm_add_epi32(_sum0, _mm_madd_epi16(_w0, _x));
+        _sum1 = _mm_add_epi32(_sum1, _mm_madd_epi16(_w1, _x));
+
+        x += 4;
+        kptr += 16;
+    }
+
+    __m128i _tmp0 = _mm_unpacklo_epi32(_sum0, _sum1);
+    __m128i _tmp1 = _mm_unpackhi_epi32(_sum0, _sum1);
+    __m128i _IO = _mm_add_epi32(_tmp0, _mm_unpackhi_epi64(_tmp0, _tmp0));
+    __m128i _FG = _mm_add_epi32(_tmp1, _mm_unpackhi_epi64(_tmp1, _tmp1));
+    return _mm_unpacklo_epi32(_IO, _FG);
+#endif // __AVX2__
+}
+#else  // __SSE2__
+static inline void lstm_int8_dot_IFOG(const signed char* x, const signed char* kptr, int size8, int* IFOG)
+{
+    IFOG[0] = 0;
+    IFOG[1] = 0;
+    IFOG[2] = 0;
+    IFOG[3] = 0;
+    for (int i = 0; i < size8; i += 4)
+    {
+        for (int g = 0; g < 4; g++)
+        {
+            IFOG[g] += kptr[0] * x[0] + kptr[1] * x[1] + kptr[2] * x[2] + kptr[3] * x[3];
+            kptr += 4;
+        }
+
+        x += 4;
+    }
+}
+#endif // __SSE2__
+
+static int lstm_int8(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, const Mat& weight_hr, Mat& hidden_state, Mat& cell_state, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX2__ && !__AVXVNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        return lstm_int8_avxvnni(bottom_blob, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, weight_hr, hidden_state, cell_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        return lstm_int8_avx2(bottom_blob, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, weight_hr, hidden_state, cell_state, opt);
+    }
+#endif
+
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    int num_output = top_blob.w;
+    int hidden_size = cell_state.w;
+
+    const int size8 = (size + 7) / 8 * 8;
+    const int num_output8 = (num_output + 7) / 8 * 8;
+
+    // dynamic quantize bottom_blob, one scale per timestep
+    Mat bottom_blob_int8(size8, T, (size_t)1u, opt.workspace_allocator);
+    if (bottom_blob_int8.empty())
+        return -100;
+
+    Mat bottom_blob_int8_descales(T, 4u, opt.workspace_allocator);
+    if (bottom_blob_int8_descales.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < T; t++)
+    {
+        bottom_blob_int8_descales[t] = lstm_dynamic_quantize(bottom_blob.row(t), bottom_blob_int8.row<signed char>(t), size, size8);
+    }
+
+    Mat hidden_state_int8(num_output8, (size_t)1u, opt.workspace_allocator);
+    if (hidden_state_int8.empty())
+        return -100;
+
+    // 4 x hidden_size
+    Mat gates(4, hidden_size, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    Mat tmp_hidden_state;
+    if (num_output != hidden_size)
+    {
+        tmp_hidden_state.create(hidden_size, 4u, opt.workspace_allocator);
+        if (tmp_hidden_state.empty())
+            return -100;
+    }
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        int ti = reverse ? T - 1 - t : t;
+
+        const signed char* x = bottom_blob_int8.row<const signed char>(ti);
+        const float descale_x = bottom_blob_int8_descales[ti];
+
+        // dynamic quantize hidden_state
+        const signed char* h = hidden_state_int8;
+        const float descale_h = lstm_dynamic_quantize(hidden_state, hidden_state_int8, num_output, num_output8);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < hidden_size; q++)
+        {
+            const signed char* kptr = weight_data_tm.row<const signed char>(q);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+            const float* bias_c_IFOG = bias_c.row(q);
+
+            float* gates_data = gates.row(q);
+
+#if __SSE2__
+            __m128i _IFOG_x = lstm_int8_dot_IFOG(x, kptr, size8);
+            __m128i _IFOG_h = lstm_int8_dot_IFOG(h, kptr + size8 * 4, num_output8);
+
+            __m128 _descale_xc = _mm_mul_ps(_mm_loadu_ps(descales_ptr), _mm_set1_ps(descale_x));
+            __m128 _descale_hc = _mm_mul_ps(_mm_loadu_ps(descales_ptr + 4), _mm_set1_ps(descale_h));
+
+            __m128 _IFOG = _mm_loadu_ps(bias_c_IFOG);
+            _IFOG = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_IFOG_x), _descale_xc, _IFOG);
+            _IFOG = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_IFOG_h), _descale_hc, _IFOG);
+
+            _mm_storeu_ps(gates_data, _IFOG);
+#else  // __SSE2__
+            int IFOG_x[4];
+            int IFOG_h[4];
+            lstm_int8_dot_IFOG(x, kptr, size8, IFOG_x);
+            lstm_int8_dot_IFOG(h, kptr + size8 * 4, num_output8, IFOG_h);
+
+            for (int g = 0; g < 4; g++)
+            {
+                gates_data[g] = bias_c_IFOG[g] + IFOG_x[g] * (descales_ptr[g] * descale_x) + IFOG_h[g] * (descales_ptr[4 + g] * descale_h);
+            }
+#endif // __SSE2__
+        }
+
+        // lstm unit
+        // sigmoid(I)
+        // sigmoid(F)
+        // sigmoid(O)
+        // tanh(G)
+        // c_t := f_t .* c_{t-1} + i_t .* g_t
+        // h_t := o_t .* tanh[c_t]
+        float* output_data = top_blob.row(ti);
+
+        float* cell_ptr = cell_state;
+        float* hidden_ptr = hidden_state;
+        float* tmp_hidden_ptr = tmp_hidden_state;
+
+        int remain_hidden_size_start = 0;
+#if __SSE2__
+        int nn_hidden_size = hidden_size >> 2;
+        remain_hidden_size_start = nn_hidden_size << 2;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int qq = 0; qq < nn_hidden_size; qq++)
+        {
+            int q = qq * 4;
+
+            const float* gates_data = gates.row(q);
+
+            __m128 _IFOG_4x4_0 = _mm_loadu_ps(gates_data);
+            __m128 _IFOG_4x4_1 = _mm_loadu_ps(gates_data + 4);
+            __m128 _IFOG_4x4_2 = _mm_loadu_ps(gates_data + 8);
+            __m128 _IFOG_4x4_3 = _mm_loadu_ps(gates_data + 12);
+
+            _MM_TRANSPOSE4_PS(_IFOG_4x4_0, _IFOG_4x4_1, _IFOG_4x4_2, _IFOG_4x4_3);
+
+            __m128 _I = sigmoid_sse(_IFOG_4x4_0);
+            __m128 _F = sigmoid_sse(_IFOG_4x4_1);
+            __m128 _O = sigmoid_sse(_IFOG_4x4_2);
+            __m128 _G = tanh_sse(_IFOG_4x4_3);
+
+            __m128 _cell2 = _mm_add_ps(_mm_mul_ps(_F, _mm_loadu_ps(cell_ptr + q)), _mm_mul_ps(_I, _G));
+            __m128 _H = _mm_mul_ps(_O, tanh_sse(_cell2));
+
+            _mm_storeu_ps(cell_ptr + q, _cell2);
+
+            if (num_output == hidden_size)
+            {
+                _mm_storeu_ps(hidden_ptr + q, _H);
+                _mm_storeu_ps(output_data + q, _H);
+            }
+            else
+            {
+                _mm_storeu_ps(tmp_hidden_ptr + q, _H);
+            }
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_hidden_size_start; q < hidden_size; q++)
+        {
+            const float* gates_data = gates.row(q);
+
+            float I = gates_data[0];
+            float F = gates_data[1];
+            float O = gates_data[2];
+            float G = gates_data[3];
+
+            I = 1.f / (1.f + expf(-I));
+            F = 1.f / (1.f + expf(-F));
+            O = 1.f / (1.f + expf(-O));
+            G = tanhf(G);
+
+            float cell2 = F * cell_ptr[q] + I * G;
+            float H = O * tanhf(cell2);
+
+            cell_ptr[q] = cell2;
+            if (num_output == hidden_size)
+            {
+                hidden_ptr[q] = H;
+                output_data[q] = H;
+            }
+            else
+            {
+                tmp_hidden_ptr[q] = H;
+            }
+        }
+
+        if (num_output != hidden_size)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q = 0; q < num_output; q++)
+            {
+                const float* hr = weight_hr.row(q);
+                const float* tmp_hidden_ptr = tmp_hidden_state;
+
+                float H = 0;
+                for (int i = 0; i < hidden_size; i++)
+                {
+                    H += tmp_hidden_ptr[i] * hr[i];
+                }
+
+                output_data[q] = H;
+                hidden_ptr[q] = H;
+            }
+        }
+    }
+
+    return 0;
+}
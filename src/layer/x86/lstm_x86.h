@@ -30,10 +30,20 @@ public:
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
+protected:
+#if NCNN_INT8
+    int create_pipeline_int8(const Option& opt);
+#endif
+
 public:
     Mat weight_xc_data_packed;
     Mat bias_c_data_packed;
     Mat weight_hc_data_packed;
+
+#if NCNN_INT8
+    Mat weight_data_tm;
+    Mat weight_data_tm_int8_descales;
+#endif
 };
 
 } // namespace ncnn
@@ -27,6 +27,9 @@ int Packing_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
 {
     int elembits = bottom_blob.elembits();
 
+    if (elembits == 16)
+        return forward_bf16s_fp16s(bottom_blob, top_blob, opt);
+
     if (elembits == 8)
         return forward_int8(bottom_blob, top_blob, opt);
 
@@ -1397,6 +1400,131 @@ int Packing_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& op
     return 0;
 }
 
+int Packing_x86::forward_bf16s_fp16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    if (use_padding)
+    {
+        return Packing::forward(bottom_blob, top_blob, opt);
+    }
+
+    size_t elemsize = bottom_blob.elemsize;
+    int elempack = bottom_blob.elempack;
+
+    if (elempack == out_elempack)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    bool supported_pack = (elempack == 1 || elempack == 4 || elempack == 8 || elempack == 16) && (out_elempack == 1 || out_elempack == 4 || out_elempack == 8 || out_elempack == 16);
+    if (!supported_pack)
+    {
+        return Packing::forward(bottom_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int d = bottom_blob.d;
+    int channels = bottom_blob.c;
+    int dims = bottom_blob.dims;
+
+    if (!use_padding)
+    {
+        // identity if use_padding not allowed
+        if (dims == 1 && w * elempack % out_elempack != 0)
+        {
+            top_blob = bottom_blob;
+            return 0;
+        }
+        if (dims == 2 && h * elempack % out_elempack != 0)
+        {
+            top_blob = bottom_blob;
+            return 0;
+        }
+        if ((dims == 3 || dims == 4) && channels * elempack % out_elempack != 0)
+        {
+            top_blob = bottom_blob;
+            return 0;
+        }
+    }
+
+    if (dims == 1)
+    {
+        top_blob = bottom_blob;
+        top_blob.w = w * elempack / out_elempack;
+        top_blob.cstep = w * elempack / out_elempack;
+        top_blob.elemsize = elemsize / elempack * out_elempack;
+        top_blob.elempack = out_elempack;
+        return 0;
+    }
+
+    if (dims == 2)
+    {
+        int outh = h * elempack / out_elempack;
+        size_t out_elemsize = elemsize / elempack * out_elempack;
+
+        top_blob.create(w, outh, out_elemsize, out_elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < outh; i++)
+        {
+            unsigned short* outptr = top_blob.row<unsigned short>(i);
+
+            // gather each output lane from its source row and lane
+            for (int k = 0; k < out_elempack; k++)
+            {
+                const int srcy = i * out_elempack + k;
+                const unsigned short* ptr = bottom_blob.row<const unsigned short>(srcy / elempack) + srcy % elempack;
+
+                for (int j = 0; j < w; j++)
+                {
+                    outptr[j * out_elempack + k] = ptr[j * elempack];
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 || dims == 4)
+    {
+        int size = w * h * d;
+        int outc = channels * elempack / out_elempack;
+        size_t out_elemsize = elemsize / elempack * out_elempack;
+
+        if (dims == 3)
+            top_blob.create(w, h, outc, out_elemsize, out_elempack, opt.blob_allocator);
+        else // if (dims == 4)
+            top_blob.create(w, h, d, outc, out_elemsize, out_elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < outc; q++)
+        {
+            unsigned short* outptr = top_blob.channel(q);
+
+            // gather each output lane from its source channel and lane
+            for (int k = 0; k < out_elempack; k++)
+            {
+                const int srcq = q * out_elempack + k;
+                const unsigned short* ptr = (const unsigned short*)bottom_blob.channel(srcq / elempack) + srcq % elempack;
+
+                for (int i = 0; i < size; i++)
+                {
+                    outptr[i * out_elempack + k] = ptr[i * elempack];
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    return 0;
+}
+
 int Packing_x86::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
     if (use_padding)
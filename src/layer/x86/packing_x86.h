@@ -27,6 +27,7 @@ public:
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 protected:
+    int forward_bf16s_fp16s(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
     int forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 };
 
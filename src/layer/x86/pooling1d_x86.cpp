@@ -0,0 +1,495 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "pooling1d_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+namespace ncnn {
+
+Pooling1D_x86::Pooling1D_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int Pooling1D_x86::create_pipeline(const Option& /*opt*/)
+{
+    if (adaptive_pooling)
+    {
+        support_packing = false;
+    }
+    return 0;
+}
+
+int Pooling1D_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    // max value in N window
+    // avg value in N window
+
+    if (adaptive_pooling)
+    {
+        return Pooling1D::forward(bottom_blob, top_blob, opt);
+    }
+
+    int elempack = bottom_blob.elempack;
+
+#if __SSE2__
+    if (elempack > 1)
+    {
+        int w = bottom_blob.w;
+        int h = bottom_blob.h;
+        size_t elemsize = bottom_blob.elemsize;
+
+#if __AVX__
+#if __AVX512F__
+        if (elempack == 16)
+        {
+            if (global_pooling)
+            {
+                top_blob.create(h, elemsize, elempack, opt.blob_allocator);
+                if (top_blob.empty())
+                    return -100;
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob.row(q);
+
+                    __m512 _out;
+                    if (pooling_type == PoolMethod_MAX)
+                    {
+                        _out = _mm512_loadu_ps(ptr);
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm512_max_ps(_out, _mm512_loadu_ps(ptr));
+                            ptr += 16;
+                        }
+                    }
+                    else // if (pooling_type == PoolMethod_AVE)
+                    {
+                        _out = _mm512_setzero_ps();
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm512_add_ps(_out, _mm512_loadu_ps(ptr));
+                            ptr += 16;
+                        }
+                        _out = _mm512_mul_ps(_out, _mm512_set1_ps(1.f / w));
+                    }
+
+                    float* outptr = top_blob;
+                    _mm512_storeu_ps(outptr + q * 16, _out);
+                }
+
+                return 0;
+            }
+
+            Mat bottom_blob_bordered;
+            make_padding(bottom_blob, bottom_blob_bordered, opt);
+            if (bottom_blob_bordered.empty())
+                return -100;
+
+            w = bottom_blob_bordered.w;
+
+            const int outw = (w - kernel_w) / stride_w + 1;
+
+            top_blob.create(outw, h, elemsize, elempack, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            if (pooling_type == PoolMethod_MAX || avgpool_count_include_pad == 1)
+            {
+                const bool is_max = pooling_type == PoolMethod_MAX;
+                const __m512 _inv_kernel_w = _mm512_set1_ps(1.f / kernel_w);
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        const float* sptr = ptr + j * stride_w * 16;
+
+                        __m512 _out;
+                        if (is_max)
+                        {
+                            _out = _mm512_load_ps(sptr);
+                            for (int k = 1; k < kernel_w; k++)
+                            {
+                                _out = _mm512_max_ps(_out, _mm512_load_ps(sptr + k * 16));
+                            }
+                        }
+                        else
+                        {
+                            _out = _mm512_setzero_ps();
+                            for (int k = 0; k < kernel_w; k++)
+                            {
+                                _out = _mm512_add_ps(_out, _mm512_load_ps(sptr + k * 16));
+                            }
+                            _out = _mm512_mul_ps(_out, _inv_kernel_w);
+                        }
+
+                        _mm512_store_ps(outptr, _out);
+                        outptr += 16;
+                    }
+                }
+            }
+            else // if (avgpool_count_include_pad == 0)
+            {
+                int wtailpad = 0;
+
+                if (pad_mode == 0) // full padding
+                {
+                    wtailpad = bottom_blob_bordered.w - bottom_blob.w - pad_left - pad_right;
+                }
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        int sx0 = j * stride_w;
+
+                        __m512 _sum = _mm512_setzero_ps();
+                        int area = 0;
+
+                        for (int kj = 0; kj < kernel_w; kj++)
+                        {
+                            int sx = sx0 + kj;
+
+                            if (sx < pad_left)
+                                continue;
+
+                            if (sx >= w - pad_right - wtailpad)
+                                break;
+
+                            _sum = _mm512_add_ps(_sum, _mm512_load_ps(ptr + sx * 16));
+                            area += 1;
+                        }
+
+                        _mm512_store_ps(outptr, _mm512_mul_ps(_sum, _mm512_set1_ps(1.f / area)));
+                        outptr += 16;
+                    }
+                }
+            }
+
+            return 0;
+        }
+#endif // __AVX512F__
+
+        if (elempack == 8)
+        {
+            if (global_pooling)
+            {
+                top_blob.create(h, elemsize, elempack, opt.blob_allocator);
+                if (top_blob.empty())
+                    return -100;
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob.row(q);
+
+                    __m256 _out;
+                    if (pooling_type == PoolMethod_MAX)
+                    {
+                        _out = _mm256_loadu_ps(ptr);
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm256_max_ps(_out, _mm256_loadu_ps(ptr));
+                            ptr += 8;
+                        }
+                    }
+                    else // if (pooling_type == PoolMethod_AVE)
+                    {
+                        _out = _mm256_setzero_ps();
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm256_add_ps(_out, _mm256_loadu_ps(ptr));
+                            ptr += 8;
+                        }
+                        _out = _mm256_mul_ps(_out, _mm256_set1_ps(1.f / w));
+                    }
+
+                    float* outptr = top_blob;
+                    _mm256_storeu_ps(outptr + q * 8, _out);
+                }
+
+                return 0;
+            }
+
+            Mat bottom_blob_bordered;
+            make_padding(bottom_blob, bottom_blob_bordered, opt);
+            if (bottom_blob_bordered.empty())
+                return -100;
+
+            w = bottom_blob_bordered.w;
+
+            const int outw = (w - kernel_w) / stride_w + 1;
+
+            top_blob.create(outw, h, elemsize, elempack, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            if (pooling_type == PoolMethod_MAX || avgpool_count_include_pad == 1)
+            {
+                const bool is_max = pooling_type == PoolMethod_MAX;
+                const __m256 _inv_kernel_w = _mm256_set1_ps(1.f / kernel_w);
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        const float* sptr = ptr + j * stride_w * 8;
+
+                        __m256 _out;
+                        if (is_max)
+                        {
+                            _out = _mm256_load_ps(sptr);
+                            for (int k = 1; k < kernel_w; k++)
+                            {
+                                _out = _mm256_max_ps(_out, _mm256_load_ps(sptr + k * 8));
+                            }
+                        }
+                        else
+                        {
+                            _out = _mm256_setzero_ps();
+                            for (int k = 0; k < kernel_w; k++)
+                            {
+                                _out = _mm256_add_ps(_out, _mm256_load_ps(sptr + k * 8));
+                            }
+                            _out = _mm256_mul_ps(_out, _inv_kernel_w);
+                        }
+
+                        _mm256_store_ps(outptr, _out);
+                        outptr += 8;
+                    }
+                }
+            }
+            else // if (avgpool_count_include_pad == 0)
+            {
+                int wtailpad = 0;
+
+                if (pad_mode == 0) // full padding
+                {
+                    wtailpad = bottom_blob_bordered.w - bottom_blob.w - pad_left - pad_right;
+                }
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        int sx0 = j * stride_w;
+
+                        __m256 _sum = _mm256_setzero_ps();
+                        int area = 0;
+
+                        for (int kj = 0; kj < kernel_w; kj++)
+                        {
+                            int sx = sx0 + kj;
+
+                            if (sx < pad_left)
+                                continue;
+
+                            if (sx >= w - pad_right - wtailpad)
+                                break;
+
+                            _sum = _mm256_add_ps(_sum, _mm256_load_ps(ptr + sx * 8));
+                            area += 1;
+                        }
+
+                        _mm256_store_ps(outptr, _mm256_mul_ps(_sum, _mm256_set1_ps(1.f / area)));
+                        outptr += 8;
+                    }
+                }
+            }
+
+            return 0;
+        }
+#endif // __AVX__
+
+        if (elempack == 4)
+        {
+            if (global_pooling)
+            {
+                top_blob.create(h, elemsize, elempack, opt.blob_allocator);
+                if (top_blob.empty())
+                    return -100;
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob.row(q);
+
+                    __m128 _out;
+                    if (pooling_type == PoolMethod_MAX)
+                    {
+                        _out = _mm_loadu_ps(ptr);
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm_max_ps(_out, _mm_loadu_ps(ptr));
+                            ptr += 4;
+                        }
+                    }
+                    else // if (pooling_type == PoolMethod_AVE)
+                    {
+                        _out = _mm_setzero_ps();
+                        for (int i = 0; i < w; i++)
+                        {
+                            _out = _mm_add_ps(_out, _mm_loadu_ps(ptr));
+                            ptr += 4;
+                        }
+                        _out = _mm_mul_ps(_out, _mm_set1_ps(1.f / w));
+                    }
+
+                    float* outptr = top_blob;
+                    _mm_storeu_ps(outptr + q * 4, _out);
+                }
+
+                return 0;
+            }
+
+            Mat bottom_blob_bordered;
+            make_padding(bottom_blob, bottom_blob_bordered, opt);
+            if (bottom_blob_bordered.empty())
+                return -100;
+
+            w = bottom_blob_bordered.w;
+
+            const int outw = (w - kernel_w) / stride_w + 1;
+
+            top_blob.create(outw, h, elemsize, elempack, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            if (pooling_type == PoolMethod_MAX || avgpool_count_include_pad == 1)
+            {
+                const bool is_max = pooling_type == PoolMethod_MAX;
+                const __m128 _inv_kernel_w = _mm_set1_ps(1.f / kernel_w);
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        const float* sptr = ptr + j * stride_w * 4;
+
+                        __m128 _out;
+                        if (is_max)
+                        {
+                            _out = _mm_load_ps(sptr);
+                            for (int k = 1; k < kernel_w; k++)
+                            {
+                                _out = _mm_max_ps(_out, _mm_load_ps(sptr + k * 4));
+                            }
+                        }
+                        else
+                        {
+                            _out = _mm_setzero_ps();
+                            for (int k = 0; k < kernel_w; k++)
+                            {
+                                _out = _mm_add_ps(_out, _mm_load_ps(sptr + k * 4));
+                            }
+                            _out = _mm_mul_ps(_out, _inv_kernel_w);
+                        }
+
+                        _mm_store_ps(outptr, _out);
+                        outptr += 4;
+                    }
+                }
+            }
+            else // if (avgpool_count_include_pad == 0)
+            {
+                int wtailpad = 0;
+
+                if (pad_mode == 0) // full padding
+                {
+                    wtailpad = bottom_blob_bordered.w - bottom_blob.w - pad_left - pad_right;
+                }
+
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int q = 0; q < h; q++)
+                {
+                    const float* ptr = bottom_blob_bordered.row(q);
+                    float* outptr = top_blob.row(q);
+
+                    for (int j = 0; j < outw; j++)
+                    {
+                        int sx0 = j * stride_w;
+
+                        __m128 _sum = _mm_setzero_ps();
+                        int area = 0;
+
+                        for (int kj = 0; kj < kernel_w; kj++)
+                        {
+                            int sx = sx0 + kj;
+
+                            if (sx < pad_left)
+                                continue;
+
+                            if (sx >= w - pad_right - wtailpad)
+                                break;
+
+                            _sum = _mm_add_ps(_sum, _mm_load_ps(ptr + sx * 4));
+                            area += 1;
+                        }
+
+                        _mm_store_ps(outptr, _mm_mul_ps(_sum, _mm_set1_ps(1.f / area)));
+                        outptr += 4;
+                    }
+                }
+            }
+
+            return 0;
+        }
+    }
+#endif // __SSE2__
+
+    Mat bottom_blob_unpacked = bottom_blob;
+    if (elempack != 1)
+    {
+        Option opt_pack1 = opt;
+        opt_pack1.blob_allocator = opt.workspace_allocator;
+
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_pack1);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+    }
+
+    return Pooling1D::forward(bottom_blob_unpacked, top_blob, opt);
+}
+
+} // namespace ncnn
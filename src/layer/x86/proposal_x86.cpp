@@ -0,0 +1,248 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "proposal_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#endif // __SSE2__
+
+#include "x86_nms.h"
+
+#include <math.h>
+
+namespace ncnn {
+
+Proposal_x86::Proposal_x86()
+{
+}
+
+struct BBoxRect
+{
+    float xmin;
+    float ymin;
+    float xmax;
+    float ymax;
+    int label;
+};
+
+int Proposal_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& score_blob = bottom_blobs[0];
+    const Mat& bbox_blob = bottom_blobs[1];
+    const Mat& im_info_blob = bottom_blobs[2];
+
+    int w = score_blob.w;
+    int h = score_blob.h;
+
+    // generate proposals from bbox deltas and shifted anchors
+    // and clip predicted boxes to image in the same pass
+    const int num_anchors = anchors.h;
+
+    float im_w = im_info_blob[1];
+    float im_h = im_info_blob[0];
+
+    Mat proposals;
+    proposals.create(4, w * h, num_anchors, 4u, opt.workspace_allocator);
+    if (proposals.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < num_anchors; q++)
+    {
+        const float* bbox_xptr = bbox_blob.channel(q * 4);
+        const float* bbox_yptr = bbox_blob.channel(q * 4 + 1);
+        const float* bbox_wptr = bbox_blob.channel(q * 4 + 2);
+        const float* bbox_hptr = bbox_blob.channel(q * 4 + 3);
+
+        Mat pbs = proposals.channel(q);
+
+        const float* anchor = anchors.row(q);
+
+        // shifted anchor
+        float anchor_y = anchor[1];
+
+        float anchor_w = anchor[2] - anchor[0];
+        float anchor_h = anchor[3] - anchor[1];
+
+        for (int i = 0; i < h; i++)
+        {
+            float anchor_x = anchor[0];
+
+            int j = 0;
+#if __SSE2__
+            const __m128 _half = _mm_set1_ps(0.5f);
+            const __m128 _anchor_w = _mm_set1_ps(anchor_w);
+            const __m128 _anchor_h = _mm_set1_ps(anchor_h);
+            const __m128 _cy = _mm_set1_ps(anchor_y + anchor_h * 0.5f);
+            const __m128 _shift = _mm_setr_ps(0.f, (float)feat_stride, (float)(feat_stride * 2), (float)(feat_stride * 3));
+            const __m128 _zero = _mm_setzero_ps();
+            const __m128 _im_max = _mm_setr_ps(im_w - 1, im_h - 1, im_w - 1, im_h - 1);
+
+            for (; j + 3 < w; j += 4)
+            {
+                float* pb = pbs.row(i * w + j);
+
+                // apply center size
+                __m128 _dx = _mm_loadu_ps(bbox_xptr + j);
+                __m128 _dy = _mm_loadu_ps(bbox_yptr + j);
+                __m128 _dw = _mm_loadu_ps(bbox_wptr + j);
+                __m128 _dh = _mm_loadu_ps(bbox_hptr + j);
+
+                __m128 _cx = _mm_add_ps(_mm_add_ps(_mm_set1_ps(anchor_x), _shift), _mm_mul_ps(_anchor_w, _half));
+
+                __m128 _pb_cx = _mm_add_ps(_cx, _mm_mul_ps(_anchor_w, _dx));
+                __m128 _pb_cy = _mm_add_ps(_cy, _mm_mul_ps(_anchor_h, _dy));
+
+                __m128 _pb_w = _mm_mul_ps(_anchor_w, exp_ps(_dw));
+                __m128 _pb_h = _mm_mul_ps(_anchor_h, exp_ps(_dh));
+
+                __m128 _pb0 = _mm_sub_ps(_pb_cx, _mm_mul_ps(_pb_w, _half));
+                __m128 _pb1 = _mm_sub_ps(_pb_cy, _mm_mul_ps(_pb_h, _half));
+                __m128 _pb2 = _mm_add_ps(_pb_cx, _mm_mul_ps(_pb_w, _half));
+                __m128 _pb3 = _mm_add_ps(_pb_cy, _mm_mul_ps(_pb_h, _half));
+                _MM_TRANSPOSE4_PS(_pb0, _pb1, _pb2, _pb3);
+
+                // clip box
+                _pb0 = _mm_max_ps(_mm_min_ps(_pb0, _im_max), _zero);
+                _pb1 = _mm_max_ps(_mm_min_ps(_pb1, _im_max), _zero);
+                _pb2 = _mm_max_ps(_mm_min_ps(_pb2, _im_max), _zero);
+                _pb3 = _mm_max_ps(_mm_min_ps(_pb3, _im_max), _zero);
+
+                _mm_storeu_ps(pb, _pb0);
+                _mm_storeu_ps(pb + 4, _pb1);
+                _mm_storeu_ps(pb + 8, _pb2);
+                _mm_storeu_ps(pb + 12, _pb3);
+
+                anchor_x += feat_stride * 4;
+            }
+#endif // __SSE2__
+            for (; j < w; j++)
+            {
+                float* pb = pbs.row(i * w + j);
+
+                // apply center size
+                float dx = bbox_xptr[j];
+                float dy = bbox_yptr[j];
+                float dw = bbox_wptr[j];
+                float dh = bbox_hptr[j];
+
+                float cx = anchor_x + anchor_w * 0.5f;
+                float cy = anchor_y + anchor_h * 0.5f;
+
+                float pb_cx = cx + anchor_w * dx;
+                float pb_cy = cy + anchor_h * dy;
+
+                float pb_w = anchor_w * expf(dw);
+                float pb_h = anchor_h * expf(dh);
+
+                // clip box
+                pb[0] = std::max(std::min(pb_cx - pb_w * 0.5f, im_w - 1), 0.f);
+                pb[1] = std::max(std::min(pb_cy - pb_h * 0.5f, im_h - 1), 0.f);
+                pb[2] = std::max(std::min(pb_cx + pb_w * 0.5f, im_w - 1), 0.f);
+                pb[3] = std::max(std::min(pb_cy + pb_h * 0.5f, im_h - 1), 0.f);
+
+                anchor_x += feat_stride;
+            }
+
+            bbox_xptr += w;
+            bbox_yptr += w;
+            bbox_wptr += w;
+            bbox_hptr += w;
+
+            anchor_y += feat_stride;
+        }
+    }
+
+    // remove predicted boxes with either height or width < threshold
+    std::vector<BBoxRect> proposal_boxes;
+    std::vector<float> scores;
+
+    float im_scale = im_info_blob[2];
+    float min_boxsize = min_size * im_scale;
+
+    for (int q = 0; q < num_anchors; q++)
+    {
+        Mat pbs = proposals.channel(q);
+        const float* scoreptr = score_blob.channel(q + num_anchors);
+
+        for (int i = 0; i < w * h; i++)
+        {
+            float* pb = pbs.row(i);
+
+            float pb_w = pb[2] - pb[0] + 1;
+            float pb_h = pb[3] - pb[1] + 1;
+
+            if (pb_w >= min_boxsize && pb_h >= min_boxsize)
+            {
+                BBoxRect r = {pb[0], pb[1], pb[2], pb[3], 0};
+                proposal_boxes.push_back(r);
+                scores.push_back(scoreptr[i]);
+            }
+        }
+    }
+
+    // take top pre_nms_topN by score from highest to lowest
+    std::vector<int> order;
+    topk_descent_indices(scores, pre_nms_topN > 0 ? pre_nms_topN : -1, order);
+
+    std::vector<BBoxRect> sorted_boxes(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        sorted_boxes[i] = proposal_boxes[order[i]];
+    }
+
+    // apply nms with nms_thresh
+    std::vector<size_t> picked;
+    nms_sorted_bboxes_x86(sorted_boxes, picked, nms_thresh);
+
+    // take after_nms_topN
+    int picked_count = std::min((int)picked.size(), after_nms_topN);
+
+    // return the top proposals
+    Mat& roi_blob = top_blobs[0];
+    roi_blob.create(4, 1, picked_count, 4u, opt.blob_allocator);
+    if (roi_blob.empty())
+        return -100;
+
+    for (int i = 0; i < picked_count; i++)
+    {
+        float* outptr = roi_blob.channel(i);
+
+        outptr[0] = sorted_boxes[picked[i]].xmin;
+        outptr[1] = sorted_boxes[picked[i]].ymin;
+        outptr[2] = sorted_boxes[picked[i]].xmax;
+        outptr[3] = sorted_boxes[picked[i]].ymax;
+    }
+
+    if (top_blobs.size() > 1)
+    {
+        Mat& roi_score_blob = top_blobs[1];
+        roi_score_blob.create(1, 1, picked_count, 4u, opt.blob_allocator);
+        if (roi_score_blob.empty())
+            return -100;
+
+        for (int i = 0; i < picked_count; i++)
+        {
+            float* outptr = roi_score_blob.channel(i);
+            outptr[0] = scores[order[picked[i]]];
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
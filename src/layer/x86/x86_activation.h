@@ -47,6 +47,19 @@ static NCNN_FORCEINLINE __m128 swish_sse(__m128 inputs)
     return _mm_mul_ps(inputs, sigmoid_sse(inputs));
 }
 
+// the tanh approximation of gelu
+static NCNN_FORCEINLINE __m128 gelu_sse(__m128 inputs)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 fast1c = _mm_set1_ps(0.79788452f);
+    const __m128 fast2c = _mm_set1_ps(0.044715f);
+    __m128 cube = _mm_mul_ps(_mm_mul_ps(inputs, inputs), inputs);
+    __m128 blob = _mm_mul_ps(fast1c, _mm_add_ps(inputs, _mm_mul_ps(fast2c, cube)));
+    blob = _mm_add_ps(one, tanh_sse(blob));
+    return _mm_mul_ps(half, _mm_mul_ps(blob, inputs));
+}
+
 static NCNN_FORCEINLINE __m128 hardswish_sse(__m128 inputs, __m128 a, __m128 b)
 {
     const __m128 one = _mm_set1_ps(1.0f);
@@ -115,6 +128,24 @@ static NCNN_FORCEINLINE __m128 activation_sse(__m128 _v, int activation_type, co
         __m128 _b = _mm_set1_ps(activation_params[1]);
         return hardswish_sse(_v, _a, _b);
     }
+    case 7:
+    {
+        return swish_sse(_v);
+    }
+    case 8:
+    {
+        if (activation_params[0] != 0.f)
+            return gelu_sse(_v);
+
+        // no vector erf, the exact gelu runs per lane
+        float tmp[4];
+        _mm_storeu_ps(tmp, _v);
+        for (int i = 0; i < 4; i++)
+        {
+            tmp[i] = activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm_loadu_ps(tmp);
+    }
     }
 
     return _v;
@@ -151,6 +182,19 @@ static NCNN_FORCEINLINE __m256 swish_avx(__m256 inputs)
     return _mm256_mul_ps(inputs, sigmoid_avx(inputs));
 }
 
+// the tanh approximation of gelu
+static NCNN_FORCEINLINE __m256 gelu_avx(__m256 inputs)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 fast1c = _mm256_set1_ps(0.79788452f);
+    const __m256 fast2c = _mm256_set1_ps(0.044715f);
+    __m256 cube = _mm256_mul_ps(_mm256_mul_ps(inputs, inputs), inputs);
+    __m256 blob = _mm256_mul_ps(fast1c, _mm256_add_ps(inputs, _mm256_mul_ps(fast2c, cube)));
+    blob = _mm256_add_ps(one, tanh_avx(blob));
+    return _mm256_mul_ps(half, _mm256_mul_ps(blob, inputs));
+}
+
 static NCNN_FORCEINLINE __m256 hardswish_avx(__m256 inputs, __m256 a, __m256 b)
 {
     const __m256 one = _mm256_set1_ps(1.0f);
@@ -219,6 +263,24 @@ static NCNN_FORCEINLINE __m256 activation_avx(__m256 _v, int activation_type, co
         __m256 _b = _mm256_set1_ps(activation_params[1]);
         return hardswish_avx(_v, _a, _b);
     }
+    case 7:
+    {
+        return swish_avx(_v);
+    }
+    case 8:
+    {
+        if (activation_params[0] != 0.f)
+            return gelu_avx(_v);
+
+        // no vector erf, the exact gelu runs per lane
+        float tmp[8];
+        _mm256_storeu_ps(tmp, _v);
+        for (int i = 0; i < 8; i++)
+        {
+            tmp[i] = activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm256_loadu_ps(tmp);
+    }
     }
 
     return _v;
@@ -250,6 +312,19 @@ static NCNN_FORCEINLINE __m512 swish_avx512(__m512 inputs)
     return _mm512_mul_ps(inputs, sigmoid_avx512(inputs));
 }
 
+// the tanh approximation of gelu
+static NCNN_FORCEINLINE __m512 gelu_avx512(__m512 inputs)
+{
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 fast1c = _mm512_set1_ps(0.79788452f);
+    const __m512 fast2c = _mm512_set1_ps(0.044715f);
+    __m512 cube = _mm512_mul_ps(_mm512_mul_ps(inputs, inputs), inputs);
+    __m512 blob = _mm512_mul_ps(fast1c, _mm512_add_ps(inputs, _mm512_mul_ps(fast2c, cube)));
+    blob = _mm512_add_ps(one, tanh_avx512(blob));
+    return _mm512_mul_ps(half, _mm512_mul_ps(blob, inputs));
+}
+
 static NCNN_FORCEINLINE __m512 hardswish_avx512(__m512 inputs, __m512 a, __m512 b)
 {
     const __m512 one = _mm512_set1_ps(1.0f);
@@ -317,6 +392,24 @@ static NCNN_FORCEINLINE __m512 activation_avx512(__m512 _v, int activation_type,
         __m512 _b = _mm512_set1_ps(activation_params[1]);
         return hardswish_avx512(_v, _a, _b);
     }
+    case 7:
+    {
+        return swish_avx512(_v);
+    }
+    case 8:
+    {
+        if (activation_params[0] != 0.f)
+            return gelu_avx512(_v);
+
+        // no vector erf, the exact gelu runs per lane
+        float tmp[16];
+        _mm512_storeu_ps(tmp, _v);
+        for (int i = 0; i < 16; i++)
+        {
+            tmp[i] = activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm512_loadu_ps(tmp);
+    }
     }
 
     return _v;
@@ -0,0 +1,204 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_NMS_H
+#define X86_NMS_H
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include <algorithm>
+#include <vector>
+
+// sort helper for topk_descent_indices
+// equal scores are ordered by index, which matches the stable sort of the reference layers
+struct topk_descent_compare
+{
+    const float* scores;
+
+    bool operator()(int a, int b) const
+    {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    }
+};
+
+// indices of the k highest scores, highest first
+// only the k survivors are fully ordered, the rest is a heap pass
+// k < 0 sorts all of them
+static void topk_descent_indices(const std::vector<float>& scores, int k, std::vector<int>& indices)
+{
+    const int n = (int)scores.size();
+
+    indices.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        indices[i] = i;
+    }
+
+    if (n == 0)
+        return;
+
+    topk_descent_compare comp = {&scores[0]};
+
+    if (k >= 0 && k < n)
+    {
+        std::partial_sort(indices.begin(), indices.begin() + k, indices.end(), comp);
+        indices.resize(k);
+    }
+    else
+    {
+        std::sort(indices.begin(), indices.end(), comp);
+    }
+}
+
+// greedy nms for boxes sorted by score from highest to lowest
+// T needs xmin ymin xmax ymax, the iou arithmetic matches the reference layers bit by bit
+// the picked boxes are mirrored in soa buffers so each candidate is tested against 8 or 4 of them at once
+// and a candidate stops at the first picked box that overlaps it above nms_threshold
+template<typename T>
+static void nms_sorted_bboxes_x86(const std::vector<T>& bboxes, std::vector<size_t>& picked, float nms_threshold)
+{
+    picked.clear();
+
+    const int n = (int)bboxes.size();
+    if (n == 0)
+        return;
+
+    std::vector<float> picked_data(n * 5);
+    float* px0 = &picked_data[0];
+    float* py0 = px0 + n;
+    float* px1 = py0 + n;
+    float* py1 = px1 + n;
+    float* parea = py1 + n;
+
+    int picked_count = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        const T& a = bboxes[i];
+
+        const float area = (a.xmax - a.xmin) * (a.ymax - a.ymin);
+
+        bool keep = true;
+
+        int j = 0;
+#if __SSE2__
+#if __AVX__
+        {
+            __m256 _ax0 = _mm256_set1_ps(a.xmin);
+            __m256 _ay0 = _mm256_set1_ps(a.ymin);
+            __m256 _ax1 = _mm256_set1_ps(a.xmax);
+            __m256 _ay1 = _mm256_set1_ps(a.ymax);
+            __m256 _area = _mm256_set1_ps(area);
+            __m256 _nms_threshold = _mm256_set1_ps(nms_threshold);
+
+            for (; j + 7 < picked_count; j += 8)
+            {
+                __m256 _bx0 = _mm256_loadu_ps(px0 + j);
+                __m256 _by0 = _mm256_loadu_ps(py0 + j);
+                __m256 _bx1 = _mm256_loadu_ps(px1 + j);
+                __m256 _by1 = _mm256_loadu_ps(py1 + j);
+                __m256 _barea = _mm256_loadu_ps(parea + j);
+
+                // no intersection
+                __m256 _disjoint = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(_ax0, _bx1, _CMP_GT_OQ), _mm256_cmp_ps(_ax1, _bx0, _CMP_LT_OQ)), _mm256_or_ps(_mm256_cmp_ps(_ay0, _by1, _CMP_GT_OQ), _mm256_cmp_ps(_ay1, _by0, _CMP_LT_OQ)));
+
+                __m256 _inter_width = _mm256_sub_ps(_mm256_min_ps(_ax1, _bx1), _mm256_max_ps(_ax0, _bx0));
+                __m256 _inter_height = _mm256_sub_ps(_mm256_min_ps(_ay1, _by1), _mm256_max_ps(_ay0, _by0));
+                __m256 _inter_area = _mm256_andnot_ps(_disjoint, _mm256_mul_ps(_inter_width, _inter_height));
+                __m256 _union_area = _mm256_sub_ps(_mm256_add_ps(_area, _barea), _inter_area);
+
+                __m256 _iou = _mm256_div_ps(_inter_area, _union_area);
+                if (_mm256_movemask_ps(_mm256_cmp_ps(_iou, _nms_threshold, _CMP_GT_OQ)))
+                {
+                    keep = false;
+                    break;
+                }
+            }
+        }
+#endif // __AVX__
+        if (keep)
+        {
+            __m128 _ax0 = _mm_set1_ps(a.xmin);
+            __m128 _ay0 = _mm_set1_ps(a.ymin);
+            __m128 _ax1 = _mm_set1_ps(a.xmax);
+            __m128 _ay1 = _mm_set1_ps(a.ymax);
+            __m128 _area = _mm_set1_ps(area);
+            __m128 _nms_threshold = _mm_set1_ps(nms_threshold);
+
+            for (; j + 3 < picked_count; j += 4)
+            {
+                __m128 _bx0 = _mm_loadu_ps(px0 + j);
+                __m128 _by0 = _mm_loadu_ps(py0 + j);
+                __m128 _bx1 = _mm_loadu_ps(px1 + j);
+                __m128 _by1 = _mm_loadu_ps(py1 + j);
+                __m128 _barea = _mm_loadu_ps(parea + j);
+
+                // no intersection
+                __m128 _disjoint = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(_ax0, _bx1), _mm_cmplt_ps(_ax1, _bx0)), _mm_or_ps(_mm_cmpgt_ps(_ay0, _by1), _mm_cmplt_ps(_ay1, _by0)));
+
+                __m128 _inter_width = _mm_sub_ps(_mm_min_ps(_ax1, _bx1), _mm_max_ps(_ax0, _bx0));
+                __m128 _inter_height = _mm_sub_ps(_mm_min_ps(_ay1, _by1), _mm_max_ps(_ay0, _by0));
+                __m128 _inter_area = _mm_andnot_ps(_disjoint, _mm_mul_ps(_inter_width, _inter_height));
+                __m128 _union_area = _mm_sub_ps(_mm_add_ps(_area, _barea), _inter_area);
+
+                __m128 _iou = _mm_div_ps(_inter_area, _union_area);
+                if (_mm_movemask_ps(_mm_cmpgt_ps(_iou, _nms_threshold)))
+                {
+                    keep = false;
+                    break;
+                }
+            }
+        }
+#endif // __SSE2__
+        if (keep)
+        {
+            for (; j < picked_count; j++)
+            {
+                // no intersection
+                if (a.xmin > px1[j] || a.xmax < px0[j] || a.ymin > py1[j] || a.ymax < py0[j])
+                    continue;
+
+                float inter_width = std::min(a.xmax, px1[j]) - std::max(a.xmin, px0[j]);
+                float inter_height = std::min(a.ymax, py1[j]) - std::max(a.ymin, py0[j]);
+                float inter_area = inter_width * inter_height;
+                float union_area = area + parea[j] - inter_area;
+
+                if (inter_area / union_area > nms_threshold)
+                {
+                    keep = false;
+                    break;
+                }
+            }
+        }
+
+        if (keep)
+        {
+            px0[picked_count] = a.xmin;
+            py0[picked_count] = a.ymin;
+            px1[picked_count] = a.xmax;
+            py1[picked_count] = a.ymax;
+            parea[picked_count] = area;
+            picked_count++;
+
+            picked.push_back(i);
+        }
+    }
+}
+
+#endif // X86_NMS_H
@@ -0,0 +1,355 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_SPARSE_WEIGHT_H
+#define X86_SPARSE_WEIGHT_H
+
+#include "mat.h"
+#include "option.h"
+#include "x86_activation.h"
+#include "x86_usability.h"
+
+#include <algorithm>
+
+// block sparse weight for pruned innerproduct and 1x1 convolution
+//
+// the outputs are grouped by nb, a 1xnb block is nb outputs sharing one input index
+// and only the blocks with at least one nonzero weight are stored
+//
+// weight_sparse_index : int32, group offsets [ngroup + 1] followed by input indices [nnz]
+// weight_sparse_data  : fp32, nb weights per stored block, the tail group is zero padded
+
+static inline int sparse_weight_block_width()
+{
+#if __AVX512F__
+    return 16;
+#elif __AVX__
+    return 8;
+#else
+    return 4;
+#endif
+}
+
+// weight is num_output rows of num_input
+// returns 0 and leaves the outputs empty when less than half of the blocks are all zero
+static int sparse_weight_transform_kernel(const ncnn::Mat& weight, ncnn::Mat& weight_sparse_index, ncnn::Mat& weight_sparse_data, int num_input, int num_output)
+{
+    const int nb = sparse_weight_block_width();
+    const int ngroup = (num_output + nb - 1) / nb;
+
+    const float* kptr = weight;
+
+    int nnz = 0;
+    for (int g = 0; g < ngroup; g++)
+    {
+        for (int k = 0; k < num_input; k++)
+        {
+            for (int r = 0; r < nb && g * nb + r < num_output; r++)
+            {
+                if (kptr[(g * nb + r) * num_input + k] != 0.f)
+                {
+                    nnz++;
+                    break;
+                }
+            }
+        }
+    }
+
+    const int nblock = ngroup * num_input;
+    if (nblock == 0 || (nblock - nnz) * 2 < nblock)
+        return 0;
+
+    weight_sparse_index.create(ngroup + 1 + nnz, (size_t)4u);
+    weight_sparse_data.create(nnz * nb + nb, (size_t)4u);
+    if (weight_sparse_index.empty() || weight_sparse_data.empty())
+        return -100;
+
+    weight_sparse_data.fill(0.f);
+
+    int* offsets = weight_sparse_index;
+    int* indices = offsets + ngroup + 1;
+    float* g00 = weight_sparse_data;
+
+    int j = 0;
+    for (int g = 0; g < ngroup; g++)
+    {
+        offsets[g] = j;
+
+        for (int k = 0; k < num_input; k++)
+        {
+            bool nonzero = false;
+            for (int r = 0; r < nb && g * nb + r < num_output; r++)
+            {
+                if (kptr[(g * nb + r) * num_input + k] != 0.f)
+                {
+                    nonzero = true;
+                    break;
+                }
+            }
+
+            if (!nonzero)
+                continue;
+
+            indices[j] = k;
+            for (int r = 0; r < nb && g * nb + r < num_output; r++)
+            {
+                g00[j * nb + r] = kptr[(g * nb + r) * num_input + k];
+            }
+            j++;
+        }
+    }
+    offsets[ngroup] = j;
+
+    return 0;
+}
+
+// outputs [g * nb, g * nb + nb) of one input vector
+// x and out may be strided so that a row of a packed blob is visited lane by lane
+static void sparse_weight_gemv_group(const float* x, int xstride, float* out, int outstride, int g, const ncnn::Mat& weight_sparse_index, const ncnn::Mat& weight_sparse_data, const ncnn::Mat& bias_data, int num_output, int activation_type, const ncnn::Mat& activation_params)
+{
+    const int nb = sparse_weight_block_width();
+    const int ngroup = (num_output + nb - 1) / nb;
+
+    const int* offsets = weight_sparse_index;
+    const int* indices = offsets + ngroup + 1;
+
+    const int valid = std::min(nb, num_output - g * nb);
+
+    float sum[16];
+    for (int r = 0; r < nb; r++)
+    {
+        sum[r] = !bias_data.empty() && r < valid ? bias_data[g * nb + r] : 0.f;
+    }
+
+    const float* kptr = (const float*)weight_sparse_data + offsets[g] * nb;
+    const int nnz = offsets[g + 1] - offsets[g];
+    const int* iptr = indices + offsets[g];
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _sum = _mm512_loadu_ps(sum);
+    for (int j = 0; j < nnz; j++)
+    {
+        __m512 _w = _mm512_loadu_ps(kptr);
+        _sum = _mm512_fmadd_ps(_w, _mm512_set1_ps(x[iptr[j] * xstride]), _sum);
+        kptr += 16;
+    }
+    _sum = activation_avx512(_sum, activation_type, activation_params);
+
+    if (outstride == 1 && valid == 16)
+    {
+        _mm512_storeu_ps(out + g * 16, _sum);
+        return;
+    }
+    _mm512_storeu_ps(sum, _sum);
+#else  // __AVX512F__
+    __m256 _sum = _mm256_loadu_ps(sum);
+    for (int j = 0; j < nnz; j++)
+    {
+        __m256 _w = _mm256_loadu_ps(kptr);
+        _sum = _mm256_comp_fmadd_ps(_w, _mm256_set1_ps(x[iptr[j] * xstride]), _sum);
+        kptr += 8;
+    }
+    _sum = activation_avx(_sum, activation_type, activation_params);
+
+    if (outstride == 1 && valid == 8)
+    {
+        _mm256_storeu_ps(out + g * 8, _sum);
+        return;
+    }
+    _mm256_storeu_ps(sum, _sum);
+#endif // __AVX512F__
+#else  // __AVX__
+    __m128 _sum = _mm_loadu_ps(sum);
+    for (int j = 0; j < nnz; j++)
+    {
+        __m128 _w = _mm_loadu_ps(kptr);
+        _sum = _mm_comp_fmadd_ps(_w, _mm_set1_ps(x[iptr[j] * xstride]), _sum);
+        kptr += 4;
+    }
+    _sum = activation_sse(_sum, activation_type, activation_params);
+
+    if (outstride == 1 && valid == 4)
+    {
+        _mm_storeu_ps(out + g * 4, _sum);
+        return;
+    }
+    _mm_storeu_ps(sum, _sum);
+#endif // __AVX__
+#else  // __SSE2__
+    for (int j = 0; j < nnz; j++)
+    {
+        const float xi = x[iptr[j] * xstride];
+        for (int r = 0; r < nb; r++)
+        {
+            sum[r] += kptr[r] * xi;
+        }
+        kptr += nb;
+    }
+    for (int r = 0; r < nb; r++)
+    {
+        sum[r] = activation_ss(sum[r], activation_type, activation_params);
+    }
+#endif // __SSE2__
+
+    for (int r = 0; r < valid; r++)
+    {
+        out[(g * nb + r) * outstride] = sum[r];
+    }
+}
+
+// top = weight x bottom for unpacked blobs of num_input and num_output channels
+// nb output channels are accumulated for a run of pixels, each stored block loads one input row once
+static void sparse_weight_gemm(const ncnn::Mat& bottom_blob, ncnn::Mat& top_blob, const ncnn::Mat& weight_sparse_index, const ncnn::Mat& weight_sparse_data, const ncnn::Mat& bias_data, int activation_type, const ncnn::Mat& activation_params, const ncnn::Option& opt)
+{
+    const int size = bottom_blob.w * bottom_blob.h;
+    const int num_output = top_blob.c;
+
+    const int nb = sparse_weight_block_width();
+    const int ngroup = (num_output + nb - 1) / nb;
+
+    const int* offsets = weight_sparse_index;
+    const int* indices = offsets + ngroup + 1;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g = 0; g < ngroup; g++)
+    {
+        const int valid = std::min(nb, num_output - g * nb);
+
+        float bias[16];
+        for (int r = 0; r < nb; r++)
+        {
+            bias[r] = !bias_data.empty() && r < valid ? bias_data[g * nb + r] : 0.f;
+        }
+
+        float* outptrs[16];
+        for (int r = 0; r < nb; r++)
+        {
+            outptrs[r] = r < valid ? (float*)top_blob.channel(g * nb + r) : 0;
+        }
+
+        const int nnz = offsets[g + 1] - offsets[g];
+        const int* iptr = indices + offsets[g];
+        const float* kptr0 = (const float*)weight_sparse_data + offsets[g] * nb;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i + 15 < size; i += 16)
+        {
+            __m512 _sum[16];
+            for (int r = 0; r < 16; r++)
+            {
+                _sum[r] = _mm512_set1_ps(bias[r]);
+            }
+
+            const float* kptr = kptr0;
+            for (int j = 0; j < nnz; j++)
+            {
+                __m512 _v = _mm512_loadu_ps((const float*)bottom_blob.channel(iptr[j]) + i);
+                for (int r = 0; r < 16; r++)
+                {
+                    _sum[r] = _mm512_fmadd_ps(_mm512_set1_ps(kptr[r]), _v, _sum[r]);
+                }
+                kptr += 16;
+            }
+
+            for (int r = 0; r < valid; r++)
+            {
+                _mm512_storeu_ps(outptrs[r] + i, activation_avx512(_sum[r], activation_type, activation_params));
+            }
+        }
+#else  // __AVX512F__
+        for (; i + 7 < size; i += 8)
+        {
+            __m256 _sum[8];
+            for (int r = 0; r < 8; r++)
+            {
+                _sum[r] = _mm256_set1_ps(bias[r]);
+            }
+
+            const float* kptr = kptr0;
+            for (int j = 0; j < nnz; j++)
+            {
+                __m256 _v = _mm256_loadu_ps((const float*)bottom_blob.channel(iptr[j]) + i);
+                for (int r = 0; r < 8; r++)
+                {
+                    _sum[r] = _mm256_comp_fmadd_ps(_mm256_set1_ps(kptr[r]), _v, _sum[r]);
+                }
+                kptr += 8;
+            }
+
+            for (int r = 0; r < valid; r++)
+            {
+                _mm256_storeu_ps(outptrs[r] + i, activation_avx(_sum[r], activation_type, activation_params));
+            }
+        }
+#endif // __AVX512F__
+#else  // __AVX__
+        for (; i + 3 < size; i += 4)
+        {
+            __m128 _sum[4];
+            for (int r = 0; r < 4; r++)
+            {
+                _sum[r] = _mm_set1_ps(bias[r]);
+            }
+
+            const float* kptr = kptr0;
+            for (int j = 0; j < nnz; j++)
+            {
+                __m128 _v = _mm_loadu_ps((const float*)bottom_blob.channel(iptr[j]) + i);
+                for (int r = 0; r < 4; r++)
+                {
+                    _sum[r] = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[r]), _v, _sum[r]);
+                }
+                kptr += 4;
+            }
+
+            for (int r = 0; r < valid; r++)
+            {
+                _mm_storeu_ps(outptrs[r] + i, activation_sse(_sum[r], activation_type, activation_params));
+            }
+        }
+#endif // __AVX__
+#endif // __SSE2__
+        for (; i < size; i++)
+        {
+            float sum[16];
+            for (int r = 0; r < nb; r++)
+            {
+                sum[r] = bias[r];
+            }
+
+            const float* kptr = kptr0;
+            for (int j = 0; j < nnz; j++)
+            {
+                const float v = ((const float*)bottom_blob.channel(iptr[j]))[i];
+                for (int r = 0; r < nb; r++)
+                {
+                    sum[r] += kptr[r] * v;
+                }
+                kptr += nb;
+            }
+
+            for (int r = 0; r < valid; r++)
+            {
+                outptrs[r][i] = activation_ss(sum[r], activation_type, activation_params);
+            }
+        }
+    }
+}
+
+#endif // X86_SPARSE_WEIGHT_H
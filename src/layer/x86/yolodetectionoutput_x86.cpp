@@ -0,0 +1,244 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "yolodetectionoutput_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#include "x86_nms.h"
+
+#include <math.h>
+
+namespace ncnn {
+
+YoloDetectionOutput_x86::YoloDetectionOutput_x86()
+{
+}
+
+struct BBoxRect
+{
+    float xmin;
+    float ymin;
+    float xmax;
+    float ymax;
+    int label;
+};
+
+static inline float sigmoid(float x)
+{
+    return 1.f / (1.f + expf(-x));
+}
+
+int YoloDetectionOutput_x86::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+{
+    // gather all box
+    std::vector<BBoxRect> all_bbox_rects;
+    std::vector<float> all_bbox_scores;
+
+    for (size_t b = 0; b < bottom_top_blobs.size(); b++)
+    {
+        Mat& bottom_top_blob = bottom_top_blobs[b];
+
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+
+        const int channels_per_box = channels / num_box;
+
+        // anchor coord + box score + num_class
+        if (channels_per_box != 4 + 1 + num_class)
+            return -1;
+
+        std::vector<std::vector<BBoxRect> > all_box_bbox_rects;
+        std::vector<std::vector<float> > all_box_bbox_scores;
+        all_box_bbox_rects.resize(num_box);
+        all_box_bbox_scores.resize(num_box);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int pp = 0; pp < num_box; pp++)
+        {
+            int p = pp * channels_per_box;
+
+            const float bias_w = biases[pp * 2];
+            const float bias_h = biases[pp * 2 + 1];
+
+            const float* xptr = bottom_top_blob.channel(p);
+            const float* yptr = bottom_top_blob.channel(p + 1);
+            const float* wptr = bottom_top_blob.channel(p + 2);
+            const float* hptr = bottom_top_blob.channel(p + 3);
+
+            const float* box_score_ptr = bottom_top_blob.channel(p + 4);
+
+            // softmax class scores
+            Mat scores = bottom_top_blob.channel_range(p + 5, num_class);
+            softmax->forward_inplace(scores, opt);
+
+            std::vector<BBoxRect>& box_bbox_rects = all_box_bbox_rects[pp];
+            std::vector<float>& box_bbox_scores = all_box_bbox_scores[pp];
+
+            for (int i = 0; i < h; i++)
+            {
+                int j = 0;
+#if __SSE2__
+                for (; j + 3 < w; j += 4)
+                {
+                    // find class index with max class score, four positions at once
+                    __m128 _class_index = _mm_setzero_ps();
+                    __m128 _class_score = _mm_setzero_ps();
+                    for (int q = 0; q < num_class; q++)
+                    {
+                        __m128 _score = _mm_loadu_ps((const float*)scores.channel(q) + i * w + j);
+                        __m128 _mask = _mm_cmpgt_ps(_score, _class_score);
+                        _class_score = _mm_or_ps(_mm_and_ps(_mask, _score), _mm_andnot_ps(_mask, _class_score));
+                        _class_index = _mm_or_ps(_mm_and_ps(_mask, _mm_set1_ps((float)q)), _mm_andnot_ps(_mask, _class_index));
+                    }
+
+                    float class_index[4];
+                    float class_score[4];
+                    _mm_storeu_ps(class_index, _class_index);
+                    _mm_storeu_ps(class_score, _class_score);
+
+                    // scalar sigmoid and exp keep the scores bit exact with the reference
+                    // so that near ties are ordered the same way in the global sort
+                    for (int k = 0; k < 4; k++)
+                    {
+                        float confidence = sigmoid(box_score_ptr[k]) * class_score[k];
+                        if (confidence < confidence_threshold)
+                            continue;
+
+                        // region box
+                        float bbox_cx = (j + k + sigmoid(xptr[k])) / w;
+                        float bbox_cy = (i + sigmoid(yptr[k])) / h;
+                        float bbox_w = expf(wptr[k]) * bias_w / w;
+                        float bbox_h = expf(hptr[k]) * bias_h / h;
+
+                        float bbox_xmin = bbox_cx - bbox_w * 0.5f;
+                        float bbox_ymin = bbox_cy - bbox_h * 0.5f;
+                        float bbox_xmax = bbox_cx + bbox_w * 0.5f;
+                        float bbox_ymax = bbox_cy + bbox_h * 0.5f;
+
+                        BBoxRect c = {bbox_xmin, bbox_ymin, bbox_xmax, bbox_ymax, (int)class_index[k]};
+                        box_bbox_rects.push_back(c);
+                        box_bbox_scores.push_back(confidence);
+                    }
+
+                    xptr += 4;
+                    yptr += 4;
+                    wptr += 4;
+                    hptr += 4;
+
+                    box_score_ptr += 4;
+                }
+#endif // __SSE2__
+                for (; j < w; j++)
+                {
+                    // box score
+                    float box_score = sigmoid(box_score_ptr[0]);
+
+                    // find class index with max class score
+                    int class_index = 0;
+                    float class_score = 0.f;
+                    for (int q = 0; q < num_class; q++)
+                    {
+                        float score = scores.channel(q).row(i)[j];
+                        if (score > class_score)
+                        {
+                            class_index = q;
+                            class_score = score;
+                        }
+                    }
+
+                    float confidence = box_score * class_score;
+                    if (confidence >= confidence_threshold)
+                    {
+                        // region box
+                        float bbox_cx = (j + sigmoid(xptr[0])) / w;
+                        float bbox_cy = (i + sigmoid(yptr[0])) / h;
+                        float bbox_w = expf(wptr[0]) * bias_w / w;
+                        float bbox_h = expf(hptr[0]) * bias_h / h;
+
+                        float bbox_xmin = bbox_cx - bbox_w * 0.5f;
+                        float bbox_ymin = bbox_cy - bbox_h * 0.5f;
+                        float bbox_xmax = bbox_cx + bbox_w * 0.5f;
+                        float bbox_ymax = bbox_cy + bbox_h * 0.5f;
+
+                        BBoxRect c = {bbox_xmin, bbox_ymin, bbox_xmax, bbox_ymax, class_index};
+                        box_bbox_rects.push_back(c);
+                        box_bbox_scores.push_back(confidence);
+                    }
+
+                    xptr++;
+                    yptr++;
+                    wptr++;
+                    hptr++;
+
+                    box_score_ptr++;
+                }
+            }
+        }
+
+        for (int i = 0; i < num_box; i++)
+        {
+            const std::vector<BBoxRect>& box_bbox_rects = all_box_bbox_rects[i];
+            const std::vector<float>& box_bbox_scores = all_box_bbox_scores[i];
+
+            all_bbox_rects.insert(all_bbox_rects.end(), box_bbox_rects.begin(), box_bbox_rects.end());
+            all_bbox_scores.insert(all_bbox_scores.end(), box_bbox_scores.begin(), box_bbox_scores.end());
+        }
+    }
+
+    // global sort
+    std::vector<int> order;
+    topk_descent_indices(all_bbox_scores, -1, order);
+
+    std::vector<BBoxRect> sorted_bbox_rects(order.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        sorted_bbox_rects[i] = all_bbox_rects[order[i]];
+    }
+
+    // apply nms
+    std::vector<size_t> picked;
+    nms_sorted_bboxes_x86(sorted_bbox_rects, picked, nms_threshold);
+
+    // fill result
+    int num_detected = static_cast<int>(picked.size());
+    if (num_detected == 0)
+        return 0;
+
+    Mat& top_blob = bottom_top_blobs[0];
+    top_blob.create(6, num_detected, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    for (int i = 0; i < num_detected; i++)
+    {
+        const BBoxRect& r = sorted_bbox_rects[picked[i]];
+        float score = all_bbox_scores[order[picked[i]]];
+        float* outptr = top_blob.row(i);
+
+        outptr[0] = r.label + 1.0f; // +1 for prepend background class
+        outptr[1] = score;
+        outptr[2] = r.xmin;
+        outptr[3] = r.ymin;
+        outptr[4] = r.xmax;
+        outptr[5] = r.ymax;
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
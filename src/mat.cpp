@@ -1440,7 +1440,10 @@ void copy_make_border_3d(const Mat& src, Mat& dst, int top, int bottom, int left
 
 void copy_cut_border(const Mat& src, Mat& dst, int top, int bottom, int left, int right, const Option& opt)
 {
-    if (left + right > src.w || top + bottom > src.h)
+    // crop takes the height of packed 2d blob in elements
+    const int h = src.dims == 2 ? src.h * src.elempack : src.h;
+
+    if (left + right > src.w || top + bottom > h)
     {
         NCNN_LOGE("copy_cut_border parameter error, top: %d, bottom: %d, left: %d, right: %d, src.w: %d, src.h: %d", top, bottom, left, right, src.w, src.h);
         return;
@@ -1452,7 +1455,7 @@ void copy_cut_border(const Mat& src, Mat& dst, int top, int bottom, int left, in
     pd.set(1, top);
     pd.set(2, 0);
     pd.set(3, src.w - left - right);
-    pd.set(4, src.h - top - bottom);
+    pd.set(4, h - top - bottom);
     pd.set(5, -233);
 
     crop->load_param(pd);
@@ -20,6 +20,21 @@
 #include "modelbin.h"
 #include "paramdict.h"
 
+#include "layer/binaryop.h"
+#include "layer/clip.h"
+#include "layer/concat.h"
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/deconvolution.h"
+#include "layer/deconvolutiondepthwise.h"
+#include "layer/eltwise.h"
+#include "layer/gelu.h"
+#include "layer/gemm.h"
+#include "layer/hardswish.h"
+#include "layer/innerproduct.h"
+#include "layer/relu.h"
+#include "layer/slice.h"
+
 #include <stdarg.h>
 #include <stdint.h>
 #include <string.h>
@@ -35,6 +50,55 @@
 
 namespace ncnn {
 
+struct weight_cache_entry
+{
+    int typeindex;
+    unsigned int checksum;
+    uint64_t param_hash;
+    std::vector<Mat> mats;
+};
+
+// the concat output of the last forward
+struct concat_view_shape
+{
+    int dims;
+    int w;
+    int h;
+    int d;
+    size_t elemsize;
+    int elempack;
+    // the channel count of each bottom, in elempack units
+    std::vector<int> channels;
+};
+
+// the local state of the inputs padded to one shape bucket
+struct shape_bucket
+{
+    int w;
+    int h;
+    PoolAllocator* blob_allocator;
+    PoolAllocator* workspace_allocator;
+    // the concat outputs of the last forward in this bucket
+    std::vector<concat_view_shape> concat_view_shapes;
+};
+
+// an input padded to a shape bucket, with its shape before padding
+struct shape_bucket_input
+{
+    int blob_index;
+    int w;
+    int h;
+};
+
+// an output cropped back to the unpadded shape of an input, registered with set_shape_bucket_output
+struct shape_bucket_output
+{
+    int blob_index;
+    int input_blob_index;
+    int stride_w;
+    int stride_h;
+};
+
 class NetPrivate
 {
 public:
@@ -56,9 +120,9 @@ public:
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, std::vector<VkImageMat>& blob_mats_gpu_image, VkCompute& cmd, const Option& opt) const;
 #endif // NCNN_VULKAN
 
-    int convert_layout(Mat& bottom_blob, const Layer* layer, const Option& opt) const;
+    int convert_layout(Mat& bottom_blob, int layout_flags, const Option& opt) const;
 
-    int do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats, const Option& opt) const;
+    int do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats, const Option& opt, int layout_flags = -1) const;
 #if NCNN_VULKAN
     int do_forward_layer(const Layer* layer, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const;
     int do_forward_layer(const Layer* layer, std::vector<VkImageMat>& blob_mats_gpu_image, VkCompute& cmd, const Option& opt) const;
@@ -69,6 +133,21 @@ public:
     void update_input_output_names();
 #endif // NCNN_STRING
 
+    bool is_builtin_layer_overwritten(int typeindex) const;
+    int get_fusable_consumer(int layer_index) const;
+    void fuse_layer_into(int layer_index, int fused_layer_index);
+    int fuse_layers();
+
+    bool is_tileable_layer(int layer_index) const;
+    void build_tile_chains();
+    int forward_tile_chain(int chain_index, std::vector<Mat>& blob_mats, const Option& opt) const;
+
+    int plan_split_packing();
+
+    void build_channel_views();
+    int forward_concat_view(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const;
+    int forward_slice_view(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const;
+
     std::vector<Blob> blobs;
     std::vector<Layer*> layers;
 
@@ -82,9 +161,91 @@ public:
     std::vector<custom_layer_registry_entry> custom_layer_registry;
     std::vector<overwrite_builtin_layer_registry_entry> overwrite_builtin_layer_registry;
 
+    // depth-first tiling
+    // layer indexes of each chain and the chain ended by each layer, -1 for none
+    std::vector<std::vector<int> > tile_chains;
+    std::vector<int> tile_chain_of_tail;
+
+    // load-time packing of the Split outputs, see Net::set_split_output_packing
+    bool use_split_output_packing;
+    // the layout flags each layer converts its inputs to, -1 for the flags of the layer itself
+    std::vector<int> split_packing_plan;
+    // the repacks removed by the plan
+    int split_packing_removed_repacks;
+
+    // zero-copy concat and slice along channels
+    // 1 for each Concat whose producers may write into the channel ranges of its output
+    // and each Slice whose outputs may be channel ranges of its input
+    std::vector<int> channel_view_layers;
+    // 1 for each concat bottom whose producer may write into a channel range of the concat output
+    std::vector<int> channel_view_blobs;
+    // the output shape of each Concat in the last forward, the next forward allocates it up front
+    mutable std::vector<concat_view_shape> concat_view_shapes;
+    mutable Mutex concat_view_lock;
+
+    // the concat plans of the bucket whose blob pool is the allocator, the shared ones otherwise
+    std::vector<concat_view_shape>& get_concat_view_shapes(const Allocator* blob_allocator) const;
+
+    // shape buckets, made on the first input padded to each bucket, see Net::set_shape_bucket
+    int shape_bucket_w;
+    int shape_bucket_h;
+    float shape_bucket_pad_value;
+    shape_bucket* get_shape_bucket(int w, int h) const;
+    mutable std::vector<shape_bucket*> shape_buckets;
+    mutable Mutex shape_bucket_lock;
+    std::vector<shape_bucket_output> shape_bucket_outputs;
+
+    // transformed weight cache and shared weight store, see Net::set_shared_weight_store
+    bool use_shared_weight_store;
+    // the weight checksum of each layer computed in load_model
+    std::vector<unsigned int> weight_checksums;
+    // the 64bit weight and param hashes of each layer for the shared weight store
+    std::vector<uint64_t> weight_hashes;
+    std::vector<uint64_t> param_hashes;
+    // the cache key and entries loaded before load_model
+    std::vector<int> weight_cache_key;
+    mutable std::vector<weight_cache_entry> weight_cache;
+
+    int create_layer_pipeline(int layer_index, bool use_weight_cache) const;
+
+    // lazy pipeline creation
+    // 1 for each layer whose create_pipeline is deferred to the first forward
+    int ensure_layer_pipeline(int layer_index) const;
+    int ensure_all_pipelines() const;
+    mutable std::vector<int> pipeline_pending;
+    mutable Mutex pipeline_lock;
+    bool lazy_use_weight_cache;
+
+    // the transformed weights copied onto huge pages, see Net::set_huge_page_weights
+    bool use_huge_page_weights;
+    mutable std::vector<void*> huge_page_weights;
+
+    // memory accounting
+    // the weight bytes each layer loads and holds after create_pipeline
+    std::vector<size_t> layer_weight_bytes;
+    mutable std::vector<size_t> layer_pipeline_weight_bytes;
+    // the loaded weights referenced until the pipeline of their layer is created
+    mutable std::vector<std::vector<Mat> > loaded_weights;
+
+    // the local pool allocator of the net, 0 for others
+    PoolAllocator* find_local_pool_allocator(const Allocator* allocator) const;
+
     PoolAllocator* local_blob_allocator;
     PoolAllocator* local_workspace_allocator;
 
+    // the extractors handed out by acquire_extractor and the idle ones among them
+    mutable std::vector<Extractor*> pooled_extractors;
+    mutable std::vector<Extractor*> idle_extractors;
+    mutable Mutex extractor_pool_lock;
+
+    // the transformed weights spread over the numa nodes, see Net::set_numa_interleaved_weights
+    bool use_numa_interleaved_weights;
+
+    // local pool allocators of each numa node for extractors bound to a node
+    // the pooled memory is first touched and then reused by the threads of that node
+    std::vector<PoolAllocator*> numa_blob_allocators;
+    std::vector<PoolAllocator*> numa_workspace_allocators;
+
 #if NCNN_VULKAN
     const VulkanDevice* vkdev;
 
@@ -98,6 +259,18 @@ public:
 NetPrivate::NetPrivate(Option& _opt)
     : opt(_opt)
 {
+    use_split_output_packing = false;
+    split_packing_removed_repacks = 0;
+
+    shape_bucket_w = 0;
+    shape_bucket_h = 0;
+    shape_bucket_pad_value = 0.f;
+
+    use_shared_weight_store = false;
+    lazy_use_weight_cache = false;
+    use_huge_page_weights = false;
+    use_numa_interleaved_weights = false;
+
     local_blob_allocator = 0;
     local_workspace_allocator = 0;
 
@@ -109,6 +282,82 @@ NetPrivate::NetPrivate(Option& _opt)
 #endif // NCNN_VULKAN
 }
 
+PoolAllocator* NetPrivate::find_local_pool_allocator(const Allocator* allocator) const
+{
+    if (!allocator)
+        return 0;
+
+    if (allocator == local_blob_allocator)
+        return local_blob_allocator;
+
+    if (allocator == local_workspace_allocator)
+        return local_workspace_allocator;
+
+    for (size_t i = 0; i < numa_blob_allocators.size(); i++)
+    {
+        if (allocator == numa_blob_allocators[i])
+            return numa_blob_allocators[i];
+
+        if (allocator == numa_workspace_allocators[i])
+            return numa_workspace_allocators[i];
+    }
+
+    MutexLockGuard lock(shape_bucket_lock);
+
+    for (size_t i = 0; i < shape_buckets.size(); i++)
+    {
+        if (allocator == shape_buckets[i]->blob_allocator)
+            return shape_buckets[i]->blob_allocator;
+
+        if (allocator == shape_buckets[i]->workspace_allocator)
+            return shape_buckets[i]->workspace_allocator;
+    }
+
+    return 0;
+}
+
+std::vector<concat_view_shape>& NetPrivate::get_concat_view_shapes(const Allocator* blob_allocator) const
+{
+    if (blob_allocator)
+    {
+        MutexLockGuard lock(shape_bucket_lock);
+
+        for (size_t i = 0; i < shape_buckets.size(); i++)
+        {
+            if (blob_allocator == shape_buckets[i]->blob_allocator)
+                return shape_buckets[i]->concat_view_shapes;
+        }
+    }
+
+    return concat_view_shapes;
+}
+
+shape_bucket* NetPrivate::get_shape_bucket(int w, int h) const
+{
+    MutexLockGuard lock(shape_bucket_lock);
+
+    for (size_t i = 0; i < shape_buckets.size(); i++)
+    {
+        if (shape_buckets[i]->w == w && shape_buckets[i]->h == h)
+            return shape_buckets[i];
+    }
+
+    shape_bucket* bucket = new shape_bucket;
+    bucket->w = w;
+    bucket->h = h;
+    bucket->blob_allocator = new PoolAllocator;
+    bucket->blob_allocator->set_size_compare_ratio(0.f);
+    bucket->workspace_allocator = new PoolAllocator;
+    bucket->workspace_allocator->set_size_compare_ratio(0.f);
+
+    concat_view_shape empty_shape = {0, 0, 0, 0, 0u, 0, std::vector<int>()};
+    bucket->concat_view_shapes.resize(concat_view_shapes.size(), empty_shape);
+
+    shape_buckets.push_back(bucket);
+
+    return bucket;
+}
+
 static Option get_masked_option(const Option& opt, int featmask)
 {
     // mask option usage as layer specific featmask
@@ -170,6 +419,17 @@ int NetPrivate::upload_model()
 
 int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
 {
+    if (opt.use_depth_first_tiling && !tile_chain_of_tail.empty() && tile_chain_of_tail[layer_index] != -1)
+    {
+        return forward_tile_chain(tile_chain_of_tail[layer_index], blob_mats, opt);
+    }
+
+    if (opt.lightmode && !channel_view_layers.empty() && channel_view_layers[layer_index])
+    {
+        if (layers[layer_index]->typeindex == LayerType::Concat)
+            return forward_concat_view(layer_index, blob_mats, opt);
+    }
+
     const Layer* layer = layers[layer_index];
 
     //     NCNN_LOGE("forward_layer %d %s", layer_index, layer->name.c_str());
@@ -187,6 +447,13 @@ int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, cons
         }
     }
 
+    if (!pipeline_pending.empty())
+    {
+        int ret = ensure_layer_pipeline(layer_index);
+        if (ret != 0)
+            return ret;
+    }
+
 #if NCNN_BENCHMARK
     double start = get_current_time();
     Mat bottom_blob;
@@ -201,14 +468,24 @@ int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, cons
         bottom_blob.elemsize = blob_mats[bottom_blob_index].elemsize;
     }
 #endif
+    if (opt.lightmode && !channel_view_layers.empty() && channel_view_layers[layer_index])
+    {
+        // falls through to the regular slice when the outputs can not be views
+        int ret = forward_slice_view(layer_index, blob_mats, opt);
+        if (ret != 1)
+            return ret;
+    }
+
+    const int layout_flags = split_packing_plan.empty() ? -1 : split_packing_plan[layer_index];
+
     int ret = 0;
     if (layer->featmask)
     {
-        ret = do_forward_layer(layer, blob_mats, get_masked_option(opt, layer->featmask));
+        ret = do_forward_layer(layer, blob_mats, get_masked_option(opt, layer->featmask), layout_flags);
     }
     else
     {
-        ret = do_forward_layer(layer, blob_mats, opt);
+        ret = do_forward_layer(layer, blob_mats, opt, layout_flags);
     }
 #if NCNN_BENCHMARK
     double end = get_current_time();
@@ -605,20 +882,123 @@ IMAGE_ALLOCATION_FAILED:
 }
 #endif // NCNN_VULKAN
 
-int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Option& opt) const
+// the input layout a layer accepts
+enum
+{
+    LAYOUT_PACKING = 1 << 0,
+    LAYOUT_FP16_STORAGE = 1 << 1,
+    LAYOUT_BF16_STORAGE = 1 << 2
+};
+
+static int get_layer_layout_flags(const Layer* layer)
+{
+    int layout_flags = 0;
+    if (layer->support_packing) layout_flags |= LAYOUT_PACKING;
+    if (layer->support_fp16_storage) layout_flags |= LAYOUT_FP16_STORAGE;
+    if (layer->support_bf16_storage) layout_flags |= LAYOUT_BF16_STORAGE;
+    return layout_flags;
+}
+
+// the elempack convert_layout packs elemcount elements of elembits to
+static int resolve_dst_elempack(int elemcount, int elembits, bool support_packing, const Option& opt)
+{
+    int dst_elempack = 1;
+    if (opt.use_packing_layout)
+    {
+        if (support_packing)
+        {
+            if (elembits == 32)
+            {
+#if NCNN_AVX512
+                if (elemcount % 16 == 0 && ncnn::cpu_support_x86_avx512())
+                    dst_elempack = 16;
+                else if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_AVX
+                if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_RVV
+                const int packn = ncnn::cpu_riscv_vlenb() / 4;
+                if (elemcount % packn == 0)
+                    dst_elempack = packn;
+#else
+                if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#endif
+            }
+            if (elembits == 16)
+            {
+#if NCNN_ARM82
+                if (elemcount % 8 == 0 && ncnn::cpu_support_arm_asimdhp() && opt.use_fp16_arithmetic)
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_AVX512
+                // 16bit storage is widened to fp32 lanes for arithmetic on x86
+                if (elemcount % 16 == 0 && ncnn::cpu_support_x86_avx512())
+                    dst_elempack = 16;
+                else if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_AVX
+                // 16bit storage is widened to fp32 lanes for arithmetic on x86
+                if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
+                    dst_elempack = 8;
+                else if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#elif NCNN_RVV
+                const int packn = ncnn::cpu_riscv_vlenb() / 2;
+                if (elemcount % packn == 0)
+                    dst_elempack = packn;
+#else
+                if (elemcount % 4 == 0)
+                    dst_elempack = 4;
+#endif
+            }
+            if (elembits == 8)
+            {
+#if NCNN_RVV
+                const int packn = ncnn::cpu_riscv_vlenb() / 1;
+                if (elemcount % packn == 0)
+                    dst_elempack = packn;
+#else
+                if (elemcount % 8 == 0)
+                    dst_elempack = 8;
+#endif
+            }
+        }
+    }
+
+    return dst_elempack;
+}
+
+int NetPrivate::convert_layout(Mat& bottom_blob, int layout_flags, const Option& opt) const
 {
+    const bool support_packing = layout_flags & LAYOUT_PACKING;
+#if NCNN_ARM82 || NCNN_RVV
+    const bool support_fp16_storage = layout_flags & LAYOUT_FP16_STORAGE;
+#endif
+#if NCNN_BF16
+    const bool support_bf16_storage = layout_flags & LAYOUT_BF16_STORAGE;
+#endif
+
     // clang-format off
     // *INDENT-OFF*
 #if NCNN_ARM82
     if (opt.use_fp16_storage && cpu_support_arm_asimdhp())
     {
-        if (bottom_blob.elembits() == 32 && layer->support_fp16_storage)
+        if (bottom_blob.elembits() == 32 && support_fp16_storage)
         {
             Mat bottom_blob_fp16;
             cast_float32_to_float16(bottom_blob, bottom_blob_fp16, opt);
             bottom_blob = bottom_blob_fp16;
         }
-        if (bottom_blob.elembits() == 16 && !layer->support_fp16_storage)
+        if (bottom_blob.elembits() == 16 && !support_fp16_storage)
         {
             Mat bottom_blob_fp32;
             cast_float16_to_float32(bottom_blob, bottom_blob_fp32, opt);
@@ -630,13 +1010,13 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
 #if NCNN_RVV
     if (opt.use_fp16_storage && cpu_support_riscv_v() && cpu_support_riscv_zfh())
     {
-        if (bottom_blob.elembits() == 32 && layer->support_fp16_storage)
+        if (bottom_blob.elembits() == 32 && support_fp16_storage)
         {
             Mat bottom_blob_fp16;
             cast_float32_to_float16(bottom_blob, bottom_blob_fp16, opt);
             bottom_blob = bottom_blob_fp16;
         }
-        if (bottom_blob.elembits() == 16 && !layer->support_fp16_storage)
+        if (bottom_blob.elembits() == 16 && !support_fp16_storage)
         {
             Mat bottom_blob_fp32;
             cast_float16_to_float32(bottom_blob, bottom_blob_fp32, opt);
@@ -648,13 +1028,13 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
 #if NCNN_BF16
     if (opt.use_bf16_storage)
     {
-        if (bottom_blob.elembits() == 32 && layer->support_bf16_storage)
+        if (bottom_blob.elembits() == 32 && support_bf16_storage)
         {
             Mat bottom_blob_bf16;
             cast_float32_to_bfloat16(bottom_blob, bottom_blob_bf16, opt);
             bottom_blob = bottom_blob_bf16;
         }
-        if (bottom_blob.elembits() == 16 && !layer->support_bf16_storage)
+        if (bottom_blob.elembits() == 16 && !support_bf16_storage)
         {
             Mat bottom_blob_fp32;
             cast_bfloat16_to_float32(bottom_blob, bottom_blob_fp32, opt);
@@ -679,61 +1059,7 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
         if (dims == 2) elemcount = bottom_blob.elempack * bottom_blob.h;
         if (dims == 3 || dims == 4) elemcount = bottom_blob.elempack * bottom_blob.c;
 
-        int elembits = bottom_blob.elembits();
-
-        if (layer->support_packing)
-        {
-            if (elembits == 32)
-            {
-#if NCNN_AVX512
-                if (elemcount % 16 == 0 && ncnn::cpu_support_x86_avx512())
-                    dst_elempack = 16;
-                else if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
-                    dst_elempack = 8;
-                else if (elemcount % 4 == 0)
-                    dst_elempack = 4;
-#elif NCNN_AVX
-                if (elemcount % 8 == 0 && ncnn::cpu_support_x86_avx())
-                    dst_elempack = 8;
-                else if (elemcount % 4 == 0)
-                    dst_elempack = 4;
-#elif NCNN_RVV
-                const int packn = ncnn::cpu_riscv_vlenb() / 4;
-                if (elemcount % packn == 0)
-                    dst_elempack = packn;
-#else
-                if (elemcount % 4 == 0)
-                    dst_elempack = 4;
-#endif
-            }
-            if (elembits == 16)
-            {
-#if NCNN_ARM82
-                if (elemcount % 8 == 0 && ncnn::cpu_support_arm_asimdhp() && opt.use_fp16_arithmetic)
-                    dst_elempack = 8;
-                else if (elemcount % 4 == 0)
-                    dst_elempack = 4;
-#elif NCNN_RVV
-                const int packn = ncnn::cpu_riscv_vlenb() / 2;
-                if (elemcount % packn == 0)
-                    dst_elempack = packn;
-#else
-                if (elemcount % 4 == 0)
-                    dst_elempack = 4;
-#endif
-            }
-            if (elembits == 8)
-            {
-#if NCNN_RVV
-                const int packn = ncnn::cpu_riscv_vlenb() / 1;
-                if (elemcount % packn == 0)
-                    dst_elempack = packn;
-#else
-                if (elemcount % 8 == 0)
-                    dst_elempack = 8;
-#endif
-            }
-        }
+        dst_elempack = resolve_dst_elempack(elemcount, bottom_blob.elembits(), support_packing, opt);
     }
 
     if (bottom_blob.elempack != dst_elempack)
@@ -746,8 +1072,11 @@ int NetPrivate::convert_layout(Mat& bottom_blob, const Layer* layer, const Optio
     return 0;
 }
 
-int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats, const Option& opt) const
+int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats, const Option& opt, int layout_flags) const
 {
+    if (layout_flags == -1)
+        layout_flags = get_layer_layout_flags(layer);
+
     if (layer->one_blob_only)
     {
         int bottom_blob_index = layer->bottoms[0];
@@ -759,7 +1088,7 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
         if (opt.lightmode)
         {
             // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+            if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
             {
                 bottom_blob = bottom_blob_ref.clone(opt.blob_allocator);
             }
@@ -769,7 +1098,7 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
             bottom_blob = bottom_blob_ref;
         }
 
-        convert_layout(bottom_blob, layer, opt);
+        convert_layout(bottom_blob, layout_flags, opt);
 
         // forward
         if (opt.lightmode && layer->support_inplace)
@@ -784,7 +1113,12 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
         }
         else
         {
+            // a channel range of the consumer concat output if one is preallocated
             Mat top_blob;
+            if (!channel_view_blobs.empty() && channel_view_blobs[top_blob_index])
+            {
+                top_blob = blob_mats[top_blob_index];
+            }
             int ret = layer->forward(bottom_blob, top_blob, opt);
             if (ret != 0)
                 return ret;
@@ -812,7 +1146,7 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
             if (opt.lightmode)
             {
                 // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blob_ref.refcount != 1)
+                if (layer->support_inplace && (!bottom_blob_ref.refcount || *bottom_blob_ref.refcount != 1))
                 {
                     bottom_blobs[i] = bottom_blob_ref.clone(opt.blob_allocator);
                 }
@@ -822,7 +1156,7 @@ int NetPrivate::do_forward_layer(const Layer* layer, std::vector<Mat>& blob_mats
                 bottom_blobs[i] = bottom_blob_ref;
             }
 
-            convert_layout(bottom_blobs[i], layer, opt);
+            convert_layout(bottom_blobs[i], layout_flags, opt);
         }
 
         // forward
@@ -1168,43 +1502,1659 @@ void NetPrivate::update_input_output_names()
 }
 #endif // NCNN_STRING
 
-Net::Net()
-    : d(new NetPrivate(opt))
+bool NetPrivate::is_builtin_layer_overwritten(int typeindex) const
 {
+    for (size_t i = 0; i < overwrite_builtin_layer_registry.size(); i++)
+    {
+        if (overwrite_builtin_layer_registry[i].typeindex == typeindex)
+            return true;
+    }
+
+    return false;
 }
 
-Net::~Net()
+void NetPrivate::fuse_layer_into(int layer_index, int fused_layer_index)
 {
-    clear();
+    Layer* layer = layers[layer_index];
+    Layer* fused_layer = layers[fused_layer_index];
 
-    delete d;
-}
+    // the intermediate blob is orphaned
+    int top_blob_index = layer->tops[0];
+    blobs[top_blob_index].producer = -1;
+    blobs[top_blob_index].consumer = -1;
 
-Net::Net(const Net&)
-    : d(0)
-{
+    int top_blob_index_final = fused_layer->tops[0];
+    layer->tops[0] = top_blob_index_final;
+    blobs[top_blob_index_final].producer = layer_index;
+
+    // the other inputs of the fused layer become trailing inputs
+    for (size_t i = 0; i < fused_layer->bottoms.size(); i++)
+    {
+        int bottom_blob_index = fused_layer->bottoms[i];
+        if (bottom_blob_index == top_blob_index)
+            continue;
+
+        layer->bottoms.push_back(bottom_blob_index);
+        blobs[bottom_blob_index].consumer = layer_index;
+    }
+
+    // the fused layer stays in place but is never reached
+    fused_layer->bottoms.clear();
+    fused_layer->tops.clear();
 }
 
-Net& Net::operator=(const Net&)
+int NetPrivate::get_fusable_consumer(int layer_index) const
 {
-    return *this;
+    // the single consumer of the only top blob
+    const Layer* layer = layers[layer_index];
+    if (layer->tops.size() != 1)
+        return -1;
+
+    int consumer = blobs[layer->tops[0]].consumer;
+    if (consumer == -1)
+        return -1;
+
+    const Layer* consumer_layer = layers[consumer];
+    if (consumer_layer->tops.size() != 1 || consumer_layer->featmask != layer->featmask)
+        return -1;
+
+    if ((consumer_layer->typeindex & LayerType::CustomBit) || is_builtin_layer_overwritten(consumer_layer->typeindex))
+        return -1;
+
+    return consumer;
 }
 
-#if NCNN_STRING
-int Net::register_custom_layer(const char* type, layer_creator_func creator, layer_destroyer_func destroyer, void* userdata)
+static int get_fused_activation_type(const Layer* layer, Mat& activation_params)
 {
-    int typeindex = layer_to_index(type);
-    if (typeindex != -1)
+    if (layer->typeindex == LayerType::ReLU)
     {
-        NCNN_LOGE("overwrite built-in layer type %s", type);
+        const ReLU* relu = (const ReLU*)layer;
+        if (relu->slope == 0.f)
+            return 1;
 
-        for (size_t i = 0; i < d->overwrite_builtin_layer_registry.size(); i++)
-        {
-            if (d->overwrite_builtin_layer_registry[i].typeindex == typeindex)
-            {
-                NCNN_LOGE("overwrite existing overwritten built-in layer index %d", typeindex);
+        activation_params = Mat(1);
+        activation_params[0] = relu->slope;
+        return 2;
+    }
 
-                d->overwrite_builtin_layer_registry[i].creator = creator;
+    if (layer->typeindex == LayerType::Clip)
+    {
+        const Clip* clip = (const Clip*)layer;
+        activation_params = Mat(2);
+        activation_params[0] = clip->min;
+        activation_params[1] = clip->max;
+        return 3;
+    }
+
+    if (layer->typeindex == LayerType::Sigmoid)
+        return 4;
+
+    if (layer->typeindex == LayerType::Mish)
+        return 5;
+
+    if (layer->typeindex == LayerType::HardSwish)
+    {
+        const HardSwish* hardswish = (const HardSwish*)layer;
+        activation_params = Mat(2);
+        activation_params[0] = hardswish->alpha;
+        activation_params[1] = hardswish->beta;
+        return 6;
+    }
+
+    return 0;
+}
+
+template<typename T>
+static bool fuse_activation(Layer* layer, int activation_type, const Mat& activation_params)
+{
+    T* op = (T*)layer;
+    if (op->activation_type != 0)
+        return false;
+
+    op->activation_type = activation_type;
+    op->activation_params = activation_params;
+    return true;
+}
+
+static bool is_residual_add(const Layer* layer)
+{
+    if (layer->bottoms.size() != 2 || layer->bottoms[0] == layer->bottoms[1])
+        return false;
+
+    if (layer->typeindex == LayerType::BinaryOp)
+    {
+        const BinaryOp* binaryop = (const BinaryOp*)layer;
+        return binaryop->op_type == BinaryOp::Operation_ADD && binaryop->with_scalar == 0;
+    }
+
+    if (layer->typeindex == LayerType::Eltwise)
+    {
+        const Eltwise* eltwise = (const Eltwise*)layer;
+        if (eltwise->op_type != Eltwise::Operation_SUM)
+            return false;
+
+        return eltwise->coeffs.w == 0 || (eltwise->coeffs[0] == 1.f && eltwise->coeffs[1] == 1.f);
+    }
+
+    return false;
+}
+
+int NetPrivate::fuse_layers()
+{
+    const int layer_count = (int)layers.size();
+
+    int fused_count = 0;
+
+    // inner product / convolution - activation
+    for (int i = 0; i < layer_count; i++)
+    {
+        Layer* layer = layers[i];
+
+        const int typeindex = layer->typeindex;
+        if (typeindex != LayerType::Convolution && typeindex != LayerType::ConvolutionDepthWise && typeindex != LayerType::Deconvolution && typeindex != LayerType::DeconvolutionDepthWise && typeindex != LayerType::InnerProduct)
+            continue;
+
+        if (is_builtin_layer_overwritten(typeindex))
+            continue;
+
+        int j = get_fusable_consumer(i);
+        if (j == -1 || layers[j]->bottoms.size() != 1)
+            continue;
+
+        Mat activation_params;
+        int activation_type = get_fused_activation_type(layers[j], activation_params);
+        if (activation_type == 0)
+            continue;
+
+        // deconvolution kernels only fuse relu clip and sigmoid
+        if ((typeindex == LayerType::Deconvolution || typeindex == LayerType::DeconvolutionDepthWise) && activation_type > 4)
+            continue;
+
+        bool fused = false;
+        if (typeindex == LayerType::Convolution) fused = fuse_activation<Convolution>(layer, activation_type, activation_params);
+        if (typeindex == LayerType::ConvolutionDepthWise) fused = fuse_activation<ConvolutionDepthWise>(layer, activation_type, activation_params);
+        if (typeindex == LayerType::Deconvolution) fused = fuse_activation<Deconvolution>(layer, activation_type, activation_params);
+        if (typeindex == LayerType::DeconvolutionDepthWise) fused = fuse_activation<DeconvolutionDepthWise>(layer, activation_type, activation_params);
+        if (typeindex == LayerType::InnerProduct) fused = fuse_activation<InnerProduct>(layer, activation_type, activation_params);
+        if (!fused)
+            continue;
+
+        fuse_layer_into(i, j);
+        fused_count++;
+    }
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    // the residual add epilogue is only implemented in the x86 cpu kernels
+    if (!opt.use_vulkan_compute)
+    {
+        // convolution - residual add - activation
+        for (int i = 0; i < layer_count; i++)
+        {
+            if (layers[i]->typeindex != LayerType::Convolution || is_builtin_layer_overwritten(LayerType::Convolution))
+                continue;
+
+            Convolution* convolution = (Convolution*)layers[i];
+            if (convolution->bottoms.size() != 1 || convolution->activation_type != 0 || convolution->dynamic_weight || convolution->int8_scale_term || convolution->fuse_residual)
+                continue;
+
+            int j = get_fusable_consumer(i);
+            if (j == -1 || !is_residual_add(layers[j]))
+                continue;
+
+            // constant addend is a broadcasting bias rather than a residual
+            int residual_blob_index = layers[j]->bottoms[0] == convolution->tops[0] ? layers[j]->bottoms[1] : layers[j]->bottoms[0];
+            int residual_producer = blobs[residual_blob_index].producer;
+            if (residual_producer == -1 || layers[residual_producer]->typeindex == LayerType::MemoryData)
+                continue;
+
+            convolution->one_blob_only = false;
+            convolution->fuse_residual = 1;
+            fuse_layer_into(i, j);
+            fused_count++;
+
+            int k = get_fusable_consumer(i);
+            if (k == -1 || layers[k]->bottoms.size() != 1)
+                continue;
+
+            Mat activation_params;
+            int activation_type = get_fused_activation_type(layers[k], activation_params);
+            if (activation_type == 0)
+                continue;
+
+            convolution->residual_activation_type = activation_type;
+            convolution->residual_activation_params = activation_params;
+            fuse_layer_into(i, k);
+            fused_count++;
+        }
+
+        // gemm - residual add, the addend is taken as C
+        for (int i = 0; i < layer_count; i++)
+        {
+            if (layers[i]->typeindex != LayerType::Gemm || is_builtin_layer_overwritten(LayerType::Gemm))
+                continue;
+
+            Gemm* gemm = (Gemm*)layers[i];
+            if (gemm->constantC || gemm->alpha != 1.f || gemm->output_N1M || gemm->output_transpose || gemm->fuse_residual)
+                continue;
+
+            // no C input yet
+            const int input_count = (gemm->constantA ? 0 : 1) + (gemm->constantB ? 0 : 1);
+            if (input_count == 0 || (int)gemm->bottoms.size() != input_count)
+                continue;
+
+            int j = get_fusable_consumer(i);
+            if (j == -1 || !is_residual_add(layers[j]))
+                continue;
+
+            gemm->one_blob_only = false;
+            gemm->beta = 1.f;
+            gemm->fuse_residual = 1;
+            fuse_layer_into(i, j);
+            fused_count++;
+        }
+
+        // inner product / gemm - swish / gelu, the x86 kernels apply them to each output tile
+        for (int i = 0; i < layer_count; i++)
+        {
+            const int typeindex = layers[i]->typeindex;
+            if ((typeindex != LayerType::InnerProduct && typeindex != LayerType::Gemm) || is_builtin_layer_overwritten(typeindex))
+                continue;
+
+            int j = get_fusable_consumer(i);
+            if (j == -1 || layers[j]->bottoms.size() != 1)
+                continue;
+
+            int activation_type = 0;
+            Mat activation_params;
+            if (layers[j]->typeindex == LayerType::Swish)
+            {
+                activation_type = 7;
+            }
+            if (layers[j]->typeindex == LayerType::GELU)
+            {
+                activation_type = 8;
+                activation_params = Mat(1);
+                activation_params[0] = (float)((const GELU*)layers[j])->fast_gelu;
+            }
+            if (activation_type == 0)
+                continue;
+
+            bool fused = false;
+            if (typeindex == LayerType::InnerProduct)
+            {
+                fused = fuse_activation<InnerProduct>(layers[i], activation_type, activation_params);
+            }
+            if (typeindex == LayerType::Gemm)
+            {
+                // the output is activated by row tiles, the residual fallback runs outside the tiles
+                const Gemm* gemm = (const Gemm*)layers[i];
+                if (!gemm->output_transpose && !gemm->fuse_residual)
+                    fused = fuse_activation<Gemm>(layers[i], activation_type, activation_params);
+            }
+            if (!fused)
+                continue;
+
+            fuse_layer_into(i, j);
+            fused_count++;
+        }
+    }
+#endif // defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+
+    return fused_count;
+}
+
+// window of a layer running on row bands, elementwise layers are 1x1 stride 1 without padding
+struct tile_window
+{
+    int num_output; // 0 = same as input
+    int kernel_extent_w;
+    int kernel_extent_h;
+    int stride_w;
+    int stride_h;
+    int pad_left;
+    int pad_right;
+    int pad_top;
+    int pad_bottom;
+};
+
+template<typename T>
+static bool get_convolution_tile_window(const Layer* layer, tile_window& tw)
+{
+    const T* op = (const T*)layer;
+
+    // same padding depends on the input height
+    if (op->pad_left < 0 || op->pad_right < 0 || op->pad_top < 0 || op->pad_bottom < 0)
+        return false;
+
+    tw.num_output = op->num_output;
+    tw.kernel_extent_w = op->dilation_w * (op->kernel_w - 1) + 1;
+    tw.kernel_extent_h = op->dilation_h * (op->kernel_h - 1) + 1;
+    tw.stride_w = op->stride_w;
+    tw.stride_h = op->stride_h;
+    tw.pad_left = op->pad_left;
+    tw.pad_right = op->pad_right;
+    tw.pad_top = op->pad_top;
+    tw.pad_bottom = op->pad_bottom;
+    return true;
+}
+
+static bool get_layer_tile_window(const Layer* layer, tile_window& tw)
+{
+    const int typeindex = layer->typeindex;
+
+    if (typeindex == LayerType::Convolution)
+        return get_convolution_tile_window<Convolution>(layer, tw);
+
+    if (typeindex == LayerType::ConvolutionDepthWise)
+        return get_convolution_tile_window<ConvolutionDepthWise>(layer, tw);
+
+    // elementwise or per-channel
+    if (typeindex == LayerType::AbsVal || typeindex == LayerType::BatchNorm || typeindex == LayerType::Bias
+            || typeindex == LayerType::BNLL || typeindex == LayerType::Clip || typeindex == LayerType::Dropout
+            || typeindex == LayerType::ELU || typeindex == LayerType::Exp || typeindex == LayerType::GELU
+            || typeindex == LayerType::HardSigmoid || typeindex == LayerType::HardSwish || typeindex == LayerType::Log
+            || typeindex == LayerType::Mish || typeindex == LayerType::Power || typeindex == LayerType::PReLU
+            || typeindex == LayerType::ReLU || typeindex == LayerType::SELU || typeindex == LayerType::Sigmoid
+            || typeindex == LayerType::Swish || typeindex == LayerType::TanH || typeindex == LayerType::Threshold
+            || typeindex == LayerType::UnaryOp)
+    {
+        tw.num_output = 0;
+        tw.kernel_extent_w = 1;
+        tw.kernel_extent_h = 1;
+        tw.stride_w = 1;
+        tw.stride_h = 1;
+        tw.pad_left = 0;
+        tw.pad_right = 0;
+        tw.pad_top = 0;
+        tw.pad_bottom = 0;
+        return true;
+    }
+
+    return false;
+}
+
+bool NetPrivate::is_tileable_layer(int layer_index) const
+{
+    const Layer* layer = layers[layer_index];
+    if (!layer->one_blob_only || layer->bottoms.size() != 1 || layer->tops.size() != 1)
+        return false;
+
+    if ((layer->typeindex & LayerType::CustomBit) || is_builtin_layer_overwritten(layer->typeindex))
+        return false;
+
+    tile_window tw;
+    return get_layer_tile_window(layer, tw);
+}
+
+void NetPrivate::build_tile_chains()
+{
+    const int layer_count = (int)layers.size();
+
+    tile_chains.clear();
+    tile_chain_of_tail.clear();
+    tile_chain_of_tail.resize(layer_count, -1);
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (!is_tileable_layer(i))
+            continue;
+
+        // chain starts where the input is not produced by a tileable layer
+        int producer = blobs[layers[i]->bottoms[0]].producer;
+        if (producer != -1 && is_tileable_layer(producer))
+            continue;
+
+        std::vector<int> chain(1, i);
+        for (;;)
+        {
+            int consumer = blobs[layers[chain.back()]->tops[0]].consumer;
+            if (consumer == -1 || !is_tileable_layer(consumer))
+                break;
+
+            chain.push_back(consumer);
+        }
+
+        // elementwise only chains gain nothing over inplace forward
+        bool has_spatial_window = false;
+        for (size_t j = 0; j < chain.size(); j++)
+        {
+            const int typeindex = layers[chain[j]]->typeindex;
+            if (typeindex == LayerType::Convolution || typeindex == LayerType::ConvolutionDepthWise)
+                has_spatial_window = true;
+        }
+
+        if (chain.size() < 2 || !has_spatial_window)
+            continue;
+
+        tile_chain_of_tail[chain.back()] = (int)tile_chains.size();
+        tile_chains.push_back(chain);
+    }
+}
+
+static void copy_rows(const Mat& src, int y, int rows, Mat& dst, int dsty)
+{
+    const size_t row_size = (size_t)src.w * src.elemsize;
+
+    for (int q = 0; q < src.c; q++)
+    {
+        const unsigned char* ptr = (const unsigned char*)src.data + src.cstep * q * src.elemsize + row_size * y;
+        unsigned char* outptr = (unsigned char*)dst.data + dst.cstep * q * dst.elemsize + row_size * dsty;
+
+        memcpy(outptr, ptr, row_size * rows);
+    }
+}
+
+int NetPrivate::forward_tile_chain(int chain_index, std::vector<Mat>& blob_mats, const Option& opt) const
+{
+    const std::vector<int>& chain = tile_chains[chain_index];
+    const int chain_size = (int)chain.size();
+
+    const int bottom_blob_index = layers[chain[0]]->bottoms[0];
+    const int top_blob_index = layers[chain[chain_size - 1]]->tops[0];
+
+    if (!pipeline_pending.empty())
+    {
+        for (int i = 0; i < chain_size; i++)
+        {
+            int ret = ensure_layer_pipeline(chain[i]);
+            if (ret != 0)
+                return ret;
+        }
+    }
+
+    // some intermediate blob has been extracted before, continue from it
+    for (int i = chain_size - 2; i >= 0; i--)
+    {
+        if (blob_mats[layers[chain[i]]->tops[0]].dims == 0)
+            continue;
+
+        for (int j = i + 1; j < chain_size; j++)
+        {
+            const Layer* layer = layers[chain[j]];
+
+            int ret = do_forward_layer(layer, blob_mats, layer->featmask ? get_masked_option(opt, layer->featmask) : opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    if (blob_mats[bottom_blob_index].dims == 0)
+    {
+        int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    const Mat& bottom_blob = blob_mats[bottom_blob_index];
+
+    // output shape of each layer
+    std::vector<tile_window> windows(chain_size);
+    std::vector<int> outw(chain_size);
+    std::vector<int> outh(chain_size);
+    std::vector<int> outc(chain_size);
+
+    bool tileable = bottom_blob.dims == 3;
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int c = bottom_blob.c * bottom_blob.elempack;
+    for (int i = 0; i < chain_size && tileable; i++)
+    {
+        tile_window& tw = windows[i];
+        get_layer_tile_window(layers[chain[i]], tw);
+
+        if (w + tw.pad_left + tw.pad_right < tw.kernel_extent_w || h + tw.pad_top + tw.pad_bottom < tw.kernel_extent_h)
+        {
+            tileable = false;
+            break;
+        }
+
+        w = (w + tw.pad_left + tw.pad_right - tw.kernel_extent_w) / tw.stride_w + 1;
+        h = (h + tw.pad_top + tw.pad_bottom - tw.kernel_extent_h) / tw.stride_h + 1;
+        c = tw.num_output ? tw.num_output : c;
+
+        outw[i] = w;
+        outh[i] = h;
+        outc[i] = c;
+    }
+
+    // pick the band height so that all intermediate rows of one band fit in half of level2 cache
+    int band_h = 0;
+    if (tileable)
+    {
+        size_t band_row_size = 0;
+        int halo = 0;
+        int rows = 1;
+        for (int i = chain_size - 1; i >= 0; i--)
+        {
+            band_row_size += (size_t)rows * outw[i] * outc[i] * sizeof(float);
+            halo += windows[i].kernel_extent_h - 1;
+            rows *= windows[i].stride_h;
+        }
+        band_row_size += (size_t)rows * bottom_blob.w * bottom_blob.c * bottom_blob.elempack * sizeof(float);
+
+        int l2_cache_size = get_cpu_level2_cache_size();
+        if (l2_cache_size <= 0)
+            l2_cache_size = 256 * 1024;
+
+        band_h = (int)(l2_cache_size / 2 / band_row_size);
+
+        // too many halo rows recomputed in thin bands
+        if (band_h < halo * 2)
+            band_h = halo * 2;
+        if (band_h < 1)
+            band_h = 1;
+    }
+
+    const int tail_h = tileable ? outh[chain_size - 1] : 0;
+
+    if (!tileable || band_h >= tail_h)
+    {
+        // run the whole chain layer by layer
+        for (int i = 0; i < chain_size; i++)
+        {
+            const Layer* layer = layers[chain[i]];
+
+            int ret = do_forward_layer(layer, blob_mats, layer->featmask ? get_masked_option(opt, layer->featmask) : opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    // needed rows of the chain input and of each layer output for the current band
+    std::vector<int> band_y0(chain_size + 1);
+    std::vector<int> band_y1(chain_size + 1);
+
+    std::vector<Mat> band_mats(blobs.size());
+
+    Mat top_blob;
+
+    for (int y = 0; y < tail_h; y += band_h)
+    {
+        band_y0[chain_size] = y;
+        band_y1[chain_size] = y + band_h < tail_h ? y + band_h : tail_h;
+
+        for (int i = chain_size - 1; i >= 0; i--)
+        {
+            const tile_window& tw = windows[i];
+            const int h_in = i == 0 ? bottom_blob.h : outh[i - 1];
+
+            // align the band start to the stride so that band output rows map back to whole rows
+            int y0 = band_y0[i + 1] * tw.stride_h - tw.pad_top;
+            int y1 = (band_y1[i + 1] - 1) * tw.stride_h - tw.pad_top + tw.kernel_extent_h;
+            band_y0[i] = y0 > 0 ? y0 / tw.stride_h * tw.stride_h : 0;
+            band_y1[i] = y1 < h_in ? y1 : h_in;
+        }
+
+        Mat band;
+        band.create(bottom_blob.w, band_y1[0] - band_y0[0], bottom_blob.c, bottom_blob.elemsize, bottom_blob.elempack, opt.workspace_allocator);
+        if (band.empty())
+            return -100;
+
+        copy_rows(bottom_blob, band_y0[0], band.h, band, 0);
+
+        for (int i = 0; i < chain_size; i++)
+        {
+            const Layer* layer = layers[chain[i]];
+
+            // band intermediates come from workspace
+            Option opt1 = layer->featmask ? get_masked_option(opt, layer->featmask) : opt;
+            opt1.blob_allocator = opt.workspace_allocator;
+
+            band_mats[layer->bottoms[0]] = band;
+            band.release();
+
+            int ret = do_forward_layer(layer, band_mats, opt1);
+            if (ret != 0)
+                return ret;
+
+            Mat band_top = band_mats[layer->tops[0]];
+            band_mats[layer->bottoms[0]].release();
+            band_mats[layer->tops[0]].release();
+
+            // global row of the first band output row
+            const int band_top_y = band_y0[i] / windows[i].stride_h;
+            const int crop_top = band_y0[i + 1] - band_top_y;
+            const int rows = band_y1[i + 1] - band_y0[i + 1];
+
+            if (i + 1 < chain_size)
+            {
+                if (crop_top == 0 && rows == band_top.h)
+                {
+                    band = band_top;
+                    continue;
+                }
+
+                band.create(band_top.w, rows, band_top.c, band_top.elemsize, band_top.elempack, opt.workspace_allocator);
+                if (band.empty())
+                    return -100;
+
+                copy_rows(band_top, crop_top, rows, band, 0);
+            }
+            else
+            {
+                if (top_blob.empty())
+                {
+                    top_blob.create(band_top.w, tail_h, band_top.c, band_top.elemsize, band_top.elempack, opt.blob_allocator);
+                    if (top_blob.empty())
+                        return -100;
+                }
+
+                copy_rows(band_top, crop_top, rows, top_blob, band_y0[chain_size]);
+            }
+        }
+    }
+
+    blob_mats[top_blob_index] = top_blob;
+
+    if (opt.lightmode)
+    {
+        // delete after taken in light mode
+        blob_mats[bottom_blob_index].release();
+    }
+
+    return 0;
+}
+
+// which 16bit storage convert_layout casts to with this option, 0 for none
+static int get_storage16_flag(const Option& opt)
+{
+#if NCNN_ARM82
+    if (opt.use_fp16_storage && cpu_support_arm_asimdhp())
+        return LAYOUT_FP16_STORAGE;
+#endif
+#if NCNN_RVV
+    if (opt.use_fp16_storage && cpu_support_riscv_v() && cpu_support_riscv_zfh())
+        return LAYOUT_FP16_STORAGE;
+#endif
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+        return LAYOUT_BF16_STORAGE;
+#endif
+    return 0;
+}
+
+// the layout an input ends up in after convert_layout
+// the result is also valid layout flags that convert to exactly this layout
+static int get_layout_class(int layout_flags, const Option& opt)
+{
+    int layout_class = layout_flags & get_storage16_flag(opt);
+    if (opt.use_packing_layout && (layout_flags & LAYOUT_PACKING))
+        layout_class |= LAYOUT_PACKING;
+
+    return layout_class;
+}
+
+int NetPrivate::plan_split_packing()
+{
+    const int layer_count = (int)layers.size();
+
+    split_packing_plan.clear();
+    split_packing_plan.resize(layer_count, -1);
+
+    if (is_builtin_layer_overwritten(LayerType::Split))
+        return 0;
+
+    int removed_count = 0;
+
+    // every consumer converts its input on its own, so a blob fanned out by Split
+    // is repacked once per consumer that differs from the packing Split passes on
+    // pass on pack1 when that needs fewer repacks around the Split than its own packing
+    // consumers come later in the graph, visit backwards so that nested Split see the plan of the inner one
+    for (int i = layer_count - 1; i >= 0; i--)
+    {
+        const Layer* layer = layers[i];
+        if (layer->typeindex != LayerType::Split)
+            continue;
+
+        // int8 blobs are never cast
+        bool has_int8 = false;
+
+        // the net input comes in fp32 pack1
+        int incoming_class = 0;
+        const int producer = blobs[layer->bottoms[0]].producer;
+        if (producer != -1 && layers[producer]->typeindex != LayerType::Input)
+        {
+            const Layer* producer_layer = layers[producer];
+            const int producer_flags = split_packing_plan[producer] == -1 ? get_layer_layout_flags(producer_layer) : split_packing_plan[producer];
+            incoming_class = get_layout_class(producer_flags, producer_layer->featmask ? get_masked_option(opt, producer_layer->featmask) : opt);
+            has_int8 = has_int8 || producer_layer->support_int8_storage;
+        }
+
+        std::vector<int> consumer_classes;
+        for (size_t j = 0; j < layer->tops.size(); j++)
+        {
+            const int consumer = blobs[layer->tops[j]].consumer;
+            if (consumer == -1)
+                continue;
+
+            const Layer* consumer_layer = layers[consumer];
+            const int consumer_flags = split_packing_plan[consumer] == -1 ? get_layer_layout_flags(consumer_layer) : split_packing_plan[consumer];
+            consumer_classes.push_back(get_layout_class(consumer_flags, consumer_layer->featmask ? get_masked_option(opt, consumer_layer->featmask) : opt));
+            has_int8 = has_int8 || consumer_layer->support_int8_storage;
+        }
+
+        if (has_int8 || consumer_classes.empty())
+            continue;
+
+        // only the packing is planned, the 16bit storage casts stay where they are so that the results do not change
+        const int split_class = get_layout_class(get_layer_layout_flags(layer), opt);
+        if (!(split_class & LAYOUT_PACKING))
+            continue;
+
+        // one repack for the split input and one for each consumer wanting the other packing
+        int packed_repacks = (incoming_class & LAYOUT_PACKING) ? 0 : 1;
+        int unpacked_repacks = 1 - packed_repacks;
+        for (size_t k = 0; k < consumer_classes.size(); k++)
+        {
+            if (consumer_classes[k] & LAYOUT_PACKING)
+                unpacked_repacks++;
+            else
+                packed_repacks++;
+        }
+
+        // ties keep the packing of the split itself
+        if (unpacked_repacks < packed_repacks)
+        {
+            split_packing_plan[i] = split_class & ~LAYOUT_PACKING;
+            removed_count += packed_repacks - unpacked_repacks;
+        }
+    }
+
+    return removed_count;
+}
+
+void NetPrivate::build_channel_views()
+{
+    const int layer_count = (int)layers.size();
+
+    channel_view_layers.clear();
+    channel_view_layers.resize(layer_count, 0);
+
+    channel_view_blobs.clear();
+    channel_view_blobs.resize(blobs.size(), 0);
+
+    concat_view_shape empty_shape = {0, 0, 0, 0, 0u, 0, std::vector<int>()};
+    concat_view_shapes.clear();
+    concat_view_shapes.resize(layer_count, empty_shape);
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Layer* layer = layers[i];
+
+        const int typeindex = layer->typeindex;
+        if (typeindex != LayerType::Concat && typeindex != LayerType::Slice)
+            continue;
+
+        if (is_builtin_layer_overwritten(typeindex))
+            continue;
+
+        if (typeindex == LayerType::Slice)
+        {
+            channel_view_layers[i] = 1;
+            continue;
+        }
+
+        // the producers write into the concat output through their regular forward
+        // which only works for the single output layers that create their top blob themselves
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            const int producer = blobs[layer->bottoms[j]].producer;
+            if (producer == -1)
+                continue;
+
+            const Layer* producer_layer = layers[producer];
+            if (producer_layer->one_blob_only && producer_layer->tops.size() == 1 && producer_layer->typeindex != LayerType::Input)
+            {
+                channel_view_layers[i] = 1;
+                channel_view_blobs[layer->bottoms[j]] = 1;
+            }
+        }
+    }
+}
+
+// the channel count of a 3d or 4d blob concatenated or sliced along channels, 0 for the other cases
+static int get_channel_view_channels(const Mat& m, int axis)
+{
+    if (m.dims != 3 && m.dims != 4)
+        return 0;
+
+    const int positive_axis = axis < 0 ? m.dims + axis : axis;
+    if (positive_axis != 0)
+        return 0;
+
+    return m.c * m.elempack;
+}
+
+int NetPrivate::forward_concat_view(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
+{
+    const Concat* layer = (const Concat*)layers[layer_index];
+    const int bottom_count = (int)layer->bottoms.size();
+    const int top_blob_index = layer->tops[0];
+
+    // the plans of each shape bucket are kept apart
+    std::vector<concat_view_shape>& view_shapes = get_concat_view_shapes(opt.blob_allocator);
+
+    // allocate the output with the shape of the last forward and hand its channel ranges to the producers
+    // a producer whose output shape changed allocates its own top blob, which is copied below
+    Mat top_blob;
+    std::vector<Mat> bottom_views(bottom_count);
+    {
+        MutexLockGuard lock(concat_view_lock);
+
+        const concat_view_shape& shape = view_shapes[layer_index];
+
+        int outc = 0;
+        for (size_t i = 0; i < shape.channels.size(); i++)
+        {
+            outc += shape.channels[i];
+        }
+
+        if (shape.dims == 3)
+            top_blob.create(shape.w, shape.h, outc, shape.elemsize, shape.elempack, opt.blob_allocator);
+        if (shape.dims == 4)
+            top_blob.create(shape.w, shape.h, shape.d, outc, shape.elemsize, shape.elempack, opt.blob_allocator);
+
+        if (!top_blob.empty())
+        {
+            int q = 0;
+            for (int i = 0; i < bottom_count; i++)
+            {
+                bottom_views[i] = top_blob.channel_range(q, shape.channels[i]);
+                q += shape.channels[i];
+            }
+        }
+    }
+
+    // load bottom blobs
+    for (int i = 0; i < bottom_count; i++)
+    {
+        const int bottom_blob_index = layer->bottoms[i];
+        if (blob_mats[bottom_blob_index].dims != 0)
+            continue;
+
+        const int producer = blobs[bottom_blob_index].producer;
+
+        const bool is_tile_chain_tail = opt.use_depth_first_tiling && !tile_chain_of_tail.empty() && tile_chain_of_tail[producer] != -1;
+        if (!bottom_views[i].empty() && channel_view_blobs[bottom_blob_index] && !is_tile_chain_tail)
+        {
+            blob_mats[bottom_blob_index] = bottom_views[i];
+        }
+
+        int ret = forward_layer(producer, blob_mats, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (!pipeline_pending.empty())
+    {
+        int ret = ensure_layer_pipeline(layer_index);
+        if (ret != 0)
+            return ret;
+    }
+
+    const Option opt1 = layer->featmask ? get_masked_option(opt, layer->featmask) : opt;
+
+    std::vector<Mat> bottom_blobs(bottom_count);
+    for (int i = 0; i < bottom_count; i++)
+    {
+        bottom_blobs[i] = blob_mats[layer->bottoms[i]];
+        convert_layout(bottom_blobs[i], get_layer_layout_flags(layer), opt1);
+    }
+
+    // the bottoms must agree on everything but the channel count
+    // and the output must take the elempack the regular concat would choose
+    const Mat& b0 = bottom_blobs[0];
+    int top_channels = 0;
+    bool viewable = true;
+    for (int i = 0; i < bottom_count; i++)
+    {
+        const Mat& b = bottom_blobs[i];
+        const int channels = get_channel_view_channels(b, layer->axis);
+        if (channels == 0 || b.dims != b0.dims || b.w != b0.w || b.h != b0.h || b.d != b0.d || b.elemsize != b0.elemsize || b.elempack != b0.elempack
+                || b.cstep != alignSize((size_t)b.w * b.h * b.d * b.elemsize, 16) / b.elemsize)
+        {
+            viewable = false;
+            break;
+        }
+
+        top_channels += channels;
+    }
+
+    if (viewable)
+    {
+        viewable = resolve_dst_elempack(top_channels, b0.elembits(), layer->support_packing, opt1) == b0.elempack;
+    }
+
+    if (!viewable)
+    {
+        {
+            MutexLockGuard lock(concat_view_lock);
+            view_shapes[layer_index].dims = 0;
+        }
+
+        // regular concat
+        return do_forward_layer(layer, blob_mats, opt1);
+    }
+
+    bool same_shape = !top_blob.empty() && top_blob.dims == b0.dims && top_blob.w == b0.w && top_blob.h == b0.h && top_blob.d == b0.d && top_blob.elemsize == b0.elemsize && top_blob.elempack == b0.elempack;
+    for (int i = 0; i < bottom_count && same_shape; i++)
+    {
+        same_shape = bottom_views[i].c == bottom_blobs[i].c;
+    }
+
+    // keeps the bottoms produced into the stale output alive until they are copied
+    Mat stale_top_blob;
+
+    if (!same_shape)
+    {
+        // first forward or the shape changed
+        const int outc = top_channels / b0.elempack;
+
+        stale_top_blob = top_blob;
+        top_blob.release();
+        if (b0.dims == 3)
+            top_blob.create(b0.w, b0.h, outc, b0.elemsize, b0.elempack, opt.blob_allocator);
+        if (b0.dims == 4)
+            top_blob.create(b0.w, b0.h, b0.d, outc, b0.elemsize, b0.elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        MutexLockGuard lock(concat_view_lock);
+        concat_view_shape& shape = view_shapes[layer_index];
+        shape.dims = b0.dims;
+        shape.w = b0.w;
+        shape.h = b0.h;
+        shape.d = b0.d;
+        shape.elemsize = b0.elemsize;
+        shape.elempack = b0.elempack;
+        shape.channels.resize(bottom_count);
+        for (int i = 0; i < bottom_count; i++)
+        {
+            shape.channels[i] = bottom_blobs[i].c;
+        }
+    }
+
+    // copy the bottoms not produced in place
+    int q = 0;
+    for (int i = 0; i < bottom_count; i++)
+    {
+        const Mat& b = bottom_blobs[i];
+        unsigned char* outptr = top_blob.channel(q);
+
+        if (b.data != outptr)
+        {
+            memcpy(outptr, b.data, b.cstep * b.c * b.elemsize);
+        }
+
+        q += b.c;
+    }
+
+    top_blob.dims = b0.dims;
+    blob_mats[top_blob_index] = top_blob;
+
+    // delete after taken in light mode
+    for (int i = 0; i < bottom_count; i++)
+    {
+        blob_mats[layer->bottoms[i]].release();
+    }
+
+    return 0;
+}
+
+int NetPrivate::forward_slice_view(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
+{
+    const Slice* layer = (const Slice*)layers[layer_index];
+    const int bottom_blob_index = layer->bottoms[0];
+    const int top_count = (int)layer->tops.size();
+
+    const Option opt1 = layer->featmask ? get_masked_option(opt, layer->featmask) : opt;
+
+    Mat bottom_blob = blob_mats[bottom_blob_index];
+    convert_layout(bottom_blob, get_layer_layout_flags(layer), opt1);
+
+    const int channels = get_channel_view_channels(bottom_blob, layer->axis);
+    if (channels == 0 || layer->slices.w != top_count)
+        return 1;
+
+    // every output takes the elempack of the input, which is also what the regular slice would choose
+    const int* slices_ptr = layer->slices;
+    std::vector<int> top_channels(top_count);
+    int q = 0;
+    for (int i = 0; i < top_count; i++)
+    {
+        int slice = slices_ptr[i];
+        if (slice == -233)
+        {
+            slice = (channels - q) / (top_count - i);
+        }
+
+        if (slice <= 0 || slice % bottom_blob.elempack != 0 || resolve_dst_elempack(slice, bottom_blob.elembits(), layer->support_packing, opt1) != bottom_blob.elempack)
+            return 1;
+
+        top_channels[i] = slice;
+        q += slice;
+    }
+
+    if (q != channels)
+        return 1;
+
+    // the input stays in blob_mats until the extractor goes away, the outputs point into it
+    // so it is not released in light mode
+    blob_mats[bottom_blob_index] = bottom_blob;
+
+    q = 0;
+    for (int i = 0; i < top_count; i++)
+    {
+        const int outc = top_channels[i] / bottom_blob.elempack;
+        blob_mats[layer->tops[i]] = bottom_blob.channel_range(q, outc);
+        q += outc;
+    }
+
+    return 0;
+}
+
+// accumulate a 32bit checksum and a 64bit hash of the weights loaded through it
+// the checksum keys the weight cache file, the shared weight store needs both
+class ModelBinChecksum : public ModelBin
+{
+public:
+    explicit ModelBinChecksum(const ModelBin& _mb)
+        : mb(_mb), checksum(2166136261u), hash(14695981039346656037ull)
+    {
+    }
+
+    virtual Mat load(int w, int type) const
+    {
+        Mat m = mb.load(w, type);
+
+        update((unsigned int)m.w);
+        update((unsigned int)m.elemsize);
+
+        // fnv-1a over 32bit words, the weights are 32bit aligned
+        const size_t size = m.total() * m.elemsize;
+        const unsigned int* ptr = (const unsigned int*)m.data;
+        for (size_t i = 0; i < size / 4; i++)
+        {
+            update(ptr[i]);
+        }
+
+        const unsigned char* tail = (const unsigned char*)m.data + size / 4 * 4;
+        for (size_t i = 0; i < size % 4; i++)
+        {
+            update(tail[i]);
+        }
+
+        return m;
+    }
+
+    void update(unsigned int v) const
+    {
+        checksum = (checksum ^ v) * 16777619u;
+        hash = (hash ^ v) * 1099511628211ull;
+    }
+
+public:
+    const ModelBin& mb;
+    mutable unsigned int checksum;
+    mutable uint64_t hash;
+};
+
+// 64bit fnv-1a over the type and value of each param
+static uint64_t get_param_hash(const ParamDict& pd)
+{
+    uint64_t hash = 14695981039346656037ull;
+
+    for (int id = 0; id < NCNN_MAX_PARAM_COUNT; id++)
+    {
+        const int type = pd.type(id);
+
+        hash = (hash ^ (unsigned int)type) * 1099511628211ull;
+
+        if (type == 0)
+            continue;
+
+        if (type == 4 || type == 5 || type == 6)
+        {
+            // the array elements are 32bit int or float
+            Mat v = pd.get(id, Mat());
+            const unsigned int* ptr = v;
+            hash = (hash ^ (unsigned int)v.w) * 1099511628211ull;
+            for (int i = 0; i < v.w; i++)
+            {
+                hash = (hash ^ ptr[i]) * 1099511628211ull;
+            }
+        }
+        else
+        {
+            // int and float share the bits
+            hash = (hash ^ (unsigned int)pd.get(id, 0)) * 1099511628211ull;
+        }
+    }
+
+    return hash;
+}
+
+// keeps a reference to each weight a layer loads
+// so that the ones still held by the layer can be told apart after create_pipeline
+class ModelBinRecorder : public ModelBin
+{
+public:
+    ModelBinRecorder(const ModelBin& _mb, std::vector<Mat>& _mats)
+        : mb(_mb), mats(_mats)
+    {
+    }
+
+    virtual Mat load(int w, int type) const
+    {
+        Mat m = mb.load(w, type);
+
+        mats.push_back(m);
+
+        return m;
+    }
+
+public:
+    const ModelBin& mb;
+    std::vector<Mat>& mats;
+};
+
+static const int weight_cache_magic = 0x6e637763; // ncwc
+static const int weight_cache_version = 4;
+
+// everything that steers the weight transform in create_pipeline
+static void get_weight_cache_key(const Option& opt, int layer_count, std::vector<int>& key)
+{
+    int isa = 0;
+    isa |= cpu_support_x86_avx() << 0;
+    isa |= cpu_support_x86_fma() << 1;
+    isa |= cpu_support_x86_xop() << 2;
+    isa |= cpu_support_x86_f16c() << 3;
+    isa |= cpu_support_x86_avx2() << 4;
+    isa |= cpu_support_x86_avx_vnni() << 5;
+    isa |= cpu_support_x86_avx512() << 6;
+    isa |= cpu_support_x86_avx512_vnni() << 7;
+    isa |= cpu_support_x86_avx512_bf16() << 8;
+    isa |= cpu_support_x86_avx512_fp16() << 9;
+    isa |= cpu_support_arm_neon() << 10;
+    isa |= cpu_support_arm_vfpv4() << 11;
+    isa |= cpu_support_arm_asimdhp() << 12;
+    isa |= cpu_support_arm_asimddp() << 13;
+    isa |= cpu_support_arm_asimdfhm() << 14;
+    isa |= cpu_support_arm_bf16() << 15;
+    isa |= cpu_support_arm_i8mm() << 16;
+
+    int flags = 0;
+    flags |= opt.use_winograd_convolution << 0;
+    flags |= opt.use_sgemm_convolution << 1;
+    flags |= opt.use_int8_inference << 2;
+    flags |= opt.use_bf16_storage << 3;
+    flags |= opt.use_fp16_packed << 4;
+    flags |= opt.use_fp16_storage << 5;
+    flags |= opt.use_fp16_arithmetic << 6;
+    flags |= opt.use_packing_layout << 7;
+    flags |= opt.use_winograd23_convolution << 8;
+    flags |= opt.use_winograd43_convolution << 9;
+    flags |= opt.use_winograd63_convolution << 10;
+    flags |= opt.use_a53_a55_optimized_kernel << 11;
+    flags |= opt.use_layer_fusion << 12;
+    flags |= opt.use_sparse_weight << 13;
+
+    key.resize(5);
+    key[0] = isa;
+    key[1] = get_cpu_level2_cache_size();
+    key[2] = opt.num_threads;
+    key[3] = flags;
+    key[4] = layer_count;
+}
+
+// process-wide store of the transformed weights shared by the nets with Net::set_shared_weight_store
+// the mats are never written after create_pipeline, each net references them as its own
+// the entries are kept sorted by the hash of their key, a lookup bisects to the hash and compares the full keys
+struct shared_weight_entry
+{
+    uint64_t hash;
+    std::vector<int> key;
+    std::vector<Mat> mats;
+};
+
+static Mutex g_shared_weight_store_lock;
+static std::vector<shared_weight_entry> g_shared_weight_store;
+
+// the transformed weights of Net::set_huge_page_weights are copied into this allocator
+// the weights are never reallocated, so each mapping is unmapped as soon as its weight is released
+class HugePageWeightAllocator : public HugePageAllocator
+{
+public:
+    virtual void fastFree(void* ptr)
+    {
+        HugePageAllocator::fastFree(ptr);
+
+        // drop the mapping just returned to the budgets
+        clear();
+    }
+};
+
+// the weights may be shared through the store above and outlive the net that made them
+// so the allocator itself is never destroyed, it holds no mapping once all of them are released
+static Mutex g_huge_page_weight_allocator_lock;
+static HugePageAllocator* g_huge_page_weight_allocator = 0;
+
+static HugePageAllocator* get_huge_page_weight_allocator()
+{
+    MutexLockGuard lock(g_huge_page_weight_allocator_lock);
+
+    if (!g_huge_page_weight_allocator)
+    {
+        g_huge_page_weight_allocator = new HugePageWeightAllocator;
+        g_huge_page_weight_allocator->set_size_threshold(NCNN_HUGE_PAGE_SIZE);
+    }
+
+    return g_huge_page_weight_allocator;
+}
+
+static void push_shared_weight_key_shapes(const std::vector<Mat>& shapes, std::vector<int>& key)
+{
+    key.push_back((int)shapes.size());
+    for (size_t i = 0; i < shapes.size(); i++)
+    {
+        const Mat& shape = shapes[i];
+        key.push_back(shape.dims);
+        key.push_back(shape.w);
+        key.push_back(shape.h);
+        key.push_back(shape.d);
+        key.push_back(shape.c);
+    }
+}
+
+// the layer content and everything that steers its weight transform
+// the weights are identified by their byte size, 32bit checksum and an independent 64bit hash
+static void get_shared_weight_key(const Layer* layer, unsigned int weight_checksum, uint64_t weight_hash, uint64_t param_hash, size_t weight_bytes, const Option& opt, std::vector<int>& key)
+{
+    get_weight_cache_key(opt, 0, key);
+
+    key.push_back(layer->typeindex);
+    key.push_back((int)weight_checksum);
+    key.push_back((int)(weight_hash & 0xffffffff));
+    key.push_back((int)(weight_hash >> 32));
+    key.push_back((int)(param_hash & 0xffffffff));
+    key.push_back((int)(param_hash >> 32));
+    key.push_back((int)(weight_bytes & 0x7fffffff));
+    key.push_back((int)(weight_bytes >> 31));
+
+    push_shared_weight_key_shapes(layer->bottom_shapes, key);
+    push_shared_weight_key_shapes(layer->top_shapes, key);
+}
+
+static uint64_t get_shared_weight_key_hash(const std::vector<int>& key)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < key.size(); i++)
+    {
+        hash = (hash ^ (unsigned int)key[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// the first entry whose hash is not less than hash, the caller holds the store lock
+static size_t shared_weight_lower_bound(uint64_t hash)
+{
+    size_t lo = 0;
+    size_t hi = g_shared_weight_store.size();
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (g_shared_weight_store[mid].hash < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// the entry with the same key or -1, the caller holds the store lock
+static int find_shared_weight_entry(uint64_t hash, const std::vector<int>& key)
+{
+    for (size_t i = shared_weight_lower_bound(hash); i < g_shared_weight_store.size() && g_shared_weight_store[i].hash == hash; i++)
+    {
+        if (g_shared_weight_store[i].key == key)
+            return (int)i;
+    }
+
+    return -1;
+}
+
+static bool find_shared_weights(const std::vector<int>& key, std::vector<Mat>& mats)
+{
+    const uint64_t hash = get_shared_weight_key_hash(key);
+
+    MutexLockGuard lock(g_shared_weight_store_lock);
+
+    const int i = find_shared_weight_entry(hash, key);
+    if (i == -1)
+        return false;
+
+    mats = g_shared_weight_store[i].mats;
+    return true;
+}
+
+static void add_shared_weights(const std::vector<int>& key, const std::vector<Mat>& mats)
+{
+    // weights referencing external memory may go away with their net
+    bool owned = false;
+    for (size_t i = 0; i < mats.size(); i++)
+    {
+        if (mats[i].empty())
+            continue;
+
+        if (!mats[i].refcount)
+            return;
+
+        owned = true;
+    }
+
+    if (!owned)
+        return;
+
+    const uint64_t hash = get_shared_weight_key_hash(key);
+
+    MutexLockGuard lock(g_shared_weight_store_lock);
+
+    // another net may have added the same weights while we were transforming
+    if (find_shared_weight_entry(hash, key) != -1)
+        return;
+
+    shared_weight_entry entry;
+    entry.hash = hash;
+    entry.key = key;
+    entry.mats = mats;
+
+    // keep the store sorted by hash
+    const size_t pos = shared_weight_lower_bound(hash);
+    g_shared_weight_store.push_back(entry);
+    for (size_t i = g_shared_weight_store.size() - 1; i > pos; i--)
+    {
+        g_shared_weight_store[i] = g_shared_weight_store[i - 1];
+    }
+    g_shared_weight_store[pos] = entry;
+}
+
+// drop the entries that no layer references any more
+static void prune_shared_weights()
+{
+    MutexLockGuard lock(g_shared_weight_store_lock);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < g_shared_weight_store.size(); i++)
+    {
+        const std::vector<Mat>& mats = g_shared_weight_store[i].mats;
+
+        bool referenced = false;
+        for (size_t j = 0; j < mats.size(); j++)
+        {
+            if (mats[j].refcount && NCNN_XADD(mats[j].refcount, 0) > 1)
+                referenced = true;
+        }
+
+        if (!referenced)
+            continue;
+
+        if (kept != i)
+            g_shared_weight_store[kept] = g_shared_weight_store[i];
+        kept++;
+    }
+
+    g_shared_weight_store.resize(kept);
+}
+
+// mat shape with external data, data may be null for shape only
+static Mat weight_cache_mat(int dims, int w, int h, int d, int c, void* data, size_t elemsize, int elempack)
+{
+    if (dims == 1)
+        return Mat(w, data, elemsize, elempack);
+    if (dims == 2)
+        return Mat(w, h, data, elemsize, elempack);
+    if (dims == 3)
+        return Mat(w, h, c, data, elemsize, elempack);
+    if (dims == 4)
+        return Mat(w, h, d, c, data, elemsize, elempack);
+
+    return Mat();
+}
+
+static int read_weight_cache_mat(const DataReader& dr, size_t& offset, Mat& m)
+{
+    int header[8];
+    if (dr.read(header, sizeof(header)) != sizeof(header))
+        return -1;
+
+    offset += sizeof(header);
+
+    const int dims = header[0];
+    if (dims == 0)
+    {
+        m.release();
+        return 0;
+    }
+
+    if (dims < 0 || dims > 4)
+        return -1;
+
+    // mat data is 64-byte aligned in the cache
+    const size_t padding = alignSize(offset, 64) - offset;
+    if (padding)
+    {
+        unsigned char buf[64];
+        if (dr.read(buf, padding) != padding)
+            return -1;
+
+        offset += padding;
+    }
+
+    const Mat shape = weight_cache_mat(dims, header[1], header[2], header[3], header[4], 0, (size_t)header[5], header[6]);
+    const size_t size = shape.total() * shape.elemsize;
+
+    const void* refbuf = 0;
+    size_t nread = dr.reference(size, &refbuf);
+    if (nread == size && ((size_t)refbuf & (NCNN_MALLOC_ALIGN - 1)) == 0)
+    {
+        m = weight_cache_mat(dims, header[1], header[2], header[3], header[4], (void*)refbuf, (size_t)header[5], header[6]);
+    }
+    else
+    {
+        m.create_like(shape);
+        if (m.empty())
+            return -100;
+
+        if (nread == size)
+        {
+            // misaligned reference
+            memcpy(m.data, refbuf, size);
+        }
+        else if (dr.read(m.data, size) != size)
+        {
+            return -1;
+        }
+    }
+
+    offset += size;
+
+    return 0;
+}
+
+#if NCNN_STDIO
+static int write_weight_cache_mat(FILE* fp, size_t& offset, const Mat& _m)
+{
+    int header[8] = {0};
+    if (_m.empty())
+    {
+        if (fwrite(header, sizeof(header), 1, fp) != 1)
+            return -1;
+
+        offset += sizeof(header);
+        return 0;
+    }
+
+    // write with the default channel step
+    Mat m = _m;
+    const Mat shape = weight_cache_mat(m.dims, m.w, m.h, m.d, m.c, 0, m.elemsize, m.elempack);
+    if (m.cstep != shape.cstep)
+    {
+        m = _m.clone();
+        if (m.empty())
+            return -100;
+    }
+
+    header[0] = m.dims;
+    header[1] = m.w;
+    header[2] = m.h;
+    header[3] = m.d;
+    header[4] = m.c;
+    header[5] = (int)m.elemsize;
+    header[6] = m.elempack;
+    if (fwrite(header, sizeof(header), 1, fp) != 1)
+        return -1;
+
+    offset += sizeof(header);
+
+    const size_t padding = alignSize(offset, 64) - offset;
+    if (padding)
+    {
+        const unsigned char zeros[64] = {0};
+        if (fwrite(zeros, 1, padding, fp) != padding)
+            return -1;
+
+        offset += padding;
+    }
+
+    const size_t size = m.total() * m.elemsize;
+    if (fwrite(m.data, 1, size, fp) != size)
+        return -1;
+
+    offset += size;
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
+// container section types
+enum
+{
+    container_section_param = 1,   // binary param
+    container_section_names = 2,   // layer type, layer name and blob name strings
+    container_section_weight_cache = 3,
+    container_section_model = 4
+};
+
+static const int container_magic = 0x6e636e63; // ncnc
+static const int container_version = 1;
+
+struct container_section
+{
+    int type;
+    int64_t offset;
+    int64_t size;
+};
+
+// track how many bytes a section loader consumed
+class DataReaderCounting : public DataReader
+{
+public:
+    explicit DataReaderCounting(const DataReader& _dr)
+        : dr(_dr), consumed(0)
+    {
+    }
+
+#if NCNN_STRING
+    virtual int scan(const char* format, void* p) const
+    {
+        return dr.scan(format, p);
+    }
+#endif // NCNN_STRING
+
+    virtual size_t read(void* buf, size_t size) const
+    {
+        size_t nread = dr.read(buf, size);
+        consumed += nread;
+        return nread;
+    }
+
+    virtual size_t reference(size_t size, const void** buf) const
+    {
+        size_t nref = dr.reference(size, buf);
+        consumed += nref;
+        return nref;
+    }
+
+public:
+    const DataReader& dr;
+    mutable size_t consumed;
+};
+
+static int skip_data(const DataReader& dr, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    const void* refbuf = 0;
+    if (dr.reference(size, &refbuf) == size)
+        return 0;
+
+    unsigned char buf[4096];
+    while (size > 0)
+    {
+        size_t nread = dr.read(buf, size < sizeof(buf) ? size : sizeof(buf));
+        if (nread == 0)
+            return -1;
+
+        size -= nread;
+    }
+
+    return 0;
+}
+
+Net::Net()
+    : d(new NetPrivate(opt))
+{
+}
+
+Net::~Net()
+{
+    clear();
+
+    delete d;
+}
+
+Net::Net(const Net&)
+    : d(0)
+{
+}
+
+Net& Net::operator=(const Net&)
+{
+    return *this;
+}
+
+#if NCNN_STRING
+int Net::register_custom_layer(const char* type, layer_creator_func creator, layer_destroyer_func destroyer, void* userdata)
+{
+    int typeindex = layer_to_index(type);
+    if (typeindex != -1)
+    {
+        NCNN_LOGE("overwrite built-in layer type %s", type);
+
+        for (size_t i = 0; i < d->overwrite_builtin_layer_registry.size(); i++)
+        {
+            if (d->overwrite_builtin_layer_registry[i].typeindex == typeindex)
+            {
+                NCNN_LOGE("overwrite existing overwritten built-in layer index %d", typeindex);
+
+                d->overwrite_builtin_layer_registry[i].creator = creator;
                 d->overwrite_builtin_layer_registry[i].destroyer = destroyer;
                 d->overwrite_builtin_layer_registry[i].userdata = userdata;
                 return 0;
@@ -1312,6 +3262,7 @@ int Net::load_param(const DataReader& dr)
 
     d->layers.resize((size_t)layer_count);
     d->blobs.resize((size_t)blob_count);
+    d->param_hashes.assign((size_t)layer_count, 0);
 
 #if NCNN_VULKAN
     // TODO enable gpu when bf16 conversion implemented
@@ -1489,6 +3440,8 @@ int Net::load_param(const DataReader& dr)
         // pull out layer specific feature disabled set
         layer->featmask = pd.get(31, 0);
 
+        d->param_hashes[i] = get_param_hash(pd);
+
         int lr = layer->load_param(pd);
         if (lr != 0)
         {
@@ -1536,6 +3489,7 @@ int Net::load_param_bin(const DataReader& dr)
 
     d->layers.resize(layer_count);
     d->blobs.resize(blob_count);
+    d->param_hashes.assign(layer_count, 0);
 
 #if NCNN_VULKAN
     // TODO enable gpu when bf16 conversion implemented
@@ -1699,6 +3653,8 @@ int Net::load_param_bin(const DataReader& dr)
         // pull out layer specific feature disabled set
         layer->featmask = pd.get(31, 0);
 
+        d->param_hashes[i] = get_param_hash(pd);
+
         int lr = layer->load_param(pd);
         if (lr != 0)
         {
@@ -1710,12 +3666,207 @@ int Net::load_param_bin(const DataReader& dr)
             continue;
         }
 
-        d->layers[i] = layer;
+        d->layers[i] = layer;
+    }
+
+    d->update_input_output_indexes();
+
+#undef READ_VALUE
+    return 0;
+}
+
+int NetPrivate::create_layer_pipeline(int layer_index, bool use_weight_cache) const
+{
+    Layer* layer = layers[layer_index];
+
+    Option opt1 = get_masked_option(opt, layer->featmask);
+#if NCNN_VULKAN
+    if (opt1.use_vulkan_compute)
+    {
+        if (!layer->support_image_storage) opt1.use_image_storage = false;
+    }
+    else
+    {
+        layer->vkdev = 0;
+        layer->support_vulkan = false;
+    }
+#endif // NCNN_VULKAN
+
+    const bool share_weights = use_shared_weight_store && !opt1.use_vulkan_compute && layer_index < (int)weight_hashes.size() && layer_index < (int)param_hashes.size();
+
+    std::vector<int> shared_weight_key;
+    if (share_weights)
+    {
+        get_shared_weight_key(layer, weight_checksums[layer_index], weight_hashes[layer_index], param_hashes[layer_index], layer_weight_bytes[layer_index], opt1, shared_weight_key);
+    }
+
+    int cret = -1;
+    bool shared = false;
+    if (share_weights)
+    {
+        std::vector<Mat> shared_mats;
+        if (find_shared_weights(shared_weight_key, shared_mats))
+        {
+            cret = layer->load_weight_cache(shared_mats, opt1);
+            shared = cret == 0;
+        }
+    }
+    if (cret != 0 && use_weight_cache)
+    {
+        const weight_cache_entry& entry = weight_cache[layer_index];
+        if (!entry.mats.empty() && entry.typeindex == layer->typeindex && entry.checksum == weight_checksums[layer_index] && entry.param_hash == param_hashes[layer_index])
+        {
+            cret = layer->load_weight_cache(entry.mats, opt1);
+        }
+    }
+    if (cret != 0)
+    {
+        cret = layer->create_pipeline(opt1);
+    }
+    if (cret != 0)
+    {
+#if NCNN_STRING
+        NCNN_LOGE("layer create_pipeline %d %s failed", layer_index, layer->name.c_str());
+#else
+        NCNN_LOGE("layer create_pipeline %d failed", layer_index);
+#endif
+        return -1;
+    }
+
+    // the transformed weights are the ones read in forward
+    std::vector<Mat> mats;
+    if (layer->save_weight_cache(mats) != 0)
+        mats.clear();
+
+    const bool use_huge_page = use_huge_page_weights && !opt1.use_vulkan_compute;
+    if (use_huge_page && !shared)
+    {
+        // copy the large weights onto huge pages and hand the copies back to the layer
+        // weights referencing external memory are left alone
+        std::vector<Mat> huge_page_mats = mats;
+        std::vector<void*> huge_page_ptrs;
+        for (size_t i = 0; i < mats.size(); i++)
+        {
+            if (mats[i].empty() || !mats[i].refcount || mats[i].total() * mats[i].elemsize < NCNN_HUGE_PAGE_SIZE)
+                continue;
+
+            Mat m = mats[i].clone(get_huge_page_weight_allocator());
+            if (m.empty())
+                continue;
+
+            huge_page_mats[i] = m;
+            huge_page_ptrs.push_back(m.data);
+        }
+
+        if (!huge_page_ptrs.empty())
+        {
+            layer->destroy_pipeline(opt1);
+
+            cret = layer->load_weight_cache(huge_page_mats, opt1);
+            if (cret != 0)
+            {
+#if NCNN_STRING
+                NCNN_LOGE("layer load_weight_cache %d %s failed", layer_index, layer->name.c_str());
+#else
+                NCNN_LOGE("layer load_weight_cache %d failed", layer_index);
+#endif
+                return -1;
+            }
+
+            mats = huge_page_mats;
+            huge_page_weights.insert(huge_page_weights.end(), huge_page_ptrs.begin(), huge_page_ptrs.end());
+        }
+    }
+
+    const bool use_numa_interleave = use_numa_interleaved_weights && !opt1.use_vulkan_compute && get_cpu_numa_node_count() > 1;
+
+    size_t pipeline_weight_bytes = 0;
+    for (size_t i = 0; i < mats.size(); i++)
+    {
+        if (mats[i].empty())
+            continue;
+
+        const size_t size = mats[i].total() * mats[i].elemsize;
+
+        pipeline_weight_bytes += size;
+
+        // the shared weights were placed by the net that transformed them
+        if (shared)
+            continue;
+
+        if (use_numa_interleave)
+            set_memory_numa_interleave(mats[i].data, size);
+    }
+
+    if (share_weights && !shared && !mats.empty())
+    {
+        add_shared_weights(shared_weight_key, mats);
+    }
+
+    if (layer_index < (int)loaded_weights.size())
+    {
+        // the loaded weights still referenced by the layer besides us
+        const std::vector<Mat>& loaded = loaded_weights[layer_index];
+        for (size_t i = 0; i < loaded.size(); i++)
+        {
+            const Mat& m = loaded[i];
+            if (!m.refcount || NCNN_XADD(m.refcount, 0) <= 1)
+                continue;
+
+            bool exported = false;
+            for (size_t j = 0; j < mats.size(); j++)
+            {
+                if (mats[j].data == m.data)
+                    exported = true;
+            }
+
+            if (!exported)
+                pipeline_weight_bytes += m.total() * m.elemsize;
+        }
+
+        loaded_weights[layer_index].clear();
+        layer_pipeline_weight_bytes[layer_index] = pipeline_weight_bytes;
+    }
+
+    return 0;
+}
+
+int NetPrivate::ensure_layer_pipeline(int layer_index) const
+{
+    int* pending = &pipeline_pending[layer_index];
+    if (NCNN_XADD(pending, 0) == 0)
+        return 0;
+
+    MutexLockGuard lock(pipeline_lock);
+
+    // another extractor may have created it while we were waiting
+    if (*pending == 0)
+        return 0;
+
+    int ret = create_layer_pipeline(layer_index, lazy_use_weight_cache);
+    if (ret != 0)
+        return ret;
+
+    if (lazy_use_weight_cache)
+    {
+        // the cached mats are held by the layer now
+        weight_cache[layer_index].mats.clear();
+    }
+
+    NCNN_XADD(pending, -1);
+
+    return 0;
+}
+
+int NetPrivate::ensure_all_pipelines() const
+{
+    for (size_t i = 0; i < pipeline_pending.size(); i++)
+    {
+        int ret = ensure_layer_pipeline((int)i);
+        if (ret != 0)
+            return ret;
     }
 
-    d->update_input_output_indexes();
-
-#undef READ_VALUE
     return 0;
 }
 
@@ -1732,6 +3883,18 @@ int Net::load_model(const DataReader& dr)
     // load file
     int ret = 0;
 
+    const bool use_weight_checksum = opt.use_weight_cache || d->use_shared_weight_store;
+    if (use_weight_checksum)
+    {
+        d->weight_checksums.resize(layer_count);
+        d->weight_hashes.resize(layer_count);
+    }
+
+    d->layer_weight_bytes.assign(layer_count, 0);
+    d->layer_pipeline_weight_bytes.assign(layer_count, 0);
+    d->loaded_weights.clear();
+    d->loaded_weights.resize(layer_count);
+
     ModelBinFromDataReader mb(dr);
     for (int i = 0; i < layer_count; i++)
     {
@@ -1745,7 +3908,26 @@ int Net::load_model(const DataReader& dr)
             break;
         }
 
-        int lret = layer->load_model(mb);
+        int lret = 0;
+        if (use_weight_checksum)
+        {
+            ModelBinChecksum mbc(mb);
+            ModelBinRecorder mbr(mbc, d->loaded_weights[i]);
+            lret = layer->load_model(mbr);
+            d->weight_checksums[i] = mbc.checksum;
+            d->weight_hashes[i] = mbc.hash;
+        }
+        else
+        {
+            ModelBinRecorder mbr(mb, d->loaded_weights[i]);
+            lret = layer->load_model(mbr);
+        }
+
+        for (size_t j = 0; j < d->loaded_weights[i].size(); j++)
+        {
+            const Mat& m = d->loaded_weights[i][j];
+            d->layer_weight_bytes[i] += m.total() * m.elemsize;
+        }
         if (lret != 0)
         {
 #if NCNN_STRING
@@ -1764,6 +3946,24 @@ int Net::load_model(const DataReader& dr)
         }
     }
 
+    if (ret == 0 && opt.use_layer_fusion)
+    {
+        d->fuse_layers();
+    }
+
+    if (ret == 0 && opt.use_depth_first_tiling && !opt.use_vulkan_compute)
+    {
+        d->build_tile_chains();
+    }
+
+    d->channel_view_layers.clear();
+    d->channel_view_blobs.clear();
+
+    if (ret == 0 && opt.use_zero_copy_concat_slice && !opt.use_vulkan_compute)
+    {
+        d->build_channel_views();
+    }
+
 #if NCNN_VULKAN
     if (opt.use_vulkan_compute)
     {
@@ -1776,34 +3976,53 @@ int Net::load_model(const DataReader& dr)
     }
 #endif // NCNN_VULKAN
 
-    for (int i = 0; i < layer_count; i++)
+    bool use_weight_cache = false;
+    if (ret == 0 && opt.use_weight_cache && !opt.use_vulkan_compute && !d->weight_cache.empty())
     {
-        Layer* layer = d->layers[i];
+        std::vector<int> key;
+        get_weight_cache_key(opt, layer_count, key);
 
-        Option opt1 = get_masked_option(opt, layer->featmask);
-#if NCNN_VULKAN
-        if (opt1.use_vulkan_compute)
+        use_weight_cache = key == d->weight_cache_key;
+        if (!use_weight_cache)
         {
-            if (!layer->support_image_storage) opt1.use_image_storage = false;
+            NCNN_LOGE("weight cache mismatch with the current cpu or option, ignored");
         }
-        else
+    }
+
+    d->pipeline_pending.clear();
+    d->huge_page_weights.clear();
+
+    if (ret == 0 && opt.use_lazy_pipeline && !opt.use_vulkan_compute)
+    {
+        // create_pipeline on the first forward reaching each layer
+        d->pipeline_pending.resize(layer_count, 1);
+        d->lazy_use_weight_cache = use_weight_cache;
+    }
+    else
+    {
+        for (int i = 0; i < layer_count && ret == 0; i++)
         {
-            layer->vkdev = 0;
-            layer->support_vulkan = false;
+            ret = d->create_layer_pipeline(i, use_weight_cache);
         }
-#endif // NCNN_VULKAN
+    }
 
-        int cret = layer->create_pipeline(opt1);
-        if (cret != 0)
-        {
-#if NCNN_STRING
-            NCNN_LOGE("layer create_pipeline %d %s failed", i, layer->name.c_str());
-#else
-            NCNN_LOGE("layer create_pipeline %d failed", i);
+    d->split_packing_plan.clear();
+    d->split_packing_removed_repacks = 0;
+
+    if (ret == 0 && d->use_split_output_packing && !opt.use_vulkan_compute && d->pipeline_pending.empty())
+    {
+        // the support flags are final once the pipelines are created
+        d->split_packing_removed_repacks = d->plan_split_packing();
+#if NCNN_BENCHMARK
+        NCNN_LOGE("split output packing removed %d repacks", d->split_packing_removed_repacks);
 #endif
-            ret = -1;
-            break;
-        }
+    }
+
+    if (d->pipeline_pending.empty() || !d->lazy_use_weight_cache)
+    {
+        // the layers hold what they need
+        d->weight_cache_key.clear();
+        d->weight_cache.clear();
     }
 
     if (opt.use_local_pool_allocator)
@@ -1824,6 +4043,20 @@ int Net::load_model(const DataReader& dr)
                 d->local_workspace_allocator->set_size_compare_ratio(0.f);
             }
         }
+
+        const int numa_node_count = get_cpu_numa_node_count();
+        if (numa_node_count > 1 && d->numa_blob_allocators.empty())
+        {
+            d->numa_blob_allocators.resize(numa_node_count);
+            d->numa_workspace_allocators.resize(numa_node_count);
+            for (int i = 0; i < numa_node_count; i++)
+            {
+                d->numa_blob_allocators[i] = new PoolAllocator;
+                d->numa_blob_allocators[i]->set_size_compare_ratio(0.f);
+                d->numa_workspace_allocators[i] = new PoolAllocator;
+                d->numa_workspace_allocators[i]->set_size_compare_ratio(0.f);
+            }
+        }
     }
 
 #if NCNN_VULKAN
@@ -1836,6 +4069,211 @@ int Net::load_model(const DataReader& dr)
     return ret;
 }
 
+int Net::load_weight_cache(const DataReader& dr)
+{
+    if (d->layers.empty())
+    {
+        NCNN_LOGE("network graph not ready");
+        return -1;
+    }
+
+    const int layer_count = (int)d->layers.size();
+
+    size_t offset = 0;
+
+    int header[8];
+    if (dr.read(header, sizeof(header)) != sizeof(header))
+    {
+        NCNN_LOGE("read weight cache header failed");
+        return -1;
+    }
+
+    offset += sizeof(header);
+
+    if (header[0] != weight_cache_magic || header[1] != weight_cache_version)
+    {
+        NCNN_LOGE("weight cache magic %x version %d not supported", header[0], header[1]);
+        return -1;
+    }
+
+    if (header[6] != layer_count)
+    {
+        NCNN_LOGE("weight cache layer count %d mismatch with %d", header[6], layer_count);
+        return -1;
+    }
+
+    std::vector<weight_cache_entry> weight_cache(layer_count);
+
+    const int entry_count = header[7];
+    for (int i = 0; i < entry_count; i++)
+    {
+        int entry_header[6];
+        if (dr.read(entry_header, sizeof(entry_header)) != sizeof(entry_header))
+        {
+            NCNN_LOGE("read weight cache entry %d failed", i);
+            return -1;
+        }
+
+        offset += sizeof(entry_header);
+
+        const int layer_index = entry_header[0];
+        if (layer_index < 0 || layer_index >= layer_count)
+        {
+            NCNN_LOGE("weight cache entry %d has invalid layer index %d", i, layer_index);
+            return -1;
+        }
+
+        weight_cache_entry& entry = weight_cache[layer_index];
+        entry.typeindex = entry_header[1];
+        entry.checksum = (unsigned int)entry_header[2];
+        entry.param_hash = (uint64_t)(unsigned int)entry_header[3] | (uint64_t)(unsigned int)entry_header[4] << 32;
+        entry.mats.resize(entry_header[5]);
+
+        for (int j = 0; j < entry_header[5]; j++)
+        {
+            int ret = read_weight_cache_mat(dr, offset, entry.mats[j]);
+            if (ret != 0)
+            {
+                NCNN_LOGE("read weight cache entry %d mat %d failed", i, j);
+                return ret;
+            }
+        }
+
+        // the weights were transformed for other params of the layer
+        if (entry.param_hash != d->param_hashes[layer_index])
+        {
+            entry.mats.clear();
+        }
+    }
+
+    d->weight_cache_key.assign(header + 2, header + 7);
+    d->weight_cache = weight_cache;
+
+    return 0;
+}
+
+int Net::load_container(const DataReader& dr)
+{
+    int header[4];
+    if (dr.read(header, sizeof(header)) != sizeof(header))
+    {
+        NCNN_LOGE("read container header failed");
+        return -1;
+    }
+
+    if (header[0] != container_magic || header[1] != container_version)
+    {
+        NCNN_LOGE("container magic %x version %d not supported", header[0], header[1]);
+        return -1;
+    }
+
+    const int section_count = header[2];
+    if (section_count <= 0)
+    {
+        NCNN_LOGE("invalid container section count %d", section_count);
+        return -1;
+    }
+
+    std::vector<container_section> sections(section_count);
+    for (int i = 0; i < section_count; i++)
+    {
+        // type, reserved, 64bit offset, 64bit size
+        int section_header[6];
+        if (dr.read(section_header, sizeof(section_header)) != sizeof(section_header))
+        {
+            NCNN_LOGE("read container section %d failed", i);
+            return -1;
+        }
+
+        sections[i].type = section_header[0];
+        memcpy(&sections[i].offset, section_header + 2, sizeof(int64_t));
+        memcpy(&sections[i].size, section_header + 4, sizeof(int64_t));
+    }
+
+    int64_t offset = sizeof(header) + section_count * sizeof(int) * 6;
+
+    for (int i = 0; i < section_count; i++)
+    {
+        const int type = sections[i].type;
+        const int64_t section_offset = sections[i].offset;
+        const int64_t section_size = sections[i].size;
+
+        // sections are read in file order
+        if (section_offset < offset || section_size < 0)
+        {
+            NCNN_LOGE("invalid container section %d offset %lld", i, (long long)section_offset);
+            return -1;
+        }
+
+        if (skip_data(dr, (size_t)(section_offset - offset)) != 0)
+        {
+            NCNN_LOGE("seek container section %d failed", i);
+            return -1;
+        }
+
+        DataReaderCounting sdr(dr);
+
+        int ret = 0;
+        if (type == container_section_param)
+        {
+            ret = load_param_bin(sdr);
+        }
+#if NCNN_STRING
+        else if (type == container_section_names)
+        {
+            std::vector<char> names((size_t)section_size + 1, '\0');
+            if (sdr.read(names.data(), (size_t)section_size) != (size_t)section_size)
+            {
+                ret = -1;
+            }
+            else
+            {
+                const char* p = names.data();
+                const char* end = p + section_size;
+                for (size_t j = 0; j < d->layers.size() && p < end; j++)
+                {
+                    d->layers[j]->type = std::string(p);
+                    p += strlen(p) + 1;
+                    d->layers[j]->name = std::string(p);
+                    p += strlen(p) + 1;
+                }
+                for (size_t j = 0; j < d->blobs.size() && p < end; j++)
+                {
+                    d->blobs[j].name = std::string(p);
+                    p += strlen(p) + 1;
+                }
+
+                d->update_input_output_names();
+            }
+        }
+#endif // NCNN_STRING
+        else if (type == container_section_weight_cache && opt.use_weight_cache)
+        {
+            ret = load_weight_cache(sdr);
+        }
+        else if (type == container_section_model)
+        {
+            ret = load_model(sdr);
+        }
+
+        if (ret != 0)
+        {
+            NCNN_LOGE("load container section %d type %d failed", i, type);
+            return ret;
+        }
+
+        if (sdr.consumed > (size_t)section_size || skip_data(dr, (size_t)section_size - sdr.consumed) != 0)
+        {
+            NCNN_LOGE("container section %d type %d size mismatch", i, type);
+            return -1;
+        }
+
+        offset = section_offset + section_size;
+    }
+
+    return 0;
+}
+
 #if NCNN_STDIO
 #if NCNN_STRING
 int Net::load_param(FILE* fp)
@@ -1877,31 +4315,167 @@ int Net::load_param_bin(const char* protopath)
     FILE* fp = fopen(protopath, "rb");
     if (!fp)
     {
-        NCNN_LOGE("fopen %s failed", protopath);
+        NCNN_LOGE("fopen %s failed", protopath);
+        return -1;
+    }
+
+    int ret = load_param_bin(fp);
+    fclose(fp);
+    return ret;
+}
+
+int Net::load_model(FILE* fp)
+{
+    DataReaderFromStdio dr(fp);
+    return load_model(dr);
+}
+
+int Net::load_model(const char* modelpath)
+{
+    FILE* fp = fopen(modelpath, "rb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", modelpath);
+        return -1;
+    }
+
+    int ret = load_model(fp);
+    fclose(fp);
+    return ret;
+}
+
+int Net::load_weight_cache(FILE* fp)
+{
+    DataReaderFromStdio dr(fp);
+    return load_weight_cache(dr);
+}
+
+int Net::load_weight_cache(const char* cachepath)
+{
+    FILE* fp = fopen(cachepath, "rb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", cachepath);
+        return -1;
+    }
+
+    int ret = load_weight_cache(fp);
+    fclose(fp);
+    return ret;
+}
+
+int Net::save_weight_cache(FILE* fp) const
+{
+    const int layer_count = (int)d->layers.size();
+
+    if ((int)d->weight_checksums.size() != layer_count)
+    {
+        NCNN_LOGE("weight checksums not ready, enable opt.use_weight_cache before load_model");
+        return -1;
+    }
+
+    // the lazy layers have nothing transformed yet
+    if (d->ensure_all_pipelines() != 0)
+        return -1;
+
+    std::vector<int> layer_indexes;
+    std::vector<std::vector<Mat> > layer_mats;
+    for (int i = 0; i < layer_count; i++)
+    {
+        std::vector<Mat> mats;
+        if (d->layers[i]->save_weight_cache(mats) != 0)
+            continue;
+
+        layer_indexes.push_back(i);
+        layer_mats.push_back(mats);
+    }
+
+    std::vector<int> key;
+    get_weight_cache_key(opt, layer_count, key);
+
+    size_t offset = 0;
+
+    int header[8];
+    header[0] = weight_cache_magic;
+    header[1] = weight_cache_version;
+    header[2] = key[0];
+    header[3] = key[1];
+    header[4] = key[2];
+    header[5] = key[3];
+    header[6] = key[4];
+    header[7] = (int)layer_indexes.size();
+    if (fwrite(header, sizeof(header), 1, fp) != 1)
+    {
+        NCNN_LOGE("write weight cache header failed");
+        return -1;
+    }
+
+    offset += sizeof(header);
+
+    for (size_t i = 0; i < layer_indexes.size(); i++)
+    {
+        const int layer_index = layer_indexes[i];
+        const std::vector<Mat>& mats = layer_mats[i];
+
+        int entry_header[6];
+        entry_header[0] = layer_index;
+        entry_header[1] = d->layers[layer_index]->typeindex;
+        entry_header[2] = (int)d->weight_checksums[layer_index];
+        entry_header[3] = (int)(d->param_hashes[layer_index] & 0xffffffff);
+        entry_header[4] = (int)(d->param_hashes[layer_index] >> 32);
+        entry_header[5] = (int)mats.size();
+        if (fwrite(entry_header, sizeof(entry_header), 1, fp) != 1)
+        {
+            NCNN_LOGE("write weight cache entry %d failed", layer_index);
+            return -1;
+        }
+
+        offset += sizeof(entry_header);
+
+        for (size_t j = 0; j < mats.size(); j++)
+        {
+            int ret = write_weight_cache_mat(fp, offset, mats[j]);
+            if (ret != 0)
+            {
+                NCNN_LOGE("write weight cache entry %d mat %d failed", layer_index, (int)j);
+                return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int Net::save_weight_cache(const char* cachepath) const
+{
+    FILE* fp = fopen(cachepath, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", cachepath);
         return -1;
     }
 
-    int ret = load_param_bin(fp);
+    int ret = save_weight_cache(fp);
     fclose(fp);
     return ret;
 }
 
-int Net::load_model(FILE* fp)
+int Net::load_container(FILE* fp)
 {
     DataReaderFromStdio dr(fp);
-    return load_model(dr);
+    return load_container(dr);
 }
 
-int Net::load_model(const char* modelpath)
+int Net::load_container(const char* containerpath)
 {
-    FILE* fp = fopen(modelpath, "rb");
+    FILE* fp = fopen(containerpath, "rb");
     if (!fp)
     {
-        NCNN_LOGE("fopen %s failed", modelpath);
+        NCNN_LOGE("fopen %s failed", containerpath);
         return -1;
     }
 
-    int ret = load_model(fp);
+    int ret = load_container(fp);
     fclose(fp);
     return ret;
 }
@@ -1923,6 +4497,20 @@ int Net::load_model(const unsigned char* _mem)
     return static_cast<int>(mem - _mem);
 }
 
+int Net::load_weight_cache(const unsigned char* _mem)
+{
+    const unsigned char* mem = _mem;
+    DataReaderFromMemory dr(mem);
+    return load_weight_cache(dr);
+}
+
+int Net::load_container(const unsigned char* _mem)
+{
+    const unsigned char* mem = _mem;
+    DataReaderFromMemory dr(mem);
+    return load_container(dr);
+}
+
 #if NCNN_PLATFORM_API
 #if __ANDROID_API__ >= 9
 #if NCNN_STRING
@@ -1991,6 +4579,14 @@ int Net::load_model(AAssetManager* mgr, const char* assetpath)
 
 void Net::clear()
 {
+    // the pooled extractors release their blobs before the layers go
+    for (size_t i = 0; i < d->pooled_extractors.size(); i++)
+    {
+        delete d->pooled_extractors[i];
+    }
+    d->pooled_extractors.clear();
+    d->idle_extractors.clear();
+
     d->blobs.clear();
     for (size_t i = 0; i < d->layers.size(); i++)
     {
@@ -2004,7 +4600,10 @@ void Net::clear()
         }
 #endif // NCNN_VULKAN
 
-        int dret = layer->destroy_pipeline(opt1);
+        // the lazy layer never reached has no pipeline
+        bool pipeline_created = d->pipeline_pending.empty() || d->pipeline_pending[i] == 0;
+
+        int dret = pipeline_created ? layer->destroy_pipeline(opt1) : 0;
         if (dret != 0)
         {
             NCNN_LOGE("layer destroy_pipeline failed");
@@ -2049,6 +4648,40 @@ void Net::clear()
     }
     d->layers.clear();
 
+    d->tile_chains.clear();
+    d->tile_chain_of_tail.clear();
+    d->split_packing_plan.clear();
+    d->split_packing_removed_repacks = 0;
+    d->channel_view_layers.clear();
+    d->channel_view_blobs.clear();
+    d->concat_view_shapes.clear();
+
+    d->weight_checksums.clear();
+    d->weight_hashes.clear();
+    d->param_hashes.clear();
+    d->weight_cache_key.clear();
+    d->weight_cache.clear();
+
+    d->pipeline_pending.clear();
+    d->lazy_use_weight_cache = false;
+    d->huge_page_weights.clear();
+
+    d->layer_weight_bytes.clear();
+    d->layer_pipeline_weight_bytes.clear();
+    d->loaded_weights.clear();
+
+    // the layers are gone, so are their references to the shared weights
+    prune_shared_weights();
+
+    for (size_t i = 0; i < d->shape_buckets.size(); i++)
+    {
+        delete d->shape_buckets[i]->blob_allocator;
+        delete d->shape_buckets[i]->workspace_allocator;
+        delete d->shape_buckets[i];
+    }
+    d->shape_buckets.clear();
+    d->shape_bucket_outputs.clear();
+
     if (d->local_blob_allocator)
     {
         delete d->local_blob_allocator;
@@ -2059,6 +4692,13 @@ void Net::clear()
         delete d->local_workspace_allocator;
         d->local_workspace_allocator = 0;
     }
+    for (size_t i = 0; i < d->numa_blob_allocators.size(); i++)
+    {
+        delete d->numa_blob_allocators[i];
+        delete d->numa_workspace_allocators[i];
+    }
+    d->numa_blob_allocators.clear();
+    d->numa_workspace_allocators.clear();
 
 #if NCNN_VULKAN
     if (d->weight_vkallocator)
@@ -2117,6 +4757,106 @@ const std::vector<Layer*>& Net::layers() const
     return d->layers;
 }
 
+void Net::set_split_output_packing(bool enable)
+{
+    d->use_split_output_packing = enable;
+}
+
+void Net::set_numa_interleaved_weights(bool enable)
+{
+    d->use_numa_interleaved_weights = enable;
+}
+
+void Net::set_huge_page_weights(bool enable)
+{
+    d->use_huge_page_weights = enable;
+}
+
+void Net::set_shared_weight_store(bool enable)
+{
+    d->use_shared_weight_store = enable;
+}
+
+void Net::set_shape_bucket(int step_w, int step_h, float pad_value)
+{
+    d->shape_bucket_w = step_w;
+    d->shape_bucket_h = step_h;
+    d->shape_bucket_pad_value = pad_value;
+}
+
+#if NCNN_STRING
+int Net::set_shape_bucket_output(const char* output_name, const char* input_name, int stride_w, int stride_h)
+{
+    int output_blob_index = find_blob_index_by_name(output_name);
+    if (output_blob_index == -1)
+        return -1;
+
+    int input_blob_index = find_blob_index_by_name(input_name);
+    if (input_blob_index == -1)
+        return -1;
+
+    return set_shape_bucket_output(output_blob_index, input_blob_index, stride_w, stride_h);
+}
+#endif // NCNN_STRING
+
+int Net::set_shape_bucket_output(int output_blob_index, int input_blob_index, int stride_w, int stride_h)
+{
+    if (output_blob_index < 0 || output_blob_index >= (int)d->blobs.size() || input_blob_index < 0 || input_blob_index >= (int)d->blobs.size())
+        return -1;
+
+    if (stride_w <= 0 || stride_h <= 0)
+    {
+        NCNN_LOGE("set_shape_bucket_output invalid stride %d %d", stride_w, stride_h);
+        return -1;
+    }
+
+    shape_bucket_output bucket_output = {output_blob_index, input_blob_index, stride_w, stride_h};
+
+    for (size_t i = 0; i < d->shape_bucket_outputs.size(); i++)
+    {
+        if (d->shape_bucket_outputs[i].blob_index == output_blob_index && d->shape_bucket_outputs[i].input_blob_index == input_blob_index)
+        {
+            d->shape_bucket_outputs[i] = bucket_output;
+            return 0;
+        }
+    }
+
+    d->shape_bucket_outputs.push_back(bucket_output);
+
+    return 0;
+}
+
+int Net::split_packing_removed_repacks() const
+{
+    return d->split_packing_removed_repacks;
+}
+
+size_t Net::huge_page_weight_bytes() const
+{
+    MutexLockGuard lock(d->pipeline_lock);
+
+    if (d->huge_page_weights.empty())
+        return 0;
+
+    return get_huge_page_weight_allocator()->get_huge_page_bytes(d->huge_page_weights);
+}
+
+size_t Net::layer_weight_bytes(int layer_index) const
+{
+    if (layer_index < 0 || layer_index >= (int)d->layer_weight_bytes.size())
+        return 0;
+
+    return d->layer_weight_bytes[layer_index];
+}
+
+size_t Net::layer_pipeline_weight_bytes(int layer_index) const
+{
+    if (layer_index < 0 || layer_index >= (int)d->layer_pipeline_weight_bytes.size())
+        return 0;
+
+    return d->layer_pipeline_weight_bytes[layer_index];
+}
+
 std::vector<Blob>& Net::mutable_blobs()
 {
     return d->blobs;
@@ -2252,10 +4992,32 @@ public:
     ExtractorPrivate(const Net* _net)
         : net(_net)
     {
+        numa_node = -1;
+        peak_blob_bytes = 0;
+        peak_workspace_bytes = 0;
+        use_buffer_cache = false;
+        cache_blob_allocator = 0;
+        cache_workspace_allocator = 0;
+        bucket = 0;
     }
     const Net* net;
     std::vector<Mat> blob_mats;
     Option opt;
+    int numa_node;
+
+    // the buffer cache enabled by reset
+    // replaces the local pool allocators of the net, the allocators set by user are left alone
+    bool use_buffer_cache;
+    PoolAllocator* cache_blob_allocator;
+    PoolAllocator* cache_workspace_allocator;
+
+    // the shape bucket of the first bucketed input and the inputs padded to their buckets
+    shape_bucket* bucket;
+    std::vector<shape_bucket_input> bucket_inputs;
+
+    // the high-water marks of the local pools in the last extract
+    size_t peak_blob_bytes;
+    size_t peak_workspace_bytes;
 
 #if NCNN_VULKAN
     VkAllocator* local_blob_vkallocator;
@@ -2266,6 +5028,84 @@ public:
 #endif // NCNN_VULKAN
 };
 
+Extractor* Net::acquire_extractor() const
+{
+    MutexLockGuard lock(d->extractor_pool_lock);
+
+    if (!d->idle_extractors.empty())
+    {
+        Extractor* ex = d->idle_extractors.back();
+        d->idle_extractors.pop_back();
+        return ex;
+    }
+
+    Extractor* ex = new Extractor(this, d->blobs.size());
+    ex->reset();
+    d->pooled_extractors.push_back(ex);
+
+    return ex;
+}
+
+int Net::reclaim_extractor(Extractor* ex) const
+{
+    if (!ex)
+        return -1;
+
+    MutexLockGuard lock(d->extractor_pool_lock);
+
+    bool pooled = false;
+    for (size_t i = 0; i < d->pooled_extractors.size(); i++)
+    {
+        if (d->pooled_extractors[i] == ex)
+        {
+            pooled = true;
+            break;
+        }
+    }
+
+    if (!pooled || ex->d->net != this)
+    {
+        NCNN_LOGE("reclaim_extractor %p not acquired from this net", ex);
+        return -1;
+    }
+
+    for (size_t i = 0; i < d->idle_extractors.size(); i++)
+    {
+        if (d->idle_extractors[i] == ex)
+        {
+            NCNN_LOGE("reclaim_extractor %p already reclaimed", ex);
+            return -1;
+        }
+    }
+
+    ex->reset();
+
+    // back to the settings of a fresh extractor, the buffer cache stays
+    ex->d->opt = opt;
+    ex->d->numa_node = -1;
+
+#if NCNN_VULKAN
+    if (opt.use_vulkan_compute)
+    {
+        // keep the local vulkan allocators acquired by the extractor
+        if (ex->d->local_blob_vkallocator && !opt.blob_vkallocator)
+        {
+            ex->d->opt.blob_vkallocator = ex->d->local_blob_vkallocator;
+            if (!opt.workspace_vkallocator)
+                ex->d->opt.workspace_vkallocator = ex->d->local_blob_vkallocator;
+        }
+        if (ex->d->local_staging_vkallocator && !opt.staging_vkallocator)
+        {
+            ex->d->opt.staging_vkallocator = ex->d->local_staging_vkallocator;
+        }
+    }
+#endif // NCNN_VULKAN
+
+    d->idle_extractors.push_back(ex);
+
+    return 0;
+}
+
 Extractor::Extractor(const Net* _net, size_t blob_count)
     : d(new ExtractorPrivate(_net))
 {
@@ -2288,6 +5128,9 @@ Extractor::~Extractor()
 {
     clear();
 
+    delete d->cache_blob_allocator;
+    delete d->cache_workspace_allocator;
+
     delete d;
 }
 
@@ -2297,6 +5140,15 @@ Extractor::Extractor(const Extractor& rhs)
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
     d->opt = rhs.d->opt;
+    d->numa_node = rhs.d->numa_node;
+    d->bucket = rhs.d->bucket;
+    d->bucket_inputs = rhs.d->bucket_inputs;
+
+    // the buffer cache belongs to rhs
+    if (d->opt.blob_allocator == rhs.d->cache_blob_allocator)
+        d->opt.blob_allocator = 0;
+    if (d->opt.workspace_allocator == rhs.d->cache_workspace_allocator)
+        d->opt.workspace_allocator = 0;
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2315,6 +5167,15 @@ Extractor& Extractor::operator=(const Extractor& rhs)
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
     d->opt = rhs.d->opt;
+    d->numa_node = rhs.d->numa_node;
+    d->bucket = rhs.d->bucket;
+    d->bucket_inputs = rhs.d->bucket_inputs;
+
+    // the buffer cache belongs to rhs
+    if (d->opt.blob_allocator == rhs.d->cache_blob_allocator)
+        d->opt.blob_allocator = 0;
+    if (d->opt.workspace_allocator == rhs.d->cache_workspace_allocator)
+        d->opt.workspace_allocator = 0;
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2331,6 +5192,14 @@ void Extractor::clear()
 {
     d->blob_mats.clear();
 
+    d->bucket = 0;
+    d->bucket_inputs.clear();
+
+    if (d->cache_blob_allocator)
+        d->cache_blob_allocator->clear();
+    if (d->cache_workspace_allocator)
+        d->cache_workspace_allocator->clear();
+
 #if NCNN_VULKAN
     if (d->opt.use_vulkan_compute)
     {
@@ -2349,6 +5218,27 @@ void Extractor::clear()
 #endif // NCNN_VULKAN
 }
 
+void Extractor::reset()
+{
+    d->blob_mats.clear();
+    d->blob_mats.resize(d->net->blobs().size());
+
+    d->bucket = 0;
+    d->bucket_inputs.clear();
+
+#if NCNN_VULKAN
+    if (d->opt.use_vulkan_compute)
+    {
+        d->blob_mats_gpu.clear();
+        d->blob_mats_gpu.resize(d->net->blobs().size());
+        d->blob_mats_gpu_image.clear();
+        d->blob_mats_gpu_image.resize(d->net->blobs().size());
+    }
+#endif // NCNN_VULKAN
+
+    d->use_buffer_cache = true;
+}
+
 void Extractor::set_light_mode(bool enable)
 {
     d->opt.lightmode = enable;
@@ -2359,6 +5249,34 @@ void Extractor::set_num_threads(int num_threads)
     d->opt.num_threads = num_threads;
 }
 
+void Extractor::set_numa_node(int node)
+{
+    if (node >= get_cpu_numa_node_count())
+    {
+        NCNN_LOGE("set_numa_node failed, numa node %d not found", node);
+        return;
+    }
+
+    d->numa_node = node;
+
+    if (node >= 0)
+    {
+        const int node_cpu_count = get_cpu_numa_node_affinity_mask(node).num_enabled();
+        if (d->opt.num_threads > node_cpu_count)
+            d->opt.num_threads = node_cpu_count;
+    }
+}
+
+size_t Extractor::peak_blob_bytes() const
+{
+    return d->peak_blob_bytes;
+}
+
+size_t Extractor::peak_workspace_bytes() const
+{
+    return d->peak_workspace_bytes;
+}
+
 void Extractor::set_blob_allocator(Allocator* allocator)
 {
     d->opt.blob_allocator = allocator;
@@ -2441,41 +5359,163 @@ int Extractor::input(int blob_index, const Mat& in)
     if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
         return -1;
 
+    // forget the padding of the previous input to this blob
+    for (size_t i = 0; i < d->bucket_inputs.size(); i++)
+    {
+        if (d->bucket_inputs[i].blob_index == blob_index)
+        {
+            d->bucket_inputs.erase(d->bucket_inputs.begin() + i);
+            break;
+        }
+    }
+
+    if (in.dims == 3 && (d->net->d->shape_bucket_w > 0 || d->net->d->shape_bucket_h > 0))
+    {
+        const int bucket_w = d->net->d->shape_bucket_w > 0 ? (in.w + d->net->d->shape_bucket_w - 1) / d->net->d->shape_bucket_w * d->net->d->shape_bucket_w : in.w;
+        const int bucket_h = d->net->d->shape_bucket_h > 0 ? (in.h + d->net->d->shape_bucket_h - 1) / d->net->d->shape_bucket_h * d->net->d->shape_bucket_h : in.h;
+
+        // the first bucketed input picks the local pools
+        if (!d->bucket && d->opt.use_local_pool_allocator)
+        {
+            d->bucket = d->net->d->get_shape_bucket(bucket_w, bucket_h);
+        }
+
+        if (bucket_w != in.w || bucket_h != in.h)
+        {
+            Option opt_pad = d->opt;
+            if (d->bucket && !d->use_buffer_cache && d->numa_node < 0 && (!opt_pad.blob_allocator || d->net->d->find_local_pool_allocator(opt_pad.blob_allocator)))
+            {
+                opt_pad.blob_allocator = d->bucket->blob_allocator;
+            }
+
+            Mat in_padded;
+            copy_make_border(in, in_padded, 0, bucket_h - in.h, 0, bucket_w - in.w, BORDER_CONSTANT, d->net->d->shape_bucket_pad_value, opt_pad);
+            if (in_padded.empty())
+                return -100;
+
+            d->blob_mats[blob_index] = in_padded;
+
+            shape_bucket_input bucket_input = {blob_index, in.w, in.h};
+            d->bucket_inputs.push_back(bucket_input);
+
+            return 0;
+        }
+    }
+
     d->blob_mats[blob_index] = in;
 
     return 0;
 }
 
+static bool is_same_cpu_set(const CpuSet& a, const CpuSet& b)
+{
+    const int cpu_count = get_cpu_count();
+    for (int i = 0; i < cpu_count; i++)
+    {
+        if (a.is_enabled(i) != b.is_enabled(i))
+            return false;
+    }
+
+    return true;
+}
+
 int Extractor::extract(int blob_index, Mat& feat, int type)
 {
     if (blob_index < 0 || blob_index >= (int)d->blob_mats.size())
         return -1;
 
+    if (d->blob_mats[blob_index].dims == 0 && d->net->blobs()[blob_index].producer == -1)
+    {
+        NCNN_LOGE("blob %d has no producer, it may have been fused into its consumer", blob_index);
+        return -1;
+    }
+
     int old_blocktime = get_kmp_blocktime();
     set_kmp_blocktime(d->opt.openmp_blocktime);
 
     int old_flush_denormals = get_flush_denormals();
     set_flush_denormals(d->opt.flush_denormals);
 
+    // set_cpu_thread_affinity also resets the openmp thread count of the caller
+    CpuSet old_thread_affinity;
+    int old_omp_num_threads = 0;
+    bool restore_thread_affinity = false;
+
     int ret = 0;
 
     if (d->blob_mats[blob_index].dims == 0)
     {
         int layer_index = d->net->blobs()[blob_index].producer;
 
+        if (d->numa_node >= 0)
+        {
+            // run on the cpus of the node, the affinity of the calling thread is restored before returning
+            // nothing to bind when the calling thread already runs on exactly these cpus
+            const CpuSet& node_mask = get_cpu_numa_node_affinity_mask(d->numa_node);
+            if (get_cpu_thread_affinity(old_thread_affinity) == 0 && !is_same_cpu_set(old_thread_affinity, node_mask))
+            {
+                old_omp_num_threads = get_omp_num_threads();
+                restore_thread_affinity = set_cpu_thread_affinity(node_mask) == 0;
+            }
+        }
+
+        if (d->use_buffer_cache)
+        {
+            // take over from the local pool allocators of the net
+            if (!d->opt.blob_allocator || d->net->d->find_local_pool_allocator(d->opt.blob_allocator))
+            {
+                if (!d->cache_blob_allocator)
+                {
+                    d->cache_blob_allocator = new PoolAllocator;
+                    d->cache_blob_allocator->set_size_compare_ratio(0.f);
+                }
+                d->opt.blob_allocator = d->cache_blob_allocator;
+            }
+            if (!d->opt.workspace_allocator || d->net->d->find_local_pool_allocator(d->opt.workspace_allocator))
+            {
+                if (!d->cache_workspace_allocator)
+                {
+                    d->cache_workspace_allocator = new PoolAllocator;
+                    d->cache_workspace_allocator->set_size_compare_ratio(0.f);
+                }
+                d->opt.workspace_allocator = d->cache_workspace_allocator;
+            }
+        }
+
+        if (d->bucket && !d->use_buffer_cache && d->numa_node < 0)
+        {
+            // the local pools of the shape bucket
+            if (!d->opt.blob_allocator || d->net->d->find_local_pool_allocator(d->opt.blob_allocator))
+            {
+                d->opt.blob_allocator = d->bucket->blob_allocator;
+            }
+            if (!d->opt.workspace_allocator || d->net->d->find_local_pool_allocator(d->opt.workspace_allocator))
+            {
+                d->opt.workspace_allocator = d->bucket->workspace_allocator;
+            }
+        }
+
         // use local allocator
         if (d->opt.use_local_pool_allocator)
         {
+            const bool use_numa_allocator = d->numa_node >= 0 && d->numa_node < (int)d->net->d->numa_blob_allocators.size();
             if (!d->opt.blob_allocator)
             {
-                d->opt.blob_allocator = d->net->d->local_blob_allocator;
+                d->opt.blob_allocator = use_numa_allocator ? d->net->d->numa_blob_allocators[d->numa_node] : d->net->d->local_blob_allocator;
             }
             if (!d->opt.workspace_allocator)
             {
-                d->opt.workspace_allocator = d->net->d->local_workspace_allocator;
+                d->opt.workspace_allocator = use_numa_allocator ? d->net->d->numa_workspace_allocators[d->numa_node] : d->net->d->local_workspace_allocator;
             }
         }
 
+        PoolAllocator* blob_pool = d->opt.blob_allocator == d->cache_blob_allocator ? d->cache_blob_allocator : d->net->d->find_local_pool_allocator(d->opt.blob_allocator);
+        PoolAllocator* workspace_pool = d->opt.workspace_allocator == d->cache_workspace_allocator ? d->cache_workspace_allocator : d->net->d->find_local_pool_allocator(d->opt.workspace_allocator);
+        if (blob_pool)
+            blob_pool->reset_peak_payout_bytes();
+        if (workspace_pool)
+            workspace_pool->reset_peak_payout_bytes();
+
 #if NCNN_VULKAN
         if (d->opt.use_vulkan_compute)
         {
@@ -2563,10 +5603,23 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
 #else
         ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
 #endif // NCNN_VULKAN
+
+        d->peak_blob_bytes = blob_pool ? blob_pool->get_peak_payout_bytes() : 0;
+        d->peak_workspace_bytes = workspace_pool ? workspace_pool->get_peak_payout_bytes() : 0;
     }
 
     feat = d->blob_mats[blob_index];
 
+    if (!d->net->d->channel_view_layers.empty() && feat.data && !feat.refcount)
+    {
+        // a channel range of a concat output or slice input owned by this extractor
+        const int producer = d->net->blobs()[blob_index].producer;
+        if (producer != -1 && d->net->layers()[producer]->typeindex != LayerType::Input)
+        {
+            feat = feat.clone();
+        }
+    }
+
     if (d->opt.use_packing_layout && (type == 0) && feat.elempack != 1)
     {
         Mat bottom_blob_unpacked;
@@ -2609,12 +5662,65 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
     // *INDENT-ON*
     // clang-format on
 
-    if (d->opt.use_local_pool_allocator && feat.allocator == d->net->d->local_blob_allocator)
+    if (!d->bucket_inputs.empty() && (feat.dims == 2 || feat.dims == 3))
+    {
+        // crop a padded input back to its own shape
+        // and a registered output to the unpadded shape of its input over the stride
+        // the rows of a packed 2d blob are counted in elements, as copy_cut_border does
+        const int feath = feat.dims == 2 ? feat.h * feat.elempack : feat.h;
+        int outw = feat.w;
+        int outh = feath;
+        for (size_t i = 0; i < d->bucket_inputs.size(); i++)
+        {
+            const shape_bucket_input& bucket_input = d->bucket_inputs[i];
+            if (bucket_input.blob_index == blob_index)
+            {
+                outw = bucket_input.w < outw ? bucket_input.w : outw;
+                outh = bucket_input.h < outh ? bucket_input.h : outh;
+            }
+
+            const std::vector<shape_bucket_output>& bucket_outputs = d->net->d->shape_bucket_outputs;
+            for (size_t j = 0; j < bucket_outputs.size(); j++)
+            {
+                const shape_bucket_output& bucket_output = bucket_outputs[j];
+                if (bucket_output.blob_index == blob_index && bucket_output.input_blob_index == bucket_input.blob_index)
+                {
+                    const int cropw = (bucket_input.w + bucket_output.stride_w - 1) / bucket_output.stride_w;
+                    const int croph = (bucket_input.h + bucket_output.stride_h - 1) / bucket_output.stride_h;
+                    outw = cropw < outw ? cropw : outw;
+                    outh = croph < outh ? croph : outh;
+                }
+            }
+        }
+
+        if (outw < feat.w || outh < feath)
+        {
+            Mat feat_cropped;
+            copy_cut_border(feat, feat_cropped, 0, feath - outh, 0, feat.w - outw, d->opt);
+            if (feat_cropped.empty())
+                ret = -100;
+            feat = feat_cropped;
+        }
+    }
+
+    if (d->opt.use_local_pool_allocator && d->net->d->find_local_pool_allocator(feat.allocator))
     {
         // detach the returned mat from local pool allocator
         // so we could destroy net instance much earlier
         feat = feat.clone();
     }
+    else if (d->cache_blob_allocator && feat.allocator == d->cache_blob_allocator)
+    {
+        // detach the returned mat from the buffer cache
+        // so we could reset and destroy this extractor much earlier
+        feat = feat.clone();
+    }
+
+    if (restore_thread_affinity)
+    {
+        set_cpu_thread_affinity(old_thread_affinity);
+        set_omp_num_threads(old_omp_num_threads);
+    }
 
     set_kmp_blocktime(old_blocktime);
     set_flush_denormals(old_flush_denormals);
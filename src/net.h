@@ -57,6 +57,39 @@ public:
     const VulkanDevice* vulkan_device() const;
 #endif // NCNN_VULKAN
 
+    // choose at load time the packing each Split converts its input to
+    // so that a blob fanned out to several consumers is repacked once instead of once per consumer
+    // only the elempack of the Split outputs is chosen, the 16bit storage casts stay where they are
+    // the choice minimizes the count of repacks around each Split, not the bytes repacked
+    // call before load_model, disabled by default
+    void set_split_output_packing(bool enable);
+
+    // spread the pages of the transformed weights over all numa nodes after create_pipeline
+    // so that extractors bound to any node see the same memory bandwidth
+    // no-op on single node machines
+    // call before load_model, disabled by default
+    void set_numa_interleaved_weights(bool enable);
+
+    // move the transformed weights onto transparent huge pages after create_pipeline
+    // large weights take fewer dTLB entries, linux only
+    // call before load_model, disabled by default
+    void set_huge_page_weights(bool enable);
+
+    // share the transformed weights with the other nets of the process in a read-only store
+    // keyed by the weight and param checksums, the blob shapes and the options steering the transform
+    // so that loading the same model again references the weights instead of transforming another copy
+    // call before load_model, disabled by default
+    void set_shared_weight_store(bool enable);
+
+    // round the width and height of 3 dims inputs up to a multiple of these steps in the extractor
+    // the inputs are padded on the right and bottom with pad_value
+    // the input blobs are extracted without the padding
+    // the outputs registered with set_shape_bucket_output are cropped back to the unpadded shape
+    // each bucket keeps its own local blob pools and concat plans
+    // so that a few buckets serve arbitrary input shapes with steady memory and latency
+    // call before create_extractor, 0 to disable, disabled by default
+    void set_shape_bucket(int step_w, int step_h, float pad_value = 0.f);
+
 #if NCNN_STRING
     // register custom layer or overwrite built-in layer by layer type name
     // return 0 if success
@@ -75,6 +108,10 @@ public:
 
     int load_model(const DataReader& dr);
 
+    int load_weight_cache(const DataReader& dr);
+
+    int load_container(const DataReader& dr);
+
 #if NCNN_STDIO
 #if NCNN_STRING
     // load network structure from plain param file
@@ -92,6 +129,26 @@ public:
     // return 0 if success
     int load_model(FILE* fp);
     int load_model(const char* modelpath);
+
+    // load the transformed weights saved by save_weight_cache
+    // call after load_param and before load_model with opt.use_weight_cache enabled
+    // the cached layers skip the weight transform in load_model
+    // the cache is ignored if it was saved with another cpu, thread count or option
+    // return 0 if success
+    int load_weight_cache(FILE* fp);
+    int load_weight_cache(const char* cachepath);
+
+    // save the weights transformed in load_model with opt.use_weight_cache enabled
+    // return 0 if success
+    int save_weight_cache(FILE* fp) const;
+    int save_weight_cache(const char* cachepath) const;
+
+    // load network structure, names, weight data and the optional weight cache
+    // from a single-file container made by ncnn2container
+    // the weight cache section is used only if opt.use_weight_cache enabled
+    // return 0 if success
+    int load_container(FILE* fp);
+    int load_container(const char* containerpath);
 #endif // NCNN_STDIO
 
     // load network structure from external memory
@@ -106,6 +163,20 @@ public:
     // return bytes consumed
     int load_model(const unsigned char* mem);
 
+    // reference transformed weights from external memory, such as a mmap-ed weight cache file
+    // weight data is not copied but referenced
+    // so external memory should be retained when used
+    // memory pointer should be 64-byte aligned, otherwise weight data is copied
+    // return 0 if success
+    int load_weight_cache(const unsigned char* mem);
+
+    // load network from a single-file container in external memory, such as a mmap-ed container file
+    // weight data is not copied but referenced
+    // so external memory should be retained when used
+    // memory pointer should be 64-byte aligned
+    // return 0 if success
+    int load_container(const unsigned char* mem);
+
 #if NCNN_PLATFORM_API
 #if __ANDROID_API__ >= 9
 #if NCNN_STRING
@@ -129,6 +200,15 @@ public:
     // construct an Extractor from network
     Extractor create_extractor() const;
 
+    // take an extractor from the extractor pool of network, a new one is made if the pool is empty
+    // the pooled extractors keep their blob and workspace buffers warm across requests
+    // return it with reclaim_extractor when the request is done, the settings are restored on reclaim
+    // thread-safe, the pooled extractors are destroyed in clear()
+    Extractor* acquire_extractor() const;
+
+    // return 0 if success, -1 if ex is not acquired from this net or already reclaimed
+    int reclaim_extractor(Extractor* ex) const;
+
     // get input/output indexes/names
     const std::vector<int>& input_indexes() const;
     const std::vector<int>& output_indexes() const;
@@ -143,6 +223,31 @@ public:
     std::vector<Blob>& mutable_blobs();
     std::vector<Layer*>& mutable_layers();
 
+    // crop an output back to the unpadded shape of an input padded by set_shape_bucket
+    // the output keeps ceil(w / stride_w) columns and ceil(h / stride_h) rows of the input
+    // outputs not registered are extracted with the padding
+    // call after load_param
+    // return 0 if success
+#if NCNN_STRING
+    int set_shape_bucket_output(const char* output_name, const char* input_name, int stride_w, int stride_h);
+#endif // NCNN_STRING
+    int set_shape_bucket_output(int output_blob_index, int input_blob_index, int stride_w, int stride_h);
+
+    // the count of repacks removed by set_split_output_packing in load_model
+    // one for each Split input or consumer that no longer repacks, whatever the blob size
+    int split_packing_removed_repacks() const;
+
+    // the bytes of transformed weights backed by huge pages with set_huge_page_weights
+    // lazy pipelines add theirs on the first forward
+    size_t huge_page_weight_bytes() const;
+
+    // weight bytes of a layer loaded from the model and held after create_pipeline
+    // the held bytes are the transformed weights the layer exports for the weight cache
+    // plus the loaded weights it still keeps, weights referencing external memory are not held
+    // lazy pipelines hold zero bytes until created
+    size_t layer_weight_bytes(int layer_index) const;
+    size_t layer_pipeline_weight_bytes(int layer_index) const;
+
 protected:
     friend class Extractor;
 #if NCNN_STRING
@@ -177,6 +282,12 @@ public:
     // clear blob mats and alloctors
     void clear();
 
+    // clear blob mats for the next input, the settings are kept
+    // the blob and workspace memory is taken from a buffer cache of this extractor from now on
+    // so that the buffers of the last extract are reused instead of allocated again
+    // the mats extracted afterwards are detached from the buffer cache and outlive the extractor
+    void reset();
+
     // enable light mode
     // intermediate blob will be recycled when enabled
     // enabled by default
@@ -187,6 +298,20 @@ public:
     // default count is system depended
     void set_num_threads(int num_threads);
 
+    // bind this extractor to a numa node
+    // the threads run on the cpus of the node during extract and the local blob memory is pooled per node
+    // the thread affinity and openmp thread count of the caller are restored when extract returns
+    // the threads are bound again on each extract, there is no persistent thread pool per node
+    // thread count is capped to the cpu count of the node, call after set_num_threads
+    // -1 = not bound(default)
+    void set_numa_node(int node);
+
+    // the high-water marks of blob and workspace memory during the last extract that ran layers
+    // measured on the local pool allocators or the buffer cache, 0 with the allocators set by user
+    // the pools are shared by the extractors of a net, extract one at a time for exact figures
+    size_t peak_blob_bytes() const;
+    size_t peak_workspace_bytes() const;
+
     // set blob memory allocator
     void set_blob_allocator(Allocator* allocator);
 
@@ -262,7 +387,7 @@ public:
 #endif // NCNN_VULKAN
 
 protected:
-    friend Extractor Net::create_extractor() const;
+    friend class Net;
     Extractor(const Net* net, size_t blob_count);
 
 private:
@@ -60,7 +60,7 @@ Option::Option()
     use_image_storage = false;
     use_tensor_storage = false;
 
-    use_reserved_0 = false;
+    use_sparse_weight = false;
 
     flush_denormals = 3;
 
@@ -74,6 +74,12 @@ Option::Option()
     use_winograd63_convolution = true;
 
     use_a53_a55_optimized_kernel = is_current_thread_running_on_a53_a55();
+
+    use_layer_fusion = false;
+    use_depth_first_tiling = false;
+    use_weight_cache = false;
+    use_lazy_pipeline = false;
+    use_zero_copy_concat_slice = false;
 }
 
 } // namespace ncnn
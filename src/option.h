@@ -117,7 +117,10 @@ public:
     bool use_image_storage;
     bool use_tensor_storage;
 
-    bool use_reserved_0;
+    // pack the weights of innerproduct and 1x1 convolution into a block sparse format at load time
+    // when at least half of the weight blocks are all zero, as in pruned models
+    // applies to fp32 weights only
+    bool use_sparse_weight;
 
     // enable DAZ(Denormals-Are-Zero) and FTZ(Flush-To-Zero)
     // default value is 3
@@ -144,11 +147,25 @@ public:
     // but you can force this on/off if you wish
     bool use_a53_a55_optimized_kernel;
 
-    bool use_reserved_7;
-    bool use_reserved_8;
-    bool use_reserved_9;
-    bool use_reserved_10;
-    bool use_reserved_11;
+    // fuse activation and residual add into the preceding layer at load time
+    // the intermediate blobs of fused layers can not be extracted anymore
+    bool use_layer_fusion;
+
+    // run chains of convolution and elementwise layers band by band
+    // so that the intermediate blobs of one band stay in level2 cache
+    bool use_depth_first_tiling;
+
+    // checksum the weights in load_model
+    // so that the transformed weights can be saved to and loaded from a weight cache
+    bool use_weight_cache;
+
+    // defer create_pipeline of each layer to the first forward that reaches it
+    // so that the branches never extracted keep only their raw weights
+    bool use_lazy_pipeline;
+
+    // in light mode, let the producers of a channel concat write into its output
+    // and let the outputs of a channel slice point into its input
+    bool use_zero_copy_concat_slice;
 };
 
 } // namespace ncnn
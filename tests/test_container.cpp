@@ -0,0 +1,283 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "layer_type.h"
+#include "net.h"
+#include "testutil.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static const char net_param[] = "7767517\n"
+                                "3 3\n"
+                                "Input            data     0 1 data\n"
+                                "Convolution      conv0    1 1 data c0 0=24 1=3 4=1 5=1 6=648\n"
+                                "ReLU             relu0    1 1 c0 output\n";
+
+static void append_int(std::vector<unsigned char>& data, int v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    data.insert(data.end(), p, p + sizeof(int));
+}
+
+static void append_string(std::vector<unsigned char>& data, const char* s)
+{
+    data.insert(data.end(), s, s + strlen(s) + 1);
+}
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+// the binary form of net_param
+static void make_param_bin(std::vector<unsigned char>& parambin, std::vector<unsigned char>& names)
+{
+    append_int(parambin, 7767517);
+    append_int(parambin, 3);
+    append_int(parambin, 3);
+
+    append_int(parambin, ncnn::LayerType::Input);
+    append_int(parambin, 0);
+    append_int(parambin, 1);
+    append_int(parambin, 0);
+    append_int(parambin, -233);
+
+    append_int(parambin, ncnn::LayerType::Convolution);
+    append_int(parambin, 1);
+    append_int(parambin, 1);
+    append_int(parambin, 0);
+    append_int(parambin, 1);
+    append_int(parambin, 0);
+    append_int(parambin, 24);
+    append_int(parambin, 1);
+    append_int(parambin, 3);
+    append_int(parambin, 4);
+    append_int(parambin, 1);
+    append_int(parambin, 5);
+    append_int(parambin, 1);
+    append_int(parambin, 6);
+    append_int(parambin, 648);
+    append_int(parambin, -233);
+
+    append_int(parambin, ncnn::LayerType::ReLU);
+    append_int(parambin, 1);
+    append_int(parambin, 1);
+    append_int(parambin, 1);
+    append_int(parambin, 2);
+    append_int(parambin, -233);
+
+    append_string(names, "Input");
+    append_string(names, "data");
+    append_string(names, "Convolution");
+    append_string(names, "conv0");
+    append_string(names, "ReLU");
+    append_string(names, "relu0");
+    append_string(names, "data");
+    append_string(names, "c0");
+    append_string(names, "output");
+}
+
+// the layout written by ncnn2container
+static void make_container(const std::vector<int>& types, const std::vector<const std::vector<unsigned char>*>& datas, ncnn::Mat& container)
+{
+    const int section_count = (int)types.size();
+
+    std::vector<unsigned char> data;
+    append_int(data, 0x6e636e63);
+    append_int(data, 1);
+    append_int(data, section_count);
+    append_int(data, 0);
+
+    int64_t offset = 16 + section_count * 24;
+    std::vector<int64_t> offsets(section_count);
+    for (int i = 0; i < section_count; i++)
+    {
+        offset = (offset + 63) / 64 * 64;
+        offsets[i] = offset;
+        offset += (int64_t)datas[i]->size();
+    }
+
+    for (int i = 0; i < section_count; i++)
+    {
+        int64_t size = (int64_t)datas[i]->size();
+        append_int(data, types[i]);
+        append_int(data, 0);
+        data.insert(data.end(), (const unsigned char*)&offsets[i], (const unsigned char*)&offsets[i] + 8);
+        data.insert(data.end(), (const unsigned char*)&size, (const unsigned char*)&size + 8);
+    }
+
+    for (int i = 0; i < section_count; i++)
+    {
+        data.resize(offsets[i], 0);
+        data.insert(data.end(), datas[i]->begin(), datas[i]->end());
+    }
+
+    // 64-byte aligned for zero-copy reference
+    container.create((int)data.size(), (size_t)1u);
+    memcpy(container.data, data.data(), data.size());
+}
+
+static int extract_output(ncnn::Net& net, const ncnn::Mat& in, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("data", in);
+
+    return ex.extract("output", out);
+}
+
+static int test_container(bool with_weight_cache)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 648, true);
+    append_weight(model, 24, false);
+
+    ncnn::Mat in = RandomMat(13, 11, 3);
+
+    ncnn::Option opt;
+    opt.num_threads = 1;
+    opt.use_vulkan_compute = false;
+    opt.use_weight_cache = with_weight_cache;
+
+    ncnn::Mat out_ref;
+    std::vector<unsigned char> weight_cache;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(net_param);
+        net.load_model(model.data());
+
+        if (extract_output(net, in, out_ref) != 0)
+        {
+            fprintf(stderr, "extract reference failed\n");
+            return -1;
+        }
+
+        if (with_weight_cache)
+        {
+            const char* cache_path = "test_container_weightcache.bin";
+            if (net.save_weight_cache(cache_path) != 0)
+            {
+                fprintf(stderr, "save_weight_cache failed\n");
+                return -1;
+            }
+
+            FILE* fp = fopen(cache_path, "rb");
+            fseek(fp, 0, SEEK_END);
+            weight_cache.resize(ftell(fp));
+            fseek(fp, 0, SEEK_SET);
+            size_t nread = fread(weight_cache.data(), 1, weight_cache.size(), fp);
+            fclose(fp);
+            remove(cache_path);
+
+            if (nread != weight_cache.size())
+            {
+                fprintf(stderr, "read weight cache failed\n");
+                return -1;
+            }
+        }
+    }
+
+    std::vector<unsigned char> parambin;
+    std::vector<unsigned char> names;
+    make_param_bin(parambin, names);
+
+    std::vector<int> types;
+    std::vector<const std::vector<unsigned char>*> datas;
+    types.push_back(1);
+    datas.push_back(&parambin);
+    types.push_back(2);
+    datas.push_back(&names);
+    if (with_weight_cache)
+    {
+        types.push_back(3);
+        datas.push_back(&weight_cache);
+    }
+    types.push_back(4);
+    datas.push_back(&model);
+
+    ncnn::Mat container;
+    make_container(types, datas, container);
+
+    // from memory
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        if (net.load_container((const unsigned char*)container.data) != 0)
+        {
+            fprintf(stderr, "load_container from memory failed\n");
+            return -1;
+        }
+
+        ncnn::Mat out;
+        if (extract_output(net, in, out) != 0 || CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_container memory output mismatch %d\n", with_weight_cache);
+            return -1;
+        }
+
+        if (strcmp(net.output_names()[0], "output") != 0 || net.layers()[1]->name != "conv0")
+        {
+            fprintf(stderr, "test_container names mismatch\n");
+            return -1;
+        }
+    }
+
+    // from file
+    {
+        const char* container_path = "test_container.ncnn";
+        FILE* fp = fopen(container_path, "wb");
+        fwrite(container.data, 1, container.w, fp);
+        fclose(fp);
+
+        ncnn::Net net;
+        net.opt = opt;
+        int ret = net.load_container(container_path);
+        remove(container_path);
+        if (ret != 0)
+        {
+            fprintf(stderr, "load_container from file failed\n");
+            return -1;
+        }
+
+        ncnn::Mat out;
+        if (extract_output(net, in, out) != 0 || CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_container file output mismatch %d\n", with_weight_cache);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_container(false)
+           || test_container(true);
+}
@@ -0,0 +1,87 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "testutil.h"
+
+// top and bottom of packed 2d blobs count rows in elements, the same as for unpacked ones
+static int test_copycutborder(const ncnn::Mat& a, int elempack, int top, int bottom, int left, int right)
+{
+    ncnn::Option opt;
+    opt.num_threads = 1;
+    opt.use_vulkan_compute = false;
+    opt.use_fp16_storage = false;
+    opt.use_bf16_storage = false;
+    opt.use_packing_layout = true;
+
+    ncnn::Mat b_ref;
+    ncnn::copy_cut_border(a, b_ref, top, bottom, left, right, opt);
+
+    ncnn::Mat ap;
+    ncnn::convert_packing(a, ap, elempack, opt);
+
+    ncnn::Mat bp;
+    ncnn::copy_cut_border(ap, bp, top, bottom, left, right, opt);
+
+    ncnn::Mat b;
+    ncnn::convert_packing(bp, b, 1, opt);
+
+    if (b_ref.empty() || CompareMat(b_ref, b, 0.001) != 0)
+    {
+        fprintf(stderr, "test_copycutborder failed a.dims=%d a=(%d %d %d) elempack=%d top=%d bottom=%d left=%d right=%d\n", a.dims, a.w, a.h, a.c, elempack, top, bottom, left, right);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_copycutborder_0()
+{
+    ncnn::Mat a = RandomMat(13, 32);
+
+    return 0
+           || test_copycutborder(a, 4, 0, 0, 0, 0)
+           || test_copycutborder(a, 4, 0, 0, 2, 3)
+           || test_copycutborder(a, 4, 0, 8, 0, 1)
+           || test_copycutborder(a, 4, 4, 12, 1, 0)
+           || test_copycutborder(a, 4, 1, 2, 0, 0)
+           || test_copycutborder(a, 4, 0, 5, 3, 3);
+}
+
+static int test_copycutborder_1()
+{
+    ncnn::Mat a = RandomMat(9, 7, 16);
+
+    // the channels are packed, the rows are not
+    return 0
+           || test_copycutborder(a, 4, 0, 0, 0, 0)
+           || test_copycutborder(a, 4, 1, 2, 3, 1)
+           || test_copycutborder(a, 4, 0, 6, 0, 8);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    // the packed crop needs a Crop implementation that takes packed input
+    ncnn::Layer* crop = ncnn::create_layer("Crop");
+    const bool support_packing = crop->support_packing;
+    delete crop;
+
+    if (!support_packing)
+        return 0;
+
+    return 0
+           || test_copycutborder_0()
+           || test_copycutborder_1();
+}
@@ -0,0 +1,153 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// convdw3x3 stride2 - relu - conv1x1 - convdw5x5 dilation2 - swish - conv3x3 - sigmoid
+static const char chain_param[] = "7767517\n"
+                                  "8 8\n"
+                                  "Input                data     0 1 data\n"
+                                  "ConvolutionDepthWise convdw0  1 1 data c0 0=16 1=3 3=2 4=1 5=1 6=144 7=16\n"
+                                  "ReLU                 relu0    1 1 c0 r0\n"
+                                  "Convolution          conv1    1 1 r0 c1 0=24 1=1 5=1 6=384\n"
+                                  "ConvolutionDepthWise convdw2  1 1 c1 c2 0=24 1=5 2=2 4=3 5=1 6=600 7=24\n"
+                                  "Swish                swish2   1 1 c2 s2\n"
+                                  "Convolution          conv3    1 1 s2 c3 0=16 1=3 14=0 15=1 16=2 5=1 6=3456\n"
+                                  "Sigmoid              sigmoid3 1 1 c3 output\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const std::vector<unsigned char>& model, const ncnn::Option& opt, bool tiling, const ncnn::Mat& in, const char* extract_before, ncnn::Mat& out)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.opt.use_depth_first_tiling = tiling;
+
+    int ret = net.load_param_mem(chain_param);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param_mem failed\n");
+        return -1;
+    }
+
+    net.load_model(model.data());
+
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("data", in);
+
+    if (extract_before)
+    {
+        ncnn::Mat mid;
+        ret = ex.extract(extract_before, mid);
+        if (ret != 0)
+        {
+            fprintf(stderr, "extract %s failed\n", extract_before);
+            return -1;
+        }
+    }
+
+    ret = ex.extract("output", out);
+    if (ret != 0)
+    {
+        fprintf(stderr, "extract output failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_depthfirsttiling(const ncnn::Mat& a, const char* extract_before)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 144, true);
+    append_weight(model, 16, false);
+    append_weight(model, 384, true);
+    append_weight(model, 24, false);
+    append_weight(model, 600, true);
+    append_weight(model, 24, false);
+    append_weight(model, 3456, true);
+    append_weight(model, 16, false);
+
+    ncnn::Option opts[4];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_storage = false;
+    opts[2].use_bf16_storage = true;
+
+    opts[3].use_packing_layout = true;
+    opts[3].use_fp16_storage = true;
+    opts[3].use_bf16_storage = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = 1;
+        opt.use_vulkan_compute = false;
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out_tiled;
+        if (run_net(model, opt, false, a, 0, out_ref) != 0
+                || run_net(model, opt, true, a, extract_before, out_tiled) != 0)
+        {
+            fprintf(stderr, "test_depthfirsttiling failed a.dims=%d a=(%d %d %d) opt %d\n", a.dims, a.w, a.h, a.c, i);
+            return -1;
+        }
+
+        // band and whole blob forward may pick different kernels
+        const float epsilon = (opt.use_bf16_storage || opt.use_fp16_storage) ? 0.02f : 0.001f;
+        if (CompareMat(out_ref, out_tiled, epsilon) != 0)
+        {
+            fprintf(stderr, "test_depthfirsttiling output mismatch a.dims=%d a=(%d %d %d) opt %d\n", a.dims, a.w, a.h, a.c, i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_depthfirsttiling(RandomMat(13, 11, 16), 0)
+           || test_depthfirsttiling(RandomMat(96, 401, 16), 0)
+           || test_depthfirsttiling(RandomMat(333, 257, 16), 0)
+           || test_depthfirsttiling(RandomMat(333, 257, 16), "c1");
+}
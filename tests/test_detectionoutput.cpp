@@ -0,0 +1,163 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "layer/detectionoutput.h"
+#include "testutil.h"
+
+static ncnn::Mat RandomPriorBox(int num_prior, bool with_variance)
+{
+    ncnn::Mat m(num_prior * 4, with_variance ? 2 : 1);
+
+    float* pb = m.row(0);
+    for (int i = 0; i < num_prior; i++)
+    {
+        float cx = RandomFloat(0.f, 1.f);
+        float cy = RandomFloat(0.f, 1.f);
+        float w = RandomFloat(0.05f, 0.5f);
+        float h = RandomFloat(0.05f, 0.5f);
+
+        pb[0] = cx - w * 0.5f;
+        pb[1] = cy - h * 0.5f;
+        pb[2] = cx + w * 0.5f;
+        pb[3] = cy + h * 0.5f;
+        pb += 4;
+    }
+
+    if (with_variance)
+    {
+        float* var = m.row(1);
+        for (int i = 0; i < num_prior; i++)
+        {
+            var[0] = 0.1f;
+            var[1] = 0.1f;
+            var[2] = 0.2f;
+            var[3] = 0.2f;
+            var += 4;
+        }
+    }
+
+    return m;
+}
+
+static ncnn::Mat RandomConfidence(int num_class, int num_prior)
+{
+    // softmax over classes for each prior
+    ncnn::Mat m(num_class, num_prior);
+    for (int i = 0; i < num_prior; i++)
+    {
+        float* ptr = m.row(i);
+
+        float sum = 0.f;
+        for (int j = 0; j < num_class; j++)
+        {
+            ptr[j] = expf(RandomFloat(-4.f, 4.f));
+            sum += ptr[j];
+        }
+
+        for (int j = 0; j < num_class; j++)
+        {
+            ptr[j] /= sum;
+        }
+    }
+
+    return m;
+}
+
+static int test_detectionoutput(int num_prior, int num_class, float nms_threshold, int nms_top_k, int keep_top_k, float confidence_threshold)
+{
+    std::vector<ncnn::Mat> a(3);
+    a[0] = RandomMat(num_prior * 4);
+    a[1] = RandomConfidence(num_class, num_prior);
+    a[2] = RandomPriorBox(num_prior, true);
+
+    ncnn::ParamDict pd;
+    pd.set(0, num_class);
+    pd.set(1, nms_threshold);
+    pd.set(2, nms_top_k);
+    pd.set(3, keep_top_k);
+    pd.set(4, confidence_threshold);
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer<ncnn::DetectionOutput>("DetectionOutput", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_detectionoutput failed num_prior=%d num_class=%d nms_threshold=%f nms_top_k=%d keep_top_k=%d confidence_threshold=%f\n", num_prior, num_class, nms_threshold, nms_top_k, keep_top_k, confidence_threshold);
+    }
+
+    return ret;
+}
+
+static int test_detectionoutput_mxnet(int num_prior, int num_class, float nms_threshold, int nms_top_k, int keep_top_k, float confidence_threshold)
+{
+    // mxnet-ssd = num_class x num_prior confidence and priorbox without variance
+    ncnn::Mat confidence = RandomConfidence(num_class, num_prior);
+    ncnn::Mat confidence_t(num_prior, num_class);
+    for (int i = 0; i < num_class; i++)
+    {
+        for (int j = 0; j < num_prior; j++)
+        {
+            confidence_t.row(i)[j] = confidence.row(j)[i];
+        }
+    }
+
+    std::vector<ncnn::Mat> a(3);
+    a[0] = RandomMat(num_prior * 4);
+    a[1] = confidence_t;
+    a[2] = RandomPriorBox(num_prior, false).reshape(4, num_prior);
+
+    ncnn::ParamDict pd;
+    pd.set(0, -233);
+    pd.set(1, nms_threshold);
+    pd.set(2, nms_top_k);
+    pd.set(3, keep_top_k);
+    pd.set(4, confidence_threshold);
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer<ncnn::DetectionOutput>("DetectionOutput", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_detectionoutput_mxnet failed num_prior=%d num_class=%d nms_threshold=%f nms_top_k=%d keep_top_k=%d confidence_threshold=%f\n", num_prior, num_class, nms_threshold, nms_top_k, keep_top_k, confidence_threshold);
+    }
+
+    return ret;
+}
+
+static int test_detectionoutput_0()
+{
+    return 0
+           || test_detectionoutput(1, 2, 0.45f, 100, 100, 0.01f)
+           || test_detectionoutput(7, 3, 0.45f, 100, 100, 0.01f)
+           || test_detectionoutput(222, 21, 0.45f, 100, 100, 0.1f)
+           || test_detectionoutput(1000, 5, 0.45f, 400, 200, 0.05f)
+           || test_detectionoutput(1917, 21, 0.45f, 10, 30, 0.01f);
+}
+
+static int test_detectionoutput_1()
+{
+    return 0
+           || test_detectionoutput_mxnet(13, 3, 0.5f, 100, 100, 0.01f)
+           || test_detectionoutput_mxnet(300, 6, 0.45f, 50, 60, 0.05f);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_detectionoutput_0()
+           || test_detectionoutput_1();
+}
@@ -0,0 +1,263 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// two intermediate blobs for the recycled buffers to serve
+static const char pool_param[] = "7767517\n"
+                                 "5 5\n"
+                                 "Input            data     0 1 data\n"
+                                 "Convolution      conv0    1 1 data c0 0=8 1=3 4=1 5=1 6=216 9=1\n"
+                                 "Convolution      conv1    1 1 c0 c1 0=8 1=3 4=1 5=1 6=576 9=1\n"
+                                 "Pooling          pool0    1 1 c1 c2 0=1 4=1\n"
+                                 "InnerProduct     fc0      1 1 c2 output 0=10 1=1 2=80\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int test_extractorpool_reset(const ncnn::Net& net, const ncnn::Mat& in, const ncnn::Mat& out_ref)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (i > 0)
+            ex.reset();
+
+        ncnn::Mat out;
+        ex.input("data", in);
+        if (ex.extract("output", out) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_reset extract %d failed\n", i);
+            return -1;
+        }
+
+        if (CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_reset output %d mismatch\n", i);
+            return -1;
+        }
+
+        // the blobs come from the buffer cache after reset
+        if (i > 0 && ex.peak_blob_bytes() == 0)
+        {
+            fprintf(stderr, "test_extractorpool_reset buffer cache not used\n");
+            return -1;
+        }
+    }
+
+    // a reset drops the blobs, another input gives another output
+    ex.reset();
+
+    ncnn::Mat in2 = RandomMat(11, 10, 3);
+
+    ncnn::Mat out2_ref;
+    {
+        ncnn::Extractor ex2 = net.create_extractor();
+        ex2.input("data", in2);
+        ex2.extract("output", out2_ref);
+    }
+
+    ncnn::Mat out;
+    ex.input("data", in2);
+    if (ex.extract("output", out) != 0 || CompareMat(out2_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_reset blob kept after reset\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_extractorpool_detach(const ncnn::Net& net, const ncnn::Mat& in, const ncnn::Mat& out_ref)
+{
+    ncnn::Mat out;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.reset();
+
+        ex.input("data", in);
+        if (ex.extract("output", out) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_detach extract failed\n");
+            return -1;
+        }
+    }
+
+    // the output outlives the buffer cache of its extractor
+    if (out.allocator != 0 || CompareMat(out_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_detach output not detached\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_extractorpool_acquire(const ncnn::Net& net, const ncnn::Mat& in, const ncnn::Mat& out_ref)
+{
+    ncnn::Extractor* ex0 = net.acquire_extractor();
+    ncnn::Extractor* ex1 = net.acquire_extractor();
+    if (!ex0 || !ex1 || ex0 == ex1)
+    {
+        fprintf(stderr, "test_extractorpool_acquire extractors %p %p\n", ex0, ex1);
+        return -1;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        ncnn::Mat out0;
+        ncnn::Mat out1;
+        ex0->input("data", in);
+        ex1->input("data", in);
+        if (ex0->extract("output", out0) != 0 || ex1->extract("output", out1) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_acquire extract failed\n");
+            return -1;
+        }
+
+        if (CompareMat(out_ref, out0, 0.001) != 0 || CompareMat(out_ref, out1, 0.001) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_acquire output mismatch\n");
+            return -1;
+        }
+
+        ex0->reset();
+        ex1->reset();
+    }
+
+    ex1->set_num_threads(1);
+    if (net.reclaim_extractor(ex1) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_acquire reclaim failed\n");
+        return -1;
+    }
+
+    // a second reclaim of the same extractor is rejected
+    if (net.reclaim_extractor(ex1) == 0)
+    {
+        fprintf(stderr, "test_extractorpool_acquire double reclaim accepted\n");
+        return -1;
+    }
+
+    // the idle extractor is handed out again
+    ncnn::Extractor* ex2 = net.acquire_extractor();
+    if (ex2 != ex1)
+    {
+        fprintf(stderr, "test_extractorpool_acquire extractor not reused\n");
+        return -1;
+    }
+
+    ncnn::Mat out2;
+    ex2->input("data", in);
+    if (ex2->extract("output", out2) != 0 || CompareMat(out_ref, out2, 0.001) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_acquire output mismatch after reclaim\n");
+        return -1;
+    }
+
+    // an extractor of another net is rejected
+    ncnn::Net net_other;
+    net_other.opt = net.opt;
+    ncnn::Extractor* ex_other = net_other.acquire_extractor();
+    if (net.reclaim_extractor(ex_other) == 0 || net_other.reclaim_extractor(ex_other) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_acquire foreign extractor accepted\n");
+        return -1;
+    }
+
+    if (net.reclaim_extractor(ex2) != 0 || net.reclaim_extractor(ex0) != 0)
+    {
+        fprintf(stderr, "test_extractorpool_acquire reclaim failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_extractorpool_0(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 216, true);
+    append_weight(model, 8, false);
+    append_weight(model, 576, true);
+    append_weight(model, 8, false);
+    append_weight(model, 80, true);
+    append_weight(model, 10, false);
+
+    ncnn::Mat in = RandomMat(11, 10, 3);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(pool_param);
+    net.load_model(model.data());
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+        if (ex.extract("output", out_ref) != 0)
+        {
+            fprintf(stderr, "test_extractorpool_0 reference forward failed\n");
+            return -1;
+        }
+    }
+
+    return 0
+           || test_extractorpool_reset(net, in, out_ref)
+           || test_extractorpool_detach(net, in, out_ref)
+           || test_extractorpool_acquire(net, in, out_ref);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[2];
+
+    opts[0].num_threads = 1;
+    opts[0].use_packing_layout = false;
+    opts[0].use_local_pool_allocator = false;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = true;
+    opts[1].use_local_pool_allocator = true;
+
+    for (int i = 0; i < 2; i++)
+    {
+        int ret = test_extractorpool_0(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "layer/gemm.h"
+#include "testutil.h"
+
+// skinny shapes run with several threads
+// so that the tiles are spread over N and the reduction is split over K
+static int test_gemm_nt(int M, int N, int K, int transA, int transB, int output_transpose, int constantA, int constantB, int constantC, int nT)
+{
+    ncnn::ParamDict pd;
+    pd.set(0, 1.f); // alpha
+    pd.set(1, 1.f); // beta
+    pd.set(2, transA);
+    pd.set(3, transB);
+    pd.set(4, constantA);
+    pd.set(5, constantB);
+    pd.set(6, constantC);
+    pd.set(7, M);
+    pd.set(8, N);
+    pd.set(9, K);
+    pd.set(10, 4); // 1xN
+    pd.set(14, output_transpose);
+
+    ncnn::Mat C = RandomMat(N);
+
+    std::vector<ncnn::Mat> weights;
+    if (constantA) weights.push_back(RandomMat(transA ? M : K, transA ? K : M));
+    if (constantB) weights.push_back(RandomMat(transB ? K : N, transB ? N : K));
+    if (constantC) weights.push_back(C);
+
+    std::vector<ncnn::Mat> a;
+    if (!constantA) a.push_back(RandomMat(transA ? M : K, transA ? K : M));
+    if (!constantB) a.push_back(RandomMat(transB ? K : N, transB ? N : K));
+    if (!constantC) a.push_back(C);
+
+    const int typeindex = ncnn::layer_to_index("Gemm");
+
+    std::vector<ncnn::Mat> b;
+    int ret = test_layer_naive<ncnn::Gemm>(typeindex, pd, weights, a, 1, b, 0, 0);
+    if (ret != 0)
+        return ret;
+
+    ncnn::Layer* op = ncnn::create_layer(typeindex);
+
+    op->load_param(pd);
+
+    ncnn::ModelBinFromMatArray mb(weights.data());
+
+    op->load_model(mb);
+
+    ncnn::Option opt;
+    opt.num_threads = nT;
+    opt.use_packing_layout = true;
+    opt.use_fp16_packed = false;
+    opt.use_fp16_storage = false;
+    opt.use_fp16_arithmetic = false;
+    opt.use_bf16_storage = false;
+    opt.use_vulkan_compute = false;
+
+    op->create_pipeline(opt);
+
+    std::vector<ncnn::Mat> c(1);
+    ret = op->forward(a, c, opt);
+
+    op->destroy_pipeline(opt);
+
+    delete op;
+
+    if (ret == 0)
+    {
+        ncnn::Mat c0;
+        ncnn::convert_packing(c[0], c0, 1, opt);
+
+        ret = CompareMat(b[0], c0, 0.001);
+    }
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gemm_nt failed M=%d N=%d K=%d transA=%d transB=%d output_transpose=%d constantA=%d constantB=%d constantC=%d nT=%d\n", M, N, K, transA, transB, output_transpose, constantA, constantB, constantC, nT);
+    }
+
+    return ret;
+}
+
+static int test_gemm_0(int M, int N, int K)
+{
+    return 0
+           || test_gemm_nt(M, N, K, 0, 0, 0, 0, 0, 0, 4)
+           || test_gemm_nt(M, N, K, 1, 0, 0, 0, 0, 1, 4)
+           || test_gemm_nt(M, N, K, 0, 1, 1, 0, 0, 0, 3)
+           || test_gemm_nt(M, N, K, 0, 1, 0, 0, 1, 1, 4)
+           || test_gemm_nt(M, N, K, 1, 1, 1, 0, 1, 0, 4)
+           || test_gemm_nt(M, N, K, 0, 0, 0, 1, 0, 1, 4)
+           || test_gemm_nt(M, N, K, 1, 0, 1, 1, 0, 0, 2)
+           || test_gemm_nt(M, N, K, 0, 1, 0, 1, 1, 1, 4)
+           || test_gemm_nt(M, N, K, 1, 1, 1, 1, 1, 0, 8);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    int mnk[][3] = {
+        {1, 1, 3000},
+        {1, 7, 2049},
+        {1, 64, 1500},
+        {1, 1000, 700},
+        {2, 35, 2500},
+        {3, 12, 1777},
+        {4, 256, 1024},
+        {5, 3, 4000},
+        {8, 40, 2000},
+        {16, 16, 1200},
+        {17, 100, 900}
+    };
+
+    int mnk_count = sizeof(mnk) / sizeof(int) / 3;
+
+    for (int i = 0; i < mnk_count; i++)
+    {
+        int M = mnk[i][0];
+        int N = mnk[i][1];
+        int K = mnk[i][2];
+
+        int ret = test_gemm_0(M, N, K);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -119,6 +119,33 @@ static int test_gridsample_3()
            || test_gridsample(RandomMat(16, 12, 10, 5), RandomMat(3, 16, 12, 10), 2, 3, 1);
 }
 
+static int test_gridsample_4()
+{
+    return 0
+           || test_gridsample(RandomMat(13, 11, 16), RandomMat(2, 15, 9), 1, 1, 0)
+           || test_gridsample(RandomMat(13, 11, 16), RandomMat(2, 15, 9), 1, 3, 1)
+           || test_gridsample(RandomMat(13, 11, 8), RandomMat(2, 15, 9), 1, 2, 0)
+           || test_gridsample(RandomMat(13, 11, 4), RandomMat(2, 15, 9), 1, 2, 1)
+           || test_gridsample(RandomMat(13, 11, 16), RandomMat(2, 15, 9), 2, 1, 1)
+           || test_gridsample(RandomMat(13, 11, 8), RandomMat(2, 15, 9), 2, 3, 0)
+           || test_gridsample(RandomMat(13, 11, 4), RandomMat(2, 15, 9), 2, 2, 1)
+           || test_gridsample(RandomMat(13, 11, 16), RandomMat(2, 15, 9), 3, 1, 0)
+           || test_gridsample(RandomMat(13, 11, 8), RandomMat(2, 15, 9), 3, 2, 1)
+           || test_gridsample(RandomMat(13, 11, 4), RandomMat(2, 15, 9), 3, 3, 0);
+}
+
+static int test_gridsample_5()
+{
+    return 0
+           || test_gridsample(RandomMat(7, 6, 5, 16), RandomMat(3, 9, 7, 4), 1, 1, 0)
+           || test_gridsample(RandomMat(7, 6, 5, 16), RandomMat(3, 9, 7, 4), 1, 3, 1)
+           || test_gridsample(RandomMat(7, 6, 5, 8), RandomMat(3, 9, 7, 4), 1, 2, 0)
+           || test_gridsample(RandomMat(7, 6, 5, 4), RandomMat(3, 9, 7, 4), 1, 2, 1)
+           || test_gridsample(RandomMat(7, 6, 5, 16), RandomMat(3, 9, 7, 4), 2, 1, 1)
+           || test_gridsample(RandomMat(7, 6, 5, 8), RandomMat(3, 9, 7, 4), 2, 3, 0)
+           || test_gridsample(RandomMat(7, 6, 5, 4), RandomMat(3, 9, 7, 4), 2, 2, 1);
+}
+
 int main()
 {
     SRAND(7767517);
@@ -127,5 +154,7 @@ int main()
            || test_gridsample_0()
            || test_gridsample_1()
            || test_gridsample_2()
-           || test_gridsample_3();
+           || test_gridsample_3()
+           || test_gridsample_4()
+           || test_gridsample_5();
 }
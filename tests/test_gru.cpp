@@ -249,8 +249,95 @@ static int test_gru_3()
            || test_gru(RandomMat(2, 5), 17, 1);
 }
 
+#if NCNN_INT8
+static int test_gru_int8(const ncnn::Mat& a, int outch, int direction)
+{
+    int input_size = a.w;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, outch * input_size * 3 * num_directions);
+    pd.set(2, direction);
+    pd.set(8, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(5);
+    weights[0] = RandomS8Mat(outch * input_size * 3 * num_directions);
+    weights[1] = RandomMat(outch * 4 * num_directions);
+    weights[2] = RandomS8Mat(outch * outch * 3 * num_directions);
+    weights[3] = RandomMat(outch * 3 * num_directions, 100.f, 200.f);
+    weights[4] = RandomMat(outch * 3 * num_directions, 100.f, 200.f);
+
+    int ret = test_layer<ncnn::GRU>("GRU", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gru_int8 failed a.dims=%d a=(%d %d %d) outch=%d, direction = %d \n", a.dims, a.w, a.h, a.c, outch, direction);
+    }
+
+    return ret;
+}
+
+static int test_gru_int8_layer_with_hidden(const ncnn::Mat& a, int outch, int direction)
+{
+    int input_size = a.w;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, outch * input_size * 3 * num_directions);
+    pd.set(2, direction);
+    pd.set(8, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(5);
+    weights[0] = RandomS8Mat(outch * input_size * 3 * num_directions);
+    weights[1] = RandomMat(outch * 4 * num_directions);
+    weights[2] = RandomS8Mat(outch * outch * 3 * num_directions);
+    weights[3] = RandomMat(outch * 3 * num_directions, 100.f, 200.f);
+    weights[4] = RandomMat(outch * 3 * num_directions, 100.f, 200.f);
+
+    // initial hidden state
+    ncnn::Mat hidden = RandomMat(outch, num_directions);
+
+    std::vector<ncnn::Mat> as(2);
+    as[0] = a;
+    as[1] = hidden;
+
+    int ret = test_layer<ncnn::GRU>("GRU", pd, weights, as, 2);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gru_int8_layer_with_hidden failed a.dims=%d a=(%d %d %d) outch=%d, direction = %d \n", a.dims, a.w, a.h, a.c, outch, direction);
+    }
+
+    return ret;
+}
+
+static int test_gru_4()
+{
+    return 0
+           || test_gru_int8(RandomMat(4, 1), 2, 2)
+           || test_gru_int8(RandomMat(8, 2), 2, 2)
+           || test_gru_int8(RandomMat(16, 8), 7, 2)
+           || test_gru_int8(RandomMat(17, 8), 8, 2)
+           || test_gru_int8(RandomMat(19, 15), 8, 2)
+           || test_gru_int8(RandomMat(5, 16), 16, 2)
+           || test_gru_int8(RandomMat(3, 16), 8, 2)
+           || test_gru_int8(RandomMat(4, 1), 1, 0)
+           || test_gru_int8(RandomMat(17, 8), 8, 0)
+           || test_gru_int8(RandomMat(8, 2), 2, 1)
+           || test_gru_int8(RandomMat(19, 15), 8, 1)
+           || test_gru_int8_layer_with_hidden(RandomMat(4, 4), 1, 2)
+           || test_gru_int8_layer_with_hidden(RandomMat(16, 8), 7, 2)
+           || test_gru_int8_layer_with_hidden(RandomMat(19, 15), 8, 1)
+           || test_gru_int8_layer_with_hidden(RandomMat(3, 16), 8, 0);
+}
+#endif // NCNN_INT8
+
 int main()
 {
     SRAND(7767517);
+#if NCNN_INT8
+    return test_gru_0() || test_gru_1() || test_gru_2() || test_gru_3() || test_gru_4();
+#else
     return test_gru_0() || test_gru_1() || test_gru_2() || test_gru_3();
+#endif
 }
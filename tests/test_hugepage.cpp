@@ -0,0 +1,231 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "allocator.h"
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+static const char fcnet_param[] = "7767517\n"
+                                  "3 3\n"
+                                  "Input            data     0 1 data\n"
+                                  "InnerProduct     fc0      1 1 data fc0 0=1024 1=1 2=1048576 9=1\n"
+                                  "InnerProduct     fc1      1 1 fc0 output 0=16 1=1 2=16384\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int test_hugepage_allocator(bool use_hugetlbfs)
+{
+    ncnn::HugePageAllocator allocator;
+    allocator.set_use_hugetlbfs(use_hugetlbfs);
+
+    // large allocation in huge page mappings, small one from fastMalloc
+    ncnn::Mat a(1024, 1024, 3, 4u, &allocator);
+    ncnn::Mat b(100, 4u, &allocator);
+    if (a.empty() || b.empty())
+    {
+        fprintf(stderr, "test_hugepage_allocator allocation failed\n");
+        return -1;
+    }
+
+    a.fill(1.f);
+    b.fill(2.f);
+
+    const size_t huge_page_bytes = allocator.get_huge_page_bytes();
+    if (huge_page_bytes > ncnn::alignSize(a.total() * a.elemsize + NCNN_MALLOC_OVERREAD, NCNN_HUGE_PAGE_SIZE))
+    {
+        fprintf(stderr, "test_hugepage_allocator %zu huge page bytes out of range\n", huge_page_bytes);
+        return -1;
+    }
+
+    // the freed mapping is reused
+    void* a_data = a.data;
+    a.release();
+
+    ncnn::Mat c(1000, 1000, 3, 4u, &allocator);
+    if (c.empty() || c.data != a_data)
+    {
+        fprintf(stderr, "test_hugepage_allocator mapping not reused\n");
+        return -1;
+    }
+
+    c.fill(3.f);
+    for (int i = 0; i < (int)b.total(); i++)
+    {
+        if (b[i] != 2.f)
+        {
+            fprintf(stderr, "test_hugepage_allocator small allocation overwritten\n");
+            return -1;
+        }
+    }
+
+    c.release();
+    b.release();
+
+    if (allocator.get_huge_page_bytes() != 0)
+    {
+        fprintf(stderr, "test_hugepage_allocator huge page bytes left after release\n");
+        return -1;
+    }
+
+    allocator.clear();
+
+    return 0;
+}
+
+static int test_hugepage_allocator_ptrs()
+{
+    ncnn::HugePageAllocator allocator;
+
+    ncnn::Mat a(1024 * 1024 + 123, 4u, &allocator);
+    ncnn::Mat b(1024 * 1024 * 3, 4u, &allocator);
+    if (a.empty() || b.empty())
+    {
+        fprintf(stderr, "test_hugepage_allocator_ptrs allocation failed\n");
+        return -1;
+    }
+
+    a.fill(1.f);
+    b.fill(2.f);
+
+    std::vector<void*> ptrs(1, a.data);
+    const size_t a_bytes = allocator.get_huge_page_bytes(ptrs);
+    if (a_bytes > ncnn::alignSize(a.total() * a.elemsize + NCNN_MALLOC_OVERREAD, NCNN_HUGE_PAGE_SIZE))
+    {
+        fprintf(stderr, "test_hugepage_allocator_ptrs %zu huge page bytes out of range\n", a_bytes);
+        return -1;
+    }
+
+    ptrs[0] = (void*)&ptrs;
+    if (allocator.get_huge_page_bytes(ptrs) != 0)
+    {
+        fprintf(stderr, "test_hugepage_allocator_ptrs foreign pointer counted\n");
+        return -1;
+    }
+
+    ptrs[0] = a.data;
+    ptrs.push_back(b.data);
+    if (allocator.get_huge_page_bytes(ptrs) != allocator.get_huge_page_bytes())
+    {
+        fprintf(stderr, "test_hugepage_allocator_ptrs all pointers mismatch\n");
+        return -1;
+    }
+
+    a.release();
+    b.release();
+
+    allocator.clear();
+
+    return 0;
+}
+
+static int test_hugepage_weights(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 1048576, true);
+    append_weight(model, 1024, false);
+    append_weight(model, 16384, true);
+    append_weight(model, 16, false);
+
+    ncnn::Mat in = RandomMat(1024);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(fcnet_param);
+        net.load_model(model.data());
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+        if (ex.extract("output", out_ref) != 0)
+        {
+            fprintf(stderr, "extract reference failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_huge_page_weights(true);
+    net.load_param_mem(fcnet_param);
+    net.load_model(model.data());
+
+    // at most the huge pages spanned by the 4M weight of fc0
+    if (net.huge_page_weight_bytes() > ncnn::alignSize(1048576 * sizeof(float) + NCNN_MALLOC_OVERREAD, NCNN_HUGE_PAGE_SIZE))
+    {
+        fprintf(stderr, "test_hugepage_weights %zu huge page bytes out of range\n", net.huge_page_weight_bytes());
+        return -1;
+    }
+
+    ncnn::Mat out;
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    if (ex.extract("output", out) != 0 || CompareMat(out_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_hugepage_weights output mismatch\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    if (test_hugepage_allocator(false) != 0 || test_hugepage_allocator(true) != 0)
+        return -1;
+
+    if (test_hugepage_allocator_ptrs() != 0)
+        return -1;
+
+    ncnn::Option opts[2];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (test_hugepage_weights(opts[i]) != 0)
+        {
+            fprintf(stderr, "test_hugepage_weights failed opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
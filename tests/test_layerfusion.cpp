@@ -0,0 +1,241 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+static const char resnet_param[] = "7767517\n"
+                                   "13 15\n"
+                                   "Input            data     0 1 data\n"
+                                   "Convolution      conv0    1 1 data c0 0=16 1=3 4=1 5=1 6=1728\n"
+                                   "Split            split0   1 2 c0 c0_0 c0_1\n"
+                                   "Convolution      conv1    1 1 c0_0 c1 0=16 1=3 4=1 5=1 6=2304\n"
+                                   "ReLU             relu1    1 1 c1 r1\n"
+                                   "Convolution      conv2    1 1 r1 c2 0=16 1=1 5=1 6=256\n"
+                                   "BinaryOp         add0     2 1 c2 c0_1 a0 0=0\n"
+                                   "ReLU             relu2    1 1 a0 r2 0=1.000000e-01\n"
+                                   "Split            split1   1 2 r2 r2_0 r2_1\n"
+                                   "Convolution      conv3    1 1 r2_0 c3 0=16 1=1 5=1 6=256\n"
+                                   "Eltwise          sum0     2 1 r2_1 c3 s0 0=1\n"
+                                   "Convolution      conv4    1 1 s0 c4 0=8 1=1 5=1 6=128\n"
+                                   "Sigmoid          sigmoid0 1 1 c4 output\n";
+
+static const char gemm_param[] = "7767517\n"
+                                 "7 8\n"
+                                 "Input            data     0 1 data\n"
+                                 "Input            bias     0 1 bias\n"
+                                 "Split            split0   1 2 data d0 d1\n"
+                                 "Gemm             gemm0    1 1 d0 g0 5=1 8=24 9=24\n"
+                                 "BinaryOp         add0     2 1 g0 d1 a0 0=0\n"
+                                 "Gemm             gemm1    1 1 a0 g1 5=1 8=24 9=24\n"
+                                 "BinaryOp         add1     2 1 g1 bias output 0=0\n";
+
+static const char mlp_param[] = "7767517\n"
+                                "7 7\n"
+                                "Input            data     0 1 data\n"
+                                "InnerProduct     fc0      1 1 data f0 0=32 1=1 2=768\n"
+                                "GELU             gelu0    1 1 f0 e0\n"
+                                "InnerProduct     fc1      1 1 e0 f1 0=24 1=1 2=768\n"
+                                "Swish            swish0   1 1 f1 s1\n"
+                                "Gemm             gemm0    1 1 s1 g0 5=1 8=24 9=24\n"
+                                "GELU             gelu1    1 1 g0 output 0=1\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const char* param, const std::vector<unsigned char>& model, const ncnn::Option& opt, bool fusion, const std::vector<const char*>& input_names, const std::vector<ncnn::Mat>& inputs, const char* fused_blob_name, ncnn::Mat& out)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.opt.use_layer_fusion = fusion;
+
+    int ret = net.load_param_mem(param);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param_mem failed\n");
+        return -1;
+    }
+
+    net.load_model(model.data());
+
+    ncnn::Extractor ex = net.create_extractor();
+
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        ex.input(input_names[i], inputs[i]);
+    }
+
+    ret = ex.extract("output", out);
+    if (ret != 0)
+    {
+        fprintf(stderr, "extract output failed\n");
+        return -1;
+    }
+
+    if (fusion)
+    {
+        // the intermediate blob is gone after fusion
+        ncnn::Extractor ex2 = net.create_extractor();
+
+        for (size_t i = 0; i < inputs.size(); i++)
+        {
+            ex2.input(input_names[i], inputs[i]);
+        }
+
+        ncnn::Mat fused;
+        ret = ex2.extract(fused_blob_name, fused);
+        if (ret == 0)
+        {
+            fprintf(stderr, "blob %s is still extractable, layer fusion not applied\n", fused_blob_name);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_layerfusion(const char* param, const std::vector<unsigned char>& model, const std::vector<const char*>& input_names, const std::vector<ncnn::Mat>& inputs, const char* fused_blob_name)
+{
+    ncnn::Option opts[4];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_storage = false;
+    opts[2].use_bf16_storage = true;
+
+    opts[3].use_packing_layout = true;
+    opts[3].use_fp16_storage = true;
+    opts[3].use_bf16_storage = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = 1;
+        opt.use_vulkan_compute = false;
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out_fused;
+        if (run_net(param, model, opt, false, input_names, inputs, fused_blob_name, out_ref) != 0
+                || run_net(param, model, opt, true, input_names, inputs, fused_blob_name, out_fused) != 0)
+        {
+            fprintf(stderr, "test_layerfusion failed opt %d\n", i);
+            return -1;
+        }
+
+        // 16bit storage rounds the unfused intermediate blobs
+        const float epsilon = (opt.use_bf16_storage || opt.use_fp16_storage) ? 0.02f : 0.001f;
+        if (CompareMat(out_ref, out_fused, epsilon) != 0)
+        {
+            fprintf(stderr, "test_layerfusion output mismatch opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_layerfusion_0()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 1728, true);
+    append_weight(model, 16, false);
+    append_weight(model, 2304, true);
+    append_weight(model, 16, false);
+    append_weight(model, 256, true);
+    append_weight(model, 16, false);
+    append_weight(model, 256, true);
+    append_weight(model, 16, false);
+    append_weight(model, 128, true);
+    append_weight(model, 8, false);
+
+    std::vector<const char*> input_names(1, "data");
+
+    return 0
+           || test_layerfusion(resnet_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(13, 11, 12)), "c2")
+           || test_layerfusion(resnet_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(8, 8, 12)), "a0")
+           || test_layerfusion(resnet_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(5, 7, 12)), "c4");
+}
+
+static int test_layerfusion_1()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 576, true);
+    append_weight(model, 576, true);
+
+    std::vector<const char*> input_names(2);
+    input_names[0] = "data";
+    input_names[1] = "bias";
+
+    // full size residual goes through gemm C, the broadcasting bias falls back to binaryop
+    std::vector<ncnn::Mat> inputs(2);
+    inputs[0] = RandomMat(24, 16);
+    inputs[1] = RandomMat(16);
+
+    std::vector<ncnn::Mat> inputs2(2);
+    inputs2[0] = RandomMat(24, 13);
+    inputs2[1] = RandomMat(13);
+
+    return 0
+           || test_layerfusion(gemm_param, model, input_names, inputs, "g0")
+           || test_layerfusion(gemm_param, model, input_names, inputs2, "g1");
+}
+
+static int test_layerfusion_2()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 768, true);
+    append_weight(model, 32, false);
+    append_weight(model, 768, true);
+    append_weight(model, 24, false);
+    append_weight(model, 576, true);
+
+    std::vector<const char*> input_names(1, "data");
+
+    // gelu and swish run in the innerproduct and gemm kernels
+    return 0
+           || test_layerfusion(mlp_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(24)), "f0")
+           || test_layerfusion(mlp_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(24, 16)), "f1")
+           || test_layerfusion(mlp_param, model, input_names, std::vector<ncnn::Mat>(1, RandomMat(24, 37)), "g0");
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_layerfusion_0()
+           || test_layerfusion_1()
+           || test_layerfusion_2();
+}
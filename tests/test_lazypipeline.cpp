@@ -0,0 +1,175 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "layer/convolution.h"
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+static const char twohead_param[] = "7767517\n"
+                                    "6 7\n"
+                                    "Input            data     0 1 data\n"
+                                    "Convolution      conv0    1 1 data c0 0=16 1=3 4=1 5=1 6=432 9=1\n"
+                                    "Split            split0   1 2 c0 c0_0 c0_1\n"
+                                    "Convolution      conv1    1 1 c0_0 output_a 0=8 1=3 4=1 5=1 6=1152\n"
+                                    "Convolution      conv2    1 1 c0_1 c2 0=8 1=1 5=1 6=128\n"
+                                    "Sigmoid          sigmoid0 1 1 c2 output_b\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int extract(const ncnn::Net& net, const ncnn::Mat& in, const char* name, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("data", in);
+
+    return ex.extract(name, out);
+}
+
+struct extract_thread_args
+{
+    const ncnn::Net* net;
+    const ncnn::Mat* in;
+    const char* name;
+    ncnn::Mat out;
+    int ret;
+};
+
+static void* extract_thread(void* args)
+{
+    extract_thread_args* a = (extract_thread_args*)args;
+    a->ret = extract(*a->net, *a->in, a->name, a->out);
+    return 0;
+}
+
+static int test_lazypipeline(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 432, true);
+    append_weight(model, 16, false);
+    append_weight(model, 1152, true);
+    append_weight(model, 8, false);
+    append_weight(model, 128, true);
+    append_weight(model, 8, false);
+
+    ncnn::Mat in = RandomMat(13, 11, 3);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Mat out_a_ref;
+    ncnn::Mat out_b_ref;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(twohead_param);
+        net.load_model(model.data());
+
+        if (extract(net, in, "output_a", out_a_ref) != 0 || extract(net, in, "output_b", out_b_ref) != 0)
+        {
+            fprintf(stderr, "extract reference failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.opt.use_lazy_pipeline = true;
+    net.load_param_mem(twohead_param);
+    net.load_model(model.data());
+
+    // every head extracts once from its own thread at the same time
+    const int thread_count = 4;
+    extract_thread_args args[thread_count];
+    std::vector<ncnn::Thread*> threads(thread_count);
+    for (int i = 0; i < thread_count; i++)
+    {
+        args[i].net = &net;
+        args[i].in = &in;
+        args[i].name = "output_a";
+        args[i].ret = -1;
+        threads[i] = new ncnn::Thread(extract_thread, &args[i]);
+    }
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        if (args[i].ret != 0 || CompareMat(out_a_ref, args[i].out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_lazypipeline output_a mismatch thread %d\n", i);
+            return -1;
+        }
+    }
+
+    // the head never extracted keeps its raw weights
+    const ncnn::Convolution* conv2 = (const ncnn::Convolution*)net.layers()[4];
+    if (conv2->weight_data.empty())
+    {
+        fprintf(stderr, "test_lazypipeline conv2 pipeline created before use\n");
+        return -1;
+    }
+
+    ncnn::Mat out_b;
+    if (extract(net, in, "output_b", out_b) != 0 || CompareMat(out_b_ref, out_b, 0.001) != 0)
+    {
+        fprintf(stderr, "test_lazypipeline output_b mismatch\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[2];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (test_lazypipeline(opts[i]) != 0)
+        {
+            fprintf(stderr, "test_lazypipeline failed opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
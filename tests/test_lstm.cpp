@@ -284,8 +284,131 @@ static int test_lstm_3()
            || test_lstm(RandomMat(2, 5), 17, 1, 15);
 }
 
+#if NCNN_INT8
+static int test_lstm_int8(const ncnn::Mat& a, int outch, int direction, int hidden_size = 0)
+{
+    int input_size = a.w;
+    int num_directions = direction == 2 ? 2 : 1;
+    if (hidden_size == 0)
+        hidden_size = outch;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, hidden_size * input_size * 4 * num_directions);
+    pd.set(2, direction);
+    pd.set(3, hidden_size);
+    pd.set(8, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(outch == hidden_size ? 5 : 6);
+    weights[0] = RandomS8Mat(hidden_size * input_size * 4 * num_directions);
+    weights[1] = RandomMat(hidden_size * 4 * num_directions);
+    weights[2] = RandomS8Mat(outch * hidden_size * 4 * num_directions);
+    if (outch == hidden_size)
+    {
+        weights[3] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+        weights[4] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+    }
+    else
+    {
+        weights[3] = RandomMat(hidden_size * outch * num_directions);
+        weights[4] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+        weights[5] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+    }
+
+    int ret = test_layer<ncnn::LSTM>("LSTM", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_lstm_int8 failed a.dims=%d a=(%d %d %d) outch=%d direction=%d hidden_size=%d\n", a.dims, a.w, a.h, a.c, outch, direction, hidden_size);
+    }
+
+    return ret;
+}
+
+static int test_lstm_int8_layer_with_hidden(const ncnn::Mat& a, int outch, int direction, int hidden_size = 0)
+{
+    int input_size = a.w;
+    int num_directions = direction == 2 ? 2 : 1;
+    if (hidden_size == 0)
+        hidden_size = outch;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, hidden_size * input_size * 4 * num_directions);
+    pd.set(2, direction);
+    pd.set(3, hidden_size);
+    pd.set(8, 2); // int8_scale_term
+
+    std::vector<ncnn::Mat> weights(outch == hidden_size ? 5 : 6);
+    weights[0] = RandomS8Mat(hidden_size * input_size * 4 * num_directions);
+    weights[1] = RandomMat(hidden_size * 4 * num_directions);
+    weights[2] = RandomS8Mat(outch * hidden_size * 4 * num_directions);
+    if (outch == hidden_size)
+    {
+        weights[3] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+        weights[4] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+    }
+    else
+    {
+        weights[3] = RandomMat(hidden_size * outch * num_directions);
+        weights[4] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+        weights[5] = RandomMat(hidden_size * 4 * num_directions, 100.f, 200.f);
+    }
+
+    // initial hidden state
+    ncnn::Mat hidden = RandomMat(outch, num_directions);
+
+    // initial cell state
+    ncnn::Mat cell = RandomMat(hidden_size, num_directions);
+
+    std::vector<ncnn::Mat> as(3);
+    as[0] = a;
+    as[1] = hidden;
+    as[2] = cell;
+
+    int ret = test_layer<ncnn::LSTM>("LSTM", pd, weights, as, 3);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_lstm_int8_layer_with_hidden failed a.dims=%d a=(%d %d %d) outch=%d direction=%d hidden_size=%d\n", a.dims, a.w, a.h, a.c, outch, direction, hidden_size);
+    }
+
+    return ret;
+}
+
+static int test_lstm_4()
+{
+    return 0
+           || test_lstm_int8(RandomMat(4, 1), 2, 2)
+           || test_lstm_int8(RandomMat(8, 2), 2, 2)
+           || test_lstm_int8(RandomMat(16, 8), 7, 2)
+           || test_lstm_int8(RandomMat(17, 8), 8, 2)
+           || test_lstm_int8(RandomMat(19, 15), 8, 2)
+           || test_lstm_int8(RandomMat(5, 16), 16, 2)
+           || test_lstm_int8(RandomMat(3, 16), 8, 2)
+           || test_lstm_int8(RandomMat(8, 16), 16, 2)
+           || test_lstm_int8(RandomMat(31, 3), 31, 2)
+           || test_lstm_int8(RandomMat(2, 5), 17, 2, 15)
+           || test_lstm_int8(RandomMat(4, 1), 1, 0)
+           || test_lstm_int8(RandomMat(17, 8), 8, 0)
+           || test_lstm_int8(RandomMat(3, 16), 8, 0)
+           || test_lstm_int8(RandomMat(2, 5), 17, 0, 15)
+           || test_lstm_int8(RandomMat(8, 2), 2, 1)
+           || test_lstm_int8(RandomMat(19, 15), 8, 1)
+           || test_lstm_int8(RandomMat(5, 16), 16, 1)
+           || test_lstm_int8(RandomMat(2, 5), 17, 1, 15)
+           || test_lstm_int8_layer_with_hidden(RandomMat(4, 4), 1, 2)
+           || test_lstm_int8_layer_with_hidden(RandomMat(16, 8), 7, 2)
+           || test_lstm_int8_layer_with_hidden(RandomMat(2, 5), 99, 2, 33)
+           || test_lstm_int8_layer_with_hidden(RandomMat(19, 15), 8, 1)
+           || test_lstm_int8_layer_with_hidden(RandomMat(3, 16), 8, 0);
+}
+#endif // NCNN_INT8
+
 int main()
 {
     SRAND(7767517);
+#if NCNN_INT8
+    return 0 || test_lstm_0() || test_lstm_1() || test_lstm_2() || test_lstm_3() || test_lstm_4();
+#else
     return 0 || test_lstm_0() || test_lstm_1() || test_lstm_2() || test_lstm_3();
+#endif
 }
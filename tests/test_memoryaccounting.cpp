@@ -0,0 +1,212 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "allocator.h"
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// weighted layers around a weightless one
+static const char accounting_param[] = "7767517\n"
+                                       "5 5\n"
+                                       "Input            data     0 1 data\n"
+                                       "Convolution      conv0    1 1 data c0 0=8 1=3 4=1 5=1 6=216 9=1\n"
+                                       "Convolution      conv1    1 1 c0 c1 0=16 1=3 4=1 5=1 6=1152\n"
+                                       "Pooling          pool0    1 1 c1 c2 0=1 4=1\n"
+                                       "InnerProduct     fc0      1 1 c2 output 0=10 1=1 2=160\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+template<typename T>
+static int test_memoryaccounting_pool(T& allocator)
+{
+    void* p0 = allocator.fastMalloc(1000);
+    void* p1 = allocator.fastMalloc(3000);
+    if (allocator.get_payout_bytes() != 4000 || allocator.get_budget_bytes() != 0)
+    {
+        fprintf(stderr, "test_memoryaccounting_pool payout %zu budget %zu\n", allocator.get_payout_bytes(), allocator.get_budget_bytes());
+        return -1;
+    }
+
+    allocator.fastFree(p1);
+    if (allocator.get_payout_bytes() != 1000 || allocator.get_budget_bytes() != 3000 || allocator.get_peak_payout_bytes() != 4000)
+    {
+        fprintf(stderr, "test_memoryaccounting_pool payout %zu budget %zu peak %zu after free\n", allocator.get_payout_bytes(), allocator.get_budget_bytes(), allocator.get_peak_payout_bytes());
+        return -1;
+    }
+
+    allocator.reset_peak_payout_bytes();
+
+    // the budget is reused
+    void* p2 = allocator.fastMalloc(3000);
+    if (p2 != p1 || allocator.get_budget_bytes() != 0 || allocator.get_peak_payout_bytes() != 4000)
+    {
+        fprintf(stderr, "test_memoryaccounting_pool budget not reused\n");
+        return -1;
+    }
+
+    allocator.fastFree(p0);
+    allocator.fastFree(p2);
+    allocator.clear();
+
+    if (allocator.get_payout_bytes() != 0 || allocator.get_budget_bytes() != 0)
+    {
+        fprintf(stderr, "test_memoryaccounting_pool payout %zu budget %zu after clear\n", allocator.get_payout_bytes(), allocator.get_budget_bytes());
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_memoryaccounting_net(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 216, true);
+    append_weight(model, 8, false);
+    append_weight(model, 1152, true);
+    append_weight(model, 16, false);
+    append_weight(model, 160, true);
+    append_weight(model, 10, false);
+
+    ncnn::Mat in = RandomMat(11, 10, 3);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(accounting_param);
+    net.load_model(model.data());
+
+    const size_t weight_bytes[5] = {0, (216 + 8) * 4, (1152 + 16) * 4, 0, (160 + 10) * 4};
+    for (int i = 0; i < 5; i++)
+    {
+        if (net.layer_weight_bytes(i) != weight_bytes[i])
+        {
+            fprintf(stderr, "test_memoryaccounting_net layer %d weight bytes %zu expect %zu\n", i, net.layer_weight_bytes(i), weight_bytes[i]);
+            return -1;
+        }
+    }
+
+    // the transformed weights plus the kept bias
+    for (int i = 1; i < 5; i++)
+    {
+        if (i == 3)
+            continue;
+
+        if (net.layer_pipeline_weight_bytes(i) < weight_bytes[i] / 2)
+        {
+            fprintf(stderr, "test_memoryaccounting_net layer %d pipeline weight bytes %zu\n", i, net.layer_pipeline_weight_bytes(i));
+            return -1;
+        }
+    }
+
+    if (net.layer_pipeline_weight_bytes(0) != 0 || net.layer_pipeline_weight_bytes(3) != 0 || net.layer_weight_bytes(5) != 0)
+    {
+        fprintf(stderr, "test_memoryaccounting_net weightless layer holds weights\n");
+        return -1;
+    }
+
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        ncnn::Mat out;
+        if (ex.extract("output", out) != 0)
+        {
+            fprintf(stderr, "test_memoryaccounting_net extract failed\n");
+            return -1;
+        }
+
+        // at least the two largest blobs alive at the same time
+        const size_t min_peak = (11 * 10 * 8 + 11 * 10 * 16) * sizeof(float);
+        if (ex.peak_blob_bytes() < min_peak)
+        {
+            fprintf(stderr, "test_memoryaccounting_net peak blob bytes %zu less than %zu\n", ex.peak_blob_bytes(), min_peak);
+            return -1;
+        }
+    }
+
+    {
+        ncnn::PoolAllocator blob_allocator;
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.set_blob_allocator(&blob_allocator);
+        ex.input("data", in);
+
+        ncnn::Mat out;
+        if (ex.extract("output", out) != 0)
+        {
+            fprintf(stderr, "test_memoryaccounting_net extract failed\n");
+            return -1;
+        }
+
+        // the user allocator keeps its own stats
+        if (ex.peak_blob_bytes() != 0 || blob_allocator.get_peak_payout_bytes() == 0)
+        {
+            fprintf(stderr, "test_memoryaccounting_net user allocator peak %zu %zu\n", ex.peak_blob_bytes(), blob_allocator.get_peak_payout_bytes());
+            return -1;
+        }
+
+        ex.clear();
+        out.release();
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::PoolAllocator pool_allocator;
+    ncnn::UnlockedPoolAllocator unlocked_pool_allocator;
+    if (test_memoryaccounting_pool(pool_allocator) != 0 || test_memoryaccounting_pool(unlocked_pool_allocator) != 0)
+        return -1;
+
+    ncnn::Option opts[2];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (test_memoryaccounting_net(opts[i]) != 0)
+        {
+            fprintf(stderr, "test_memoryaccounting_net failed opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
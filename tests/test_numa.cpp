@@ -0,0 +1,219 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "cpu.h"
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+static const char convnet_param[] = "7767517\n"
+                                    "4 4\n"
+                                    "Input            data     0 1 data\n"
+                                    "Convolution      conv0    1 1 data c0 0=16 1=3 4=1 5=1 6=432 9=1\n"
+                                    "Convolution      conv1    1 1 c0 c1 0=32 1=1 5=1 6=512 9=1\n"
+                                    "InnerProduct     fc0      1 1 c1 output 0=10 1=1 2=35200\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int test_numa_topology()
+{
+    const int node_count = ncnn::get_cpu_numa_node_count();
+    if (node_count < 1)
+    {
+        fprintf(stderr, "test_numa_topology no numa node\n");
+        return -1;
+    }
+
+    // every cpu of a node is a valid cpu and belongs to that node only
+    const int cpu_count = ncnn::get_cpu_count();
+    std::vector<int> owner(cpu_count, -1);
+    for (int i = 0; i < node_count; i++)
+    {
+        const ncnn::CpuSet& mask = ncnn::get_cpu_numa_node_affinity_mask(i);
+        if (mask.num_enabled() == 0)
+        {
+            fprintf(stderr, "test_numa_topology node %d has no cpu\n", i);
+            return -1;
+        }
+
+        int enabled_count = 0;
+        for (int j = 0; j < cpu_count; j++)
+        {
+            if (!mask.is_enabled(j))
+                continue;
+
+            if (owner[j] != -1)
+            {
+                fprintf(stderr, "test_numa_topology cpu %d in node %d and %d\n", j, owner[j], i);
+                return -1;
+            }
+
+            owner[j] = i;
+            enabled_count++;
+        }
+
+        if (enabled_count != mask.num_enabled())
+        {
+            fprintf(stderr, "test_numa_topology node %d has cpu out of range\n", i);
+            return -1;
+        }
+    }
+
+    // interleaving is harmless for any range
+    ncnn::Mat m(1024 * 1024);
+    m.fill(1.f);
+    if (ncnn::set_memory_numa_interleave(m.data, m.total() * m.elemsize) != 0 || ncnn::set_memory_numa_interleave((const float*)m.data + 3, 100) != 0)
+    {
+        fprintf(stderr, "test_numa_topology set_memory_numa_interleave failed\n");
+        return -1;
+    }
+
+    for (int i = 0; i < (int)m.total(); i++)
+    {
+        if (m[i] != 1.f)
+        {
+            fprintf(stderr, "test_numa_topology interleaved memory changed\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int extract(const ncnn::Net& net, const ncnn::Mat& in, int numa_node, int num_threads, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.set_num_threads(num_threads);
+    ex.set_numa_node(numa_node);
+    ex.input("data", in);
+
+    return ex.extract("output", out);
+}
+
+static int test_numa_extractor(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 432, true);
+    append_weight(model, 16, false);
+    append_weight(model, 512, true);
+    append_weight(model, 32, false);
+    append_weight(model, 35200, true);
+    append_weight(model, 10, false);
+
+    ncnn::Mat in = RandomMat(11, 10, 3);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(convnet_param);
+        net.load_model(model.data());
+
+        if (extract(net, in, -1, 1, out_ref) != 0)
+        {
+            fprintf(stderr, "extract reference failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_numa_interleaved_weights(true);
+    net.load_param_mem(convnet_param);
+    net.load_model(model.data());
+
+    ncnn::CpuSet old_thread_affinity;
+    const bool has_thread_affinity = ncnn::get_cpu_thread_affinity(old_thread_affinity) == 0;
+
+    for (int i = 0; i < ncnn::get_cpu_numa_node_count(); i++)
+    {
+        ncnn::Mat out;
+        if (extract(net, in, i, opt.num_threads, out) != 0 || CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_numa_extractor node %d mismatch\n", i);
+            return -1;
+        }
+    }
+
+    // binding to a node that does not exist leaves the extractor unbound
+    ncnn::Mat out;
+    if (extract(net, in, ncnn::get_cpu_numa_node_count(), opt.num_threads, out) != 0 || CompareMat(out_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_numa_extractor unbound mismatch\n");
+        return -1;
+    }
+
+    // the extractors leave the affinity of this thread as it was
+    ncnn::CpuSet thread_affinity;
+    if (has_thread_affinity && ncnn::get_cpu_thread_affinity(thread_affinity) == 0)
+    {
+        for (int i = 0; i < ncnn::get_cpu_count(); i++)
+        {
+            if (thread_affinity.is_enabled(i) != old_thread_affinity.is_enabled(i))
+            {
+                fprintf(stderr, "test_numa_extractor thread affinity changed on cpu %d\n", i);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    if (test_numa_topology() != 0)
+        return -1;
+
+    ncnn::Option opts[2];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (test_numa_extractor(opts[i]) != 0)
+        {
+            fprintf(stderr, "test_numa_extractor failed opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
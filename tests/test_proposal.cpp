@@ -0,0 +1,67 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "layer/proposal.h"
+#include "testutil.h"
+
+static int test_proposal(int w, int h, int feat_stride, int pre_nms_topN, int after_nms_topN, float nms_thresh, int min_size)
+{
+    // 9 anchors from the default 3 ratios x 3 scales
+    const int num_anchors = 9;
+
+    ncnn::Mat im_info(3);
+    im_info[0] = (float)(h * feat_stride);
+    im_info[1] = (float)(w * feat_stride);
+    im_info[2] = 1.f;
+
+    std::vector<ncnn::Mat> a(3);
+    a[0] = RandomMat(w, h, num_anchors * 2, 0.f, 1.f);
+    a[1] = RandomMat(w, h, num_anchors * 4, -0.5f, 0.5f);
+    a[2] = im_info;
+
+    ncnn::ParamDict pd;
+    pd.set(0, feat_stride);
+    pd.set(1, 16); // base_size
+    pd.set(2, pre_nms_topN);
+    pd.set(3, after_nms_topN);
+    pd.set(4, nms_thresh);
+    pd.set(5, min_size);
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer<ncnn::Proposal>("Proposal", pd, weights, a, 2);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_proposal failed w=%d h=%d feat_stride=%d pre_nms_topN=%d after_nms_topN=%d nms_thresh=%f min_size=%d\n", w, h, feat_stride, pre_nms_topN, after_nms_topN, nms_thresh, min_size);
+    }
+
+    return ret;
+}
+
+static int test_proposal_0()
+{
+    return 0
+           || test_proposal(5, 3, 16, 6000, 300, 0.7f, 16)
+           || test_proposal(12, 9, 16, 6000, 300, 0.7f, 16)
+           || test_proposal(15, 13, 16, 300, 50, 0.6f, 8)
+           || test_proposal(7, 11, 8, 0, 20, 0.7f, 4);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return test_proposal_0();
+}
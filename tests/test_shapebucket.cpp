@@ -0,0 +1,336 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// pointwise and strided 1x1 layers only
+// so that the padded pixels never reach the outputs kept after cropping
+static const char convnet_param[] = "7767517\n"
+                                    "6 7\n"
+                                    "Input            data     0 1 data\n"
+                                    "Convolution      conv0    1 1 data c0 0=16 1=1 5=1 6=48 9=1\n"
+                                    "Split            split0   1 2 c0 c0a c0b\n"
+                                    "Convolution      conv1    1 1 c0a c1 0=8 1=1 3=2 5=1 6=128\n"
+                                    "Convolution      conv2    1 1 c0b c2 0=8 1=1 3=2 5=1 6=128 9=1\n"
+                                    "Concat           concat0  2 1 c1 c2 output\n";
+
+// two inputs of their own shapes
+static const char twoinput_param[] = "7767517\n"
+                                     "4 4\n"
+                                     "Input            data     0 1 data\n"
+                                     "Input            data2    0 1 data2\n"
+                                     "Convolution      conv0    1 1 data output 0=8 1=1 3=2 5=1 6=24\n"
+                                     "Convolution      conv1    1 1 data2 output2 0=8 1=1 5=1 6=24\n";
+
+// a 2d output whose rows are the rows of the input
+static const char rows_param[] = "7767517\n"
+                                 "3 3\n"
+                                 "Input            data     0 1 data\n"
+                                 "Convolution      conv0    1 1 data c0 0=1 1=1 5=1 6=3\n"
+                                 "Reshape          reshape0 1 1 c0 output 0=0 1=-1\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const ncnn::Net& net, const ncnn::Mat& in, ncnn::Mat& out, size_t* peak_blob_bytes = 0)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    int ret = ex.extract("output", out);
+    if (peak_blob_bytes)
+        *peak_blob_bytes = ex.peak_blob_bytes();
+    return ret;
+}
+
+static int test_shapebucket_0(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 48, true);
+    append_weight(model, 16, false);
+    append_weight(model, 128, true);
+    append_weight(model, 8, false);
+    append_weight(model, 128, true);
+    append_weight(model, 8, false);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(convnet_param);
+    net_ref.load_model(model.data());
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_shape_bucket(32, 16, 0.5f);
+    net.load_param_mem(convnet_param);
+    net.load_model(model.data());
+
+    // the output is at stride 2 of the input
+    if (net.set_shape_bucket_output("output", "data", 2, 2) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_0 set_shape_bucket_output failed\n");
+        return -1;
+    }
+
+    const int shapes[][2] = {
+        {45, 20},
+        {33, 17},
+        {64, 32},
+        {7, 3},
+        {64, 20},
+        {45, 20}
+    };
+
+    for (int i = 0; i < 6; i++)
+    {
+        ncnn::Mat in = RandomMat(shapes[i][0], shapes[i][1], 3);
+
+        ncnn::Mat out_ref;
+        ncnn::Mat out;
+        if (run_net(net_ref, in, out_ref) != 0 || run_net(net, in, out) != 0)
+        {
+            fprintf(stderr, "test_shapebucket_0 forward failed\n");
+            return -1;
+        }
+
+        if (out.dims != out_ref.dims || out.w != out_ref.w || out.h != out_ref.h || out.c != out_ref.c)
+        {
+            fprintf(stderr, "test_shapebucket_0 output shape %d %d %d expect %d %d %d\n", out.w, out.h, out.c, out_ref.w, out_ref.h, out_ref.c);
+            return -1;
+        }
+
+        if (CompareMat(out_ref, out, 0.001) != 0)
+        {
+            fprintf(stderr, "test_shapebucket_0 output mismatch for input %d x %d\n", shapes[i][0], shapes[i][1]);
+            return -1;
+        }
+    }
+
+    // the input blob comes back without the padding
+    {
+        ncnn::Mat in = RandomMat(45, 20, 3);
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        ncnn::Mat in2;
+        if (ex.extract("data", in2) != 0 || CompareMat(in, in2, 0.001) != 0)
+        {
+            fprintf(stderr, "test_shapebucket_0 input blob mismatch\n");
+            return -1;
+        }
+    }
+
+    // an output not registered keeps the padding
+    {
+        ncnn::Mat in = RandomMat(45, 20, 3);
+
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+
+        ncnn::Mat c0;
+        if (ex.extract("c0", c0) != 0 || c0.w != 64 || c0.h != 32)
+        {
+            fprintf(stderr, "test_shapebucket_0 unregistered output %d x %d expect 64 x 32\n", c0.w, c0.h);
+            return -1;
+        }
+    }
+
+    if (opt.use_local_pool_allocator)
+    {
+        // the blobs of the bucket come from its local pool
+        size_t peak0 = 0;
+        size_t peak1 = 0;
+        ncnn::Mat out0;
+        ncnn::Mat out1;
+        run_net(net, RandomMat(40, 18, 3), out0, &peak0);
+        run_net(net, RandomMat(63, 31, 3), out1, &peak1);
+        if (peak0 == 0 || peak1 == 0)
+        {
+            fprintf(stderr, "test_shapebucket_0 bucket peak blob bytes %zu %zu\n", peak0, peak1);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_shapebucket_1(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 24, true);
+    append_weight(model, 8, false);
+    append_weight(model, 24, true);
+    append_weight(model, 8, false);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(twoinput_param);
+    net_ref.load_model(model.data());
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_shape_bucket(16, 16);
+    net.load_param_mem(twoinput_param);
+    net.load_model(model.data());
+
+    if (net.set_shape_bucket_output("output", "data", 2, 2) != 0 || net.set_shape_bucket_output("output2", "data2", 1, 1) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_1 set_shape_bucket_output failed\n");
+        return -1;
+    }
+
+    // each output is cropped by the padding of its own input, whatever the input order
+    ncnn::Mat in = RandomMat(21, 9, 3);
+    ncnn::Mat in2 = RandomMat(5, 30, 3);
+
+    ncnn::Mat out_ref;
+    ncnn::Mat out2_ref;
+    {
+        ncnn::Extractor ex = net_ref.create_extractor();
+        ex.input("data", in);
+        ex.input("data2", in2);
+        if (ex.extract("output", out_ref) != 0 || ex.extract("output2", out2_ref) != 0)
+        {
+            fprintf(stderr, "test_shapebucket_1 reference forward failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    ex.input("data2", in2);
+
+    ncnn::Mat out;
+    ncnn::Mat out2;
+    if (ex.extract("output", out) != 0 || ex.extract("output2", out2) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_1 forward failed\n");
+        return -1;
+    }
+
+    if (CompareMat(out_ref, out, 0.001) != 0 || CompareMat(out2_ref, out2, 0.001) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_1 output mismatch %d x %d and %d x %d\n", out.w, out.h, out2.w, out2.h);
+        return -1;
+    }
+
+    return 0;
+}
+
+// the packed rows of a 2d output extracted as is are cropped in elements
+static int test_shapebucket_2(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 3, true);
+    append_weight(model, 1, false);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+    opt.use_fp16_storage = false;
+    opt.use_bf16_storage = false;
+
+    ncnn::Net net_ref;
+    net_ref.opt = opt;
+    net_ref.load_param_mem(rows_param);
+    net_ref.load_model(model.data());
+
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_shape_bucket(16, 16);
+    net.load_param_mem(rows_param);
+    net.load_model(model.data());
+
+    if (net.set_shape_bucket_output("output", "data", 1, 1) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_2 set_shape_bucket_output failed\n");
+        return -1;
+    }
+
+    ncnn::Mat in = RandomMat(13, 9, 3);
+
+    ncnn::Mat out_ref;
+    if (run_net(net_ref, in, out_ref) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_2 reference forward failed\n");
+        return -1;
+    }
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+
+    ncnn::Mat out_packed;
+    if (ex.extract("output", out_packed, 1) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_2 forward failed\n");
+        return -1;
+    }
+
+    ncnn::Mat out;
+    ncnn::convert_packing(out_packed, out, 1, opt);
+
+    if (CompareMat(out_ref, out, 0.001) != 0)
+    {
+        fprintf(stderr, "test_shapebucket_2 output mismatch %d x %d elempack %d\n", out_packed.w, out_packed.h, out_packed.elempack);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[3];
+
+    opts[0].num_threads = 1;
+    opts[0].use_packing_layout = false;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = true;
+    opts[1].use_zero_copy_concat_slice = true;
+
+    opts[2].num_threads = 1;
+    opts[2].use_packing_layout = true;
+    opts[2].use_local_pool_allocator = false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_shapebucket_0(opts[i]) || test_shapebucket_1(opts[i]) || test_shapebucket_2(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "layer/convolution.h"
+#include "layer/innerproduct.h"
+#include "testutil.h"
+
+// outch x inch weight with most input columns pruned away
+// and some scattered zeros in the columns kept
+static ncnn::Mat RandomPrunedWeight(int outch, int inch, float density)
+{
+    ncnn::Mat m = RandomMat(outch * inch);
+
+    for (int k = 0; k < inch; k++)
+    {
+        const bool pruned = RandomFloat(0.f, 1.f) > density;
+
+        for (int q = 0; q < outch; q++)
+        {
+            if (pruned || RandomFloat(0.f, 1.f) < 0.3f)
+                m[q * inch + k] = 0.f;
+        }
+    }
+
+    return m;
+}
+
+static int test_sparseweight_layer_opts(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const ncnn::Mat& a)
+{
+    ncnn::Option opts[4];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_packed = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_packed = false;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_packed = true;
+    opts[2].use_fp16_storage = true;
+    opts[2].use_bf16_storage = false;
+
+    opts[3].use_packing_layout = true;
+    opts[3].use_fp16_packed = false;
+    opts[3].use_fp16_storage = false;
+    opts[3].use_bf16_storage = true;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = 1;
+        opt.use_fp16_arithmetic = false;
+        opt.use_shader_pack8 = false;
+        opt.use_image_storage = false;
+        opt.use_sparse_weight = true;
+
+        int ret = strcmp(layer_type, "InnerProduct") == 0
+                  ? test_layer_opt<ncnn::InnerProduct>(layer_type, pd, weights, opt, a)
+                  : test_layer_opt<ncnn::Convolution>(layer_type, pd, weights, opt, a);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+static int test_sparseweight_innerproduct(const ncnn::Mat& a, int outch, int bias, float density)
+{
+    const int inch = a.w * a.h * a.c;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch); // num_output
+    pd.set(1, bias);  // bias_term
+    pd.set(2, outch * inch);
+
+    int activation_type = RAND() % 7; // 0 1 2 3 4 5 6
+    ncnn::Mat activation_params(2);
+    activation_params[0] = (activation_type == 6) ? RandomFloat(0, 1) : RandomFloat(-1, 0); // alpha
+    activation_params[1] = RandomFloat(0, 1);                                               // beta
+    pd.set(9, activation_type);
+    pd.set(10, activation_params);
+
+    std::vector<ncnn::Mat> weights(bias ? 2 : 1);
+    weights[0] = RandomPrunedWeight(outch, inch, density);
+    if (bias)
+        weights[1] = RandomMat(outch);
+
+    int ret = test_sparseweight_layer_opts("InnerProduct", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_sparseweight_innerproduct failed a.dims=%d a=(%d %d %d) outch=%d bias=%d density=%f act=%d actparams=[%f,%f]\n", a.dims, a.w, a.h, a.c, outch, bias, density, activation_type, activation_params[0], activation_params[1]);
+    }
+
+    return ret;
+}
+
+static int test_sparseweight_convolution(int w, int h, int c, int outch, int pad, int bias, float density)
+{
+    ncnn::Mat a = RandomMat(w, h, c);
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, 1);
+    pd.set(2, 1);
+    pd.set(3, 1);
+    pd.set(4, pad);
+    pd.set(5, bias);
+    pd.set(6, outch * c);
+
+    int activation_type = RAND() % 7; // 0 1 2 3 4 5 6
+    ncnn::Mat activation_params(2);
+    activation_params[0] = (activation_type == 6) ? RandomFloat(0, 1) : RandomFloat(-1, 0); // alpha
+    activation_params[1] = RandomFloat(0, 1);                                               // beta
+    pd.set(9, activation_type);
+    pd.set(10, activation_params);
+
+    std::vector<ncnn::Mat> weights(bias ? 2 : 1);
+    weights[0] = RandomPrunedWeight(outch, c, density);
+    if (bias)
+        weights[1] = RandomMat(outch);
+
+    int ret = test_sparseweight_layer_opts("Convolution", pd, weights, a);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_sparseweight_convolution failed w=%d h=%d c=%d outch=%d pad=%d bias=%d density=%f act=%d actparams=[%f,%f]\n", w, h, c, outch, pad, bias, density, activation_type, activation_params[0], activation_params[1]);
+    }
+
+    return ret;
+}
+
+static int test_sparseweight_0()
+{
+    return 0
+           || test_sparseweight_innerproduct(RandomMat(64), 16, 1, 0.2f)
+           || test_sparseweight_innerproduct(RandomMat(61), 13, 0, 0.2f)
+           || test_sparseweight_innerproduct(RandomMat(128), 40, 1, 0.1f)
+           || test_sparseweight_innerproduct(RandomMat(4, 4, 8), 24, 1, 0.2f)
+           || test_sparseweight_innerproduct(RandomMat(64), 16, 1, 0.9f)
+           || test_sparseweight_innerproduct(RandomMat(64), 16, 1, 0.f);
+}
+
+static int test_sparseweight_1()
+{
+    // gemm rows
+    return 0
+           || test_sparseweight_innerproduct(RandomMat(64, 8), 16, 1, 0.2f)
+           || test_sparseweight_innerproduct(RandomMat(48, 5), 21, 0, 0.2f)
+           || test_sparseweight_innerproduct(RandomMat(96, 16), 32, 1, 0.1f);
+}
+
+static int test_sparseweight_2()
+{
+    return 0
+           || test_sparseweight_convolution(9, 7, 32, 16, 0, 1, 0.2f)
+           || test_sparseweight_convolution(13, 11, 24, 40, 0, 0, 0.2f)
+           || test_sparseweight_convolution(5, 4, 16, 7, 1, 1, 0.2f)
+           || test_sparseweight_convolution(17, 17, 64, 64, 0, 1, 0.1f)
+           || test_sparseweight_convolution(6, 6, 3, 12, 0, 1, 0.3f)
+           || test_sparseweight_convolution(9, 7, 32, 16, 0, 1, 0.9f);
+}
+
+// the sparse path must be taken with the default 16bit storage options too
+static int test_sparseweight_default_option(bool use_bf16_storage)
+{
+    const int inch = 64;
+    const int outch = 16;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch); // num_output
+    pd.set(1, 1);     // bias_term
+    pd.set(2, outch * inch);
+
+    std::vector<ncnn::Mat> weights(2);
+    weights[0] = RandomPrunedWeight(outch, inch, 0.2f);
+    weights[1] = RandomMat(outch);
+
+    ncnn::Option opt;
+    opt.num_threads = 1;
+    opt.use_bf16_storage = use_bf16_storage;
+    opt.use_sparse_weight = true;
+
+    ncnn::Layer* op = ncnn::create_layer("InnerProduct");
+
+    op->load_param(pd);
+
+    ncnn::ModelBinFromMatArray mb(weights.data());
+
+    op->load_model(mb);
+
+    op->create_pipeline(opt);
+
+    int ret = 0;
+
+    // the layout of the exported mats is the one of InnerProduct_x86
+    std::vector<ncnn::Mat> mats;
+    if (op->save_weight_cache(mats) == 0)
+    {
+        if (mats.size() != 4 || mats[3].empty())
+        {
+            fprintf(stderr, "test_sparseweight_default_option sparse path not taken use_bf16_storage=%d\n", use_bf16_storage);
+            ret = -1;
+        }
+    }
+
+    op->destroy_pipeline(opt);
+
+    delete op;
+
+    return ret;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_sparseweight_0()
+           || test_sparseweight_1()
+           || test_sparseweight_2()
+           || test_sparseweight_default_option(false)
+           || test_sparseweight_default_option(true);
+}
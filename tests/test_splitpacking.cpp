@@ -0,0 +1,193 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// split fans out to layers with and without packing support
+static const char fanout_param[] = "7767517\n"
+                                   "10 14\n"
+                                   "Input            data     0 1 data\n"
+                                   "Convolution      conv0    1 1 data c0 0=16 1=3 4=1 5=1 6=1728\n"
+                                   "Split            split0   1 4 c0 c0_0 c0_1 c0_2 c0_3\n"
+                                   "Power            pow0     1 1 c0_0 p0 0=1.000000e+00 1=5.000000e-01 2=1.000000e-01\n"
+                                   "Power            pow1     1 1 c0_1 p1 0=2.000000e+00\n"
+                                   "Convolution      conv1    1 1 c0_2 c1 0=16 1=1 5=1 6=256\n"
+                                   "Split            split1   1 2 c0_3 s0 s1\n"
+                                   "AbsVal           abs0     1 1 s0 a0\n"
+                                   "Power            pow2     1 1 s1 p2 0=1.000000e+00 1=-1.000000e+00\n"
+                                   "Concat           cat0     5 1 p0 p1 c1 a0 p2 output\n";
+
+// split between layers that all support packing
+static const char packed_param[] = "7767517\n"
+                                   "6 7\n"
+                                   "Input            data     0 1 data\n"
+                                   "Convolution      conv0    1 1 data c0 0=16 1=3 4=1 5=1 6=1728\n"
+                                   "Split            split0   1 2 c0 c0_0 c0_1\n"
+                                   "Convolution      conv1    1 1 c0_0 c1 0=16 1=1 5=1 6=256\n"
+                                   "ReLU             relu0    1 1 c0_1 r0\n"
+                                   "Eltwise          sum0     2 1 c1 r0 output 0=1\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const char* param, const std::vector<unsigned char>& model, const ncnn::Option& opt, bool split_packing, const ncnn::Mat& in, ncnn::Mat& out, int* removed_repacks = 0)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.set_split_output_packing(split_packing);
+
+    int ret = net.load_param_mem(param);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param_mem failed\n");
+        return -1;
+    }
+
+    net.load_model(model.data());
+
+    if (!split_packing && net.split_packing_removed_repacks() != 0)
+    {
+        fprintf(stderr, "repacks removed without split output packing\n");
+        return -1;
+    }
+
+    if (removed_repacks)
+        *removed_repacks = net.split_packing_removed_repacks();
+
+    // run twice to cover the reuse of the plan
+    for (int i = 0; i < 2; i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+
+        ex.input("data", in);
+
+        ret = ex.extract("output", out);
+        if (ret != 0)
+        {
+            fprintf(stderr, "extract output failed\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_splitpacking(const char* param, const std::vector<unsigned char>& model, const ncnn::Mat& in, bool removes_packing)
+{
+    ncnn::Option opts[4];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_storage = false;
+    opts[2].use_bf16_storage = true;
+
+    opts[3].use_packing_layout = true;
+    opts[3].use_fp16_storage = true;
+    opts[3].use_bf16_storage = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = 1;
+        opt.use_vulkan_compute = false;
+
+        for (int j = 0; j < 2; j++)
+        {
+            opt.lightmode = j == 0;
+
+            ncnn::Mat out_ref;
+            ncnn::Mat out_split;
+            int removed_repacks = 0;
+            if (run_net(param, model, opt, false, in, out_ref) != 0
+                    || run_net(param, model, opt, true, in, out_split, &removed_repacks) != 0)
+            {
+                fprintf(stderr, "test_splitpacking failed opt %d lightmode %d\n", i, opt.lightmode);
+                return -1;
+            }
+
+            // the split fanning out to unpacked layers passes on pack1
+            if (removes_packing && opt.use_packing_layout && removed_repacks == 0)
+            {
+                fprintf(stderr, "test_splitpacking no repack removed opt %d lightmode %d\n", i, opt.lightmode);
+                return -1;
+            }
+
+            // the 16bit casts stay where they are, so the result is the same either way
+            if (CompareMat(out_ref, out_split, 0.001) != 0)
+            {
+                fprintf(stderr, "test_splitpacking output mismatch opt %d lightmode %d\n", i, opt.lightmode);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int test_splitpacking_0()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 1728, true);
+    append_weight(model, 16, false);
+    append_weight(model, 256, true);
+    append_weight(model, 16, false);
+
+    return 0
+           || test_splitpacking(fanout_param, model, RandomMat(13, 11, 12), true)
+           || test_splitpacking(fanout_param, model, RandomMat(6, 8, 12), true);
+}
+
+static int test_splitpacking_1()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 1728, true);
+    append_weight(model, 16, false);
+    append_weight(model, 256, true);
+    append_weight(model, 16, false);
+
+    return 0
+           || test_splitpacking(packed_param, model, RandomMat(13, 11, 12), false)
+           || test_splitpacking(packed_param, model, RandomMat(5, 7, 12), false);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_splitpacking_0()
+           || test_splitpacking_1();
+}
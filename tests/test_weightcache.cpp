@@ -0,0 +1,240 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// conv3x3 winograd - conv1x1 gemm - conv5x5s2 packed - innerproduct - gemm
+static const char net_param[] = "7767517\n"
+                                "7 7\n"
+                                "Input            data     0 1 data\n"
+                                "Convolution      conv0    1 1 data c0 0=24 1=3 4=1 5=1 6=3456 9=1\n"
+                                "Convolution      conv1    1 1 c0 c1 0=32 1=1 5=1 6=768\n"
+                                "Convolution      conv2    1 1 c1 c2 0=8 1=5 3=2 5=1 6=6400 9=2 -23310=1,0.1\n"
+                                "InnerProduct     fc0      1 1 c2 f0 0=48 1=1 2=21504\n"
+                                "Reshape          reshape0 1 1 f0 r0 0=16 1=3\n"
+                                "Gemm             gemm0    1 1 r0 output 5=1 8=12 9=16\n";
+
+// the same weights with a dilated conv0, whose weights are transformed for im2col instead of winograd
+static const char net_param_dilated[] = "7767517\n"
+                                        "7 7\n"
+                                        "Input            data     0 1 data\n"
+                                        "Convolution      conv0    1 1 data c0 0=24 1=3 2=2 4=2 5=1 6=3456 9=1\n"
+                                        "Convolution      conv1    1 1 c0 c1 0=32 1=1 5=1 6=768\n"
+                                        "Convolution      conv2    1 1 c1 c2 0=8 1=5 3=2 5=1 6=6400 9=2 -23310=1,0.1\n"
+                                        "InnerProduct     fc0      1 1 c2 f0 0=48 1=1 2=21504\n"
+                                        "Reshape          reshape0 1 1 f0 r0 0=16 1=3\n"
+                                        "Gemm             gemm0    1 1 r0 output 5=1 8=12 9=16\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const char* param, const std::vector<unsigned char>& model, const ncnn::Option& opt, const char* save_cache, const unsigned char* cache_mem, const char* cache_path, const ncnn::Mat& in, ncnn::Mat& out)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.opt.use_weight_cache = true;
+
+    int ret = net.load_param_mem(param);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param_mem failed\n");
+        return -1;
+    }
+
+    if (cache_mem)
+    {
+        ret = net.load_weight_cache(cache_mem);
+        if (ret != 0)
+        {
+            fprintf(stderr, "load_weight_cache from memory failed\n");
+            return -1;
+        }
+    }
+
+    if (cache_path)
+    {
+        ret = net.load_weight_cache(cache_path);
+        if (ret != 0)
+        {
+            fprintf(stderr, "load_weight_cache %s failed\n", cache_path);
+            return -1;
+        }
+    }
+
+    net.load_model(model.data());
+
+    if (save_cache)
+    {
+        ret = net.save_weight_cache(save_cache);
+        if (ret != 0)
+        {
+            fprintf(stderr, "save_weight_cache %s failed\n", save_cache);
+            return -1;
+        }
+    }
+
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("data", in);
+
+    ret = ex.extract("output", out);
+    if (ret != 0)
+    {
+        fprintf(stderr, "extract output failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int read_file(const char* path, ncnn::Mat& data)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    // 64-byte aligned for zero-copy reference
+    data.create((int)size, (size_t)1u);
+    size_t nread = fread(data.data, 1, size, fp);
+    fclose(fp);
+
+    return nread == (size_t)size ? 0 : -1;
+}
+
+static int test_weightcache(int num_threads)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 3456, true);
+    append_weight(model, 24, false);
+    append_weight(model, 768, true);
+    append_weight(model, 32, false);
+    append_weight(model, 6400, true);
+    append_weight(model, 8, false);
+    append_weight(model, 21504, true);
+    append_weight(model, 48, false);
+    append_weight(model, 192, true);
+
+    const char* cache_path = "test_weightcache.bin";
+
+    ncnn::Mat in = RandomMat(19, 17, 16);
+
+    ncnn::Option opts[3];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_storage = false;
+    opts[2].use_bf16_storage = true;
+
+    for (int i = 0; i < 3; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = num_threads;
+        opt.use_vulkan_compute = false;
+
+        ncnn::Mat out_ref;
+        if (run_net(net_param, model, opt, cache_path, 0, 0, in, out_ref) != 0)
+        {
+            fprintf(stderr, "test_weightcache save failed opt %d\n", i);
+            return -1;
+        }
+
+        ncnn::Mat cache;
+        if (read_file(cache_path, cache) != 0)
+        {
+            fprintf(stderr, "test_weightcache read %s failed\n", cache_path);
+            return -1;
+        }
+
+        ncnn::Mat out_file;
+        ncnn::Mat out_mem;
+        if (run_net(net_param, model, opt, 0, 0, cache_path, in, out_file) != 0
+                || run_net(net_param, model, opt, 0, (const unsigned char*)cache.data, 0, in, out_mem) != 0)
+        {
+            fprintf(stderr, "test_weightcache load failed opt %d\n", i);
+            return -1;
+        }
+
+        // the cache is ignored with another thread count
+        ncnn::Option opt2 = opt;
+        opt2.num_threads = num_threads + 1;
+
+        ncnn::Mat out_mismatch;
+        if (run_net(net_param, model, opt2, 0, 0, cache_path, in, out_mismatch) != 0)
+        {
+            fprintf(stderr, "test_weightcache mismatch failed opt %d\n", i);
+            return -1;
+        }
+
+        if (CompareMat(out_ref, out_file, 0.001) != 0 || CompareMat(out_ref, out_mem, 0.001) != 0 || CompareMat(out_ref, out_mismatch, 0.001) != 0)
+        {
+            fprintf(stderr, "test_weightcache output mismatch opt %d\n", i);
+            return -1;
+        }
+
+        // the entries of conv0 are ignored with other params of the same weights
+        ncnn::Mat out_dilated_ref;
+        ncnn::Mat out_dilated;
+        if (run_net(net_param_dilated, model, opt, 0, 0, 0, in, out_dilated_ref) != 0
+                || run_net(net_param_dilated, model, opt, 0, 0, cache_path, in, out_dilated) != 0)
+        {
+            fprintf(stderr, "test_weightcache param mismatch failed opt %d\n", i);
+            return -1;
+        }
+
+        if (CompareMat(out_dilated_ref, out_dilated, 0.001) != 0)
+        {
+            fprintf(stderr, "test_weightcache param mismatch output mismatch opt %d\n", i);
+            return -1;
+        }
+    }
+
+    remove(cache_path);
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_weightcache(1)
+           || test_weightcache(2);
+}
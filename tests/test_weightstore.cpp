@@ -0,0 +1,333 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// conv0 is shared by both params, conv1 only by the first
+static const char store_param[] = "7767517\n"
+                                  "5 5\n"
+                                  "Input            data     0 1 data\n"
+                                  "Convolution      conv0    1 1 data c0 0=8 1=3 4=1 5=1 6=216 9=1\n"
+                                  "Convolution      conv1    1 1 c0 c1 0=16 1=3 4=1 5=1 6=1152\n"
+                                  "Pooling          pool0    1 1 c1 c2 0=1 4=1\n"
+                                  "InnerProduct     fc0      1 1 c2 output 0=10 1=1 2=160\n";
+
+// same weights, conv1 with stride 2
+static const char store_stride_param[] = "7767517\n"
+                                         "5 5\n"
+                                         "Input            data     0 1 data\n"
+                                         "Convolution      conv0    1 1 data c0 0=8 1=3 4=1 5=1 6=216 9=1\n"
+                                         "Convolution      conv1    1 1 c0 c1 0=16 1=3 3=2 4=1 5=1 6=1152\n"
+                                         "Pooling          pool0    1 1 c1 c2 0=1 4=1\n"
+                                         "InnerProduct     fc0      1 1 c2 output 0=10 1=1 2=160\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int run_net(const ncnn::Net& net, const ncnn::Mat& in, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    return ex.extract("output", out);
+}
+
+// the first transformed weight of the layer
+static const void* layer_weight_data(const ncnn::Net& net, int layer_index)
+{
+    std::vector<ncnn::Mat> mats;
+    if (net.layers()[layer_index]->save_weight_cache(mats) != 0)
+        return 0;
+
+    for (size_t i = 0; i < mats.size(); i++)
+    {
+        if (!mats[i].empty())
+            return mats[i].data;
+    }
+
+    return 0;
+}
+
+static int test_weightstore_0(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 216, true);
+    append_weight(model, 8, false);
+    append_weight(model, 1152, true);
+    append_weight(model, 16, false);
+    append_weight(model, 160, true);
+    append_weight(model, 10, false);
+
+    // another copy of the same model
+    std::vector<unsigned char> model2 = model;
+
+    ncnn::Mat in = RandomMat(11, 10, 3);
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Net net;
+        net.opt = opt;
+        net.load_param_mem(store_param);
+        net.load_model(model.data());
+
+        if (run_net(net, in, out_ref) != 0)
+        {
+            fprintf(stderr, "test_weightstore_0 reference forward failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Net net0;
+    net0.opt = opt;
+    net0.set_shared_weight_store(true);
+    net0.load_param_mem(store_param);
+    net0.load_model(model.data());
+
+    ncnn::Net net1;
+    net1.opt = opt;
+    net1.set_shared_weight_store(true);
+    net1.load_param_mem(store_param);
+    net1.load_model(model2.data());
+
+    // the convolutions reference the same transformed weights
+    for (int i = 1; i < 3; i++)
+    {
+        const void* data0 = layer_weight_data(net0, i);
+        const void* data1 = layer_weight_data(net1, i);
+        if (!data0 || data0 != data1)
+        {
+            fprintf(stderr, "test_weightstore_0 layer %d weights not shared %p %p\n", i, data0, data1);
+            return -1;
+        }
+    }
+
+    ncnn::Mat out0;
+    ncnn::Mat out1;
+    if (run_net(net0, in, out0) != 0 || run_net(net1, in, out1) != 0)
+    {
+        fprintf(stderr, "test_weightstore_0 forward failed\n");
+        return -1;
+    }
+
+    if (CompareMat(out_ref, out0, 0.001) != 0 || CompareMat(out_ref, out1, 0.001) != 0)
+    {
+        fprintf(stderr, "test_weightstore_0 output mismatch\n");
+        return -1;
+    }
+
+    // the second net keeps working after the first one is gone
+    net0.clear();
+
+    ncnn::Mat out2;
+    if (run_net(net1, in, out2) != 0 || CompareMat(out_ref, out2, 0.001) != 0)
+    {
+        fprintf(stderr, "test_weightstore_0 output mismatch after clear\n");
+        return -1;
+    }
+
+    // a net loaded later picks up the weights still held by net1
+    ncnn::Net net2;
+    net2.opt = opt;
+    net2.set_shared_weight_store(true);
+    net2.load_param_mem(store_param);
+    net2.load_model(model.data());
+
+    if (layer_weight_data(net2, 2) != layer_weight_data(net1, 2))
+    {
+        fprintf(stderr, "test_weightstore_0 weights not shared after clear\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_weightstore_1(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 216, true);
+    append_weight(model, 8, false);
+    append_weight(model, 1152, true);
+    append_weight(model, 16, false);
+    append_weight(model, 160, true);
+    append_weight(model, 10, false);
+
+    // same shapes, different conv1 weights
+    std::vector<unsigned char> model_other = model;
+    {
+        float* ptr = (float*)&model_other[(4 + 216 + 8 + 4) * 4];
+        ptr[0] += 1.f;
+    }
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net net0;
+    net0.opt = opt;
+    net0.set_shared_weight_store(true);
+    net0.load_param_mem(store_param);
+    net0.load_model(model.data());
+
+    ncnn::Net net1;
+    net1.opt = opt;
+    net1.set_shared_weight_store(true);
+    net1.load_param_mem(store_stride_param);
+    net1.load_model(model.data());
+
+    ncnn::Net net2;
+    net2.opt = opt;
+    net2.set_shared_weight_store(true);
+    net2.load_param_mem(store_param);
+    net2.load_model(model_other.data());
+
+    // another thread count steers the transform
+    ncnn::Net net3;
+    net3.opt = opt;
+    net3.set_shared_weight_store(true);
+    net3.opt.num_threads = opt.num_threads + 1;
+    net3.load_param_mem(store_param);
+    net3.load_model(model.data());
+
+    if (layer_weight_data(net0, 1) != layer_weight_data(net1, 1) || layer_weight_data(net0, 1) != layer_weight_data(net2, 1))
+    {
+        fprintf(stderr, "test_weightstore_1 conv0 weights not shared\n");
+        return -1;
+    }
+
+    if (layer_weight_data(net0, 2) == layer_weight_data(net1, 2))
+    {
+        fprintf(stderr, "test_weightstore_1 conv1 shared across params\n");
+        return -1;
+    }
+
+    if (layer_weight_data(net0, 2) == layer_weight_data(net2, 2))
+    {
+        fprintf(stderr, "test_weightstore_1 conv1 shared across weights\n");
+        return -1;
+    }
+
+    if (layer_weight_data(net0, 2) == layer_weight_data(net3, 2))
+    {
+        fprintf(stderr, "test_weightstore_1 conv1 shared across options\n");
+        return -1;
+    }
+
+    ncnn::Mat in = RandomMat(11, 10, 3);
+
+    ncnn::Mat out1;
+    if (run_net(net1, in, out1) != 0 || out1.w != 10)
+    {
+        fprintf(stderr, "test_weightstore_1 forward failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_weightstore_2(const ncnn::Option& _opt)
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 216, true);
+    append_weight(model, 8, false);
+    append_weight(model, 1152, true);
+    append_weight(model, 16, false);
+    append_weight(model, 160, true);
+    append_weight(model, 10, false);
+
+    // many entries in the store, each model differs in one conv1 weight
+    const int model_count = 6;
+    std::vector<unsigned char> models[model_count];
+    for (int i = 0; i < model_count; i++)
+    {
+        models[i] = model;
+        float* ptr = (float*)&models[i][(4 + 216 + 8 + 4) * 4];
+        ptr[i * 7] += 1.f;
+    }
+
+    ncnn::Option opt = _opt;
+    opt.use_vulkan_compute = false;
+
+    ncnn::Net nets0[model_count];
+    for (int i = 0; i < model_count; i++)
+    {
+        nets0[i].opt = opt;
+        nets0[i].set_shared_weight_store(true);
+        nets0[i].load_param_mem(store_param);
+        nets0[i].load_model(models[i].data());
+    }
+
+    // look them up again in another order
+    ncnn::Net nets1[model_count];
+    for (int i = model_count - 1; i >= 0; i--)
+    {
+        nets1[i].opt = opt;
+        nets1[i].set_shared_weight_store(true);
+        nets1[i].load_param_mem(store_param);
+        nets1[i].load_model(models[i].data());
+    }
+
+    for (int i = 0; i < model_count; i++)
+    {
+        for (int j = 0; j < model_count; j++)
+        {
+            const bool same = layer_weight_data(nets0[i], 2) == layer_weight_data(nets1[j], 2);
+            if (same != (i == j))
+            {
+                fprintf(stderr, "test_weightstore_2 conv1 of model %d and %d shared %d\n", i, j, same);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[2];
+
+    opts[0].num_threads = 1;
+    opts[0].use_packing_layout = false;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = true;
+    opts[1].use_layer_fusion = true;
+
+    for (int i = 0; i < 2; i++)
+    {
+        int ret = test_weightstore_0(opts[i]) || test_weightstore_1(opts[i]) || test_weightstore_2(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
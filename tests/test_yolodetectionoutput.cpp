@@ -0,0 +1,66 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "layer/yolodetectionoutput.h"
+#include "testutil.h"
+
+static int test_yolodetectionoutput(const std::vector<ncnn::Mat>& a, int num_class, int num_box, float confidence_threshold, float nms_threshold)
+{
+    ncnn::Mat biases(num_box * 2);
+    Randomize(biases, 0.5f, 8.f);
+
+    ncnn::ParamDict pd;
+    pd.set(0, num_class);
+    pd.set(1, num_box);
+    pd.set(2, confidence_threshold);
+    pd.set(3, nms_threshold);
+    pd.set(4, biases);
+
+    std::vector<ncnn::Mat> weights(0);
+
+    int ret = test_layer<ncnn::YoloDetectionOutput>("YoloDetectionOutput", pd, weights, a, a.size());
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_yolodetectionoutput failed a.dims=%d a=(%d %d %d) num_class=%d num_box=%d confidence_threshold=%f nms_threshold=%f\n", a[0].dims, a[0].w, a[0].h, a[0].c, num_class, num_box, confidence_threshold, nms_threshold);
+    }
+
+    return ret;
+}
+
+static int test_yolodetectionoutput_0()
+{
+    std::vector<ncnn::Mat> a(1);
+    a[0] = RandomMat(13, 13, 5 * (4 + 1 + 20), -6.f, 1.5f);
+
+    return test_yolodetectionoutput(a, 20, 5, 0.3f, 0.45f);
+}
+
+static int test_yolodetectionoutput_1()
+{
+    std::vector<ncnn::Mat> a(2);
+    a[0] = RandomMat(7, 6, 3 * (4 + 1 + 3), -3.f, 1.5f);
+    a[1] = RandomMat(14, 12, 3 * (4 + 1 + 3), -3.f, 1.5f);
+
+    return test_yolodetectionoutput(a, 3, 3, 0.2f, 0.5f);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_yolodetectionoutput_0()
+           || test_yolodetectionoutput_1();
+}
@@ -0,0 +1,206 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "net.h"
+#include "testutil.h"
+
+#include <string.h>
+
+// even slice and concat of non-inplace producers
+static const char even_param[] = "7767517\n"
+                                 "7 8\n"
+                                 "Input            data     0 1 data\n"
+                                 "Convolution      conv0    1 1 data c0 0=48 1=3 4=1 5=1 6=5184\n"
+                                 "Slice            slice0   1 2 c0 s0 s1 -23300=2,16,-233 1=0\n"
+                                 "Convolution      conv1    1 1 s0 c1 0=32 1=1 5=1 6=512\n"
+                                 "Convolution      conv2    1 1 s1 c2 0=16 1=3 4=1 5=1 6=4608\n"
+                                 "Concat           cat0     2 1 c1 c2 cat0 0=0\n"
+                                 "Convolution      conv3    1 1 cat0 output 0=8 1=1 5=1 6=384\n";
+
+// slice not matching the packing and an inplace producer
+static const char uneven_param[] = "7767517\n"
+                                   "8 9\n"
+                                   "Input            data     0 1 data\n"
+                                   "Convolution      conv0    1 1 data c0 0=40 1=1 5=1 6=480\n"
+                                   "Slice            slice0   1 2 c0 s0 s1 -23300=2,8,-233 1=-3\n"
+                                   "Convolution      conv1    1 1 s0 c1 0=16 1=1 5=1 6=128\n"
+                                   "ReLU             relu0    1 1 s1 r1\n"
+                                   "Concat           cat0     2 1 c1 r1 cat0 0=-3\n"
+                                   "Pooling          pool0    1 1 cat0 p0 0=0 1=2 2=2\n"
+                                   "Convolution      conv3    1 1 p0 output 0=8 1=1 5=1 6=384\n";
+
+static void append_weight(std::vector<unsigned char>& model, int size, bool with_flag)
+{
+    if (with_flag)
+    {
+        // raw fp32 data follows
+        model.resize(model.size() + 4, 0);
+    }
+
+    ncnn::Mat m = RandomMat(size, -0.2f, 0.2f);
+
+    size_t offset = model.size();
+    model.resize(offset + size * sizeof(float));
+    memcpy(&model[offset], m.data, size * sizeof(float));
+}
+
+static int load_net(ncnn::Net& net, const char* param, const std::vector<unsigned char>& model, const ncnn::Option& opt, bool zero_copy)
+{
+    net.opt = opt;
+    net.opt.use_zero_copy_concat_slice = zero_copy;
+
+    int ret = net.load_param_mem(param);
+    if (ret != 0)
+    {
+        fprintf(stderr, "load_param_mem failed\n");
+        return -1;
+    }
+
+    net.load_model(model.data());
+
+    return 0;
+}
+
+static int extract(const ncnn::Net& net, const ncnn::Mat& in, const char* blob_name, ncnn::Mat& out)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("data", in);
+
+    int ret = ex.extract(blob_name, out);
+    if (ret != 0)
+    {
+        fprintf(stderr, "extract %s failed\n", blob_name);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_zerocopyconcatslice(const char* param, const std::vector<unsigned char>& model, const std::vector<ncnn::Mat>& inputs, const char* slice_blob_name)
+{
+    ncnn::Option opts[4];
+
+    opts[0].use_packing_layout = false;
+    opts[0].use_fp16_storage = false;
+    opts[0].use_bf16_storage = false;
+
+    opts[1].use_packing_layout = true;
+    opts[1].use_fp16_storage = false;
+    opts[1].use_bf16_storage = false;
+
+    opts[2].use_packing_layout = true;
+    opts[2].use_fp16_storage = false;
+    opts[2].use_bf16_storage = true;
+
+    opts[3].use_packing_layout = true;
+    opts[3].use_fp16_storage = true;
+    opts[3].use_bf16_storage = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Option opt = opts[i];
+        opt.num_threads = 1;
+        opt.use_vulkan_compute = false;
+        opt.lightmode = true;
+
+        ncnn::Net net_ref;
+        ncnn::Net net;
+        if (load_net(net_ref, param, model, opt, false) != 0 || load_net(net, param, model, opt, true) != 0)
+            return -1;
+
+        // the same net sees changing shapes, the output preallocated for the previous shape is not reused
+        for (size_t j = 0; j < inputs.size(); j++)
+        {
+            ncnn::Mat out_ref;
+            ncnn::Mat out;
+            if (extract(net_ref, inputs[j], "output", out_ref) != 0 || extract(net, inputs[j], "output", out) != 0)
+            {
+                fprintf(stderr, "test_zerocopyconcatslice failed opt %d input %d\n", i, (int)j);
+                return -1;
+            }
+
+            if (CompareMat(out_ref, out, 0.001) != 0)
+            {
+                fprintf(stderr, "test_zerocopyconcatslice output mismatch opt %d input %d\n", i, (int)j);
+                return -1;
+            }
+        }
+
+        // a slice output outlives its extractor
+        ncnn::Mat slice_ref;
+        ncnn::Mat slice;
+        if (extract(net_ref, inputs[0], slice_blob_name, slice_ref) != 0 || extract(net, inputs[0], slice_blob_name, slice) != 0)
+        {
+            fprintf(stderr, "test_zerocopyconcatslice failed opt %d\n", i);
+            return -1;
+        }
+
+        if (CompareMat(slice_ref, slice, 0.001) != 0)
+        {
+            fprintf(stderr, "test_zerocopyconcatslice slice output mismatch opt %d\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_zerocopyconcatslice_0()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 5184, true);
+    append_weight(model, 48, false);
+    append_weight(model, 512, true);
+    append_weight(model, 32, false);
+    append_weight(model, 4608, true);
+    append_weight(model, 16, false);
+    append_weight(model, 384, true);
+    append_weight(model, 8, false);
+
+    std::vector<ncnn::Mat> inputs(4);
+    inputs[0] = RandomMat(13, 11, 12);
+    inputs[1] = RandomMat(13, 11, 12);
+    inputs[2] = RandomMat(6, 8, 12);
+    inputs[3] = RandomMat(13, 11, 12);
+
+    return test_zerocopyconcatslice(even_param, model, inputs, "s1");
+}
+
+static int test_zerocopyconcatslice_1()
+{
+    std::vector<unsigned char> model;
+    append_weight(model, 480, true);
+    append_weight(model, 40, false);
+    append_weight(model, 128, true);
+    append_weight(model, 16, false);
+    append_weight(model, 384, true);
+    append_weight(model, 8, false);
+
+    std::vector<ncnn::Mat> inputs(3);
+    inputs[0] = RandomMat(9, 10, 12);
+    inputs[1] = RandomMat(9, 10, 12);
+    inputs[2] = RandomMat(4, 5, 12);
+
+    return test_zerocopyconcatslice(uneven_param, model, inputs, "s0");
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_zerocopyconcatslice_0()
+           || test_zerocopyconcatslice_1();
+}
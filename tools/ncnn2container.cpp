@@ -0,0 +1,483 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2023 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// pack ncnn param, bin and an optional weight cache into one container file
+//
+// header   : magic, version, section count, reserved
+// sections : type, reserved, 64bit offset, 64bit size
+// each section data starts at 64-byte aligned offset
+
+#include "layer.h"
+#include "layer_type.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+enum
+{
+    container_section_param = 1,
+    container_section_names = 2,
+    container_section_weight_cache = 3,
+    container_section_model = 4
+};
+
+static const int container_magic = 0x6e636e63; // ncnc
+static const int container_version = 1;
+
+static std::vector<std::string> blob_names;
+
+static int find_blob_index_by_name(const char* name)
+{
+    for (size_t i = 0; i < blob_names.size(); i++)
+    {
+        if (blob_names[i] == name)
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    fprintf(stderr, "find_blob_index_by_name %s failed\n", name);
+    return -1;
+}
+
+static bool vstr_is_float(const char vstr[16])
+{
+    // look ahead for determine isfloat
+    for (int j = 0; j < 16; j++)
+    {
+        if (vstr[j] == '\0')
+            break;
+
+        if (vstr[j] == '.' || tolower(vstr[j]) == 'e')
+            return true;
+    }
+
+    return false;
+}
+
+static float vstr_to_float(const char vstr[16])
+{
+    double v = 0.0;
+
+    const char* p = vstr;
+
+    // sign
+    bool sign = *p != '-';
+    if (*p == '+' || *p == '-')
+    {
+        p++;
+    }
+
+    // digits before decimal point or exponent
+    unsigned int v1 = 0;
+    while (isdigit(*p))
+    {
+        v1 = v1 * 10 + (*p - '0');
+        p++;
+    }
+
+    v = (double)v1;
+
+    // digits after decimal point
+    if (*p == '.')
+    {
+        p++;
+
+        unsigned int pow10 = 1;
+        unsigned int v2 = 0;
+
+        while (isdigit(*p))
+        {
+            v2 = v2 * 10 + (*p - '0');
+            pow10 *= 10;
+            p++;
+        }
+
+        v += v2 / (double)pow10;
+    }
+
+    // exponent
+    if (*p == 'e' || *p == 'E')
+    {
+        p++;
+
+        // sign of exponent
+        bool fact = *p != '-';
+        if (*p == '+' || *p == '-')
+        {
+            p++;
+        }
+
+        // digits of exponent
+        unsigned int expon = 0;
+        while (isdigit(*p))
+        {
+            expon = expon * 10 + (*p - '0');
+            p++;
+        }
+
+        double scale = 1.0;
+        while (expon >= 8)
+        {
+            scale *= 1e8;
+            expon -= 8;
+        }
+        while (expon > 0)
+        {
+            scale *= 10.0;
+            expon -= 1;
+        }
+
+        v = fact ? v * scale : v / scale;
+    }
+
+    //     fprintf(stderr, "v = %f\n", v);
+    return sign ? (float)v : (float)-v;
+}
+
+static void append_int(std::vector<unsigned char>& data, int v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    data.insert(data.end(), p, p + sizeof(int));
+}
+
+static void append_float(std::vector<unsigned char>& data, float v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    data.insert(data.end(), p, p + sizeof(float));
+}
+
+static void append_string(std::vector<unsigned char>& data, const char* s)
+{
+    data.insert(data.end(), s, s + strlen(s) + 1);
+}
+
+static void append_value(std::vector<unsigned char>& data, const char vstr[16])
+{
+    if (vstr_is_float(vstr))
+    {
+        append_float(data, vstr_to_float(vstr));
+    }
+    else
+    {
+        int v = 0;
+        sscanf(vstr, "%d", &v);
+        append_int(data, v);
+    }
+}
+
+// plain param to binary param and the name strings
+static int convert_param(const char* parampath, std::vector<unsigned char>& parambin, std::vector<unsigned char>& names)
+{
+    FILE* fp = fopen(parampath, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", parampath);
+        return -1;
+    }
+
+    int magic = 0;
+    int layer_count = 0;
+    int blob_count = 0;
+    if (fscanf(fp, "%d", &magic) != 1 || fscanf(fp, "%d %d", &layer_count, &blob_count) != 2)
+    {
+        fprintf(stderr, "read param header failed\n");
+        fclose(fp);
+        return -1;
+    }
+
+    append_int(parambin, magic);
+    append_int(parambin, layer_count);
+    append_int(parambin, blob_count);
+
+    blob_names.resize(blob_count);
+
+    std::vector<std::string> custom_layer_index;
+
+    int blob_index = 0;
+    for (int i = 0; i < layer_count; i++)
+    {
+        char layer_type[33];
+        char layer_name[257];
+        int bottom_count = 0;
+        int top_count = 0;
+        if (fscanf(fp, "%32s %256s %d %d", layer_type, layer_name, &bottom_count, &top_count) != 4)
+        {
+            fprintf(stderr, "read layer %d failed\n", i);
+            fclose(fp);
+            return -1;
+        }
+
+        int typeindex = ncnn::layer_to_index(layer_type);
+        if (typeindex == -1)
+        {
+            // lookup custom_layer_index
+            for (size_t j = 0; j < custom_layer_index.size(); j++)
+            {
+                if (custom_layer_index[j] == layer_type)
+                {
+                    typeindex = ncnn::LayerType::CustomBit | j;
+                    break;
+                }
+            }
+
+            if (typeindex == -1)
+            {
+                // new custom layer type
+                size_t j = custom_layer_index.size();
+                custom_layer_index.push_back(layer_type);
+                typeindex = ncnn::LayerType::CustomBit | j;
+
+                fprintf(stderr, "custom layer %s is registered as typeindex %d\n", layer_type, typeindex);
+            }
+        }
+
+        append_int(parambin, typeindex);
+        append_int(parambin, bottom_count);
+        append_int(parambin, top_count);
+
+        append_string(names, layer_type);
+        append_string(names, layer_name);
+
+        for (int j = 0; j < bottom_count; j++)
+        {
+            char bottom_name[257];
+            if (fscanf(fp, "%256s", bottom_name) != 1)
+            {
+                fprintf(stderr, "read bottom_name failed\n");
+                fclose(fp);
+                return -1;
+            }
+
+            int bottom_blob_index = find_blob_index_by_name(bottom_name);
+            if (bottom_blob_index == -1)
+            {
+                fclose(fp);
+                return -1;
+            }
+
+            append_int(parambin, bottom_blob_index);
+        }
+
+        for (int j = 0; j < top_count; j++)
+        {
+            char blob_name[257];
+            if (fscanf(fp, "%256s", blob_name) != 1)
+            {
+                fprintf(stderr, "read blob_name failed\n");
+                fclose(fp);
+                return -1;
+            }
+
+            blob_names[blob_index] = std::string(blob_name);
+
+            append_int(parambin, blob_index);
+
+            blob_index++;
+        }
+
+        // parse each key=value pair
+        int id = 0;
+        while (fscanf(fp, "%d=", &id) == 1)
+        {
+            append_int(parambin, id);
+
+            bool is_array = id <= -23300;
+
+            if (is_array)
+            {
+                int len = 0;
+                if (fscanf(fp, "%d", &len) != 1)
+                {
+                    fprintf(stderr, "read array length failed\n");
+                    fclose(fp);
+                    return -1;
+                }
+
+                append_int(parambin, len);
+
+                for (int j = 0; j < len; j++)
+                {
+                    char vstr[16];
+                    if (fscanf(fp, ",%15[^,\n ]", vstr) != 1)
+                    {
+                        fprintf(stderr, "read array element failed\n");
+                        fclose(fp);
+                        return -1;
+                    }
+
+                    append_value(parambin, vstr);
+                }
+            }
+            else
+            {
+                char vstr[16];
+                if (fscanf(fp, "%15s", vstr) != 1)
+                {
+                    fprintf(stderr, "read value failed\n");
+                    fclose(fp);
+                    return -1;
+                }
+
+                append_value(parambin, vstr);
+            }
+        }
+
+        // end of params
+        append_int(parambin, -233);
+    }
+
+    fclose(fp);
+
+    for (int i = 0; i < blob_count; i++)
+    {
+        append_string(names, blob_names[i].c_str());
+    }
+
+    return 0;
+}
+
+static int read_file(const char* path, std::vector<unsigned char>& data)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    data.resize(size);
+    size_t nread = size ? fread(data.data(), 1, size, fp) : 0;
+    fclose(fp);
+
+    if (nread != (size_t)size)
+    {
+        fprintf(stderr, "read %s failed\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int write_container(const char* containerpath, const std::vector<int>& types, const std::vector<const std::vector<unsigned char>*>& datas)
+{
+    FILE* fp = fopen(containerpath, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", containerpath);
+        return -1;
+    }
+
+    const int section_count = (int)types.size();
+
+    int header[4] = {container_magic, container_version, section_count, 0};
+    fwrite(header, sizeof(header), 1, fp);
+
+    // section data follows the index in order, 64-byte aligned
+    int64_t offset = sizeof(header) + section_count * sizeof(int) * 6;
+    std::vector<int64_t> offsets(section_count);
+    for (int i = 0; i < section_count; i++)
+    {
+        offset = (offset + 63) / 64 * 64;
+        offsets[i] = offset;
+        offset += (int64_t)datas[i]->size();
+    }
+
+    for (int i = 0; i < section_count; i++)
+    {
+        int section_header[6] = {types[i], 0, 0, 0, 0, 0};
+        int64_t size = (int64_t)datas[i]->size();
+        memcpy(section_header + 2, &offsets[i], sizeof(int64_t));
+        memcpy(section_header + 4, &size, sizeof(int64_t));
+        fwrite(section_header, sizeof(section_header), 1, fp);
+    }
+
+    offset = sizeof(header) + section_count * sizeof(int) * 6;
+    for (int i = 0; i < section_count; i++)
+    {
+        static const unsigned char zeros[64] = {0};
+        fwrite(zeros, 1, (size_t)(offsets[i] - offset), fp);
+
+        const std::vector<unsigned char>& data = *datas[i];
+        if (!data.empty() && fwrite(data.data(), 1, data.size(), fp) != data.size())
+        {
+            fprintf(stderr, "write %s failed\n", containerpath);
+            fclose(fp);
+            return -1;
+        }
+
+        offset = offsets[i] + (int64_t)data.size();
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4 && argc != 5)
+    {
+        fprintf(stderr, "Usage: %s [ncnnparam] [ncnnbin] [containerpath] (weightcache)\n", argv[0]);
+        fprintf(stderr, "  weightcache is the optional file from Net::save_weight_cache on the target device\n");
+        return -1;
+    }
+
+    const char* parampath = argv[1];
+    const char* modelpath = argv[2];
+    const char* containerpath = argv[3];
+    const char* weightcachepath = argc == 5 ? argv[4] : 0;
+
+    std::vector<unsigned char> parambin;
+    std::vector<unsigned char> names;
+    if (convert_param(parampath, parambin, names) != 0)
+        return -1;
+
+    std::vector<unsigned char> model;
+    if (read_file(modelpath, model) != 0)
+        return -1;
+
+    std::vector<unsigned char> weightcache;
+    if (weightcachepath && read_file(weightcachepath, weightcache) != 0)
+        return -1;
+
+    // the weight cache must come before the weights it applies to
+    std::vector<int> types;
+    std::vector<const std::vector<unsigned char>*> datas;
+
+    types.push_back(container_section_param);
+    datas.push_back(&parambin);
+
+    types.push_back(container_section_names);
+    datas.push_back(&names);
+
+    if (weightcachepath)
+    {
+        types.push_back(container_section_weight_cache);
+        datas.push_back(&weightcache);
+    }
+
+    types.push_back(container_section_model);
+    datas.push_back(&model);
+
+    return write_container(containerpath, types, datas);
+}
@@ -16,6 +16,7 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #endif
 
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <map>
@@ -127,7 +128,12 @@ public:
 public:
     int quantize_convolution();
     int quantize_convolutiondepthwise();
+    int quantize_deconvolution();
+    int quantize_deconvolutiondepthwise();
     int quantize_innerproduct();
+    int quantize_rnn();
+    int quantize_lstm();
+    int quantize_gru();
 
     int fuse_requantize();
 };
@@ -257,6 +263,124 @@ int NetQuantize::quantize_convolutiondepthwise()
     return 0;
 }
 
+int NetQuantize::quantize_deconvolution()
+{
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        // find deconvolution layer
+        if (layers[i]->type != "Deconvolution")
+            continue;
+
+        std::map<std::string, ncnn::Mat>::iterator iter_data = blob_int8scale_table.find(layers[i]->name);
+        if (iter_data == blob_int8scale_table.end())
+            continue;
+
+        char key[256];
+        sprintf(key, "%s_param_0", layers[i]->name.c_str());
+
+        std::map<std::string, ncnn::Mat>::iterator iter = weight_int8scale_table.find(key);
+        if (iter == weight_int8scale_table.end())
+        {
+            fprintf(stderr, "this layer need to be quantized, but no scale param!\n");
+            return -1;
+        }
+
+        // Deconvolution - quantize weight from fp32 to int8
+        ncnn::Deconvolution* deconvolution = (ncnn::Deconvolution*)layers[i];
+
+        ncnn::Mat bottom_blob_int8_scales = iter_data->second;
+        ncnn::Mat weight_data_int8_scales = iter->second;
+
+        fprintf(stderr, "quantize_deconvolution %s\n", deconvolution->name.c_str());
+
+        {
+            const int maxk = deconvolution->kernel_w * deconvolution->kernel_h;
+            const int num_input = deconvolution->weight_data_size / deconvolution->num_output / maxk;
+
+            ncnn::Mat weight_data_r2 = deconvolution->weight_data.reshape(maxk, num_input, deconvolution->num_output);
+
+            ncnn::Mat weight_data_int8;
+
+            ncnn::Option opt_q = opt;
+            opt_q.blob_allocator = deconvolution->weight_data.allocator;
+            opt_q.use_packing_layout = false;
+            ncnn::quantize_to_int8(weight_data_r2, weight_data_int8, weight_data_int8_scales, opt_q);
+            if (weight_data_int8.empty())
+                return -100;
+
+            deconvolution->weight_data = weight_data_int8.reshape(deconvolution->weight_data_size);
+        }
+
+        deconvolution->int8_scale_term = 2;
+        deconvolution->weight_data_int8_scales = weight_data_int8_scales;
+        deconvolution->bottom_blob_int8_scales = bottom_blob_int8_scales;
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_deconvolutiondepthwise()
+{
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        // find deconvolutiondepthwise layer
+        if (layers[i]->type != "DeconvolutionDepthWise")
+            continue;
+
+        std::map<std::string, ncnn::Mat>::iterator iter_data = blob_int8scale_table.find(layers[i]->name);
+        if (iter_data == blob_int8scale_table.end())
+            continue;
+
+        char key[256];
+        sprintf(key, "%s_param_0", layers[i]->name.c_str());
+
+        std::map<std::string, ncnn::Mat>::iterator iter = weight_int8scale_table.find(key);
+        if (iter == weight_int8scale_table.end())
+        {
+            fprintf(stderr, "this layer need to be quantized, but no scale param!\n");
+            return -1;
+        }
+
+        // DeconvolutionDepthWise - quantize weight from fp32 to int8
+        ncnn::DeconvolutionDepthWise* deconvdw = (ncnn::DeconvolutionDepthWise*)layers[i];
+
+        ncnn::Mat bottom_blob_int8_scales = iter_data->second;
+        ncnn::Mat weight_data_int8_scales = iter->second;
+
+        fprintf(stderr, "quantize_deconvolutiondepthwise %s\n", deconvdw->name.c_str());
+
+        {
+            ncnn::Mat int8_weight_data(deconvdw->weight_data_size, (size_t)1u);
+            if (int8_weight_data.empty())
+                return -100;
+
+            const int weight_data_size_g = deconvdw->weight_data_size / deconvdw->group;
+
+            for (int g = 0; g < deconvdw->group; g++)
+            {
+                ncnn::Option opt_q = opt;
+                opt_q.blob_allocator = int8_weight_data.allocator;
+                opt_q.use_packing_layout = false;
+
+                const ncnn::Mat weight_data_g = deconvdw->weight_data.range(weight_data_size_g * g, weight_data_size_g);
+                ncnn::Mat int8_weight_data_g = int8_weight_data.range(weight_data_size_g * g, weight_data_size_g);
+                const ncnn::Mat weight_data_int8_scales_g = weight_data_int8_scales.range(g, 1);
+                ncnn::quantize_to_int8(weight_data_g, int8_weight_data_g, weight_data_int8_scales_g, opt_q);
+            }
+
+            deconvdw->weight_data = int8_weight_data;
+        }
+
+        deconvdw->int8_scale_term = 1;
+        deconvdw->weight_data_int8_scales = weight_data_int8_scales;
+        deconvdw->bottom_blob_int8_scales = bottom_blob_int8_scales;
+    }
+
+    return 0;
+}
+
 int NetQuantize::quantize_innerproduct()
 {
     const int layer_count = static_cast<int>(layers.size());
@@ -312,6 +436,138 @@ int NetQuantize::quantize_innerproduct()
     return 0;
 }
 
+// quantize the recurrent weight per output row, one scale row per direction
+// src = size-rows-num_directions
+static int quantize_recurrent_weight(const ncnn::Mat& weight_data, ncnn::Mat& weight_data_int8, ncnn::Mat& weight_data_int8_scales)
+{
+    const int size = weight_data.w;
+    const int rows = weight_data.h;
+    const int num_directions = weight_data.c;
+
+    weight_data_int8.create(size, rows, num_directions, (size_t)1u);
+    weight_data_int8_scales.create(rows, num_directions);
+    if (weight_data_int8.empty() || weight_data_int8_scales.empty())
+        return -100;
+
+    for (int d = 0; d < num_directions; d++)
+    {
+        const ncnn::Mat weight_data_d = weight_data.channel(d);
+        ncnn::Mat weight_data_int8_d = weight_data_int8.channel(d);
+        float* scales = weight_data_int8_scales.row(d);
+
+        for (int q = 0; q < rows; q++)
+        {
+            const float* ptr = weight_data_d.row(q);
+            signed char* outptr = weight_data_int8_d.row<signed char>(q);
+
+            float absmax = 0.f;
+            for (int i = 0; i < size; i++)
+            {
+                absmax = std::max(absmax, (float)fabs(ptr[i]));
+            }
+
+            const float scale = absmax == 0.f ? 1.f : 127 / absmax;
+
+            for (int i = 0; i < size; i++)
+            {
+                int int32 = (int)round(ptr[i] * scale);
+                if (int32 > 127) int32 = 127;
+                if (int32 < -127) int32 = -127;
+                outptr[i] = (signed char)int32;
+            }
+
+            scales[q] = scale;
+        }
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_rnn()
+{
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "RNN")
+            continue;
+
+        // RNN - quantize weight from fp32 to int8, activation is quantized dynamically
+        ncnn::RNN* rnn = (ncnn::RNN*)layers[i];
+
+        fprintf(stderr, "quantize_rnn %s\n", rnn->name.c_str());
+
+        ncnn::Mat weight_xc_data_int8;
+        ncnn::Mat weight_hc_data_int8;
+        if (quantize_recurrent_weight(rnn->weight_xc_data, weight_xc_data_int8, rnn->weight_xc_data_int8_scales) != 0)
+            return -100;
+        if (quantize_recurrent_weight(rnn->weight_hc_data, weight_hc_data_int8, rnn->weight_hc_data_int8_scales) != 0)
+            return -100;
+
+        rnn->weight_xc_data = weight_xc_data_int8;
+        rnn->weight_hc_data = weight_hc_data_int8;
+        rnn->int8_scale_term = 2;
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_lstm()
+{
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "LSTM")
+            continue;
+
+        // LSTM - quantize weight from fp32 to int8, activation is quantized dynamically
+        ncnn::LSTM* lstm = (ncnn::LSTM*)layers[i];
+
+        fprintf(stderr, "quantize_lstm %s\n", lstm->name.c_str());
+
+        ncnn::Mat weight_xc_data_int8;
+        ncnn::Mat weight_hc_data_int8;
+        if (quantize_recurrent_weight(lstm->weight_xc_data, weight_xc_data_int8, lstm->weight_xc_data_int8_scales) != 0)
+            return -100;
+        if (quantize_recurrent_weight(lstm->weight_hc_data, weight_hc_data_int8, lstm->weight_hc_data_int8_scales) != 0)
+            return -100;
+
+        // the projection weight_hr is kept in fp32
+        lstm->weight_xc_data = weight_xc_data_int8;
+        lstm->weight_hc_data = weight_hc_data_int8;
+        lstm->int8_scale_term = 2;
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_gru()
+{
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "GRU")
+            continue;
+
+        // GRU - quantize weight from fp32 to int8, activation is quantized dynamically
+        ncnn::GRU* gru = (ncnn::GRU*)layers[i];
+
+        fprintf(stderr, "quantize_gru %s\n", gru->name.c_str());
+
+        ncnn::Mat weight_xc_data_int8;
+        ncnn::Mat weight_hc_data_int8;
+        if (quantize_recurrent_weight(gru->weight_xc_data, weight_xc_data_int8, gru->weight_xc_data_int8_scales) != 0)
+            return -100;
+        if (quantize_recurrent_weight(gru->weight_hc_data, weight_hc_data_int8, gru->weight_hc_data_int8_scales) != 0)
+            return -100;
+
+        gru->weight_xc_data = weight_xc_data_int8;
+        gru->weight_hc_data = weight_hc_data_int8;
+        gru->int8_scale_term = 2;
+    }
+
+    return 0;
+}
+
 int NetQuantize::fuse_requantize()
 {
     const size_t layer_count = layers.size();
@@ -554,7 +810,12 @@ int main(int argc, char** argv)
 
     quantizer.quantize_convolution();
     quantizer.quantize_convolutiondepthwise();
+    quantizer.quantize_deconvolution();
+    quantizer.quantize_deconvolutiondepthwise();
     quantizer.quantize_innerproduct();
+    quantizer.quantize_rnn();
+    quantizer.quantize_lstm();
+    quantizer.quantize_gru();
 
     quantizer.fuse_requantize();
 